@@ -1,36 +1,184 @@
 #include "fast_flash_core.h"
 #include "fast_flash_log.h"
+#include "fast_flash_prof.h"
+#include "fast_flash_record.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 // 全局状态
 static const flash_ops_t *g_flash_ops = NULL;
-static uint32_t g_total_size = 0;
 static bool g_allow_erase = false;
+static bool g_lazy_mount = false;      // 挂载时不读入目录页，第一次访问时再读
+
+// 运行时几何参数（fast_flash_init_ex时确定）
+static uint32_t g_sector_size = FLASH_SECTOR_SIZE;
+static uint32_t g_page_size = FLASH_WRITE_CHUNK_SIZE;
+static uint32_t g_write_granularity = 1;
+static int g_max_tables = MAX_TABLES_ALL_SECTOR;
+
+// 设备支持的擦除粒度（从小到大）
+static uint32_t g_erase_sizes[FF_MAX_ERASE_SIZES] = { FLASH_SECTOR_SIZE };
+static int g_erase_size_count = 1;
+
+// 管理表缓冲区大小（max_tables个槽位，按编程粒度对齐）
+static uint32_t g_manager_size = 0;
+
+// 分页目录的目录页数量（0表示内联目录）和表名索引的桶数量
+static uint32_t g_catalog_pages = 0;
+static uint32_t g_name_index_size = 0;
+
+// 分区状态：每个分区有独立的管理表链表、分配器和GC，分区内地址从0开始
+typedef struct {
+    char     name[TABLE_NAME_MAX_LEN];
+    uint32_t base;                 // 分区在Flash中的起始地址
+    uint32_t total_size;           // 分区大小
+    flash_manager_table_t *manager_table;
+    bool     manager_loaded;
+
+    // 当前写入位置管理（热数据和管理表共用的写入流）
+    uint32_t current_sector;
+    uint32_t current_offset;
+
+    // 冷数据/只追加类别各自打开扇区的写入位置，0表示没有打开的扇区
+    uint32_t class_heads[FF_TABLE_CLASS_COUNT];
+    // 分配前沿：所有类别都从这里取新扇区，保证管理表链表地址单调递增
+    uint32_t next_free_sector;
+    // 挂载后已确认剩余部分为空白的打开扇区（按类别的位图）
+    uint8_t  heads_checked;
+
+    flash_io_stats_t *table_stats;  // 各表槽位的I/O统计（按max_tables分配）
+
+    // 目录索引（一次分配）：目录页地址、表名散列索引（槽位+1，0为空桶），
+    // 目录页位图：待重写、已读入；各目录页的探查距离
+    uint32_t *catalog_dir;
+    uint16_t *name_index;
+    uint8_t  *catalog_dirty;
+    uint8_t  *catalog_loaded;
+    uint8_t  *catalog_probe;
+    uint32_t  catalog_pending;     // 还没读入的目录页数量（延迟挂载）
+    int       free_hint;           // 内联目录：这个槽位之前都是有效表
+} partition_state_t;
+
+static partition_state_t g_partitions[FF_MAX_PARTITIONS];
+static int g_partition_count = 0;
+static partition_state_t *g_part = &g_partitions[0];  // 当前选择的分区
+
+// 核心内存区：设置后管理表、各表统计和GC临时数组从这里按顺序切分（8字节对齐、清零），
+// GC的临时数组在GC结束时整体归还；没有设置时使用堆
+static uint8_t *g_arena = NULL;
+static uint32_t g_arena_size = 0;
+static uint32_t g_arena_used = 0;
+static uint32_t g_arena_peak = 0;
+static bool g_partitions_on_heap = false;  // 当前分区的管理表和统计缓冲区来自堆
+
+// I/O统计：Flash访问按当前入口API、当前表槽位和编程类别记账
+typedef enum {
+    IO_KIND_DATA = 0,        // 表头和数据
+    IO_KIND_METADATA,        // 管理表
+    IO_KIND_RELOCATION       // GC搬运
+} io_kind_t;
+
+static flash_stats_t g_stats;
+static flash_api_t g_stats_api = FF_API_INIT;
+static int g_stats_table = -1;
+static io_kind_t g_io_kind = IO_KIND_DATA;
+
+#define STATS_ADD(field, value) do { \
+    g_stats.total.field += (value); \
+    g_stats.per_api[g_stats_api].field += (value); \
+    if (g_stats_table >= 0) { \
+        g_part->table_stats[g_stats_table].field += (value); \
+    } \
+} while (0)
+
+// 进入公共API：之后的Flash访问记到该API名下
+static void stats_begin(flash_api_t api) {
+    g_stats_api = api;
+    g_stats_table = -1;
+    g_io_kind = IO_KIND_DATA;
+    g_stats.total.calls++;
+    g_stats.per_api[api].calls++;
+}
+
+// 公共API入口：统计记账并打开耗时剖析作用域（函数返回时记录）
+#define API_BEGIN(api) stats_begin(api); FF_PROF_API(api)
+
+// 确定操作的表之后，Flash访问同时记到该表名下
+static void stats_set_table(int slot) {
+    if (g_stats_table != slot) {
+        g_stats_table = slot;
+        g_part->table_stats[slot].calls++;
+    }
+}
+
+// 分配清零的内存（内存区或堆）
+static void *ff_alloc(uint32_t size) {
+    if (g_arena) {
+        uint32_t aligned = FF_ARENA_ALIGN(size);
+        if (aligned > g_arena_size - g_arena_used) {
+            TRACE_ERROR("Arena exhausted: need %u bytes, %u free\n", aligned, g_arena_size - g_arena_used);
+            return NULL;
+        }
+        void *ptr = g_arena + g_arena_used;
+        g_arena_used += aligned;
+        if (g_arena_used > g_arena_peak) {
+            g_arena_peak = g_arena_used;
+        }
+        memset(ptr, 0, size);
+        return ptr;
+    }
+#ifdef FAST_FLASH_NO_HEAP
+    TRACE_ERROR("No arena configured (FAST_FLASH_NO_HEAP)\n");
+    return NULL;
+#else
+    return calloc(1, size);
+#endif
+}
 
-static flash_manager_table_t g_manager_table;
-static bool g_manager_loaded = false;
+// 释放ff_alloc分配的内存：堆内存立即释放，内存区中的内存由arena_release按分配顺序整体归还
+static void ff_free(void *ptr) {
+#ifndef FAST_FLASH_NO_HEAP
+    if (!g_arena) {
+        free(ptr);
+    }
+#endif
+    (void)ptr;
+}
 
-// 当前写入位置管理
-static uint32_t g_current_sector = 0;
-static uint32_t g_current_offset = 0;
+static void arena_release(uint32_t mark) {
+    if (g_arena) {
+        g_arena_used = mark;
+    }
+}
 
 // 内部函数声明
 static uint32_t calculate_crc32(const uint8_t *data, uint32_t length);
 static uint32_t calculate_manager_table_crc(const flash_manager_table_t *table);
+static void seal_manager_table(flash_manager_table_t *table);
 // static uint32_t align_to_sector_boundary(uint32_t addr);
 static int load_manager_table(void);
-static int save_manager_table(void);
-static int find_free_table_slot(void);
+static int save_manager_table(int slot);
+static int find_free_table_slot(const char *name);
 static int find_table_index(const char *name);
-static int allocate_table_space(uint32_t size, uint32_t *out_addr);
+static int open_new_sector(uint32_t *out_addr);
+static int allocate_table_space(uint32_t size, uint8_t flags, uint32_t *out_addr);
+static void restore_write_heads(const flash_manager_table_t *table, uint32_t data_end);
 static int write_with_chunks(uint32_t addr, const uint8_t *data, uint32_t size);
-static int validate_manager_table(const flash_manager_table_t *table);
-
-// CRC32计算
-static uint32_t calculate_crc32(const uint8_t *data, uint32_t length) {
-    uint32_t crc = 0xFFFFFFFF;
+static int write_table_image(uint32_t addr, const table_header_t *header, const uint8_t *data, uint32_t size);
+static int erase_range(uint32_t addr, uint32_t size);
+static uint32_t align_to_write_granularity(uint32_t value);
+static int migrate_manager_table(void);
+static int collect_garbage(void);
+
+// CRC32增量计算：从CRC32_INIT开始，分段调用crc32_update，最后异或CRC32_FINAL
+#define CRC32_INIT   0xFFFFFFFFu
+#define CRC32_FINAL  0xFFFFFFFFu
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, uint32_t length) {
+    FF_PROF_PHASE(FF_PHASE_CRC);
+    STATS_ADD(crc_bytes, length);
     for (uint32_t i = 0; i < length; i++) {
         crc ^= data[i];
         for (int j = 0; j < 8; j++) {
@@ -41,31 +189,236 @@ static uint32_t calculate_crc32(const uint8_t *data, uint32_t length) {
             }
         }
     }
-    return crc ^ 0xFFFFFFFF;
+    return crc;
+}
+
+// CRC32计算
+static uint32_t calculate_crc32(const uint8_t *data, uint32_t length) {
+    return crc32_update(CRC32_INIT, data, length) ^ CRC32_FINAL;
+}
+
+// GF(2)上模CRC多项式的乘法（反射表示，x^0在最高位）
+static uint32_t crc32_multmodp(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    while (m != 0) {
+        if (a & m) {
+            p ^= b;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ 0xEDB88320 : b >> 1;
+    }
+    return p;
+}
+
+// CRC寄存器后面接n个0字节（不读数据，O(log n)）
+static uint32_t crc32_shift(uint32_t crc, uint32_t n) {
+    uint32_t power = 1u << 31;   // x^0
+    uint32_t square = 1u << 23;  // x^8
+    while (n != 0) {
+        if (n & 1) {
+            power = crc32_multmodp(square, power);
+        }
+        square = crc32_multmodp(square, square);
+        n >>= 1;
+    }
+    return crc32_multmodp(power, crc);
 }
 
-// 计算管理表CRC（从version字段开始计算）
+// 由A和B各自的CRC得到A后接B（长度len_b）的CRC
+static uint32_t crc32_combine(uint32_t crc_a, uint32_t crc_b, uint32_t len_b) {
+    return crc32_shift(crc_a, len_b) ^ crc_b;
+}
+
+// 管理表表头CRC（magic到reserved，table_count到write_granularity；不含两个CRC字段）
+static uint32_t manager_header_crc(const flash_manager_table_t *table) {
+    uint32_t crc = crc32_update(CRC32_INIT, (const uint8_t*)table, offsetof(flash_manager_table_t, crc));
+    crc = crc32_update(crc, (const uint8_t*)&table->table_count,
+                       sizeof(flash_manager_table_t) - offsetof(flash_manager_table_t, table_count));
+    return crc ^ CRC32_FINAL;
+}
+
+// 计算管理表CRC（从header_crc开始到映像末尾：内联目录按Flash映像中的顺序跳过空槽位，分页目录是目录页地址）
 static uint32_t calculate_manager_table_crc(const flash_manager_table_t *table) {
-    uint8_t *crc_start = (uint8_t*)table + sizeof(uint16_t) + sizeof(uint32_t);
-    uint32_t crc_length = sizeof(flash_manager_table_t) - sizeof(uint16_t) - sizeof(uint32_t);
-    return calculate_crc32(crc_start, crc_length);
+    uint32_t crc = crc32_update(CRC32_INIT, (const uint8_t*)&table->header_crc,
+                                sizeof(flash_manager_table_t) - offsetof(flash_manager_table_t, header_crc));
+    if (g_catalog_pages > 0) {
+        crc = crc32_update(crc, (const uint8_t*)g_part->catalog_dir, table->page_count * sizeof(uint32_t));
+        return crc ^ CRC32_FINAL;
+    }
+    for (int i = 0; i < g_max_tables; i++) {
+        if (table->tables[i].status == TABLE_STATUS_VALID) {
+            crc = crc32_update(crc, (const uint8_t*)&table->tables[i], sizeof(flash_table_info_t));
+        }
+    }
+    return crc ^ CRC32_FINAL;
+}
+
+// 计算表头CRC和整表CRC（表头CRC包含在整表CRC中，必须先计算）
+static void seal_manager_table(flash_manager_table_t *table) {
+    table->header_crc = manager_header_crc(table);
+    table->crc = calculate_manager_table_crc(table);
+}
+
+// 管理表在Flash中的大小（表头和count个表项或pages个目录页地址，按编程粒度对齐）
+static uint32_t manager_image_size(uint32_t count, uint32_t pages) {
+    uint32_t body = (g_catalog_pages > 0) ? pages * sizeof(uint32_t) : count * sizeof(flash_table_info_t);
+    return align_to_write_granularity(sizeof(flash_manager_table_t) + body);
+}
+
+// 为下一个管理表预留的大小：两次保存之间最多新建一张表（内联目录多一个表项）；
+// 分页目录的新表按表名散列到任意目录页，目录页地址数组按全部目录页预留
+static uint32_t manager_reserve_size(uint32_t count) {
+    return manager_image_size(count < (uint32_t)g_max_tables ? count + 1 : (uint32_t)g_max_tables, g_catalog_pages);
+}
+
+// 分页目录中最后一个非空目录页之后的页数（管理表中目录页地址数组的长度）
+static uint32_t catalog_used_pages(void) {
+    uint32_t pages = g_catalog_pages;
+    while (pages > 0 && g_part->catalog_dir[pages - 1] == 0) {
+        pages--;
+    }
+    return pages;
+}
+
+// 器件累计能耗，适配层不提供时为0
+static uint64_t device_energy(void) {
+    return g_flash_ops->energy ? g_flash_ops->energy() : 0;
+}
+
+// 分区内地址的Flash访问（加上分区起始地址）；每次操作的器件能耗记到当前API和表名下
+static int part_read(uint32_t addr, uint8_t *buf, uint32_t size) {
+    STATS_ADD(read_bytes, size);
+    uint64_t energy = device_energy();
+    int result = g_flash_ops->read(g_part->base + addr, buf, size);
+    STATS_ADD(energy_nj, device_energy() - energy);
+    return result;
+}
+
+static int part_write(uint32_t addr, const uint8_t *buf, uint32_t size) {
+    FF_PROF_PHASE(FF_PHASE_PROGRAM);
+    if (g_io_kind == IO_KIND_METADATA) {
+        STATS_ADD(metadata_bytes, size);
+    } else if (g_io_kind == IO_KIND_RELOCATION) {
+        STATS_ADD(relocation_bytes, size);
+    } else {
+        STATS_ADD(data_bytes, size);
+    }
+    uint64_t energy = device_energy();
+    int result = g_flash_ops->write(g_part->base + addr, buf, size);
+    STATS_ADD(energy_nj, device_energy() - energy);
+    return result;
+}
+
+// 器件内部复制：编程量照常记账，数据不经过主机，不计读取量
+static int part_copy(uint32_t dst, uint32_t src, uint32_t size) {
+    FF_PROF_PHASE(FF_PHASE_PROGRAM);
+    if (g_io_kind == IO_KIND_RELOCATION) {
+        STATS_ADD(relocation_bytes, size);
+    } else {
+        STATS_ADD(data_bytes, size);
+    }
+    uint64_t energy = device_energy();
+    int result = g_flash_ops->copy(g_part->base + dst, g_part->base + src, size);
+    STATS_ADD(energy_nj, device_energy() - energy);
+    return result;
+}
+
+static int part_erase(uint32_t addr, uint32_t size) {
+    FF_PROF_PHASE(FF_PHASE_ERASE);
+    STATS_ADD(erase_count, 1);
+    STATS_ADD(erase_bytes, size);
+    uint64_t energy = device_energy();
+    int result = g_flash_ops->erase(g_part->base + addr, size);
+    STATS_ADD(energy_nj, device_energy() - energy);
+    return result;
+}
+
+// 检查区域是否为擦除状态
+static bool region_blank(uint32_t addr, uint32_t size) {
+    uint8_t buf[64];
+
+    while (size > 0) {
+        uint32_t n = (size > sizeof(buf)) ? sizeof(buf) : size;
+        if (part_read(addr, buf, n) != 0) {
+            return false;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            if (buf[i] != 0xFF) {
+                return false;
+            }
+        }
+        addr += n;
+        size -= n;
+    }
+    return true;
+}
+
+// 读取表头
+static int read_table_header(uint32_t table_addr, table_header_t *header) {
+    FF_PROF_PHASE(FF_PHASE_HEADER_READ);
+    return part_read(table_addr, (uint8_t*)header, sizeof(table_header_t));
+}
+
+// 核对表头与管理表记录：魔数、数据长度与used_size、结构体数量×大小必须一致。
+// 表头被破坏或停留在擦除状态时，其中的长度不可信，不能据此流式搬运、计算CRC或循环
+static int validate_table_header(const flash_table_info_t *table_info, const table_header_t *header) {
+    if (header->magic != MAGIC_NUMBER_TABLE || header->struct_size == 0 ||
+        header->table_size < sizeof(table_header_t) || table_info->used_size < sizeof(table_header_t) ||
+        header->data_len != table_info->used_size - sizeof(table_header_t) ||
+        (uint64_t)header->struct_nums * header->struct_size != header->data_len) {
+        TRACE_ERROR("Table header at 0x%08X is inconsistent (magic 0x%04X, data_len %u, used_size %u, %u x %u)\n",
+                    table_info->addr, header->magic, header->data_len, table_info->used_size,
+                    header->struct_nums, header->struct_size);
+        return -1;
+    }
+    return 0;
+}
+
+// 读取表头并核对，供所有按表头长度访问数据的接口使用
+static int read_valid_table_header(const flash_table_info_t *table_info, table_header_t *header) {
+    if (read_table_header(table_info->addr, header) != 0) {
+        return -1;
+    }
+    return validate_table_header(table_info, header);
+}
+
+// 读取表数据（addr为数据区内的地址）
+static int read_table_payload(uint32_t addr, void *buf, uint32_t size) {
+    FF_PROF_PHASE(FF_PHASE_DATA_READ);
+    return part_read(addr, (uint8_t*)buf, size);
+}
+
+// 持久化屏障：管理表写入是提交点，提交后要求设备把之前的修改落盘
+static int flash_sync(void) {
+    if (g_flash_ops->sync && g_flash_ops->sync() != 0) {
+        TRACE_ERROR("Flash sync failed\n");
+        return -1;
+    }
+    return 0;
 }
 
 // 对齐到扇区边界
 // static uint32_t align_to_sector_boundary(uint32_t addr) {
-//     return (addr + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+//     return (addr + g_sector_size - 1) & ~(g_sector_size - 1);
 // }
 
-// 分块写入（确保可打断性）
+// 对齐到编程粒度
+static uint32_t align_to_write_granularity(uint32_t value) {
+    return (value + g_write_granularity - 1) & ~(g_write_granularity - 1);
+}
+
+// 分块写入（确保可打断性），每块不跨编程页；末尾不足编程粒度的部分用0xFF补齐
 static int write_with_chunks(uint32_t addr, const uint8_t *data, uint32_t size) {
     const uint8_t *src = data;
-    uint32_t remain = size;
+    uint32_t remain = size - size % g_write_granularity;
     uint32_t current_addr = addr;
 
     while (remain > 0) {
-        uint32_t chunk_size = (remain > FLASH_WRITE_CHUNK_SIZE) ? FLASH_WRITE_CHUNK_SIZE : remain;
+        uint32_t page_remain = g_page_size - current_addr % g_page_size;
+        uint32_t chunk_size = (remain > page_remain) ? page_remain : remain;
 
-        int result = g_flash_ops->write(current_addr, src, chunk_size);
+        int result = part_write(current_addr, src, chunk_size);
         if (result != 0) {
             TRACE_DEBUG("Write failed at addr=0x%08X, size=%u\n", current_addr, chunk_size);
             return result;
@@ -76,24 +429,763 @@ static int write_with_chunks(uint32_t addr, const uint8_t *data, uint32_t size)
         remain -= chunk_size;
     }
 
+    uint32_t tail = size % g_write_granularity;
+    if (tail > 0) {
+        uint8_t unit[FF_MAX_WRITE_GRANULARITY];
+        memset(unit, 0xFF, g_write_granularity);
+        memcpy(unit, src, tail);
+        int result = part_write(current_addr, unit, g_write_granularity);
+        if (result != 0) {
+            TRACE_DEBUG("Write failed at addr=0x%08X, size=%u\n", current_addr, g_write_granularity);
+            return result;
+        }
+    }
+
     return 0;
 }
 
-// 验证管理表有效性
-static int validate_manager_table(const flash_manager_table_t *table) {
-    if (!table) return -1;
+// 写入表头和数据（作为一个连续的流，表头与数据衔接处按编程粒度拼接）
+static int write_table_image(uint32_t addr, const table_header_t *header, const uint8_t *data, uint32_t size) {
+    uint32_t header_aligned = sizeof(table_header_t) - sizeof(table_header_t) % g_write_granularity;
+    uint32_t header_tail = sizeof(table_header_t) - header_aligned;
+
+    if (header_tail == 0 || size == 0) {
+        // 表头本身对齐（或没有数据），分别写入即可
+        int result = write_with_chunks(addr, (const uint8_t*)header, sizeof(table_header_t));
+        if (result == 0 && size > 0) {
+            result = write_with_chunks(addr + sizeof(table_header_t), data, size);
+        }
+        return result;
+    }
+
+    if (header_aligned > 0) {
+        int result = write_with_chunks(addr, (const uint8_t*)header, header_aligned);
+        if (result != 0) {
+            return result;
+        }
+    }
+
+    // 表头尾部和数据开头拼成一个编程单位
+    uint8_t unit[FF_MAX_WRITE_GRANULARITY];
+    uint32_t head = g_write_granularity - header_tail;
+    if (head > size) {
+        head = size;
+    }
+    memset(unit, 0xFF, g_write_granularity);
+    memcpy(unit, (const uint8_t*)header + header_aligned, header_tail);
+    memcpy(unit + header_tail, data, head);
+    int result = write_with_chunks(addr + header_aligned, unit, g_write_granularity);
+    if (result != 0 || head == size) {
+        return result;
+    }
+
+    return write_with_chunks(addr + header_aligned + g_write_granularity, data + head, size - head);
+}
+
+#if FF_STREAM_BUFFER_SIZE % FF_MAX_WRITE_GRANULARITY != 0
+#error "FF_STREAM_BUFFER_SIZE must be a multiple of FF_MAX_WRITE_GRANULARITY"
+#endif
+
+// 流式缓冲区：表数据的搬运、清除和校验都经过这块固定大小的缓冲区，RAM占用不随表大小变化
+static uint8_t g_stream_buf[FF_STREAM_BUFFER_SIZE];
+
+// 流式写入的数据源：新表数据由源表的记录（跳过skip_mask标记的记录）和调用者提供的一段RAM数据组成，
+// RAM数据覆盖新数据中[patch_offset, patch_offset + patch_size)的部分（改写某条记录或在末尾追加）
+typedef struct {
+    uint32_t src;                // 源表数据区地址，没有源表时不使用
+    uint32_t struct_size;
+    uint64_t skip_mask;          // 按源表索引跳过的记录（只对前64条有效）
+    const uint8_t *patch;        // NULL表示没有RAM数据
+    uint32_t patch_offset;
+    uint32_t patch_size;
+    bool     crc_derived;        // header->data_crc已由旧CRC推导，来自源表的数据不必读出
+} stream_source_t;
+
+static bool stream_record_kept(const stream_source_t *source, uint32_t index) {
+    return index >= 64 || !(source->skip_mask & (1ULL << index));
+}
+
+// 新数据中第record条记录对应的源表索引
+static uint32_t stream_source_index(const stream_source_t *source, uint32_t record) {
+    uint32_t index = 0;
+    while (!stream_record_kept(source, index) || record-- > 0) {
+        index++;
+    }
+    return index;
+}
+
+// 新数据offset处的字节在源表中的地址，返回从这里开始在源表中连续的字节数；offset落在RAM数据中时返回0
+static uint32_t stream_locate(const stream_source_t *source, uint32_t offset, uint32_t *src_addr) {
+    uint32_t available = UINT32_MAX;
+    if (source->patch) {
+        if (offset >= source->patch_offset && offset - source->patch_offset < source->patch_size) {
+            return 0;
+        }
+        if (offset < source->patch_offset) {
+            available = source->patch_offset - offset;
+        }
+    }
+
+    *src_addr = source->src + offset;
+    if (source->skip_mask) {
+        // 从该记录开始连续保留的记录在源表中是连续的
+        uint32_t within = offset % source->struct_size;
+        uint32_t index = stream_source_index(source, offset / source->struct_size);
+        uint32_t run = 1;
+        while (index + run < 64 && stream_record_kept(source, index + run)) {
+            run++;
+        }
+        if (index + run < 64 && run * source->struct_size - within < available) {
+            available = run * source->struct_size - within;
+        }
+        *src_addr = source->src + index * source->struct_size + within;
+    }
+    return available;
+}
 
+// 取新数据[offset, offset + size)到buf
+static int stream_fill(const stream_source_t *source, uint32_t offset, uint8_t *buf, uint32_t size) {
+    while (size > 0) {
+        uint32_t src_addr;
+        uint32_t n = stream_locate(source, offset, &src_addr);
+        if (n == 0) {
+            n = source->patch_offset + source->patch_size - offset;
+            if (n > size) {
+                n = size;
+            }
+            memcpy(buf, source->patch + (offset - source->patch_offset), n);
+        } else {
+            if (n > size) {
+                n = size;
+            }
+            if (read_table_payload(src_addr, buf, n) != 0) {
+                return -1;
+            }
+        }
+
+        buf += n;
+        offset += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// 读出一段数据累加到CRC寄存器
+static int stream_crc_update(uint32_t addr, uint32_t size, uint32_t *crc) {
+    for (uint32_t offset = 0; offset < size; ) {
+        uint32_t n = (size - offset > FF_STREAM_BUFFER_SIZE) ? FF_STREAM_BUFFER_SIZE : size - offset;
+        int result = read_table_payload(addr + offset, g_stream_buf, n);
+        if (result != 0) {
+            return result;
+        }
+        *crc = crc32_update(*crc, g_stream_buf, n);
+        offset += n;
+    }
+    return 0;
+}
+
+// 流式计算表数据的CRC
+static int stream_data_crc(uint32_t addr, uint32_t size, uint32_t *crc_out) {
+    uint32_t crc = CRC32_INIT;
+    int result = stream_crc_update(addr, size, &crc);
+    *crc_out = crc ^ CRC32_FINAL;
+    return result;
+}
+
+// 分块复制（dst为编程粒度对齐的地址，size为编程粒度的整数倍），每块不跨编程页；
+// 器件支持内部复制时数据不经过主机，否则经流式缓冲区读出再写入
+static int copy_with_chunks(uint32_t dst, uint32_t src, uint32_t size) {
+    while (size > 0) {
+        uint32_t page_remain = g_page_size - dst % g_page_size;
+        uint32_t n = (size > page_remain) ? page_remain : size;
+        int result;
+        if (g_flash_ops->copy) {
+            result = part_copy(dst, src, n);
+        } else {
+            if (n > FF_STREAM_BUFFER_SIZE) {
+                n = FF_STREAM_BUFFER_SIZE;
+            }
+            result = part_read(src, g_stream_buf, n);
+            if (result == 0) {
+                result = write_with_chunks(dst, g_stream_buf, n);
+            }
+        }
+        if (result != 0) {
+            TRACE_DEBUG("Copy failed at addr=0x%08X, size=%u\n", dst, n);
+            return result;
+        }
+        dst += n;
+        src += n;
+        size -= n;
+    }
+    return 0;
+}
+
+// 流式写入一张表：新数据经流式缓冲区从数据源搬运到新位置，CRC随搬运计算。
+// 器件支持内部复制时，来自源表、能按编程单位整块搬运的部分直接在器件内复制，只有RAM数据和拼接处的编程单位经过主机；
+// CRC已推导时这部分数据不再读出。
+// 表头中的CRC要等全部数据读过才知道，所以先写数据、最后写表头（与数据开头共用的编程单位随表头一起写）；
+// 新表在管理表提交之前不可见，写入顺序不影响掉电后的状态。header->data_len为新数据长度，data_crc在这里填写
+static int stream_table_image(uint32_t addr, table_header_t *header, const stream_source_t *source) {
+    uint32_t size = header->data_len;
+    uint32_t header_tail = sizeof(table_header_t) % g_write_granularity;
+    uint32_t head = header_tail ? g_write_granularity - header_tail : 0;
+    uint8_t head_data[FF_MAX_WRITE_GRANULARITY];
+    bool device_copy = (g_flash_ops->copy != NULL);
+    bool need_crc = !(device_copy && source->crc_derived);
+    uint32_t crc = CRC32_INIT;
+
+    if (head > size) {
+        head = size;
+    }
+    if (head > 0) {
+        if (stream_fill(source, 0, head_data, head) != 0) {
+            return -1;
+        }
+        if (need_crc) {
+            crc = crc32_update(crc, head_data, head);
+        }
+    }
+
+    for (uint32_t offset = head; offset < size; ) {
+        uint32_t data_addr = addr + sizeof(table_header_t) + offset;
+        uint32_t n = size - offset;
+        int result;
+
+        if (device_copy) {
+            uint32_t src_addr = 0;
+            uint32_t span = stream_locate(source, offset, &src_addr);
+            if (span > n) {
+                span = n;
+            }
+            uint32_t units = span - span % g_write_granularity;
+            if (units > 0) {
+                // 整块来自源表：器件内复制
+                result = need_crc ? stream_crc_update(src_addr, units, &crc) : 0;
+                if (result == 0) {
+                    result = copy_with_chunks(data_addr, src_addr, units);
+                }
+                if (result != 0) {
+                    return result;
+                }
+                offset += units;
+                continue;
+            }
+            // RAM数据（到其结束处所在编程单位为止）或源表数据与其他数据拼接的编程单位
+            uint32_t host = span;
+            if (span == 0) {
+                host = source->patch_offset + source->patch_size - offset;
+            }
+            host = (host + g_write_granularity - 1) & ~(g_write_granularity - 1);
+            if (n > host) {
+                n = host;
+            }
+        }
+
+        if (n > FF_STREAM_BUFFER_SIZE) {
+            n = FF_STREAM_BUFFER_SIZE;
+        }
+        if (stream_fill(source, offset, g_stream_buf, n) != 0) {
+            return -1;
+        }
+        if (need_crc) {
+            crc = crc32_update(crc, g_stream_buf, n);
+        }
+        result = write_with_chunks(data_addr, g_stream_buf, n);
+        if (result != 0) {
+            return result;
+        }
+        offset += n;
+    }
+
+    if (need_crc) {
+        header->data_crc = crc ^ CRC32_FINAL;
+    }
+    return write_table_image(addr, header, head_data, head);
+}
+
+// 把一段数据接到流式缓冲区中，缓冲区满时写出
+static int stream_append(uint32_t addr, uint32_t *fill, const uint8_t *data, uint32_t size) {
+    while (size > 0) {
+        uint32_t offset = *fill % FF_STREAM_BUFFER_SIZE;
+        uint32_t n = (size > FF_STREAM_BUFFER_SIZE - offset) ? FF_STREAM_BUFFER_SIZE - offset : size;
+        memcpy(g_stream_buf + offset, data, n);
+        *fill += n;
+        data += n;
+        size -= n;
+        if (*fill % FF_STREAM_BUFFER_SIZE == 0) {
+            int result = write_with_chunks(addr + *fill - FF_STREAM_BUFFER_SIZE, g_stream_buf, FF_STREAM_BUFFER_SIZE);
+            if (result != 0) {
+                return result;
+            }
+        }
+    }
+    return 0;
+}
+
+// 写出流式缓冲区中还没写出的部分
+static int stream_flush(uint32_t addr, uint32_t fill) {
+    uint32_t rest = fill % FF_STREAM_BUFFER_SIZE;
+    return (rest != 0) ? write_with_chunks(addr + fill - rest, g_stream_buf, rest) : 0;
+}
+
+// 写入当前分区的管理表（按元数据记账）：内联目录在表头之后依次写有效表项，
+// 有效表项连续时直接写RAM中的映像，否则经流式缓冲区跳过空槽位；分页目录在表头之后写目录页地址
+static int write_manager_image(uint32_t addr) {
+    const flash_manager_table_t *table = g_part->manager_table;
+    uint32_t count = table->table_count;
+    uint32_t size = sizeof(flash_manager_table_t) + count * sizeof(flash_table_info_t);
+    io_kind_t saved_kind = g_io_kind;
+    g_io_kind = IO_KIND_METADATA;
+
+    bool contiguous = (g_catalog_pages == 0);
+    for (uint32_t i = 0; i < count && contiguous; i++) {
+        contiguous = (table->tables[i].status == TABLE_STATUS_VALID);
+    }
+
+    int result;
+    if (contiguous) {
+        result = write_with_chunks(addr, (const uint8_t*)table, size);
+    } else {
+        uint32_t fill = 0;
+        result = stream_append(addr, &fill, (const uint8_t*)table, sizeof(flash_manager_table_t));
+        if (g_catalog_pages > 0 && result == 0) {
+            result = stream_append(addr, &fill, (const uint8_t*)g_part->catalog_dir,
+                                   table->page_count * sizeof(uint32_t));
+        }
+        for (int i = 0; g_catalog_pages == 0 && i < g_max_tables && result == 0; i++) {
+            if (table->tables[i].status == TABLE_STATUS_VALID) {
+                result = stream_append(addr, &fill, (const uint8_t*)&table->tables[i], sizeof(flash_table_info_t));
+            }
+        }
+        if (result == 0) {
+            result = stream_flush(addr, fill);
+        }
+    }
+    g_io_kind = saved_kind;
+    return result;
+}
+
+// 目录页位图（待重写、已读入）
+static bool page_bit(const uint8_t *bitmap, uint32_t page) {
+    return (bitmap[page / 8] & (1u << (page % 8))) != 0;
+}
+
+static void set_page_bit(uint8_t *bitmap, uint32_t page) {
+    bitmap[page / 8] |= (uint8_t)(1u << (page % 8));
+}
+
+// 目录页包含的槽位区间
+static void catalog_page_slots(uint32_t page, int *first, int *last) {
+    *first = (int)(page * FF_CATALOG_PAGE_TABLES);
+    *last = *first + FF_CATALOG_PAGE_TABLES;
+    if (*last > g_max_tables) {
+        *last = g_max_tables;
+    }
+}
+
+// 目录页中的有效表项数量
+static uint32_t catalog_page_count(uint32_t page) {
+    int first, last;
+    uint32_t count = 0;
+    catalog_page_slots(page, &first, &last);
+    for (int i = first; i < last; i++) {
+        if (g_part->manager_table->tables[i].status == TABLE_STATUS_VALID) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// 目录页在Flash中的大小（页头和count个表项，按编程粒度对齐）
+static uint32_t catalog_page_size(uint32_t count) {
+    return align_to_write_granularity(sizeof(flash_catalog_page_t) + count * sizeof(flash_table_info_t));
+}
+
+// 目录页是否要写入Flash：没有有效表项、探查距离也为0的页不写，页地址记为0
+static bool catalog_page_stored(uint32_t page, uint32_t count) {
+    return count > 0 || g_part->catalog_probe[page] > 0;
+}
+
+// 写入一个目录页（按元数据记账）：页头之后依次写该页的有效表项
+static int write_catalog_page(uint32_t page, uint32_t addr, uint32_t count) {
+    const flash_manager_table_t *table = g_part->manager_table;
+    flash_catalog_page_t header;
+    int first, last;
+    catalog_page_slots(page, &first, &last);
+
+    memset(&header, 0, sizeof(header));
+    header.magic = MAGIC_NUMBER_CATALOG;
+    header.page = (uint16_t)page;
+    header.count = (uint16_t)count;
+    header.probe = g_part->catalog_probe[page];
+    uint32_t crc = crc32_update(CRC32_INIT, (const uint8_t*)&header, offsetof(flash_catalog_page_t, crc));
+    for (int i = first; i < last; i++) {
+        if (table->tables[i].status == TABLE_STATUS_VALID) {
+            crc = crc32_update(crc, (const uint8_t*)&table->tables[i], sizeof(flash_table_info_t));
+        }
+    }
+    header.crc = crc ^ CRC32_FINAL;
+
+    io_kind_t saved_kind = g_io_kind;
+    g_io_kind = IO_KIND_METADATA;
+    uint32_t fill = 0;
+    int result = stream_append(addr, &fill, (const uint8_t*)&header, sizeof(header));
+    for (int i = first; i < last && result == 0; i++) {
+        if (table->tables[i].status == TABLE_STATUS_VALID) {
+            result = stream_append(addr, &fill, (const uint8_t*)&table->tables[i], sizeof(flash_table_info_t));
+        }
+    }
+    if (result == 0) {
+        result = stream_flush(addr, fill);
+    }
+    g_io_kind = saved_kind;
+    return result;
+}
+
+// 读取一个目录页，表项依次放入该页从头开始的槽位并记录探查距离，返回表项数量
+static int read_catalog_page(uint32_t page, uint32_t addr) {
+    flash_catalog_page_t header;
+    int first, last;
+    catalog_page_slots(page, &first, &last);
+
+    if (part_read(addr, (uint8_t*)&header, sizeof(header)) != 0) {
+        return -1;
+    }
+    if (header.magic != MAGIC_NUMBER_CATALOG || header.page != page || header.count > (uint32_t)(last - first)) {
+        TRACE_DEBUG("Invalid catalog page %u at 0x%08X\n", page, addr);
+        return -1;
+    }
+
+    flash_table_info_t *entries = &g_part->manager_table->tables[first];
+    if (header.count > 0 &&
+        part_read(addr + sizeof(header), (uint8_t*)entries, header.count * sizeof(flash_table_info_t)) != 0) {
+        return -1;
+    }
+    uint32_t crc = crc32_update(CRC32_INIT, (const uint8_t*)&header, offsetof(flash_catalog_page_t, crc));
+    crc = crc32_update(crc, (const uint8_t*)entries, header.count * sizeof(flash_table_info_t)) ^ CRC32_FINAL;
+    if (crc != header.crc) {
+        TRACE_ERROR("Catalog page %u CRC mismatch: calculated=0x%08X, stored=0x%08X\n", page, crc, header.crc);
+        return -1;
+    }
+    for (uint32_t k = 0; k < header.count; k++) {
+        if (entries[k].status != TABLE_STATUS_VALID) {
+            return -1;
+        }
+    }
+    if (header.probe >= g_catalog_pages) {
+        return -1;
+    }
+    g_part->catalog_probe[page] = (uint8_t)header.probe;
+    return header.count;
+}
+
+// 擦除连续的扇区区间，按对齐情况合并为设备支持的最大块擦除
+static int erase_range(uint32_t addr, uint32_t size) {
+    uint32_t end = addr + size;
+
+    while (addr < end) {
+        uint32_t erase_size = g_sector_size;
+        for (int i = g_erase_size_count - 1; i > 0; i--) {
+            // 块擦除按Flash绝对地址对齐
+            if ((g_part->base + addr) % g_erase_sizes[i] == 0 && addr + g_erase_sizes[i] <= end) {
+                erase_size = g_erase_sizes[i];
+                break;
+            }
+        }
+
+        int result = part_erase(addr, erase_size);
+        if (result != 0) {
+            TRACE_DEBUG("Erase failed at addr=0x%08X, size=%u\n", addr, erase_size);
+            return result;
+        }
+        addr += erase_size;
+    }
+
+    return 0;
+}
+
+// 表名散列（FNV-1a，与表名比较一致最多取TABLE_NAME_MAX_LEN个字符）
+static uint32_t name_hash(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < TABLE_NAME_MAX_LEN && name[i] != '\0'; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// 表名索引：开放寻址、线性探测，桶中存槽位+1（0为空桶），只索引有效表
+static int name_index_find(const char *name) {
+    uint32_t bucket = name_hash(name) % g_name_index_size;
+    while (g_part->name_index[bucket] != 0) {
+        int slot = g_part->name_index[bucket] - 1;
+        if (strncmp(g_part->manager_table->tables[slot].name, name, TABLE_NAME_MAX_LEN) == 0) {
+            return slot;
+        }
+        bucket = (bucket + 1) % g_name_index_size;
+    }
+    return -1;
+}
+
+static void name_index_insert(int slot) {
+    uint32_t bucket = name_hash(g_part->manager_table->tables[slot].name) % g_name_index_size;
+    while (g_part->name_index[bucket] != 0) {
+        bucket = (bucket + 1) % g_name_index_size;
+    }
+    g_part->name_index[bucket] = (uint16_t)(slot + 1);
+}
+
+// 删除时把同一探测链上后面的项前移填补空桶（不使用墓碑，查找长度不会随删除增长）
+static void name_index_remove(int slot) {
+    uint32_t hole = name_hash(g_part->manager_table->tables[slot].name) % g_name_index_size;
+    while (g_part->name_index[hole] != (uint16_t)(slot + 1)) {
+        if (g_part->name_index[hole] == 0) {
+            return;
+        }
+        hole = (hole + 1) % g_name_index_size;
+    }
+    g_part->name_index[hole] = 0;
+
+    uint32_t bucket = hole;
+    for (;;) {
+        bucket = (bucket + 1) % g_name_index_size;
+        uint16_t entry = g_part->name_index[bucket];
+        if (entry == 0) {
+            break;
+        }
+        // 起始桶不在(hole, bucket]区间内的项前移到空桶
+        uint32_t home = name_hash(g_part->manager_table->tables[entry - 1].name) % g_name_index_size;
+        bool reachable = (hole <= bucket) ? (hole < home && home <= bucket) : (hole < home || home <= bucket);
+        if (!reachable) {
+            g_part->name_index[hole] = entry;
+            g_part->name_index[bucket] = 0;
+            hole = bucket;
+        }
+    }
+}
+
+// 清空目录索引：目录页地址、表名索引、各位图和空闲槽位提示（全部目录页视为已读入）
+static void reset_catalog(void) {
+    uint32_t bitmap_size = (g_catalog_pages + 7) / 8;
+    memset(g_part->catalog_dir, 0, g_catalog_pages * sizeof(uint32_t));
+    memset(g_part->name_index, 0, g_name_index_size * sizeof(uint16_t));
+    memset(g_part->catalog_dirty, 0, bitmap_size);
+    memset(g_part->catalog_probe, 0, g_catalog_pages);
+    memset(g_part->catalog_loaded, 0xFF, bitmap_size);
+    g_part->catalog_pending = 0;
+    g_part->free_hint = 0;
+}
+
+// 按RAM中的表项重建表名索引
+static void rebuild_name_index(void) {
+    memset(g_part->name_index, 0, g_name_index_size * sizeof(uint16_t));
+    for (int i = 0; i < g_max_tables; i++) {
+        if (g_part->manager_table->tables[i].status == TABLE_STATUS_VALID) {
+            name_index_insert(i);
+        }
+    }
+}
+
+// 标记槽位所在的目录页需要重写（slot为-1时标记全部目录页）
+static void mark_catalog_dirty(int slot) {
+    if (slot < 0) {
+        memset(g_part->catalog_dirty, 0xFF, (g_catalog_pages + 7) / 8);
+    } else if (g_catalog_pages > 0) {
+        set_page_bit(g_part->catalog_dirty, (uint32_t)slot / FF_CATALOG_PAGE_TABLES);
+    }
+}
+
+// 全部目录页读入后表项总数必须与表头一致。挂载时不一致则回退到上一个管理表节点；
+// 延迟挂载在之后才读完目录页，已经不能回退，分区停用（操作返回-1）直到重新初始化
+static int check_catalog_count(void) {
+    uint32_t total = 0;
+    for (uint32_t page = 0; page < g_catalog_pages; page++) {
+        total += catalog_page_count(page);
+    }
+    if (total != g_part->manager_table->table_count) {
+        TRACE_ERROR("Catalog holds %u tables, manager table records %u\n", total, g_part->manager_table->table_count);
+        g_part->manager_loaded = false;
+        return -1;
+    }
+    return 0;
+}
+
+// 读入一个还没读入的目录页（延迟挂载），表项加入表名索引；最后一页读入后检查表项总数
+static int load_catalog_page(uint32_t page) {
+    if (page_bit(g_part->catalog_loaded, page)) {
+        return 0;
+    }
+    uint32_t addr = g_part->catalog_dir[page];
+    int count = (addr < g_part->total_size) ? read_catalog_page(page, addr) : -1;
+    if (count < 0) {
+        TRACE_ERROR("Failed to load catalog page %u at 0x%08X\n", page, addr);
+        return -1;
+    }
+
+    int first, last;
+    catalog_page_slots(page, &first, &last);
+    for (int i = first; i < first + count; i++) {
+        name_index_insert(i);
+    }
+    set_page_bit(g_part->catalog_loaded, page);
+    g_part->catalog_pending--;
+    return (g_part->catalog_pending == 0) ? check_catalog_count() : 0;
+}
+
+// 读入全部还没读入的目录页（遍历全部表的操作之前调用）
+static int load_catalog(void) {
+    for (uint32_t page = 0; page < g_catalog_pages && g_part->catalog_pending > 0; page++) {
+        if (load_catalog_page(page) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 分页目录中为新表选择槽位：从表名散列到的目录页开始找第一个有空槽位的页；
+// 放到后面的页时增大散列页的探查距离（散列页随后重写），按名查找时只需找到这个距离为止
+static int catalog_place(const char *name) {
+    uint32_t home = name_hash(name) % g_catalog_pages;
+    for (uint32_t n = 0; n < g_catalog_pages; n++) {
+        uint32_t page = (home + n) % g_catalog_pages;
+        if (load_catalog_page(page) != 0) {
+            return -1;
+        }
+        int first, last;
+        catalog_page_slots(page, &first, &last);
+        for (int i = first; i < last; i++) {
+            if (g_part->manager_table->tables[i].status != TABLE_STATUS_VALID) {
+                if (n > g_part->catalog_probe[home]) {
+                    g_part->catalog_probe[home] = (uint8_t)n;
+                    set_page_bit(g_part->catalog_dirty, home);
+                }
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+// 按表项实际所在的目录页重新计算探查距离（GC重写全部目录页之前，去掉删表后不再需要的距离）
+static void rebuild_catalog_probe(void) {
+    memset(g_part->catalog_probe, 0, g_catalog_pages);
+    for (int i = 0; i < g_max_tables; i++) {
+        if (g_part->manager_table->tables[i].status != TABLE_STATUS_VALID) {
+            continue;
+        }
+        uint32_t home = name_hash(g_part->manager_table->tables[i].name) % g_catalog_pages;
+        uint32_t n = ((uint32_t)i / FF_CATALOG_PAGE_TABLES + g_catalog_pages - home) % g_catalog_pages;
+        if (n > g_part->catalog_probe[home]) {
+            g_part->catalog_probe[home] = (uint8_t)n;
+        }
+    }
+}
+
+// 最初的管理表格式（v1）：紧凑排布（packed），CRC紧跟魔数，没有分配前沿、分类写入头、几何参数和表头CRC；
+// Flash中固定存放MAX_TABLES_ALL_SECTOR个表项，每个表项末尾有未使用的next_manager_addr。挂载时迁移到当前格式
+#define MANAGER_TABLE_VERSION_V1  1
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint32_t crc;                      // 从version到表项数组末尾
+    uint8_t  version;
+    uint8_t  table_count;
+    uint32_t total_size;
+    uint32_t used_size;
+    uint32_t next_manager_addr;        // 预留大小为MANAGER_V1_SIZE
+} manager_v1_header_t;
+
+typedef struct __attribute__((packed)) {
+    char     name[TABLE_NAME_MAX_LEN];
+    uint32_t addr;
+    uint32_t size;
+    uint32_t used_size;
+    uint16_t magic;
+    uint8_t  status;
+    uint8_t  reserved;                 // 0，即FF_TABLE_HOT
+    uint32_t next_manager_addr;        // 未使用
+} table_info_v1_t;
+
+#define MANAGER_V1_SIZE  (sizeof(manager_v1_header_t) + MAX_TABLES_ALL_SECTOR * sizeof(table_info_v1_t))
+
+// 挂载遍历链表时读取的表头：当前格式的version字段在v1中是CRC的低字节，按版本号和CRC共同区分
+typedef union {
+    flash_manager_table_t current;
+    manager_v1_header_t v1;
+} manager_header_t;
+
+// 几何参数必须与创建时一致，否则表信息数组长度和对齐规则都不同
+static int check_manager_geometry(uint32_t sector_size, uint16_t max_tables, uint16_t write_granularity) {
+    if (sector_size != g_sector_size || max_tables != (uint16_t)g_max_tables ||
+        write_granularity != g_write_granularity) {
+        TRACE_ERROR("Manager table geometry mismatch: sector=%u tables=%u granularity=%u\n",
+                   sector_size, max_tables, write_granularity);
+        return -2;
+    }
+    return 0;
+}
+
+// v1整表CRC（从version到最后一个表项），经流式缓冲区读出
+static int read_manager_v1_crc(uint32_t addr, uint32_t *crc_out) {
+    uint32_t start = offsetof(manager_v1_header_t, version);
+    uint32_t crc = CRC32_INIT;
+    if (addr + MANAGER_V1_SIZE > g_part->total_size ||
+        stream_crc_update(addr + start, MANAGER_V1_SIZE - start, &crc) != 0) {
+        return -1;
+    }
+    *crc_out = crc ^ CRC32_FINAL;
+    return 0;
+}
+
+// 验证管理表表头（只需读取表头，不含表信息数组），成功时给出格式版本和预留的下一个管理表地址；
+// v1没有表头CRC，遍历链表时就校验整表CRC，避免把半写的当前格式表头当作v1。
+// 返回-2表示几何参数不一致或版本不支持，这样的设备不能当作空白设备
+static int validate_manager_header(uint32_t addr, const manager_header_t *header, uint8_t *version, uint32_t *next_addr) {
+    if (!header) return -1;
+
+    const flash_manager_table_t *table = &header->current;
     if (table->magic != MAGIC_NUMBER_MANAGER) {
         TRACE_ERROR("Invalid manager table magic: 0x%04X\n", table->magic);
         return -1;
     }
 
-    if (table->version != MANAGER_TABLE_VERSION) {
-        TRACE_ERROR("Unsupported manager table version: %u\n", table->version);
+    if (table->version == MANAGER_TABLE_VERSION && manager_header_crc(table) == table->header_crc) {
+        if (table->table_count > table->max_tables) {
+            TRACE_DEBUG("Manager table entry count %u exceeds %u slots\n", table->table_count, table->max_tables);
+            return -1;
+        }
+        *version = MANAGER_TABLE_VERSION;
+        *next_addr = table->next_manager_addr;
+        return check_manager_geometry(table->sector_size, table->max_tables, table->write_granularity);
+    }
+
+    const manager_v1_header_t *v1 = &header->v1;
+    uint32_t crc = 0;
+    if (v1->version == MANAGER_TABLE_VERSION_V1 && read_manager_v1_crc(addr, &crc) == 0 && crc == v1->crc) {
+        *version = MANAGER_TABLE_VERSION_V1;
+        *next_addr = v1->next_manager_addr;
+        // v1没有记录几何参数，按当时固定的默认值
+        return check_manager_geometry(FLASH_SECTOR_SIZE, MAX_TABLES_ALL_SECTOR, 1);
+    }
+
+    if (table->version == MANAGER_TABLE_VERSION || v1->version == MANAGER_TABLE_VERSION_V1) {
+        TRACE_DEBUG("Manager table CRC mismatch\n");
+        return -1;
+    }
+
+    // 不支持的版本；v1表头之后还是擦除状态的是格式化时写到一半掉电
+    TRACE_ERROR("Unsupported manager table version: %u\n", table->version);
+    return (((const uint8_t*)header)[sizeof(manager_v1_header_t)] == 0xFF) ? -1 : -2;
+}
+
+// 验证管理表有效性（内联目录的表项已读入前table_count个槽位，分页目录的目录页地址已读入）
+static int validate_manager_table(const flash_manager_table_t *table) {
+    if (table->magic != MAGIC_NUMBER_MANAGER || table->version != MANAGER_TABLE_VERSION ||
+        manager_header_crc(table) != table->header_crc) {
         return -1;
     }
 
-    // CRC校验（从version字段开始计算，跳过magic和crc字段）
+    // CRC校验（从header_crc开始到映像末尾）
     uint32_t calculated_crc = calculate_manager_table_crc(table);
     if (calculated_crc != table->crc) {
         TRACE_ERROR("Manager table CRC mismatch: calculated=0x%08X, stored=0x%08X\n",
@@ -104,176 +1196,273 @@ static int validate_manager_table(const flash_manager_table_t *table) {
     return 0;
 }
 
+// 分页目录（目录页地址已通过管理表CRC校验）：延迟挂载时只记下还没读入的目录页，
+// 否则读入全部目录页，表项总数必须与表头一致（由最后读入的一页检查）
+static int read_catalog(const flash_manager_table_t *table) {
+    for (uint32_t page = 0; page < table->page_count; page++) {
+        if (g_part->catalog_dir[page] != 0) {
+            g_part->catalog_loaded[page / 8] &= (uint8_t)~(1u << (page % 8));
+            g_part->catalog_pending++;
+        }
+    }
+    if (g_lazy_mount) {
+        return 0;
+    }
+    return (g_part->catalog_pending == 0) ? check_catalog_count() : load_catalog();
+}
+
+// 读取当前格式的管理表：先读表头，再只读有效表项（内联目录）或目录页地址和各目录页（分页目录）
+static int read_manager_table(uint32_t addr, uint32_t *image_size) {
+    flash_manager_table_t *table = g_part->manager_table;
+    memset(table, 0, g_manager_size);
+    reset_catalog();
+
+    if (part_read(addr, (uint8_t*)table, sizeof(flash_manager_table_t)) != 0 ||
+        table->table_count > (uint32_t)g_max_tables || table->page_count > g_catalog_pages) {
+        return -1;
+    }
+    uint32_t body_addr = addr + sizeof(flash_manager_table_t);
+    if (g_catalog_pages > 0) {
+        if (table->page_count > 0 &&
+            part_read(body_addr, (uint8_t*)g_part->catalog_dir, table->page_count * sizeof(uint32_t)) != 0) {
+            return -1;
+        }
+    } else if (table->table_count > 0 &&
+               part_read(body_addr, (uint8_t*)table->tables, table->table_count * sizeof(flash_table_info_t)) != 0) {
+        return -1;
+    }
+    if (validate_manager_table(table) != 0) {
+        return -1;
+    }
+    if (g_catalog_pages > 0 && read_catalog(table) != 0) {
+        memset(table->tables, 0, g_max_tables * sizeof(flash_table_info_t));
+        return -1;
+    }
+    if (g_catalog_pages == 0) {
+        rebuild_name_index();
+    }
+
+    *image_size = manager_image_size(table->table_count, table->page_count);
+    return 0;
+}
+
+// 读取v1管理表并转换为当前格式：有效表项依次放入前面的槽位，预留大小为v1管理表大小；
+// v1没有分配前沿和分类写入头（为0），由restore_write_heads按数据末尾推出
+static int read_manager_v1(uint32_t addr, uint32_t *image_size) {
+    flash_manager_table_t *table = g_part->manager_table;
+    manager_v1_header_t header;
+    memset(table, 0, g_manager_size);
+    reset_catalog();
+
+    if (part_read(addr, (uint8_t*)&header, sizeof(header)) != 0) {
+        return -1;
+    }
+    uint32_t crc_start = offsetof(manager_v1_header_t, version);
+    uint32_t crc = crc32_update(CRC32_INIT, (const uint8_t*)&header + crc_start, sizeof(header) - crc_start);
+
+    // 表项经流式缓冲区分批读出，同时累加CRC
+    uint32_t batch = FF_STREAM_BUFFER_SIZE / sizeof(table_info_v1_t);
+    uint32_t entry_addr = addr + sizeof(header);
+    for (uint32_t i = 0; i < MAX_TABLES_ALL_SECTOR; i += batch) {
+        uint32_t n = (MAX_TABLES_ALL_SECTOR - i < batch) ? MAX_TABLES_ALL_SECTOR - i : batch;
+        if (part_read(entry_addr, g_stream_buf, n * sizeof(table_info_v1_t)) != 0) {
+            return -1;
+        }
+        crc = crc32_update(crc, g_stream_buf, n * sizeof(table_info_v1_t));
+        entry_addr += n * sizeof(table_info_v1_t);
+
+        for (uint32_t j = 0; j < n; j++) {
+            const table_info_v1_t *entry = (const table_info_v1_t*)g_stream_buf + j;
+            if (entry->status != TABLE_STATUS_VALID) {
+                continue;
+            }
+            flash_table_info_t *info = &table->tables[table->table_count++];
+            memcpy(info->name, entry->name, TABLE_NAME_MAX_LEN);
+            info->addr = entry->addr;
+            info->size = entry->size;
+            info->used_size = entry->used_size;
+            info->magic = entry->magic;
+            info->status = entry->status;
+            info->flags = FF_TABLE_HOT;
+        }
+    }
+
+    crc ^= CRC32_FINAL;
+    if (crc != header.crc) {
+        TRACE_ERROR("Manager table CRC mismatch: calculated=0x%08X, stored=0x%08X\n", crc, header.crc);
+        memset(table, 0, g_manager_size);
+        return -1;
+    }
+
+    table->magic = MAGIC_NUMBER_MANAGER;
+    table->version = MANAGER_TABLE_VERSION;
+    table->total_size = header.total_size;
+    table->used_size = header.used_size;
+    table->next_manager_addr = header.next_manager_addr;
+    table->next_manager_size = MANAGER_V1_SIZE;
+    table->sector_size = g_sector_size;
+    table->max_tables = (uint16_t)g_max_tables;
+    table->write_granularity = (uint16_t)g_write_granularity;
+
+    // 迁移时全部目录页都要写出
+    rebuild_name_index();
+    mark_catalog_dirty(-1);
+    *image_size = MANAGER_V1_SIZE;
+    return 0;
+}
+
+// 初始化空的管理表（位于分区开头，下一个管理表紧跟其后）
+static void init_manager_table(void) {
+    flash_manager_table_t *table = g_part->manager_table;
+    memset(table, 0, g_manager_size);
+    reset_catalog();
+    table->magic = MAGIC_NUMBER_MANAGER;
+    table->version = MANAGER_TABLE_VERSION;
+    table->total_size = g_part->total_size;
+    table->used_size = 0;
+    table->table_count = 0;
+    table->page_count = 0;
+    table->sector_size = g_sector_size;
+    table->max_tables = (uint16_t)g_max_tables;
+    table->write_granularity = (uint16_t)g_write_granularity;
+    table->next_manager_addr = manager_image_size(0, 0);
+    table->next_manager_size = manager_reserve_size(0);
+    table->next_free_sector = 1;
+    table->class_heads[FF_TABLE_HOT] = table->next_manager_addr + table->next_manager_size;
+}
+
+// 最新节点是v1时转换后立即按当前格式保存一次（迁移）。v1的预留位置通常放得下当前格式
+// （默认几何参数下24个表项也比v1小），放不下时不能写入预留位置：允许擦除时通过GC把管理表重写到地址0，
+// 否则挂载失败，不保留一个之后每次保存都会失败的挂载状态
+static int migrate_manager_table(void) {
+    flash_manager_table_t *table = g_part->manager_table;
+    uint32_t image_size = manager_image_size(table->table_count, table->page_count);
+    TRACE_INFO("Migrating manager table from v%u to v%u (%u tables)\n",
+              MANAGER_TABLE_VERSION_V1, MANAGER_TABLE_VERSION, table->table_count);
+
+    if (image_size > table->next_manager_size) {
+        TRACE_WARN("Manager table (%u bytes) exceeds v1 reserved space (%u bytes), migrating through GC\n",
+                  image_size, table->next_manager_size);
+        if (fast_flash_gc() != 0) {
+            TRACE_ERROR("No space to migrate manager table (erase allowed: %d)\n", g_allow_erase);
+            return -1;
+        }
+        return 0;
+    }
+
+    if (save_manager_table(-1) != 0) {
+        TRACE_ERROR("Failed to migrate manager table\n");
+        return -1;
+    }
+    return 0;
+}
+
+// 管理表链表遍历时保留的最近几个节点地址（最新节点整表校验失败时依次回退）
+#define MANAGER_WALK_HISTORY  4
+
 // 加载管理表（紧密排布的链表结构）
+// 先只读表头沿链表走到最新节点，再对最新节点做整表校验，每个节点只读一次表头；
+// 分页目录在整表校验时读入全部目录页；最新节点是v1格式时迁移到当前格式
 static int load_manager_table(void) {
+    FF_PROF_PHASE(FF_PHASE_MOUNT);
+    uint32_t history[MANAGER_WALK_HISTORY];
+    uint8_t history_version[MANAGER_WALK_HISTORY];
+    int history_count = 0;
     uint32_t addr = 0;
-    flash_manager_table_t candidate;
-    flash_manager_table_t last_valid_table;
-    uint32_t last_valid_addr = 0;
-    bool found_valid = false;
+    manager_header_t header;
 
     TRACE_DEBUG("Loading manager table...\n");
 
     // 重置全局状态
-    g_manager_loaded = false;
-    memset(&g_manager_table, 0, sizeof(g_manager_table));
-    g_current_sector = 0;
-    g_current_offset = 0;
+    g_part->manager_loaded = false;
+    memset(g_part->manager_table, 0, g_manager_size);
+    g_part->current_sector = 0;
+    g_part->current_offset = 0;
+    memset(g_part->class_heads, 0, sizeof(g_part->class_heads));
+    g_part->next_free_sector = 0;
 
     // 遍历管理表链表，紧密排布不需要对齐到扇区边界
-    while (addr < g_total_size) {
-        int result = g_flash_ops->read(addr, (uint8_t*)&candidate, sizeof(candidate));
-        if (result != 0) {
-            TRACE_DEBUG("Failed to read manager table at addr=0x%08X\n", addr);
+    while (addr < g_part->total_size) {
+        memset(&header, 0xFF, sizeof(header));
+        uint32_t header_size = sizeof(header);
+        if (header_size > g_part->total_size - addr) {
+            header_size = g_part->total_size - addr;
+        }
+        if (part_read(addr, (uint8_t*)&header, header_size) != 0) {
+            TRACE_DEBUG("Failed to read manager table header at addr=0x%08X\n", addr);
             break;
         }
 
         // 检查魔数
-        if (candidate.magic != MAGIC_NUMBER_MANAGER) {
+        if (header.current.magic != MAGIC_NUMBER_MANAGER) {
             TRACE_DEBUG("Invalid magic at addr=0x%08X, stopping search\n", addr);
             break;
         }
 
-        // 验证表有效性
-        if (validate_manager_table(&candidate) != 0) {
-            TRACE_DEBUG("Invalid manager table at addr=0x%08X, stopping search\n", addr);
+        uint8_t version = 0;
+        uint32_t next_addr = 0;
+        int result = validate_manager_header(addr, &header, &version, &next_addr);
+        if (result == -2 && addr == 0) {
+            // 按其他几何参数或不支持的格式格式化的设备，不能当作空白设备重新初始化
+            TRACE_ERROR("Flash was formatted with a different geometry or an unsupported format\n");
+            return -1;
+        }
+        if (result != 0) {
+            TRACE_DEBUG("Invalid manager table header at addr=0x%08X, stopping search\n", addr);
             break;
         }
 
-        // 保存当前有效表
-        memcpy(&last_valid_table, &candidate, sizeof(candidate));
-        last_valid_addr = addr;
-        found_valid = true;
-
-        // 检查下一个管理表地址是否有效
-        if (candidate.next_manager_addr == 0 ||
-            candidate.next_manager_addr >= g_total_size ||
-            candidate.next_manager_addr <= addr) {
-            // 这是最新有效的管理表
-            memcpy(&g_manager_table, &candidate, sizeof(candidate));
-            g_manager_loaded = true;
-            TRACE_INFO("g_manager_loaded %d", g_manager_loaded);
-
-            // 计算数据区域结束位置，这就是下一个写入位置
-            uint32_t data_end = addr + sizeof(flash_manager_table_t);
-            for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-                if (candidate.tables[i].status == TABLE_STATUS_VALID) {
-                    uint32_t table_end = candidate.tables[i].addr + candidate.tables[i].size;
-                    if (table_end > data_end) {
-                        data_end = table_end;
-                    }
-                }
-            }
-
-            // 跳过预留的管理表空间
-            g_current_sector = data_end / FLASH_SECTOR_SIZE;
-            g_current_offset = data_end % FLASH_SECTOR_SIZE;
+        history[history_count % MANAGER_WALK_HISTORY] = addr;
+        history_version[history_count % MANAGER_WALK_HISTORY] = version;
+        history_count++;
 
-            TRACE_INFO("Loaded manager table at 0x%08X, data end at 0x%08X, next reserved at 0x%08X\n",
-                      addr, data_end, candidate.next_manager_addr);
-            return 0;
+        // 下一个管理表地址必须递增，否则当前表就是最新的
+        if (next_addr == 0 || next_addr >= g_part->total_size || next_addr <= addr) {
+            break;
         }
+        addr = next_addr;
+    }
 
-        // 检查下一个管理表是否存在且有效
-        uint32_t next_addr = candidate.next_manager_addr;
-        flash_manager_table_t next_candidate;
-        
-        result = g_flash_ops->read(next_addr, (uint8_t*)&next_candidate, sizeof(next_candidate));
+    // 从最新节点开始整表校验（最新节点可能只写了一半）
+    int depth = history_count < MANAGER_WALK_HISTORY ? history_count : MANAGER_WALK_HISTORY;
+    for (int i = 0; i < depth; i++) {
+        uint32_t table_addr = history[(history_count - 1 - i) % MANAGER_WALK_HISTORY];
+        uint8_t version = history_version[(history_count - 1 - i) % MANAGER_WALK_HISTORY];
+        uint32_t image_size = 0;
+
+        int result = (version == MANAGER_TABLE_VERSION) ? read_manager_table(table_addr, &image_size)
+                                                        : read_manager_v1(table_addr, &image_size);
         if (result != 0) {
-            // 无法读取下一个表，说明当前表是最后一个有效表
-            TRACE_DEBUG("Failed to read next manager table at 0x%08X, using current table\n", next_addr);
-            memcpy(&g_manager_table, &candidate, sizeof(candidate));
-            g_manager_loaded = true;
-            
-            // 计算数据区域结束位置
-            uint32_t data_end = next_addr + sizeof(flash_manager_table_t);
-            for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-                if (candidate.tables[i].status == TABLE_STATUS_VALID) {
-                    uint32_t table_end = candidate.tables[i].addr + candidate.tables[i].size;
-                    if (table_end > data_end) {
-                        data_end = table_end;
-                    }
-                }
-            }
-            
-            g_current_sector = data_end / FLASH_SECTOR_SIZE;
-            g_current_offset = data_end % FLASH_SECTOR_SIZE;
-            
-            TRACE_INFO("Using last valid manager table at 0x%08X (next table unreadable)\n", addr);
-            return 0;
+            TRACE_DEBUG("Manager table at 0x%08X is invalid, falling back\n", table_addr);
+            continue;
         }
 
-        // 检查下一个表的魔数和有效性
-        if (next_candidate.magic != MAGIC_NUMBER_MANAGER || 
-            validate_manager_table(&next_candidate) != 0) {
-            // 下一个表无效，说明当前表是最后一个有效表
-            TRACE_DEBUG("Next manager table at 0x%08X is invalid, using current table\n", next_addr);
-            memcpy(&g_manager_table, &candidate, sizeof(candidate));
-            g_manager_loaded = true;
-            
-            // 计算数据区域结束位置
-            uint32_t data_end = next_addr + sizeof(flash_manager_table_t);
-            for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-                if (candidate.tables[i].status == TABLE_STATUS_VALID) {
-                    uint32_t table_end = candidate.tables[i].addr + candidate.tables[i].size;
-                    if (table_end > data_end) {
-                        data_end = table_end;
-                    }
-                }
-            }
-            
-            g_current_sector = data_end / FLASH_SECTOR_SIZE;
-            g_current_offset = data_end % FLASH_SECTOR_SIZE;
-            
-            TRACE_INFO("Using last valid manager table at 0x%08X (next table invalid)\n", addr);
-            return 0;
+        // 数据区域结束位置：预留的下一个管理表之后（预留地址无效时为当前表之后）
+        uint32_t next_addr = g_part->manager_table->next_manager_addr;
+        uint32_t data_end = table_addr + image_size;
+        if (next_addr > table_addr && next_addr < g_part->total_size) {
+            data_end = next_addr + g_part->manager_table->next_manager_size;
         }
+        restore_write_heads(g_part->manager_table, data_end);
+        g_part->manager_loaded = true;
 
-        addr = next_addr;
-        TRACE_DEBUG("Found manager table at 0x%08X, searching next at 0x%08X...\n", last_valid_addr, candidate.next_manager_addr);
-    }
-
-    if (found_valid) {
-        // 使用最后一个找到的有效表
-        memcpy(&g_manager_table, &last_valid_table, sizeof(last_valid_table));
-        g_manager_loaded = true;
-        
-        // 计算数据区域结束位置
-        uint32_t data_end = last_valid_addr + sizeof(flash_manager_table_t);
-        for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-            if (last_valid_table.tables[i].status == TABLE_STATUS_VALID) {
-                uint32_t table_end = last_valid_table.tables[i].addr + last_valid_table.tables[i].size;
-                if (table_end > data_end) {
-                    data_end = table_end;
-                }
-            }
-        }
-        
-        g_current_sector = data_end / FLASH_SECTOR_SIZE;
-        g_current_offset = data_end % FLASH_SECTOR_SIZE;
-        
-        TRACE_INFO("Using last found manager table at 0x%08X\n", last_valid_addr);
-        return 0;
+        TRACE_INFO("Loaded manager table at 0x%08X (%d in chain), data end at 0x%08X, next reserved at 0x%08X\n",
+                  table_addr, history_count, data_end, next_addr);
+        return (version == MANAGER_TABLE_VERSION) ? 0 : migrate_manager_table();
     }
 
     // 没有找到任何有效管理表，初始化新的
     TRACE_INFO("No valid manager table found, initializing new one\n");
 
-    memset(&g_manager_table, 0, sizeof(g_manager_table));
-    g_manager_table.magic = MAGIC_NUMBER_MANAGER;
-    g_manager_table.version = MANAGER_TABLE_VERSION;
-    g_manager_table.total_size = g_total_size;
-    g_manager_table.used_size = 0;
-    g_manager_table.table_count = 0;
-
     // 紧密排布：下一个管理表位置紧跟着当前管理表
-    uint32_t next_mgr = sizeof(flash_manager_table_t);
-    g_manager_table.next_manager_addr = next_mgr;
+    init_manager_table();
+    uint32_t next_mgr = g_part->manager_table->next_manager_addr;
+    g_part->next_free_sector = 1;
 
     // 初始化时需要擦除第一个扇区，临时允许擦除
     bool original_allow_erase = g_allow_erase;
     g_allow_erase = true;
-    if (g_flash_ops->erase(0, FLASH_SECTOR_SIZE) != 0) {
+    if (part_erase(0, g_sector_size) != 0) {
         TRACE_ERROR("Failed to erase first sector for manager table\n");
         g_allow_erase = original_allow_erase;
         return -1;
@@ -281,193 +1470,565 @@ static int load_manager_table(void) {
     g_allow_erase = original_allow_erase;
 
     // 写入管理表
-    g_manager_table.crc = calculate_manager_table_crc(&g_manager_table);
-    if (write_with_chunks(0, (uint8_t*)&g_manager_table, sizeof(g_manager_table)) != 0) {
+    seal_manager_table(g_part->manager_table);
+    if (write_manager_image(0) != 0) {
         TRACE_ERROR("Failed to write initial manager table\n");
         return -1;
     }
+    if (flash_sync() != 0) {
+        return -1;
+    }
+
+    // 设置写入位置在预留的管理表之后
+    g_part->current_sector = 0;
+    g_part->current_offset = next_mgr + g_part->manager_table->next_manager_size;
+
+    g_part->manager_loaded = true;
+    TRACE_INFO("g_part->manager_loaded %d", g_part->manager_loaded);
+    TRACE_INFO("Initialized new manager table at 0x%08X, g_part->current_offset at 0x%08X, next reserved at 0x%08X\n", 0, g_part->current_offset, next_mgr);
+
+    return 0;
+}
+
+// 重写需要重写的目录页（在热数据流中分配），更新RAM中的目录页地址；不需要存储的页地址清零
+static int save_catalog_pages(void) {
+    for (uint32_t page = 0; page < g_catalog_pages; page++) {
+        if (!page_bit(g_part->catalog_dirty, page)) {
+            continue;
+        }
+        uint32_t count = catalog_page_count(page);
+        if (!catalog_page_stored(page, count)) {
+            g_part->catalog_dir[page] = 0;
+            continue;
+        }
+        uint32_t addr;
+        int result = allocate_table_space(catalog_page_size(count), FF_TABLE_HOT, &addr);
+        if (result != 0) {
+            return result;
+        }
+        if (write_catalog_page(page, addr, count) != 0) {
+            TRACE_ERROR("Failed to write catalog page %u to 0x%08X\n", page, addr);
+            return -1;
+        }
+        g_part->catalog_dir[page] = addr;
+    }
+    return 0;
+}
+
+// 保存管理表（紧密排布）：写入上次预留的位置，并按当前表数量为下一次保存预留空间；
+// 分页目录先重写slot所在的目录页（slot为-1时重写全部目录页），管理表只记录目录页地址
+static int save_manager_table(int slot) {
+    FF_PROF_PHASE(FF_PHASE_MANAGER_SAVE);
+    if (!g_part->manager_loaded) {
+        TRACE_ERROR("Manager table not loaded\n");
+        return -1;
+    }
+
+    if (g_catalog_pages > 0) {
+        mark_catalog_dirty(slot);
+        int result = save_catalog_pages();
+        if (result != 0) {
+            return result;
+        }
+        g_part->manager_table->page_count = (uint16_t)catalog_used_pages();
+    }
+
+    uint32_t new_addr = g_part->manager_table->next_manager_addr;
+    uint32_t image_size = manager_image_size(g_part->manager_table->table_count, g_part->manager_table->page_count);
+    uint32_t reserve_size = manager_reserve_size(g_part->manager_table->table_count);
+
+    // 检查预留地址有效性
+    if (new_addr == 0 || new_addr >= g_part->total_size) {
+        TRACE_ERROR("Invalid next manager address: 0x%08X\n", new_addr);
+        return -1;
+    }
+    if (image_size > g_part->manager_table->next_manager_size) {
+        TRACE_ERROR("Manager table (%u bytes) exceeds reserved space (%u bytes)\n",
+                   image_size, g_part->manager_table->next_manager_size);
+        return -1;
+    }
+
+    // 预留位置不是擦除状态：上次写入管理表时掉电，留下了半写的节点。不能写入，也不能擦除它所在的扇区
+    // （当前管理表和表数据可能在同一扇区），通过GC把管理表重写到地址0，重新开始链表
+    if (!region_blank(new_addr, image_size)) {
+        if (!g_allow_erase) {
+            TRACE_ERROR("Reserved manager table at 0x%08X is not blank and erase is not allowed\n", new_addr);
+            return -2;
+        }
+        TRACE_WARN("Reserved manager table at 0x%08X is not blank, rewriting through GC\n", new_addr);
+        return collect_garbage();
+    }
+
+    // 计算下一个管理表的预留位置（在当前写入位置之后）
+    uint32_t current_write_pos = g_part->current_sector * g_sector_size + g_part->current_offset;
+    uint32_t next_reserved = current_write_pos;
+
+    // 检查是否需要跳到下一个扇区（为下一个管理表预留空间）
+    uint32_t current_offset = current_write_pos % g_sector_size;
+    uint32_t available_in_sector = g_sector_size - current_offset;
+
+    // 如果当前扇区剩余空间不足以容纳管理表，从分配前沿取新扇区
+    if (current_offset == 0 || reserve_size > available_in_sector) {
+        if (open_new_sector(&next_reserved) != 0) {
+            TRACE_ERROR("Insufficient space for next manager table\n");
+            return -2;
+        }
+    }
+
+    // 确保有足够空间
+    if (next_reserved + reserve_size > g_part->total_size) {
+        TRACE_ERROR("Insufficient space for next manager table\n");
+        return -2;
+    }
+
+    // 先更新管理表信息（包括下一个预留地址和各类别写入位置）
+    g_part->manager_table->next_manager_addr = next_reserved;
+    g_part->manager_table->next_manager_size = reserve_size;
+    g_part->manager_table->next_free_sector = g_part->next_free_sector;
+    memcpy(g_part->manager_table->class_heads, g_part->class_heads, sizeof(g_part->class_heads));
+    g_part->manager_table->class_heads[FF_TABLE_HOT] = next_reserved + reserve_size;
+    seal_manager_table(g_part->manager_table);
+
+    // 写入新管理表
+    TRACE_DEBUG("Writing new manager table to 0x%08X, size=%u\n", new_addr, image_size);
+    if (write_manager_image(new_addr) != 0) {
+        TRACE_ERROR("Failed to write new manager table to 0x%08X\n", new_addr);
+        return -1;
+    }
+
+    // 更新写入位置（在下一个预留管理表之后）
+    g_part->current_sector = (next_reserved + reserve_size) / g_sector_size;
+    g_part->current_offset = (next_reserved + reserve_size) % g_sector_size;
+
+    if (flash_sync() != 0) {
+        return -1;
+    }
+    memset(g_part->catalog_dirty, 0, (g_catalog_pages + 7) / 8);
+
+    TRACE_INFO("Saved manager table to 0x%08X, g_part->current_offset at 0x%08X, next reserved at 0x%08X\n",
+              new_addr, g_part->current_offset + g_part->current_sector * g_sector_size, next_reserved);
+
+    return 0;
+}
+
+// 查找空闲表槽（已删除的槽位可以复用）：分页目录按表名散列选择目录页，
+// 内联目录从提示位置开始，之前的槽位都是有效表
+static int find_free_table_slot(const char *name) {
+    if (g_catalog_pages > 0) {
+        return catalog_place(name);
+    }
+    for (int i = g_part->free_hint; i < g_max_tables; i++) {
+        if (g_part->manager_table->tables[i].status != TABLE_STATUS_VALID) {
+            g_part->free_hint = i;
+            return i;
+        }
+    }
+    g_part->free_hint = g_max_tables;
+    return -1;
+}
+
+// 查找表索引（表名散列索引）；延迟挂载还有目录页没读入时，读入散列页和它探查距离以内还没读入的目录页
+static int find_table_index(const char *name) {
+    if (!name) return -1;
+    int slot = name_index_find(name);
+    if (slot >= 0 || g_part->catalog_pending == 0) {
+        return slot;
+    }
+
+    uint32_t home = name_hash(name) % g_catalog_pages;
+    if (load_catalog_page(home) != 0) {
+        return -1;
+    }
+    for (uint32_t n = 1; n <= g_part->catalog_probe[home]; n++) {
+        if (load_catalog_page((home + n) % g_catalog_pages) != 0) {
+            return -1;
+        }
+    }
+    return name_index_find(name);
+}
 
-    // 设置写入位置在预留的管理表之后
-    g_current_sector = 0;
-    g_current_offset = next_mgr + sizeof(flash_manager_table_t);
+// 从分配前沿取一个新扇区（允许擦除时先擦除）
+static int open_new_sector(uint32_t *out_addr) {
+    uint32_t sector_start = g_part->next_free_sector * g_sector_size;
+
+    if (sector_start + g_sector_size > g_part->total_size) {
+        TRACE_ERROR("No free sector left (next free sector %u)\n", g_part->next_free_sector);
+        return -2;
+    }
 
-    g_manager_loaded = true;
-    TRACE_INFO("g_manager_loaded %d", g_manager_loaded);
-    TRACE_INFO("Initialized new manager table at 0x%08X, g_current_offset at 0x%08X, next reserved at 0x%08X\n", 0, g_current_offset, next_mgr);
+    if (g_allow_erase) {
+        if (part_erase(sector_start, g_sector_size) != 0) {
+            TRACE_ERROR("Failed to erase sector at 0x%08X\n", sector_start);
+            return -2;
+        }
+    }
 
+    g_part->next_free_sector++;
+    *out_addr = sector_start;
     return 0;
 }
 
-// 保存管理表（紧密排布）
-static int save_manager_table(void) {
-    if (!g_manager_loaded) {
-        TRACE_ERROR("Manager table not loaded\n");
+/// 分配表空间（确保不跨扇区，其他时候紧密排布；不同温度类别使用不同的打开扇区）
+static int allocate_table_space(uint32_t size, uint8_t flags, uint32_t *out_addr) {
+    FF_PROF_PHASE(FF_PHASE_ALLOCATE);
+    if (!out_addr || size == 0) {
         return -1;
     }
 
-    uint32_t new_addr = g_manager_table.next_manager_addr;
-
-    // 检查预留地址有效性
-    if (new_addr == 0 || new_addr >= g_total_size) {
-        TRACE_ERROR("Invalid next manager address: 0x%08X\n", new_addr);
+    if (size > g_sector_size) {
+        TRACE_ERROR("Table size %u exceeds sector size %u\n", size, g_sector_size);
         return -1;
     }
 
-    // 计算下一个管理表的预留位置（在当前写入位置之后）
-    uint32_t current_write_pos = g_current_sector * FLASH_SECTOR_SIZE + g_current_offset;
-    uint32_t next_reserved = current_write_pos;
+    // 占用空间按编程粒度对齐，保证后续表的起始地址对齐
+    size = align_to_write_granularity(size);
 
-    // 检查是否需要跳到下一个扇区（为下一个管理表预留空间）
-    uint32_t current_sector = current_write_pos / FLASH_SECTOR_SIZE;
-    uint32_t current_offset = current_write_pos % FLASH_SECTOR_SIZE;
-    uint32_t available_in_sector = FLASH_SECTOR_SIZE - current_offset;
+    uint8_t table_class = flags & FF_TABLE_CLASS_MASK;
 
-    // 如果当前扇区剩余空间不足以容纳管理表，跳到下一个扇区
-    if (sizeof(flash_manager_table_t) > available_in_sector) {
-        current_sector++;
-        next_reserved = current_sector * FLASH_SECTOR_SIZE;
-    }
+    // 当前类别的空闲地址（热数据 = g_part->current_sector * g_sector_size + g_part->current_offset）
+    uint32_t free_addr = (table_class == FF_TABLE_HOT)
+                         ? g_part->current_sector * g_sector_size + g_part->current_offset
+                         : g_part->class_heads[table_class];
+    uint32_t offset_in_sector = free_addr % g_sector_size;
 
-    // 确保有足够空间
-    if (next_reserved + sizeof(flash_manager_table_t) > g_total_size) {
-        TRACE_ERROR("Insufficient space for next manager table\n");
-        return -1;
-    }
+    // 没有打开的扇区（正好在扇区边界上）或剩余空间不足时，需要从分配前沿取新扇区
+    bool need_sector = (offset_in_sector == 0 || offset_in_sector + size > g_sector_size);
 
-    // 检查是否需要擦除目标区域
-    bool need_erase = false;
-    if (g_allow_erase) {
-        // 检查目标地址是否已经被使用过（非0xFF状态）
-        uint8_t test_byte;
-        if (g_flash_ops->read(new_addr, &test_byte, 1) == 0 && test_byte != 0xFF) {
-            need_erase = true;
-        }
+    // 挂载后第一次使用打开扇区时确认剩余部分是空白的：掉电前写到一半的表没有记入管理表，
+    // 它占用的位置会被再次分配，写入必然失败，这时放弃这个扇区
+    if (!need_sector && !(g_part->heads_checked & (1u << table_class)) &&
+        !region_blank(free_addr, g_sector_size - offset_in_sector)) {
+        TRACE_WARN("Open sector at 0x%08X holds an interrupted write, moving class %u to a new sector\n",
+                  free_addr, table_class);
+        need_sector = true;
     }
 
-    // 如果需要擦除且允许擦除，则擦除目标扇区
-    if (need_erase && g_allow_erase) {
-        uint32_t start_sector = new_addr / FLASH_SECTOR_SIZE;
-        uint32_t end_addr = new_addr + sizeof(flash_manager_table_t);
-        uint32_t end_sector = (end_addr - 1) / FLASH_SECTOR_SIZE;  // 修正边界计算
+    // 分配之后还必须能放下下一个管理表（按新建一张表后的预留大小），否则保存管理表会失败而留下不一致的状态
+    uint32_t reserve_size = manager_reserve_size(g_part->manager_table->table_count + 1u);
+    uint32_t hot_head = g_part->current_sector * g_sector_size + g_part->current_offset;
+    if (table_class == FF_TABLE_HOT) {
+        hot_head = need_sector ? g_part->next_free_sector * g_sector_size + size : free_addr + size;
+    }
+    uint32_t hot_offset = hot_head % g_sector_size;
+    bool need_manager_sector = (hot_offset == 0 || hot_offset + reserve_size > g_sector_size);
+    uint32_t free_sectors = g_part->total_size / g_sector_size - g_part->next_free_sector;
+    if ((uint32_t)need_sector + (uint32_t)need_manager_sector > free_sectors) {
+        TRACE_ERROR("Insufficient flash space for table of size %u\n", size);
+        return -2;
+    }
 
-        for (uint32_t sector = start_sector; sector <= end_sector; sector++) {
-            if (g_flash_ops->erase(sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE) != 0) {
-                TRACE_ERROR("Failed to erase sector %u for manager table\n", sector);
-                return -2;  // 表示需要擦除但不允许
-            }
+    if (need_sector) {
+        int result = open_new_sector(&free_addr);
+        if (result != 0) {
+            TRACE_ERROR("Insufficient flash space for table of size %u\n", size);
+            return result;
         }
-        TRACE_DEBUG("Erased sectors %u-%u for new manager table at 0x%08X\n", 
-                   start_sector, end_sector, new_addr);
     }
 
-    // 先更新管理表信息（包括下一个预留地址）
-    g_manager_table.next_manager_addr = next_reserved;
-    g_manager_table.crc = calculate_manager_table_crc(&g_manager_table);
+    *out_addr = free_addr;
 
-    // 写入新管理表
-    TRACE_DEBUG("Writing new manager table to 0x%08X, size=%u\n", new_addr, sizeof(g_manager_table));
-    if (write_with_chunks(new_addr, (uint8_t*)&g_manager_table, sizeof(g_manager_table)) != 0) {
-        TRACE_ERROR("Failed to write new manager table to 0x%08X\n", new_addr);
-        return -1;
+    // 更新该类别的空闲位置（指向新表之后）
+    if (table_class == FF_TABLE_HOT) {
+        g_part->current_sector = (*out_addr + size) / g_sector_size;
+        g_part->current_offset = (*out_addr + size) % g_sector_size;
+    } else {
+        g_part->class_heads[table_class] = *out_addr + size;
     }
+    g_part->heads_checked |= (uint8_t)(1u << table_class);
 
-    // 更新写入位置（在下一个预留管理表之后）
-    g_current_sector = (next_reserved + sizeof(flash_manager_table_t)) / FLASH_SECTOR_SIZE;
-    g_current_offset = (next_reserved + sizeof(flash_manager_table_t)) % FLASH_SECTOR_SIZE;
-
-    TRACE_INFO("Saved manager table to 0x%08X, g_current_offset at 0x%08X, next reserved at 0x%08X\n",
-              new_addr, g_current_offset + g_current_sector * FLASH_SECTOR_SIZE, next_reserved);
+    TRACE_DEBUG("Allocated table space: addr=0x%08X, size=%u, class=%u, next free sector=%u\n",
+                *out_addr, size, table_class, g_part->next_free_sector);
 
     return 0;
 }
 
-// 查找空闲表槽
-static int find_free_table_slot(void) {
-    for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-        if (g_manager_table.tables[i].status == TABLE_STATUS_INVALID) {
-            return i;
+// 根据最新管理表恢复各类别的写入位置
+static void restore_write_heads(const flash_manager_table_t *table, uint32_t data_end) {
+    // 热数据写入位置：在预留的管理表之后，且在所有热数据表之后
+    for (int i = 0; i < g_max_tables; i++) {
+        if (table->tables[i].status == TABLE_STATUS_VALID &&
+            (table->tables[i].flags & FF_TABLE_CLASS_MASK) == FF_TABLE_HOT) {
+            uint32_t table_end = align_to_write_granularity(table->tables[i].addr + table->tables[i].used_size);
+            if (table_end > data_end) {
+                data_end = table_end;
+            }
         }
     }
-    return -1;
+
+    g_part->current_sector = data_end / g_sector_size;
+    g_part->current_offset = data_end % g_sector_size;
+
+    memcpy(g_part->class_heads, table->class_heads, sizeof(g_part->class_heads));
+    g_part->class_heads[FF_TABLE_HOT] = 0;
+    g_part->heads_checked = 0;
+    g_part->next_free_sector = table->next_free_sector;
+
+    // 分配前沿必须在所有打开扇区之后
+    uint32_t min_free = (data_end + g_sector_size - 1) / g_sector_size;
+    for (int c = 0; c < FF_TABLE_CLASS_COUNT; c++) {
+        uint32_t head_end = (g_part->class_heads[c] + g_sector_size - 1) / g_sector_size;
+        if (head_end > min_free) {
+            min_free = head_end;
+        }
+    }
+    if (g_part->next_free_sector < min_free) {
+        g_part->next_free_sector = min_free;
+    }
 }
 
-// 查找表索引
-static int find_table_index(const char *name) {
-    if (!name) return -1;
+// 内存区需要的大小：各分区的管理表、目录索引和统计常驻，GC临时数组按最大分区计算（同一时间只有一个分区在GC）
+static uint32_t arena_required(int count, uint32_t max_tables, uint32_t manager_size, uint32_t max_sectors) {
+    uint32_t persistent = FF_ARENA_ALIGN(manager_size) + FF_ARENA_ALIGN(max_tables * sizeof(flash_io_stats_t)) +
+                          FF_ARENA_ALIGN(FF_CATALOG_RAM_SIZE(max_tables));
+    uint32_t gc_scratch = 2 * FF_ARENA_ALIGN(max_tables * FF_ARENA_GC_ITEM_SIZE) +
+                          FF_ARENA_ALIGN(FF_CATALOG_PAGES(max_tables) * sizeof(uint32_t)) +
+                          FF_ARENA_ALIGN((max_sectors + 7) / 8) +
+                          FF_ARENA_ALIGN(max_sectors * sizeof(uint32_t));
+    return count * persistent + gc_scratch;
+}
 
-    for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-        if (g_manager_table.tables[i].status == TABLE_STATUS_VALID &&
-            strncmp(g_manager_table.tables[i].name, name, TABLE_NAME_MAX_LEN) == 0) {
-            return i;
+// 释放当前分区状态（内存区中的缓冲区随内存区整体重新切分）
+static void release_partitions(void) {
+#ifndef FAST_FLASH_NO_HEAP
+    if (g_partitions_on_heap) {
+        for (int i = 0; i < FF_MAX_PARTITIONS; i++) {
+            free(g_partitions[i].manager_table);
+            free(g_partitions[i].table_stats);
+            free(g_partitions[i].catalog_dir);
         }
     }
-    return -1;
+#endif
+    memset(g_partitions, 0, sizeof(g_partitions));
+    g_partitions_on_heap = false;
 }
 
-/// 分配表空间（确保不跨扇区，其他时候紧密排布）
-static int allocate_table_space(uint32_t size, uint32_t *out_addr) {
-    if (!out_addr || size == 0) {
-        return -1;
+// === 公共API实现 ===
+
+int fast_flash_set_arena(void *buf, uint32_t size) {
+    if (!buf) {
+        g_arena = NULL;
+        g_arena_size = 0;
+        g_arena_used = 0;
+        g_arena_peak = 0;
+        return 0;
     }
 
-    if (size > FLASH_SECTOR_SIZE) {
-        TRACE_ERROR("Table size %u exceeds sector size %u\n", size, FLASH_SECTOR_SIZE);
+    // 起始地址按8字节对齐
+    uint32_t skip = (uint32_t)(-(uintptr_t)buf & 7u);
+    if (size <= skip) {
+        TRACE_ERROR("Arena too small: %u bytes\n", size);
         return -1;
     }
+    g_arena = (uint8_t*)buf + skip;
+    g_arena_size = (size - skip) & ~7u;
+    g_arena_used = 0;
+    g_arena_peak = 0;
+    return 0;
+}
 
-    // 当前空闲地址 = g_current_sector * FLASH_SECTOR_SIZE + g_current_offset
-    uint32_t free_addr = g_current_sector * FLASH_SECTOR_SIZE + g_current_offset;
-    uint32_t sector_start = (free_addr / FLASH_SECTOR_SIZE) * FLASH_SECTOR_SIZE;
-    uint32_t offset_in_sector = free_addr % FLASH_SECTOR_SIZE;
-
-    // 检查当前扇区剩余空间是否足够
-    if (offset_in_sector + size > FLASH_SECTOR_SIZE) {
-        // 跨扇区了，跳到下一个扇区开头
-        sector_start += FLASH_SECTOR_SIZE;
-        offset_in_sector = 0;
+uint32_t fast_flash_arena_size(const flash_partition_t *partitions, int count, const flash_geometry_t *geometry) {
+    if (!partitions || count <= 0 || count > FF_MAX_PARTITIONS) {
+        return 0;
+    }
 
-        // 检查总空间
-        if (sector_start + size > g_total_size) {
-            TRACE_ERROR("Insufficient flash space for table of size %u\n", size);
-            return -2;
-        }
+    uint32_t sector_size = (geometry && geometry->sector_size) ? geometry->sector_size : FLASH_SECTOR_SIZE;
+    uint32_t granularity = (geometry && geometry->write_granularity) ? geometry->write_granularity : 1;
+    uint32_t max_tables = (geometry && geometry->max_tables) ? geometry->max_tables : MAX_TABLES_ALL_SECTOR;
+    if (sector_size == 0 || granularity > FF_MAX_WRITE_GRANULARITY || max_tables > FF_MAX_TABLES_LIMIT) {
+        return 0;
+    }
 
-        // 擦除新扇区（如果允许）
-        if (g_allow_erase) {
-            if (g_flash_ops->erase(sector_start, FLASH_SECTOR_SIZE) != 0) {
-                TRACE_ERROR("Failed to erase sector at 0x%08X\n", sector_start);
-                return -2;
-            }
+    uint32_t manager_size = sizeof(flash_manager_table_t) + max_tables * sizeof(flash_table_info_t);
+    manager_size = (manager_size + granularity - 1) & ~(granularity - 1);
+    uint32_t max_sectors = 0;
+    for (int i = 0; i < count; i++) {
+        if (partitions[i].size / sector_size > max_sectors) {
+            max_sectors = partitions[i].size / sector_size;
         }
     }
+    return arena_required(count, max_tables, manager_size, max_sectors);
+}
 
-    *out_addr = sector_start + offset_in_sector;
-
-    // 更新全局空闲位置（指向新表之后）
-    g_current_sector = (*out_addr + size) / FLASH_SECTOR_SIZE;
-    g_current_offset = (*out_addr + size) % FLASH_SECTOR_SIZE;
-
-    TRACE_DEBUG("Allocated table space: addr=0x%08X, size=%u, next free=0x%08X\n",
-                *out_addr, size,
-                g_current_sector * FLASH_SECTOR_SIZE + g_current_offset);
+void fast_flash_get_arena_usage(uint32_t *used, uint32_t *peak) {
+    if (used) {
+        *used = g_arena_used;
+    }
+    if (peak) {
+        *peak = g_arena_peak;
+    }
+}
 
-    return 0;
+int fast_flash_init(const flash_ops_t *ops, uint32_t total_size, bool allow_erase) {
+    return fast_flash_init_ex(ops, total_size, allow_erase, NULL);
 }
 
-// === 公共API实现 ===
+int fast_flash_init_ex(const flash_ops_t *ops, uint32_t total_size, bool allow_erase,
+                       const flash_geometry_t *geometry) {
+    // 整个Flash作为一个未命名分区
+    flash_partition_t partition;
+    memset(&partition, 0, sizeof(partition));
+    partition.offset = 0;
+    partition.size = total_size;
+    return fast_flash_init_partitions(ops, &partition, 1, allow_erase, geometry);
+}
 
-int fast_flash_init(const flash_ops_t *ops, uint32_t total_size, bool allow_erase) {
-#ifdef RS_FLASH_DEBUG_OFF
-#else
-    flash_log_set_level(LOG_LEVEL_DEBUG);
-#endif
+int fast_flash_init_partitions(const flash_ops_t *ops, const flash_partition_t *partitions, int count,
+                               bool allow_erase, const flash_geometry_t *geometry) {
+    API_BEGIN(FF_API_INIT);
+    FF_RECORD_INIT(partitions, count, allow_erase, geometry);
     if (!ops || !ops->init || !ops->read || !ops->write || !ops->erase) {
         TRACE_ERROR("Invalid flash operations\n");
         return -1;
     }
 
+    // 几何参数：字段为0时使用默认值
+    uint32_t sector_size = (geometry && geometry->sector_size) ? geometry->sector_size : FLASH_SECTOR_SIZE;
+    uint32_t granularity = (geometry && geometry->write_granularity) ? geometry->write_granularity : 1;
+    uint32_t max_tables = (geometry && geometry->max_tables) ? geometry->max_tables : MAX_TABLES_ALL_SECTOR;
+    uint32_t page_size = (geometry && geometry->page_size) ? geometry->page_size
+                         : (sector_size < FLASH_WRITE_CHUNK_SIZE ? sector_size : FLASH_WRITE_CHUNK_SIZE);
+
+    if (sector_size == 0 || (sector_size & (sector_size - 1)) != 0) {
+        TRACE_ERROR("Invalid sector size %u\n", sector_size);
+        return -1;
+    }
+    if ((granularity & (granularity - 1)) != 0 || granularity > FF_MAX_WRITE_GRANULARITY) {
+        TRACE_ERROR("Invalid write granularity %u\n", granularity);
+        return -1;
+    }
+    if ((page_size & (page_size - 1)) != 0 || page_size < granularity || page_size > sector_size) {
+        TRACE_ERROR("Invalid page size %u\n", page_size);
+        return -1;
+    }
+    if (max_tables > FF_MAX_TABLES_LIMIT) {
+        TRACE_ERROR("Too many tables: %u (limit %u)\n", max_tables, FF_MAX_TABLES_LIMIT);
+        return -1;
+    }
+
+    // 管理表大小按编程粒度对齐，扇区0必须放得下当前管理表和预留的下一个管理表；
+    // 分页目录的管理表只存目录页地址，一个目录页也必须放进一个扇区
+    uint32_t manager_size = sizeof(flash_manager_table_t) + max_tables * sizeof(flash_table_info_t);
+    manager_size = (manager_size + granularity - 1) & ~(granularity - 1);
+    uint32_t catalog_pages = FF_CATALOG_PAGES(max_tables);
+    uint32_t image_size = (catalog_pages > 0) ? sizeof(flash_manager_table_t) + catalog_pages * sizeof(uint32_t)
+                                              : manager_size;
+    image_size = (image_size + granularity - 1) & ~(granularity - 1);
+    uint32_t page_record_size = sizeof(flash_catalog_page_t) + FF_CATALOG_PAGE_TABLES * sizeof(flash_table_info_t);
+    if (image_size * 2 > sector_size || (catalog_pages > 0 && page_record_size + image_size > sector_size)) {
+        TRACE_ERROR("Manager table (%u bytes) too large for sector size %u\n", image_size, sector_size);
+        return -1;
+    }
+
+    // 擦除粒度：扇区擦除总是可用，其余必须是扇区大小的整数倍并从小到大排列
+    uint32_t erase_sizes[FF_MAX_ERASE_SIZES] = { sector_size };
+    int erase_size_count = 1;
+    if (geometry) {
+        for (int i = 0; i < FF_MAX_ERASE_SIZES && geometry->erase_sizes[i] != 0; i++) {
+            uint32_t erase_size = geometry->erase_sizes[i];
+            if (erase_size % sector_size != 0 || erase_size < erase_sizes[erase_size_count - 1]) {
+                TRACE_ERROR("Invalid erase size %u (sector size %u)\n", erase_size, sector_size);
+                return -1;
+            }
+            if (erase_size > erase_sizes[erase_size_count - 1] && erase_size_count < FF_MAX_ERASE_SIZES) {
+                erase_sizes[erase_size_count++] = erase_size;
+            }
+        }
+    }
+
+    // 分区：按扇区对齐，至少两个扇区（GC需要暂存扇区），互不重叠且名称不同
+    if (!partitions || count <= 0 || count > FF_MAX_PARTITIONS) {
+        TRACE_ERROR("Invalid partition count %d (limit %d)\n", count, FF_MAX_PARTITIONS);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        const flash_partition_t *part = &partitions[i];
+        if (part->offset % sector_size != 0 || part->size % sector_size != 0 ||
+            part->size < 2 * sector_size || part->offset + part->size < part->offset) {
+            TRACE_ERROR("Invalid partition '%.*s': offset=0x%08X size=%u\n",
+                       TABLE_NAME_MAX_LEN, part->name, part->offset, part->size);
+            return -1;
+        }
+        for (int j = 0; j < i; j++) {
+            const flash_partition_t *other = &partitions[j];
+            if (part->offset < other->offset + other->size && other->offset < part->offset + part->size) {
+                TRACE_ERROR("Partition '%.*s' overlaps '%.*s'\n", TABLE_NAME_MAX_LEN, part->name,
+                           TABLE_NAME_MAX_LEN, other->name);
+                return -1;
+            }
+            if (strncmp(part->name, other->name, TABLE_NAME_MAX_LEN) == 0) {
+                TRACE_ERROR("Duplicate partition name '%.*s'\n", TABLE_NAME_MAX_LEN, part->name);
+                return -1;
+            }
+        }
+    }
+
+    // 参数全部有效后再提交，管理表缓冲区按新的大小重新分配；
+    // 使用内存区时先检查大小够用，再释放旧的分区状态、从头重新切分
+    if (g_arena) {
+        uint32_t max_sectors = 0;
+        for (int i = 0; i < count; i++) {
+            if (partitions[i].size / sector_size > max_sectors) {
+                max_sectors = partitions[i].size / sector_size;
+            }
+        }
+        uint32_t required = arena_required(count, max_tables, manager_size, max_sectors);
+        if (required > g_arena_size) {
+            TRACE_ERROR("Arena too small: %u bytes, need %u\n", g_arena_size, required);
+            return -1;
+        }
+        release_partitions();
+        g_arena_used = 0;
+        g_arena_peak = 0;
+    }
+
+    flash_manager_table_t *manager_tables[FF_MAX_PARTITIONS] = { NULL };
+    flash_io_stats_t *table_stats[FF_MAX_PARTITIONS] = { NULL };
+    uint8_t *catalogs[FF_MAX_PARTITIONS] = { NULL };
+    uint32_t index_size = FF_NAME_INDEX_SIZE(max_tables);
+    for (int i = 0; i < count; i++) {
+        manager_tables[i] = (flash_manager_table_t*)ff_alloc(manager_size);
+        table_stats[i] = (flash_io_stats_t*)ff_alloc(max_tables * sizeof(flash_io_stats_t));
+        catalogs[i] = (uint8_t*)ff_alloc(FF_CATALOG_RAM_SIZE(max_tables));
+        if (!manager_tables[i] || !table_stats[i] || !catalogs[i]) {
+            TRACE_ERROR("Memory allocation failed for manager table (%u bytes)\n", manager_size);
+            for (int j = 0; j <= i; j++) {
+                ff_free(manager_tables[j]);
+                ff_free(table_stats[j]);
+                ff_free(catalogs[j]);
+            }
+            arena_release(0);
+            return -1;
+        }
+    }
+    release_partitions();
+    g_partitions_on_heap = (g_arena == NULL);
+    for (int i = 0; i < count; i++) {
+        partition_state_t *part = &g_partitions[i];
+        strncpy(part->name, partitions[i].name, TABLE_NAME_MAX_LEN);
+        part->base = partitions[i].offset;
+        part->total_size = partitions[i].size;
+        part->manager_table = manager_tables[i];
+        part->table_stats = table_stats[i];
+        part->catalog_dir = (uint32_t*)catalogs[i];
+        part->name_index = (uint16_t*)(catalogs[i] + catalog_pages * sizeof(uint32_t));
+        part->catalog_dirty = catalogs[i] + catalog_pages * sizeof(uint32_t) + index_size * sizeof(uint16_t);
+        part->catalog_loaded = part->catalog_dirty + (catalog_pages + 7) / 8;
+        part->catalog_probe = part->catalog_loaded + (catalog_pages + 7) / 8;
+    }
+    g_partition_count = count;
+    g_part = &g_partitions[0];
+    g_manager_size = manager_size;
+    g_catalog_pages = catalog_pages;
+    g_name_index_size = index_size;
+
+    g_sector_size = sector_size;
+    g_page_size = page_size;
+    g_write_granularity = granularity;
+    g_max_tables = (int)max_tables;
+    memcpy(g_erase_sizes, erase_sizes, sizeof(g_erase_sizes));
+    g_erase_size_count = erase_size_count;
+
     g_flash_ops = ops;
-    g_total_size = total_size;
     g_allow_erase = allow_erase;
 
     // 初始化Flash设备
@@ -476,18 +2037,52 @@ int fast_flash_init(const flash_ops_t *ops, uint32_t total_size, bool allow_eras
         return -1;
     }
 
-    // 加载管理表
-    if (load_manager_table() != 0) {
-        TRACE_ERROR("Failed to load manager table\n");
-        return -1;
+    // 依次加载各分区的管理表
+    for (int i = 0; i < count; i++) {
+        g_part = &g_partitions[i];
+        if (load_manager_table() != 0) {
+            TRACE_ERROR("Failed to load manager table of partition '%.*s'\n", TABLE_NAME_MAX_LEN, g_part->name);
+            g_part = &g_partitions[0];
+            return -1;
+        }
     }
+    g_part = &g_partitions[0];
 
-    TRACE_INFO("Fast Flash Core initialized successfully\n");
+    TRACE_INFO("Fast Flash Core initialized successfully (%d partitions)\n", count);
     return 0;
 }
 
+int fast_flash_select_partition(const char *name) {
+    FF_RECORD(FF_REC_SELECT_PARTITION, name, 0, 0, 0, NULL, 0);
+    if (!name) {
+        return -1;
+    }
+
+    for (int i = 0; i < g_partition_count; i++) {
+        if (strncmp(g_partitions[i].name, name, TABLE_NAME_MAX_LEN) == 0) {
+            g_part = &g_partitions[i];
+            g_stats_table = -1;
+            return 0;
+        }
+    }
+
+    TRACE_ERROR("Partition '%s' not found\n", name);
+    return -1;
+}
+
 int fast_flash_create_table(const char *name, uint32_t struct_size, uint32_t max_structs) {
-    if (!name || !g_manager_loaded) {
+    return fast_flash_create_table_ex(name, struct_size, max_structs, FF_TABLE_HOT);
+}
+
+int fast_flash_create_table_ex(const char *name, uint32_t struct_size, uint32_t max_structs, uint8_t flags) {
+    API_BEGIN(FF_API_CREATE_TABLE);
+    FF_RECORD(FF_REC_CREATE_TABLE, name, struct_size, max_structs, flags, NULL, 0);
+    if (!name || !g_part->manager_loaded) {
+        return -1;
+    }
+
+    if ((flags & ~FF_TABLE_CLASS_MASK) != 0 || (flags & FF_TABLE_CLASS_MASK) >= FF_TABLE_CLASS_COUNT) {
+        TRACE_ERROR("Invalid table flags 0x%02X for '%s'\n", flags, name);
         return -1;
     }
 
@@ -498,18 +2093,20 @@ int fast_flash_create_table(const char *name, uint32_t struct_size, uint32_t max
     }
 
     // 查找空闲槽
-    int slot = find_free_table_slot();
+    int slot = find_free_table_slot(name);
     if (slot < 0) {
         TRACE_ERROR("No free table slots available\n");
         return -1;
     }
+    memset(&g_part->table_stats[slot], 0, sizeof(flash_io_stats_t));
+    stats_set_table(slot);
 
     // 计算表大小（只需要表头大小，不预分配数据空间）
     uint32_t table_size = sizeof(table_header_t);
 
     // 分配空间
     uint32_t table_addr;
-    int result = allocate_table_space(table_size, &table_addr);
+    int result = allocate_table_space(table_size, flags, &table_addr);
     if (result != 0) {
         TRACE_DEBUG("Failed to allocate space for table '%s'\n", name);
         return result;  // -2表示空间不足
@@ -533,7 +2130,7 @@ int fast_flash_create_table(const char *name, uint32_t struct_size, uint32_t max
     }
 
     // 更新管理表信息
-    flash_table_info_t *table_info = &g_manager_table.tables[slot];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[slot];
     strncpy(table_info->name, name, TABLE_NAME_MAX_LEN - 1);
     table_info->name[TABLE_NAME_MAX_LEN - 1] = '\0';
     table_info->addr = table_addr;
@@ -541,25 +2138,27 @@ int fast_flash_create_table(const char *name, uint32_t struct_size, uint32_t max
     table_info->used_size = sizeof(header);
     table_info->magic = MAGIC_NUMBER_TABLE;
     table_info->status = TABLE_STATUS_VALID;
-    table_info->reserved = 0;
-    table_info->next_manager_addr = 0;
+    table_info->flags = flags;
+    name_index_insert(slot);
 
-    g_manager_table.table_count++;
-    g_manager_table.used_size += sizeof(table_header_t);  // 只增加表头大小
+    g_part->manager_table->table_count++;
+    g_part->manager_table->used_size += sizeof(table_header_t);  // 只增加表头大小
 
     // 保存管理表
-    result = save_manager_table();
+    result = save_manager_table(slot);
     if (result != 0) {
         TRACE_DEBUG("Failed to save manager table after creating '%s'\n", name);
         return result;
     }
 
-    TRACE_DEBUG("Created table '%s' at addr=0x%08X, size=%u\n", name, table_addr, table_size);
+    TRACE_DEBUG("Created table '%s' at addr=0x%08X, size=%u, flags=0x%02X\n", name, table_addr, table_size, flags);
     return 0;
 }
 
 int fast_flash_delete_table(const char *name) {
-    if (!name || !g_manager_loaded) {
+    API_BEGIN(FF_API_DELETE_TABLE);
+    FF_RECORD(FF_REC_DELETE_TABLE, name, 0, 0, 0, NULL, 0);
+    if (!name || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -568,23 +2167,33 @@ int fast_flash_delete_table(const char *name) {
         TRACE_DEBUG("Table '%s' not found\n", name);
         return -1;
     }
+    stats_set_table(idx);
 
     // 标记为删除
-    g_manager_table.tables[idx].status = TABLE_STATUS_DELETED;
-    g_manager_table.table_count--;
+    name_index_remove(idx);
+    g_part->manager_table->tables[idx].status = TABLE_STATUS_DELETED;
+    g_part->manager_table->table_count--;
 
-    int result = save_manager_table();
+    int result = save_manager_table(idx);
     if (result != 0) {
+        // 管理表没有写入，恢复RAM中的状态（-2表示空间不足，GC后可重试）
+        g_part->manager_table->tables[idx].status = TABLE_STATUS_VALID;
+        g_part->manager_table->table_count++;
+        name_index_insert(idx);
         TRACE_DEBUG("Failed to save manager table after deleting '%s'\n", name);
         return result;
     }
 
+    if (idx < g_part->free_hint) {
+        g_part->free_hint = idx;
+    }
     TRACE_DEBUG("Deleted table '%s'\n", name);
     return 0;
 }
 
-int fast_flash_write_table_data(const char *table_name, const void *data, uint32_t size) {
-    if (!table_name || !data || !g_manager_loaded) {
+// 在表末尾追加一条记录（整表重写到新位置）
+static int append_record(const char *table_name, const void *data, uint32_t size) {
+    if (!table_name || !data || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -593,12 +2202,13 @@ int fast_flash_write_table_data(const char *table_name, const void *data, uint32
         TRACE_DEBUG("Table '%s' not found\n", table_name);
         return -1;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
 
     // 读取当前表头获取结构信息
     table_header_t header;
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         TRACE_DEBUG("Failed to read table header for '%s'\n", table_name);
         return -1;
     }
@@ -615,70 +2225,62 @@ int fast_flash_write_table_data(const char *table_name, const void *data, uint32
 
     // 分配新的表空间（表头 + 新的数据）
     uint32_t new_table_addr;
-    int result = allocate_table_space(sizeof(table_header_t) + new_data_len, &new_table_addr);
+    int result = allocate_table_space(sizeof(table_header_t) + new_data_len, table_info->flags, &new_table_addr);
     if (result != 0) {
         TRACE_DEBUG("Failed to allocate space for expanded table '%s'\n", table_name);
         return result;
     }
 
-    // 分配临时缓冲区用于存储所有数据（旧数据 + 新数据）
-    uint8_t *all_data = malloc(new_data_len);
-    if (!all_data) {
-        TRACE_DEBUG("Memory allocation failed for table '%s'\n", table_name);
-        return -1;
-    }
+    // 旧数据从原位置流式搬运，新记录追加在末尾
+    stream_source_t source = {
+        .src = table_info->addr + sizeof(header),
+        .struct_size = header.struct_size,
+        .patch = data,
+        .patch_offset = header.data_len,
+        .patch_size = size,
+    };
 
-    // 读取旧数据（如果有的话）
-    if (header.data_len > 0) {
-        if (g_flash_ops->read(table_info->addr + sizeof(header), all_data, header.data_len) != 0) {
-            TRACE_DEBUG("Failed to read old data for table '%s'\n", table_name);
-            free(all_data);
-            return -1;
-        }
+    // 器件支持内部复制时新CRC由旧CRC和新记录推导，旧数据不必读出；否则在搬运时计算
+    if (g_flash_ops->copy) {
+        header.data_crc = crc32_combine(header.data_crc, calculate_crc32(data, size), size);
+        source.crc_derived = true;
     }
 
-    // 添加新数据到缓冲区末尾
-    memcpy(all_data + header.data_len, data, size);
-
-    // 更新表头
+    // 更新表头并写入
     header.data_len = new_data_len;
     header.struct_nums = new_data_len / header.struct_size;
-    header.data_crc = calculate_crc32(all_data, new_data_len);
-
-    // 写入新表头
-    if (write_with_chunks(new_table_addr, (uint8_t*)&header, sizeof(header)) != 0) {
-        TRACE_DEBUG("Failed to write new table header for '%s'\n", table_name);
-        free(all_data);
-        return -1;
-    }
-
-    // 写入所有数据
-    if (write_with_chunks(new_table_addr + sizeof(header), all_data, new_data_len) != 0) {
+    if (stream_table_image(new_table_addr, &header, &source) != 0) {
         TRACE_DEBUG("Failed to write table data for '%s'\n", table_name);
-        free(all_data);
         return -1;
     }
 
-    free(all_data);
-
     // 更新管理表信息
     table_info->addr = new_table_addr;
     table_info->size = header.table_size;
     table_info->used_size = sizeof(table_header_t) + new_data_len;
 
     // 保存管理表
-    result = save_manager_table();
+    result = save_manager_table(idx);
     if (result != 0) {
         TRACE_DEBUG("Failed to save manager table after writing '%s'\n", table_name);
         return result;
     }
 
+    STATS_ADD(user_bytes, size);
     TRACE_DEBUG("Added data to table '%s', new total size: %u bytes\n", table_name, new_data_len);
     return 0;
 }
 
+int fast_flash_write_table_data(const char *table_name, const void *data, uint32_t size) {
+    API_BEGIN(FF_API_WRITE);
+    FF_RECORD(FF_REC_WRITE, table_name, size, 0, 0, data, size);
+    return append_record(table_name, data, size);
+}
+
 int fast_flash_read_table_data(const char *table_name, uint32_t index, void *buffer, uint32_t size) {
-    if (!table_name || !buffer || !g_manager_loaded) {
+    API_BEGIN(FF_API_READ);
+    FF_RECORD(FF_REC_READ, table_name, index, size, 0, NULL, 0);
+    if (!table_name || !buffer || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -687,12 +2289,13 @@ int fast_flash_read_table_data(const char *table_name, uint32_t index, void *buf
         TRACE_DEBUG("Table '%s' not found\n", table_name);
         return -1;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
 
     // 读取表头获取结构信息
     table_header_t header;
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         TRACE_DEBUG("Failed to read table header for '%s'\n", table_name);
         return -1;
     }
@@ -711,78 +2314,289 @@ int fast_flash_read_table_data(const char *table_name, uint32_t index, void *buf
         return -1;
     }
 
-    // 计算数据偏移量
-    uint32_t offset = index * header.struct_size;
-    uint32_t data_addr = table_info->addr + sizeof(table_header_t) + offset;
+    // 计算数据偏移量
+    uint32_t offset = index * header.struct_size;
+    uint32_t data_addr = table_info->addr + sizeof(table_header_t) + offset;
+
+    return read_table_payload(data_addr, buffer, size);
+}
+
+int fast_flash_get_table_info(const char *table_name, flash_table_t *info) {
+    if (!table_name || !info || !g_part->manager_loaded) {
+        TRACE_INFO("g_part->manager_loaded %d", g_part->manager_loaded);
+        return -1;
+    }
+
+    int idx = find_table_index(table_name);
+    if (idx < 0) {
+        TRACE_DEBUG("Table '%s' not found\n", table_name);
+        return -1;
+    }
+
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
+    strncpy(info->name, table_info->name, TABLE_NAME_MAX_LEN-1);
+    info->addr = table_info->addr;
+    info->size = table_info->size;
+    info->used_size = table_info->used_size;
+    info->magic = table_info->magic;
+    info->status = table_info->status;
+    info->flags = table_info->flags;
+
+    return 0;
+}
+
+int fast_flash_list_tables(flash_table_t *tables, int max_count) {
+    if (!tables || !g_part->manager_loaded || max_count <= 0) {
+        return -1;
+    }
+    if (load_catalog() != 0) {
+        return -1;
+    }
+
+    int count = 0;
+    for (int i = 0; i < g_max_tables && count < max_count; i++) {
+        if (g_part->manager_table->tables[i].status == TABLE_STATUS_VALID) {
+            flash_table_info_t *src = &g_part->manager_table->tables[i];
+            strncpy(tables[count].name, src->name, TABLE_NAME_MAX_LEN);
+            tables[count].addr = src->addr;
+            tables[count].size = src->size;
+            tables[count].used_size = src->used_size;
+            tables[count].magic = src->magic;
+            tables[count].status = src->status;
+            tables[count].flags = src->flags;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+bool fast_flash_table_exists(const char *name) {
+    if (!name || !g_part->manager_loaded) {
+        TRACE_INFO("g_part->manager_loaded %d", g_part->manager_loaded);
+        return false;
+    }
+
+    return find_table_index(name) >= 0;
+}
+
+void fast_flash_set_erase_allowed(bool allowed) {
+    FF_RECORD(FF_REC_SET_ERASE, NULL, allowed ? 1 : 0, 0, 0, NULL, 0);
+    g_allow_erase = allowed;
+    TRACE_DEBUG("Erase operations %s\n", allowed ? "allowed" : "disallowed");
+}
+
+bool fast_flash_is_erase_allowed(void) {
+    return g_allow_erase;
+}
+
+void fast_flash_set_lazy_mount(bool lazy) {
+    g_lazy_mount = lazy;
+    TRACE_DEBUG("Lazy mount %s\n", lazy ? "enabled" : "disabled");
+}
+
+int fast_flash_warm_up(uint32_t max_pages) {
+    API_BEGIN(FF_API_INIT);
+    if (!g_part->manager_loaded) {
+        return -1;
+    }
+
+    for (uint32_t page = 0; page < g_catalog_pages && max_pages > 0 && g_part->catalog_pending > 0; page++) {
+        if (!page_bit(g_part->catalog_loaded, page)) {
+            if (load_catalog_page(page) != 0) {
+                return -1;
+            }
+            max_pages--;
+        }
+    }
+    return (int)g_part->catalog_pending;
+}
+
+// GC搬运计划项
+typedef struct {
+    int      slot;       // 管理表槽位
+    uint8_t  table_class;
+    uint32_t src;        // 数据当前所在地址
+    uint32_t dest;       // 整理后的目标地址
+    uint32_t size;       // 表占用大小
+} gc_item_t;
+
+// GC上下文
+typedef struct {
+    gc_item_t *items;            // 按max_tables分配
+    int       count;
+    uint32_t  total_sectors;
+    uint32_t  dest_sectors;      // 整理后使用的扇区数（[0, dest_sectors)）
+    uint32_t *blank_from;        // 整理区每个扇区已确认空白的起始偏移，g_sector_size表示未知
+    uint8_t  *source_map;        // 扇区位图：扇区内还有待搬运的表
+    uint32_t  spare_addr;        // 暂存扇区写入位置，0表示没有打开的暂存扇区
+    uint32_t  spare_next;        // 下一个候选暂存扇区
+    uint32_t  erase_end;         // 结束时需要擦除到的扇区（不含）
+    uint32_t *catalog_dest;      // 分页目录各目录页的目标地址，0表示空页
+    uint32_t  arena_mark;        // GC开始时的内存区使用量，结束时归还到这里
+} gc_context_t;
+
+_Static_assert(sizeof(gc_item_t) <= FF_ARENA_GC_ITEM_SIZE, "FF_ARENA_GC_ITEM_SIZE too small");
+
+static void gc_context_free(gc_context_t *ctx) {
+    ff_free(ctx->items);
+    ff_free(ctx->blank_from);
+    ff_free(ctx->source_map);
+    ff_free(ctx->catalog_dest);
+    arena_release(ctx->arena_mark);
+}
+
+// 搬运一张表（器件内复制，或经流式缓冲区分段读出再写出），I/O记到该表的搬运量中
+static int gc_copy_table(int slot, uint32_t src, uint32_t dest, uint32_t size) {
+    FF_PROF_PHASE(FF_PHASE_GC_COPY);
+    io_kind_t saved_kind = g_io_kind;
+    int saved_table = g_stats_table;
+    g_io_kind = IO_KIND_RELOCATION;
+    g_stats_table = slot;
+
+    int result = copy_with_chunks(dest, src, size);
+
+    g_io_kind = saved_kind;
+    g_stats_table = saved_table;
+    return result;
+}
+
+static bool gc_sector_has_source(const gc_context_t *ctx, uint32_t sector) {
+    return (ctx->source_map[sector / 8] & (1u << (sector % 8))) != 0;
+}
+
+static void gc_mark_source(gc_context_t *ctx, uint32_t sector) {
+    ctx->source_map[sector / 8] |= (uint8_t)(1u << (sector % 8));
+}
+
+// 更新表的当前位置；原扇区不再有待搬运的表时清除位图
+static void gc_move_item(gc_context_t *ctx, gc_item_t *item, uint32_t new_src) {
+    uint32_t old_sector = item->src / g_sector_size;
+
+    item->src = new_src;
+    gc_mark_source(ctx, new_src / g_sector_size);
+
+    // 只有整理区之外的扇区会被选为暂存扇区，整理区内的位图不需要维护
+    if (old_sector < ctx->dest_sectors || old_sector == new_src / g_sector_size) {
+        return;
+    }
+    for (int i = 0; i < ctx->count; i++) {
+        if (ctx->items[i].src / g_sector_size == old_sector) {
+            return;
+        }
+    }
+    ctx->source_map[old_sector / 8] &= (uint8_t)~(1u << (old_sector % 8));
+}
+
+// 在整理区之外取暂存空间
+// 优先使用分配前沿之后的扇区（自上次GC以来没有写过），用完后再从整理区之后循环查找没有待搬运数据的扇区
+static int gc_spare_alloc(gc_context_t *ctx, uint32_t size, uint32_t *out_addr) {
+    uint32_t offset = ctx->spare_addr % g_sector_size;
+    if (ctx->spare_addr != 0 && offset != 0 && offset + size <= g_sector_size) {
+        *out_addr = ctx->spare_addr;
+        ctx->spare_addr += size;
+        return 0;
+    }
+
+    // 循环查找：暂存扇区里的表搬走之后，该扇区可以再次作为暂存
+    for (uint32_t n = ctx->dest_sectors; n < ctx->total_sectors; n++) {
+        if (ctx->spare_next >= ctx->total_sectors) {
+            ctx->spare_next = ctx->dest_sectors;
+        }
+
+        uint32_t sector = ctx->spare_next++;
+        if (gc_sector_has_source(ctx, sector)) {
+            continue;
+        }
+        if (!region_blank(sector * g_sector_size, g_sector_size) &&
+            part_erase(sector * g_sector_size, g_sector_size) != 0) {
+            TRACE_DEBUG("Failed to erase spare sector %u during GC\n", sector);
+            return -1;
+        }
+        if (sector + 1 > ctx->erase_end) {
+            ctx->erase_end = sector + 1;
+        }
+        *out_addr = sector * g_sector_size;
+        ctx->spare_addr = *out_addr + size;
+        return 0;
+    }
+
+    TRACE_DEBUG("No spare sector available during GC\n");
+    return -1;
+}
 
-    return g_flash_ops->read(data_addr, (uint8_t*)buffer, size);
+static int gc_compare_src(const void *a, const void *b) {
+    const gc_item_t *ia = (const gc_item_t*)a;
+    const gc_item_t *ib = (const gc_item_t*)b;
+    return (ia->src > ib->src) - (ia->src < ib->src);
 }
 
-int fast_flash_get_table_info(const char *table_name, flash_table_t *info) {
-    if (!table_name || !info || !g_manager_loaded) {
-        TRACE_INFO("g_manager_loaded %d", g_manager_loaded);
-        return -1;
-    }
+// 准备目标扇区：保证从from偏移开始可以写入
+// 不是空白时先把扇区内待搬运的表移到暂存扇区，再擦除，并写回from之前原地保留的表
+static int gc_prepare_sector(gc_context_t *ctx, uint32_t sector, uint32_t from) {
+    FF_PROF_PHASE(FF_PHASE_GC_PREPARE);
+    uint32_t sector_start = sector * g_sector_size;
 
-    int idx = find_table_index(table_name);
-    if (idx < 0) {
-        TRACE_DEBUG("Table '%s' not found\n", table_name);
-        return -1;
+    if (ctx->blank_from[sector] <= from) {
+        return 0;
     }
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
-    strncpy(info->name, table_info->name, TABLE_NAME_MAX_LEN-1);
-    info->addr = table_info->addr;
-    info->size = table_info->size;
-    info->used_size = table_info->used_size;
-    info->magic = table_info->magic;
-    info->status = table_info->status;
+    if (region_blank(sector_start + from, g_sector_size - from)) {
+        ctx->blank_from[sector] = from;
+        return 0;
+    }
 
-    return 0;
-}
+    for (int i = 0; i < ctx->count; i++) {
+        gc_item_t *item = &ctx->items[i];
+        if (item->src / g_sector_size != sector) {
+            continue;
+        }
+        uint32_t spare;
+        if (gc_spare_alloc(ctx, item->size, &spare) != 0 ||
+            gc_copy_table(item->slot, item->src, spare, item->size) != 0) {
+            return -1;
+        }
+        gc_move_item(ctx, item, spare);
+    }
 
-int fast_flash_list_tables(flash_table_t *tables, int max_count) {
-    if (!tables || !g_manager_loaded || max_count <= 0) {
+    if (part_erase(sector_start, g_sector_size) != 0) {
+        TRACE_DEBUG("Failed to erase sector %u during GC\n", sector);
         return -1;
     }
+    ctx->blank_from[sector] = 0;
 
-    int count = 0;
-    for (int i = 0; i < MAX_TABLES_ALL_SECTOR && count < max_count; i++) {
-        if (g_manager_table.tables[i].status == TABLE_STATUS_VALID) {
-            flash_table_info_t *src = &g_manager_table.tables[i];
-            strncpy(tables[count].name, src->name, TABLE_NAME_MAX_LEN);
-            tables[count].addr = src->addr;
-            tables[count].size = src->size;
-            tables[count].used_size = src->used_size;
-            tables[count].magic = src->magic;
-            tables[count].status = src->status;
-            count++;
+    for (int i = 0; i < ctx->count; i++) {
+        gc_item_t *item = &ctx->items[i];
+        if (item->dest / g_sector_size == sector && item->dest - sector_start < from) {
+            if (gc_copy_table(item->slot, item->src, item->dest, item->size) != 0) {
+                return -1;
+            }
+            gc_move_item(ctx, item, item->dest);
         }
     }
 
-    return count;
+    return 0;
 }
 
-bool fast_flash_table_exists(const char *name) {
-    if (!name || !g_manager_loaded) {
-        TRACE_INFO("g_manager_loaded %d", g_manager_loaded);
-        return false;
+// 按紧密排布规则放置（不跨扇区）
+static uint32_t gc_place(uint32_t *pos, uint32_t size) {
+    if (*pos % g_sector_size + size > g_sector_size) {
+        *pos = (*pos / g_sector_size + 1) * g_sector_size;
     }
-
-    return find_table_index(name) >= 0;
-}
-
-void fast_flash_set_erase_allowed(bool allowed) {
-    g_allow_erase = allowed;
-    TRACE_DEBUG("Erase operations %s\n", allowed ? "allowed" : "disallowed");
+    uint32_t addr = *pos;
+    *pos += size;
+    return addr;
 }
 
-bool fast_flash_is_erase_allowed(void) {
-    return g_allow_erase;
+int fast_flash_gc(void) {
+    API_BEGIN(FF_API_GC);
+    FF_RECORD(FF_REC_GC, NULL, 0, 0, 0, NULL, 0);
+    return collect_garbage();
 }
 
-int fast_flash_gc(void) {
-    if (!g_manager_loaded) {
+// 垃圾回收（不记入API统计和工作负载记录，保存管理表时也会调用）
+static int collect_garbage(void) {
+    if (!g_part->manager_loaded) {
         TRACE_DEBUG("Manager table not loaded\n");
         return -1;
     }
@@ -792,307 +2606,365 @@ int fast_flash_gc(void) {
         return -2;
     }
 
-    TRACE_DEBUG("Starting garbage collection...\n");
+    if (load_catalog() != 0) {
+        return -1;
+    }
 
-    uint32_t total_sectors = g_total_size / FLASH_SECTOR_SIZE;
-    uint32_t empty_sector = 0xFFFFFFFF;  // 标记为未找到
+    TRACE_DEBUG("Starting garbage collection...\n");
 
-    // === 阶段1：准备阶段 - 寻找空扇区并准备缓存 ===
+    gc_context_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.total_sectors = g_part->total_size / g_sector_size;
+    ctx.arena_mark = g_arena_used;
+    ctx.items = (gc_item_t*)ff_alloc(sizeof(gc_item_t) * g_max_tables);  // dest为0表示尚未放置
+    gc_item_t *planned = (gc_item_t*)ff_alloc(sizeof(gc_item_t) * g_max_tables);
+    if (!ctx.items || !planned) {
+        TRACE_DEBUG("Memory allocation failed during GC\n");
+        ff_free(planned);
+        gc_context_free(&ctx);
+        return -1;
+    }
 
-    // 1. 检查每个扇区是否有有效表
-    for (uint32_t sector = 0; sector < total_sectors; sector++) {
-        bool has_valid_table = false;
+    // === 阶段1：收集有效表并按类别、地址排序 ===
+    // 目标布局：扇区0 = 管理表 + 放得下的热数据；从扇区1开始依次是冷数据、只追加数据（各自独占扇区）、
+    // 剩余热数据。冷数据没有变化时目标地址与当前地址相同，不需要搬运和擦除。
+    static const uint8_t class_order[] = { FF_TABLE_COLD, FF_TABLE_APPEND_ONLY, FF_TABLE_HOT };
+    uint32_t live_size = 0;
 
-        // 检查当前扇区是否有有效表
-        for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-            if (g_manager_table.tables[i].status == TABLE_STATUS_VALID) {
-                uint32_t table_sector = g_manager_table.tables[i].addr / FLASH_SECTOR_SIZE;
-                if (table_sector == sector) {
-                    has_valid_table = true;
-                    break;
-                }
-            }
+    for (int i = 0; i < g_max_tables; i++) {
+        flash_table_info_t *table = &g_part->manager_table->tables[i];
+        if (table->status == TABLE_STATUS_VALID) {
+            gc_item_t *item = &ctx.items[ctx.count++];
+            item->slot = i;
+            item->table_class = table->flags & FF_TABLE_CLASS_MASK;
+            item->src = table->addr;
+            item->size = align_to_write_granularity(table->used_size);
+            live_size += table->used_size;
         }
+    }
 
-        if (!has_valid_table) {
-            empty_sector = sector;
-            TRACE_DEBUG("Found empty sector: %u\n", sector);
-            break;
+    qsort(ctx.items, ctx.count, sizeof(gc_item_t), gc_compare_src);
+
+    // 分页目录的目录页全部按RAM中的表项重写（先读入延迟挂载时还没读入的目录页）
+    uint32_t page_count = 0;
+    if (g_catalog_pages > 0) {
+        rebuild_catalog_probe();
+    }
+    for (uint32_t page = 0; page < g_catalog_pages; page++) {
+        if (catalog_page_stored(page, catalog_page_count(page))) {
+            page_count = page + 1;
         }
     }
 
-    // 2. 收集有效表并按地址排序
-    flash_table_info_t valid_tables[MAX_TABLES_ALL_SECTOR];
-    int valid_count = 0;
-
-    for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-        if (g_manager_table.tables[i].status == TABLE_STATUS_VALID) {
-            valid_tables[valid_count++] = g_manager_table.tables[i];
+    // === 阶段2：计算目标地址 ===
+    int planned_count = 0;
+    uint32_t image_size = manager_image_size(g_part->manager_table->table_count, page_count);
+    uint32_t reserve_size = manager_reserve_size(g_part->manager_table->table_count);
+    uint32_t pos = image_size;
+    uint32_t hot_end = pos;
+    uint32_t class_end[FF_TABLE_CLASS_COUNT] = {0};
+
+    for (int i = 0; i < ctx.count; i++) {
+        gc_item_t *item = &ctx.items[i];
+        if (item->table_class == FF_TABLE_HOT && pos + item->size <= g_sector_size) {
+            item->dest = pos;
+            pos += item->size;
+            hot_end = pos;
+            planned[planned_count++] = *item;
         }
     }
 
-    // 按地址排序（确保按照位置顺序写入）
-    for (int i = 0; i < valid_count - 1; i++) {
-        for (int j = i + 1; j < valid_count; j++) {
-            if (valid_tables[i].addr > valid_tables[j].addr) {
-                flash_table_info_t temp = valid_tables[i];
-                valid_tables[i] = valid_tables[j];
-                valid_tables[j] = temp;
+    pos = g_sector_size;
+    for (uint32_t c = 0; c < sizeof(class_order); c++) {
+        for (int i = 0; i < ctx.count; i++) {
+            gc_item_t *item = &ctx.items[i];
+            if (item->table_class != class_order[c] ||
+                (item->table_class == FF_TABLE_HOT && item->dest != 0)) {
+                continue;
             }
+            item->dest = gc_place(&pos, item->size);
+            class_end[item->table_class] = pos;
+            planned[planned_count++] = *item;
+        }
+        if (class_order[c] == FF_TABLE_HOT && class_end[FF_TABLE_HOT] != 0) {
+            hot_end = class_end[FF_TABLE_HOT];
+        }
+        if (pos % g_sector_size != 0) {
+            pos = (pos / g_sector_size + 1) * g_sector_size;
         }
     }
-
-    if (empty_sector != 0xFFFFFFFF) {
-        // === 阶段2：有空扇区时的处理 ===
-
-        // 2.1 擦除空扇区作为缓存扇区
-        if (g_flash_ops->erase(empty_sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE) != 0) {
-            TRACE_DEBUG("Failed to erase cache sector %u\n", empty_sector);
+    memcpy(ctx.items, planned, sizeof(gc_item_t) * planned_count);
+    ff_free(planned);
+
+    // 目录页和下一个管理表依次放在热数据之后，放不下时取整理区之后的新扇区
+    ctx.dest_sectors = pos / g_sector_size;
+    uint32_t catalog_size = 0;
+    if (page_count > 0) {
+        ctx.catalog_dest = (uint32_t*)ff_alloc(page_count * sizeof(uint32_t));
+        if (!ctx.catalog_dest) {
+            TRACE_DEBUG("Memory allocation failed during GC\n");
+            gc_context_free(&ctx);
             return -1;
         }
-
-        TRACE_DEBUG("Using sector %u as cache sector\n", empty_sector);
-
-        // 2.2 将第一个扇区的有效数据搬运到缓存扇区
-        uint32_t cache_write_pos = empty_sector * FLASH_SECTOR_SIZE;
-
-        // 收集第一个扇区的有效表
-        flash_table_info_t first_sector_tables[MAX_TABLES_ALL_SECTOR];
-        int first_sector_count = 0;
-
-        for (int i = 0; i < valid_count; i++) {
-            uint32_t table_sector = valid_tables[i].addr / FLASH_SECTOR_SIZE;
-            if (table_sector == 0) {
-                first_sector_tables[first_sector_count++] = valid_tables[i];
-            }
+    }
+    for (uint32_t page = 0; page < page_count; page++) {
+        uint32_t count = catalog_page_count(page);
+        if (!catalog_page_stored(page, count)) {
+            continue;
         }
+        uint32_t size = catalog_page_size(count);
+        if (hot_end % g_sector_size == 0 || hot_end % g_sector_size + size > g_sector_size) {
+            hot_end = ctx.dest_sectors * g_sector_size;
+            ctx.dest_sectors++;
+        }
+        ctx.catalog_dest[page] = hot_end;
+        hot_end += size;
+        catalog_size += size;
+    }
 
-        // 搬运第一个扇区的数据到缓存扇区
-        for (int i = 0; i < first_sector_count; i++) {
-            uint32_t table_size = first_sector_tables[i].size;
-
-            // 读取表数据
-            uint8_t *temp_data = malloc(table_size);
-            if (!temp_data) {
-                TRACE_DEBUG("Memory allocation failed during cache preparation\n");
-                return -1;
-            }
-
-            if (g_flash_ops->read(first_sector_tables[i].addr, temp_data, table_size) != 0) {
-                TRACE_DEBUG("Failed to read table '%s' during cache preparation\n", first_sector_tables[i].name);
-                free(temp_data);
-                return -1;
-            }
-
-            // 写入缓存扇区
-            if (write_with_chunks(cache_write_pos, temp_data, table_size) != 0) {
-                TRACE_DEBUG("Failed to write table '%s' to cache sector\n", first_sector_tables[i].name);
-                free(temp_data);
-                return -1;
-            }
+    uint32_t next_manager_pos = hot_end;
+    uint32_t hot_offset = hot_end % g_sector_size;
+    if (hot_offset == 0 || hot_offset + reserve_size > g_sector_size) {
+        next_manager_pos = ctx.dest_sectors * g_sector_size;
+        ctx.dest_sectors++;
+    }
 
-            // 更新RAM中的管理表
-            for (int j = 0; j < MAX_TABLES_ALL_SECTOR; j++) {
-                if (g_manager_table.tables[j].status == TABLE_STATUS_VALID &&
-                    strncmp(g_manager_table.tables[j].name, first_sector_tables[i].name, TABLE_NAME_MAX_LEN) == 0) {
-                    g_manager_table.tables[j].addr = cache_write_pos;
-                    break;
-                }
-            }
+    if (ctx.dest_sectors > ctx.total_sectors) {
+        TRACE_DEBUG("Live data does not fit after compaction\n");
+        gc_context_free(&ctx);
+        return -2;
+    }
 
-            cache_write_pos += table_size;
-            free(temp_data);
-        }
+    // 记录有待搬运数据的扇区
+    ctx.source_map = ff_alloc((ctx.total_sectors + 7) / 8);
+    if (!ctx.source_map) {
+        TRACE_DEBUG("Memory allocation failed during GC\n");
+        gc_context_free(&ctx);
+        return -1;
+    }
+    for (int i = 0; i < ctx.count; i++) {
+        gc_mark_source(&ctx, ctx.items[i].src / g_sector_size);
+    }
 
-        // 2.3 擦除第一扇区（现在变成空扇区）
-        if (g_flash_ops->erase(0, FLASH_SECTOR_SIZE) != 0) {
-            TRACE_DEBUG("Failed to erase first sector after cache preparation\n");
-            return -1;
+    // 整理区之外至少要有一个没有有效数据的扇区作为暂存（分配前沿之后的扇区都没有有效数据）
+    bool has_spare = (g_part->next_free_sector < ctx.total_sectors);
+    for (uint32_t sector = ctx.dest_sectors; sector < ctx.total_sectors && !has_spare; sector++) {
+        if (!gc_sector_has_source(&ctx, sector)) {
+            has_spare = true;
         }
+    }
 
-        // 2.4 现在第一扇区是空的，缓存扇区有数据，开始正式垃圾回收
-
-    } else {
-        // === 阶段3：没有空扇区时的处理 ===
+    if (!has_spare) {
+        // === 没有空扇区时的处理 ===
         TRACE_DEBUG("No empty sector found, erasing first sector and abandoning data\n");
 
-        // 擦除第一个扇区，放弃数据
-        if (g_flash_ops->erase(0, FLASH_SECTOR_SIZE) != 0) {
-            TRACE_DEBUG("Failed to erase first sector\n");
+        // 擦除分配前沿之前的所有扇区，放弃数据（合并为块擦除）
+        uint32_t used_sectors = (g_part->next_free_sector < ctx.total_sectors) ? g_part->next_free_sector : ctx.total_sectors;
+        if (erase_range(0, used_sectors * g_sector_size) != 0) {
+            TRACE_DEBUG("Failed to erase flash\n");
+            gc_context_free(&ctx);
             return -1;
         }
 
-        // 重置管理表
-        memset(&g_manager_table, 0, sizeof(g_manager_table));
-        g_manager_table.magic = MAGIC_NUMBER_MANAGER;
-        g_manager_table.version = MANAGER_TABLE_VERSION;
-        g_manager_table.total_size = g_total_size;
-        g_manager_table.used_size = 0;
-        g_manager_table.table_count = 0;
+        // 重置管理表，写入空管理表到第一扇区开头
+        init_manager_table();
+        seal_manager_table(g_part->manager_table);
 
-        // 擦除其他所有扇区
-        for (uint32_t sector = 1; sector < total_sectors; sector++) {
-            g_flash_ops->erase(sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
-        }
-
-        // 写入空管理表到第一扇区开头
-        g_manager_table.next_manager_addr = sizeof(flash_manager_table_t);
-        g_manager_table.crc = calculate_manager_table_crc(&g_manager_table);
-
-        if (write_with_chunks(0, (uint8_t*)&g_manager_table, sizeof(g_manager_table)) != 0) {
+        if (write_manager_image(0) != 0 || flash_sync() != 0) {
             TRACE_DEBUG("Failed to write empty manager table\n");
+            gc_context_free(&ctx);
             return -1;
         }
 
         // 更新全局状态
-        g_current_sector = 0;
-        g_current_offset = sizeof(flash_manager_table_t) * 2;  // 当前管理表 + 下一个预留空间
+        g_part->current_sector = 0;
+        g_part->current_offset = g_part->manager_table->class_heads[FF_TABLE_HOT];  // 当前管理表 + 下一个预留空间
+        memset(g_part->class_heads, 0, sizeof(g_part->class_heads));
+        g_part->next_free_sector = 1;
 
+        gc_context_free(&ctx);
         TRACE_DEBUG("GC completed: first sector erased, all data abandoned\n");
         return 0;
     }
 
-    // === 阶段4：正式垃圾回收（有空扇区的情况）===
-
-    TRACE_DEBUG("Starting formal garbage collection with empty sector 0\n");
-
-    // 4.1 重新收集所有有效表（因为地址可能已经更新）
-    valid_count = 0;
-    for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-        if (g_manager_table.tables[i].status == TABLE_STATUS_VALID) {
-            valid_tables[valid_count++] = g_manager_table.tables[i];
-        }
+    // 只有整理区内的扇区会被准备写入
+    ctx.blank_from = ff_alloc(ctx.dest_sectors * sizeof(uint32_t));
+    if (!ctx.blank_from) {
+        TRACE_DEBUG("Memory allocation failed during GC\n");
+        gc_context_free(&ctx);
+        return -1;
     }
-
-    // 重新按地址排序
-    for (int i = 0; i < valid_count - 1; i++) {
-        for (int j = i + 1; j < valid_count; j++) {
-            if (valid_tables[i].addr > valid_tables[j].addr) {
-                flash_table_info_t temp = valid_tables[i];
-                valid_tables[i] = valid_tables[j];
-                valid_tables[j] = temp;
-            }
-        }
+    for (uint32_t sector = 0; sector < ctx.dest_sectors; sector++) {
+        ctx.blank_from[sector] = g_sector_size;
     }
+    ctx.erase_end = g_part->next_free_sector;
+    ctx.spare_next = (g_part->next_free_sector > ctx.dest_sectors) ? g_part->next_free_sector : ctx.dest_sectors;
 
-    // 4.2 在第一扇区预留管理表空间，开始写入有效表
-    uint32_t current_write_pos = 0 + sizeof(flash_manager_table_t);  // 第一扇区预留管理表空间
-    uint32_t current_sector = 0;
+    // === 阶段3：按目标地址顺序搬运 ===
+    // 扇区0要重写管理表，先整体腾空
+    int result = gc_prepare_sector(&ctx, 0, 0);
 
-    for (int i = 0; i < valid_count; i++) {
-        uint32_t table_size = valid_tables[i].size;
+    uint32_t current_sector = 0xFFFFFFFF;
+    for (int i = 0; i < ctx.count && result == 0; i++) {
+        gc_item_t *item = &ctx.items[i];
+        uint32_t sector = item->dest / g_sector_size;
 
-        // 检查当前扇区剩余空间
-        uint32_t sector_end = (current_sector + 1) * FLASH_SECTOR_SIZE;
-        if (current_write_pos + table_size > sector_end) {
-            // 需要切换到下一个扇区
-            current_sector++;
-            current_write_pos = current_sector * FLASH_SECTOR_SIZE;
-
-            // 擦除目标扇区
-            if (g_flash_ops->erase(current_write_pos, FLASH_SECTOR_SIZE) != 0) {
-                TRACE_DEBUG("Failed to erase sector %u during GC\n", current_sector);
-                return -1;
+        if (sector != current_sector) {
+            // 进入新的目标扇区：从第一张需要搬运的表开始确保可写
+            current_sector = sector;
+            for (int j = i; j < ctx.count && ctx.items[j].dest / g_sector_size == sector; j++) {
+                if (ctx.items[j].src != ctx.items[j].dest) {
+                    result = gc_prepare_sector(&ctx, sector, ctx.items[j].dest % g_sector_size);
+                    break;
+                }
             }
         }
 
-        // 读取表数据
-        uint8_t *temp_data = malloc(table_size);
-        if (!temp_data) {
-            TRACE_DEBUG("Memory allocation failed during formal GC\n");
-            return -1;
+        if (result == 0 && item->src != item->dest) {
+            result = gc_copy_table(item->slot, item->src, item->dest, item->size);
+            if (result == 0) {
+                gc_move_item(&ctx, item, item->dest);
+            } else {
+                TRACE_DEBUG("Failed to move table '%s' during GC\n", g_part->manager_table->tables[item->slot].name);
+            }
         }
+    }
 
-        if (g_flash_ops->read(valid_tables[i].addr, temp_data, table_size) != 0) {
-            TRACE_DEBUG("Failed to read table '%s' during formal GC\n", valid_tables[i].name);
-            free(temp_data);
-            return -1;
+    for (uint32_t page = 0; page < page_count && result == 0; page++) {
+        uint32_t dest = ctx.catalog_dest[page];
+        if (dest != 0) {
+            result = gc_prepare_sector(&ctx, dest / g_sector_size, dest % g_sector_size);
         }
+    }
 
-        // 写入新位置
-        if (write_with_chunks(current_write_pos, temp_data, table_size) != 0) {
-            TRACE_DEBUG("Failed to write table '%s' during formal GC\n", valid_tables[i].name);
-            free(temp_data);
+    if (result == 0) {
+        result = gc_prepare_sector(&ctx, next_manager_pos / g_sector_size,
+                                   next_manager_pos % g_sector_size);
+    }
+
+    if (result != 0) {
+        gc_context_free(&ctx);
+        return -1;
+    }
+
+    // === 阶段4：更新RAM中的管理表并写入第一扇区开头 ===
+    for (int i = 0; i < ctx.count; i++) {
+        g_part->manager_table->tables[ctx.items[i].slot].addr = ctx.items[i].dest;
+    }
+    memset(g_part->catalog_dir, 0, g_catalog_pages * sizeof(uint32_t));
+    for (uint32_t page = 0; page < page_count; page++) {
+        uint32_t dest = ctx.catalog_dest[page];
+        if (dest != 0 && write_catalog_page(page, dest, catalog_page_count(page)) != 0) {
+            TRACE_DEBUG("Failed to write catalog page %u during GC\n", page);
+            gc_context_free(&ctx);
             return -1;
         }
+        g_part->catalog_dir[page] = dest;
+    }
+    memset(g_part->catalog_dirty, 0, (g_catalog_pages + 7) / 8);
+    g_part->manager_table->page_count = (uint16_t)page_count;
 
-        // 更新RAM中的管理表
-        for (int j = 0; j < MAX_TABLES_ALL_SECTOR; j++) {
-            if (g_manager_table.tables[j].status == TABLE_STATUS_VALID &&
-                strncmp(g_manager_table.tables[j].name, valid_tables[i].name, TABLE_NAME_MAX_LEN) == 0) {
-                g_manager_table.tables[j].addr = current_write_pos;
-                break;
-            }
+    // 冷数据类别最后一个扇区在本次GC中确认过空白时，可以继续在其后写入
+    memset(g_part->class_heads, 0, sizeof(g_part->class_heads));
+    for (int c = FF_TABLE_COLD; c < FF_TABLE_CLASS_COUNT; c++) {
+        uint32_t end = class_end[c];
+        if (end == 0 || end % g_sector_size == 0) {
+            continue;
+        }
+        uint32_t sector = end / g_sector_size;
+        if (ctx.blank_from[sector] <= end % g_sector_size) {
+            g_part->class_heads[c] = end;
         }
-
-        current_write_pos += table_size;
-        free(temp_data);
     }
 
-    // 4.3 计算下一个管理表预留位置
-    uint32_t next_manager_pos = current_write_pos;
-    g_manager_table.next_manager_addr = next_manager_pos;
-    g_manager_table.used_size = next_manager_pos;  // 更新已使用大小
+    g_part->next_free_sector = ctx.dest_sectors;
+    g_part->manager_table->next_manager_addr = next_manager_pos;
+    g_part->manager_table->next_manager_size = reserve_size;
+    g_part->manager_table->used_size = image_size + catalog_size + live_size;  // 更新已使用大小
+    g_part->manager_table->next_free_sector = g_part->next_free_sector;
+    memcpy(g_part->manager_table->class_heads, g_part->class_heads, sizeof(g_part->class_heads));
+    g_part->manager_table->class_heads[FF_TABLE_HOT] = next_manager_pos + reserve_size;
+    seal_manager_table(g_part->manager_table);
 
-    // 4.4 写入管理表到第一扇区开头
-    g_manager_table.crc = calculate_manager_table_crc(&g_manager_table);
-    if (write_with_chunks(0, (uint8_t*)&g_manager_table, sizeof(g_manager_table)) != 0) {
-        TRACE_DEBUG("Failed to write manager table during formal GC\n");
+    // 新管理表落盘之后才能擦除旧数据所在的扇区，否则掉电时旧表指向已擦除的数据
+    if (write_manager_image(0) != 0 || flash_sync() != 0) {
+        TRACE_DEBUG("Failed to write manager table during GC\n");
+        gc_context_free(&ctx);
         return -1;
     }
 
-    // 4.5 擦除后续所有扇区
-    for (uint32_t sector = current_sector + 1; sector < total_sectors; sector++) {
-        g_flash_ops->erase(sector * FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+    // === 阶段5：擦除整理区之后用过的扇区（之后的扇区自上次GC以来未使用，仍是空白）===
+    // 这些扇区是连续的，合并为块擦除。整理结果已经提交，擦除失败不影响数据：
+    // 之后分配新扇区时open_new_sector会再擦除一次
+    if (ctx.erase_end > ctx.total_sectors) {
+        ctx.erase_end = ctx.total_sectors;
     }
+    if (ctx.erase_end > ctx.dest_sectors &&
+        erase_range(ctx.dest_sectors * g_sector_size, (ctx.erase_end - ctx.dest_sectors) * g_sector_size) != 0) {
+        TRACE_WARN("Failed to erase sectors %u-%u after GC, they are erased again when reused\n",
+                  ctx.dest_sectors, ctx.erase_end - 1);
+    }
+
+    gc_context_free(&ctx);
 
-    // 4.6 更新全局状态
-    g_current_sector = current_sector;
-    g_current_offset = current_write_pos % FLASH_SECTOR_SIZE;
+    // 更新全局状态
+    g_part->current_sector = (next_manager_pos + reserve_size) / g_sector_size;
+    g_part->current_offset = (next_manager_pos + reserve_size) % g_sector_size;
 
-    TRACE_DEBUG("GC completed: valid tables compacted to sectors 0-%u\n", current_sector);
+    TRACE_DEBUG("GC completed: valid tables compacted to sectors 0-%u\n", ctx.dest_sectors - 1);
     return 0;
 }
 
 void fast_flash_dump_manager_table(void) {
-    if (!g_manager_loaded) {
+    if (!g_part->manager_loaded) {
         TRACE_DEBUG("Manager table not loaded\n");
         return;
     }
+    if (load_catalog() != 0) {
+        return;
+    }
 
     TRACE_DEBUG("=== Manager Table Info ===\n");
-    TRACE_DEBUG("Magic: 0x%04X\n", g_manager_table.magic);
-    TRACE_DEBUG("Version: %u\n", g_manager_table.version);
-    TRACE_DEBUG("Table Count: %u\n", g_manager_table.table_count);
-    TRACE_DEBUG("Total Size: %u\n", g_manager_table.total_size);
-    TRACE_DEBUG("Used Size: %u\n", g_manager_table.used_size);
-    TRACE_DEBUG("Next Manager Addr: 0x%08X\n", g_manager_table.next_manager_addr);
-    TRACE_DEBUG("CRC: 0x%08X\n", g_manager_table.crc);
+    TRACE_DEBUG("Partition: '%.*s' at 0x%08X\n", TABLE_NAME_MAX_LEN, g_part->name, g_part->base);
+    TRACE_DEBUG("Magic: 0x%04X\n", g_part->manager_table->magic);
+    TRACE_DEBUG("Version: %u\n", g_part->manager_table->version);
+    TRACE_DEBUG("Table Count: %u\n", g_part->manager_table->table_count);
+    if (g_catalog_pages > 0) {
+        TRACE_DEBUG("Catalog Pages: %u of %u\n", g_part->manager_table->page_count, g_catalog_pages);
+    }
+    TRACE_DEBUG("Total Size: %u\n", g_part->manager_table->total_size);
+    TRACE_DEBUG("Used Size: %u\n", g_part->manager_table->used_size);
+    TRACE_DEBUG("Next Manager Addr: 0x%08X (%u bytes reserved)\n", g_part->manager_table->next_manager_addr,
+                g_part->manager_table->next_manager_size);
+    TRACE_DEBUG("Next Free Sector: %u\n", g_part->manager_table->next_free_sector);
+    TRACE_DEBUG("CRC: 0x%08X\n", g_part->manager_table->crc);
 
     TRACE_DEBUG("\n=== Tables ===\n");
-    for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
-        flash_table_info_t *table = &g_manager_table.tables[i];
+    for (int i = 0; i < g_max_tables; i++) {
+        flash_table_info_t *table = &g_part->manager_table->tables[i];
         if (table->status == TABLE_STATUS_VALID) {
-            TRACE_DEBUG("[%u] Name: %-8s Addr: 0x%08X Size: %5u Used: %5u Magic: 0x%04X\n",
-                   i, table->name, table->addr, table->size, table->used_size, table->magic);
+            TRACE_DEBUG("[%u] Name: %-8s Addr: 0x%08X Size: %5u Used: %5u Magic: 0x%04X Flags: 0x%02X\n",
+                   i, table->name, table->addr, table->size, table->used_size, table->magic, table->flags);
         }
     }
 }
 
 uint32_t fast_flash_get_total_size(void) {
-    return g_total_size;
+    return g_part->total_size;
 }
 
 uint32_t fast_flash_get_used_size(void) {
-    return g_manager_loaded ? g_manager_table.used_size : 0;
+    return g_part->manager_loaded ? g_part->manager_table->used_size : 0;
 }
 
 uint32_t fast_flash_get_free_size(void) {
-    return g_total_size - fast_flash_get_used_size();
+    return g_part->total_size - fast_flash_get_used_size();
 }
 
 int fast_flash_validate_table_data(const char *table_name) {
-    if (!table_name || !g_manager_loaded) {
+    API_BEGIN(FF_API_VALIDATE);
+    FF_RECORD(FF_REC_VALIDATE, table_name, 0, 0, 0, NULL, 0);
+    if (!table_name || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -1100,43 +2972,29 @@ int fast_flash_validate_table_data(const char *table_name) {
     if (idx < 0) {
         return -1;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
     table_header_t header;
 
     // 读取表头
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         return -1;
     }
 
-    // 检查魔数
-    if (header.magic != MAGIC_NUMBER_TABLE) {
-        TRACE_DEBUG("Invalid table magic for '%s'\n", table_name);
-        return -1;
-    }
-
-    // 验证数据CRC
+    // 验证数据CRC（流式计算）
     if (header.data_len > 0) {
-        uint8_t *data = malloc(header.data_len);
-        if (!data) {
-            return -1;
-        }
-
-        int result = g_flash_ops->read(table_info->addr + sizeof(header), data, header.data_len);
+        uint32_t calculated_crc;
+        int result = stream_data_crc(table_info->addr + sizeof(header), header.data_len, &calculated_crc);
         if (result != 0) {
             TRACE_DEBUG("Failed to read table data for validation\n");
-            free(data);
             return result;
         }
         
-        uint32_t calculated_crc = calculate_crc32(data, header.data_len);
         if (calculated_crc != header.data_crc) {
             TRACE_DEBUG("Data CRC mismatch for table '%s'\n", table_name);
-            free(data);
             return -1;
         }
-
-        free(data);
         return 0;
     }
 
@@ -1144,7 +3002,9 @@ int fast_flash_validate_table_data(const char *table_name) {
 }
 
 int fast_flash_repair_table(const char *table_name) {
-    if (!table_name || !g_manager_loaded) {
+    API_BEGIN(FF_API_VALIDATE);
+    FF_RECORD(FF_REC_REPAIR, table_name, 0, 0, 0, NULL, 0);
+    if (!table_name || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -1153,32 +3013,23 @@ int fast_flash_repair_table(const char *table_name) {
     if (idx < 0) {
         return -1;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
     table_header_t header;
 
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
-        return -1;
-    }
-
-    if (header.magic != MAGIC_NUMBER_TABLE) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         return -1;
     }
 
-    // 重新计算数据CRC
+    // 重新计算数据CRC（流式计算）
     if (header.data_len > 0) {
-        uint8_t *data = malloc(header.data_len);
-        if (!data) {
-            return -1;
-        }
-
-        int result = g_flash_ops->read(table_info->addr + sizeof(header), data, header.data_len);
+        uint32_t data_crc;
+        int result = stream_data_crc(table_info->addr + sizeof(header), header.data_len, &data_crc);
         if (result == 0) {
-            header.data_crc = calculate_crc32(data, header.data_len);
+            header.data_crc = data_crc;
             result = write_with_chunks(table_info->addr, (uint8_t*)&header, sizeof(header));
         }
-
-        free(data);
         return result;
     }
 
@@ -1187,7 +3038,9 @@ int fast_flash_repair_table(const char *table_name) {
 
 // 新增：获取当前表写入的数据数量
 uint32_t fast_flash_get_table_count(const char *table_name) {
-    if (!table_name || !g_manager_loaded) {
+    API_BEGIN(FF_API_READ);
+    FF_RECORD(FF_REC_GET_COUNT, table_name, 0, 0, 0, NULL, 0);
+    if (!table_name || !g_part->manager_loaded) {
         return 0;
     }
 
@@ -1196,12 +3049,13 @@ uint32_t fast_flash_get_table_count(const char *table_name) {
         TRACE_DEBUG("Table '%s' not found\n", table_name);
         return 0;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
 
     // 读取表头获取结构信息
     table_header_t header;
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         TRACE_DEBUG("Failed to read table header for '%s'\n", table_name);
         return 0;
     }
@@ -1211,7 +3065,9 @@ uint32_t fast_flash_get_table_count(const char *table_name) {
 
 // 新增：修改指定index的数据（只能修改已存在的数据）
 int fast_flash_write_table_data_by_index(const char *table_name, uint32_t index, const void *data, uint32_t size) {
-    if (!table_name || !data || !g_manager_loaded) {
+    API_BEGIN(FF_API_WRITE_BY_INDEX);
+    FF_RECORD(FF_REC_WRITE_BY_INDEX, table_name, index, size, 0, data, size);
+    if (!table_name || !data || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -1220,12 +3076,18 @@ int fast_flash_write_table_data_by_index(const char *table_name, uint32_t index,
         TRACE_DEBUG("Table '%s' not found\n", table_name);
         return -1;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
+
+    if ((table_info->flags & FF_TABLE_CLASS_MASK) == FF_TABLE_APPEND_ONLY) {
+        TRACE_DEBUG("Table '%s' is append-only, cannot modify by index\n", table_name);
+        return -1;
+    }
 
     // 读取当前表头获取结构信息
     table_header_t header;
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         TRACE_DEBUG("Failed to read table header for '%s'\n", table_name);
         return -1;
     }
@@ -1244,94 +3106,86 @@ int fast_flash_write_table_data_by_index(const char *table_name, uint32_t index,
         return -2;  // 表示超出已有数据范围
     }
 
-    // 读取指定index的现有数据，检查是否与传入数据一致
-    uint8_t *existing_data = malloc(header.struct_size);
-    if (!existing_data) {
-        TRACE_DEBUG("Memory allocation failed for reading existing data\n");
-        return -1;
-    }
-
+    // 分段读取指定index的现有数据，检查是否与传入数据一致。
+    // 器件支持内部复制时同时累加新旧记录之差的CRC：长度不变时 新CRC = 旧CRC ^ 差值（后接其余数据长度的0）的CRC寄存器
     uint32_t data_offset = table_info->addr + sizeof(header) + index * header.struct_size;
-    if (g_flash_ops->read(data_offset, existing_data, header.struct_size) != 0) {
-        TRACE_DEBUG("Failed to read existing data at index %u\n", index);
-        free(existing_data);
-        return -1;
+    bool derive_crc = (g_flash_ops->copy != NULL);
+    bool identical = true;
+    uint32_t delta_crc = 0;
+    for (uint32_t done = 0; (identical || derive_crc) && done < size; ) {
+        uint32_t n = (size - done > FF_STREAM_BUFFER_SIZE) ? FF_STREAM_BUFFER_SIZE : size - done;
+        if (read_table_payload(data_offset + done, g_stream_buf, n) != 0) {
+            TRACE_DEBUG("Failed to read existing data at index %u\n", index);
+            return -1;
+        }
+        if (identical) {
+            identical = (memcmp(g_stream_buf, (const uint8_t*)data + done, n) == 0);
+        }
+        if (derive_crc) {
+            for (uint32_t i = 0; i < n; i++) {
+                g_stream_buf[i] ^= ((const uint8_t*)data)[done + i];
+            }
+            delta_crc = crc32_update(delta_crc, g_stream_buf, n);
+        }
+        done += n;
     }
 
     // 检查数据是否一致，如果一致则直接返回成功，避免不必要的写操作
-    if (memcmp(existing_data, data, header.struct_size) == 0) {
+    if (identical) {
         TRACE_DEBUG("Data at index %u is identical, no need to write\n", index);
-        free(existing_data);
+        STATS_ADD(user_bytes, size);
         return 0;
     }
     
     TRACE_DEBUG("Data at index %u is different, proceeding with write\n", index);
-    free(existing_data);
-
-    // 数据不一致，需要写入，读取所有现有数据
-    uint8_t *all_data = malloc(header.data_len);
-    if (!all_data) {
-        TRACE_DEBUG("Memory allocation failed for table '%s'\n", table_name);
-        return -1;
-    }
-
-    // 读取现有的所有数据
-    if (g_flash_ops->read(table_info->addr + sizeof(header), all_data, header.data_len) != 0) {
-        TRACE_DEBUG("Failed to read existing data for table '%s'\n", table_name);
-        free(all_data);
-        return -1;
-    }
-
-    // 修改指定位置的数据（在读取的数据中直接替换）
-    uint32_t offset = index * header.struct_size;
-    memcpy(all_data + offset, data, size);
-
-    // 更新表头的CRC
-    header.data_crc = calculate_crc32(all_data, header.data_len);
 
     // 分配新的表空间（写入修改后的数据）
     uint32_t new_table_addr;
-    int result = allocate_table_space(header.data_len+sizeof(table_header_t), &new_table_addr);
+    int result = allocate_table_space(header.data_len+sizeof(table_header_t), table_info->flags, &new_table_addr);
     if (result != 0) {
         TRACE_DEBUG("Failed to allocate space for modified table '%s'\n", table_name);
-        free(all_data);
         return result;
     }
 
-    // 写入新表头
-    if (write_with_chunks(new_table_addr, (uint8_t*)&header, sizeof(header)) != 0) {
-        TRACE_DEBUG("Failed to write updated table header for '%s'\n", table_name);
-        free(all_data);
-        return -1;
-    }
-
-    // 写入修改后的所有数据
-    if (write_with_chunks(new_table_addr + sizeof(header), all_data, header.data_len) != 0) {
+    // 其余记录从原位置流式搬运，指定位置替换为新数据，CRC在搬运时计算
+    stream_source_t source = {
+        .src = table_info->addr + sizeof(header),
+        .struct_size = header.struct_size,
+        .patch = data,
+        .patch_offset = index * header.struct_size,
+        .patch_size = size,
+        .crc_derived = derive_crc,
+    };
+    if (derive_crc) {
+        uint32_t tail_len = header.data_len - (index + 1) * header.struct_size;
+        header.data_crc ^= crc32_shift(delta_crc, tail_len);
+    }
+    if (stream_table_image(new_table_addr, &header, &source) != 0) {
         TRACE_DEBUG("Failed to write modified table data for '%s'\n", table_name);
-        free(all_data);
         return -1;
     }
 
-    free(all_data);
-
     // 更新管理表信息（指向新的表位置）
     table_info->addr = new_table_addr;
     table_info->used_size = sizeof(header) + header.data_len;
 
     // 保存管理表
-    result = save_manager_table();
+    result = save_manager_table(idx);
     if (result != 0) {
         TRACE_DEBUG("Failed to save manager table after modifying '%s'\n", table_name);
         return result;
     }
 
+    STATS_ADD(user_bytes, size);
     TRACE_DEBUG("Modified data in table '%s' at index %u\n", table_name, index);
     return 0;
 }
 
 // 新增：累加数据，基于max_structs管控
 int fast_flash_append_table_data(const char *table_name, const void *data, uint32_t size) {
-    if (!table_name || !data || !g_manager_loaded) {
+    API_BEGIN(FF_API_APPEND);
+    FF_RECORD(FF_REC_APPEND, table_name, size, 0, 0, data, size);
+    if (!table_name || !data || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -1340,12 +3194,13 @@ int fast_flash_append_table_data(const char *table_name, const void *data, uint3
         TRACE_DEBUG("Table '%s' not found\n", table_name);
         return -1;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
 
     // 读取当前表头获取结构信息
     table_header_t header;
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         TRACE_DEBUG("Failed to read table header for '%s'\n", table_name);
         return -1;
     }
@@ -1367,12 +3222,24 @@ int fast_flash_append_table_data(const char *table_name, const void *data, uint3
         return -2;  // 表已满
     }
 
-    return fast_flash_write_table_data(table_name, data, size);
+    return append_record(table_name, data, size);
 }
 
 // 新增：清除指定mask标记的数据，保证索引连续
+// 统计置位数（每次清掉最低位，最多64次）
+static uint32_t popcount64(uint64_t value) {
+    uint32_t count = 0;
+    while (value) {
+        value &= value - 1;
+        count++;
+    }
+    return count;
+}
+
 int fast_flash_clear_table_data(const char *table_name, uint64_t clear_mask) {
-    if (!table_name || !g_manager_loaded) {
+    API_BEGIN(FF_API_CLEAR);
+    FF_RECORD(FF_REC_CLEAR, table_name, clear_mask, 0, 0, NULL, 0);
+    if (!table_name || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -1381,12 +3248,18 @@ int fast_flash_clear_table_data(const char *table_name, uint64_t clear_mask) {
         TRACE_DEBUG("Table '%s' not found\n", table_name);
         return -1;
     }
+    stats_set_table(idx);
+
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    if ((table_info->flags & FF_TABLE_CLASS_MASK) == FF_TABLE_APPEND_ONLY) {
+        TRACE_DEBUG("Table '%s' is append-only, cannot clear data\n", table_name);
+        return -1;
+    }
 
     // 读取当前表头获取结构信息
     table_header_t header;
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         TRACE_DEBUG("Failed to read table header for '%s'\n", table_name);
         return -1;
     }
@@ -1408,101 +3281,55 @@ int fast_flash_clear_table_data(const char *table_name, uint64_t clear_mask) {
     // 执行清除操作
     TRACE_DEBUG("Clearing data with mask 0x%016llX for table '%s'\n", clear_mask, table_name);
     
-    // 读取所有数据
-    uint8_t *all_data = malloc(header.data_len);
-    if (!all_data) {
-        TRACE_DEBUG("Memory allocation failed for table '%s'\n", table_name);
-        return -1;
-    }
-
-    if (g_flash_ops->read(table_info->addr + sizeof(table_header_t), all_data, header.data_len) != 0) {
-        TRACE_DEBUG("Failed to read existing data for table '%s'\n", table_name);
-        free(all_data);
-        return -1;
-    }
-
-    // 创建新的数据缓冲区，跳过被标记清除的数据
-    uint32_t new_data_len = 0;
-    uint8_t *new_data = malloc(header.data_len);  // 新数据不会比原数据长
-    if (!new_data) {
-        TRACE_DEBUG("Memory allocation failed for new data buffer\n");
-        free(all_data);
-        return -1;
-    }
-
-    uint32_t new_struct_nums = 0;
-    for (uint32_t i = 0; i < header.struct_nums; i++) {
-        if (!(clear_mask & (1ULL << i))) {
-            // 该index没有被标记清除，复制数据
-            memcpy(new_data + new_data_len,
-                   all_data + i * header.struct_size,
-                   header.struct_size);
-            new_data_len += header.struct_size;
-            new_struct_nums++;
-        }
-    }
-
-    // 更新表头信息
+    // 统计保留的记录（清除掩码只覆盖前64条）
+    uint32_t new_struct_nums = header.struct_nums - popcount64(clear_mask & max_mask);
+
+    // 保留的记录从原位置流式搬运，跳过被标记清除的数据
+    stream_source_t source = {
+        .src = table_info->addr + sizeof(table_header_t),
+        .struct_size = header.struct_size,
+        .skip_mask = clear_mask,
+    };
+
+    // 更新表头信息（CRC在搬运时计算，没有数据时为0）
+    uint32_t new_data_len = new_struct_nums * header.struct_size;
     header.data_len = new_data_len;
     header.struct_nums = new_struct_nums;
 
-    // 更新CRC校验值
-    if (new_data_len > 0) {
-        header.data_crc = calculate_crc32(new_data, new_data_len);
-    } else {
-        header.data_crc = 0;
-    }
-
     // 分配新的表空间
     uint32_t new_table_addr;
-    int result = allocate_table_space(sizeof(table_header_t) + new_data_len, &new_table_addr);
+    int result = allocate_table_space(sizeof(table_header_t) + new_data_len, table_info->flags, &new_table_addr);
     if (result != 0) {
         TRACE_DEBUG("Failed to allocate space for cleared table '%s'\n", table_name);
-        free(all_data);
-        free(new_data);
         return result;
     }
 
-    // 写入新表头
-    if (write_with_chunks(new_table_addr, (uint8_t*)&header, sizeof(header)) != 0) {
-        TRACE_DEBUG("Failed to write new header for table '%s'\n", table_name);
-        free(all_data);
-        free(new_data);
+    // 写入新表头和数据
+    if (stream_table_image(new_table_addr, &header, &source) != 0) {
+        TRACE_DEBUG("Failed to write new data for table '%s'\n", table_name);
         return -1;
     }
 
-    // 写入新数据
-    if (new_data_len > 0) {
-        if (write_with_chunks(new_table_addr + sizeof(header), new_data, new_data_len) != 0) {
-            TRACE_DEBUG("Failed to write new data for table '%s'\n", table_name);
-            free(all_data);
-            free(new_data);
-            return -1;
-        }
-    }
-
     // 更新管理表
     table_info->addr = new_table_addr;
     table_info->size = sizeof(table_header_t) + new_data_len;
+    table_info->used_size = sizeof(table_header_t) + new_data_len;
 
-    result = save_manager_table();
+    result = save_manager_table(idx);
     if (result != 0) {
         TRACE_DEBUG("Failed to save manager table after clearing '%s'\n", table_name);
-        free(all_data);
-        free(new_data);
         return result;
     }
 
-    free(all_data);
-    free(new_data);
-
     TRACE_DEBUG("Cleared data from table '%s', new struct count: %u\n", table_name, new_struct_nums);
     return 0;
 }
 
 // 新增：批量写入数据，避免频繁构建新表
 int fast_flash_write_table_data_batch(const char *table_name, const void *data, uint32_t struct_size, uint32_t count) {
-    if (!table_name || !data || count == 0 || !g_manager_loaded) {
+    API_BEGIN(FF_API_WRITE_BATCH);
+    FF_RECORD(FF_REC_WRITE_BATCH, table_name, struct_size, count, 0, data, struct_size * count);
+    if (!table_name || !data || count == 0 || !g_part->manager_loaded) {
         return -1;
     }
 
@@ -1511,12 +3338,13 @@ int fast_flash_write_table_data_batch(const char *table_name, const void *data,
         TRACE_DEBUG("Table '%s' not found\n", table_name);
         return -1;
     }
+    stats_set_table(idx);
 
-    flash_table_info_t *table_info = &g_manager_table.tables[idx];
+    flash_table_info_t *table_info = &g_part->manager_table->tables[idx];
 
     // 读取当前表头获取结构信息
     table_header_t header;
-    if (g_flash_ops->read(table_info->addr, (uint8_t*)&header, sizeof(header)) != 0) {
+    if (read_valid_table_header(table_info, &header) != 0) {
         TRACE_DEBUG("Failed to read table header for '%s'\n", table_name);
         return -1;
     }
@@ -1542,66 +3370,131 @@ int fast_flash_write_table_data_batch(const char *table_name, const void *data,
 
     // 分配新的表空间（表头 + 新的数据）
     uint32_t new_table_addr;
-    int result = allocate_table_space(sizeof(table_header_t) + new_data_len, &new_table_addr);
+    int result = allocate_table_space(sizeof(table_header_t) + new_data_len, table_info->flags, &new_table_addr);
     if (result != 0) {
         TRACE_DEBUG("Failed to allocate space for expanded table '%s' (batch write)\n", table_name);
         return result;
     }
 
-    // 分配临时缓冲区用于存储所有数据（旧数据 + 新批量数据）
-    uint8_t *all_data = malloc(new_data_len);
-    if (!all_data) {
-        TRACE_DEBUG("Memory allocation failed for batch write to table '%s'\n", table_name);
-        return -1;
-    }
+    // 旧数据从原位置流式搬运，批量数据追加在末尾
+    stream_source_t source = {
+        .src = table_info->addr + sizeof(header),
+        .struct_size = header.struct_size,
+        .patch = data,
+        .patch_offset = header.data_len,
+        .patch_size = total_data_size,
+    };
 
-    // 读取旧数据（如果有的话）
-    if (header.data_len > 0) {
-        if (g_flash_ops->read(table_info->addr + sizeof(header), all_data, header.data_len) != 0) {
-            TRACE_DEBUG("Failed to read old data for batch write to table '%s'\n", table_name);
-            free(all_data);
-            return -1;
-        }
+    // 器件支持内部复制时新CRC由旧CRC和批量数据推导，旧数据不必读出；否则在搬运时计算
+    if (g_flash_ops->copy) {
+        header.data_crc = crc32_combine(header.data_crc, calculate_crc32(data, total_data_size), total_data_size);
+        source.crc_derived = true;
     }
 
-    // 添加批量数据到缓冲区末尾
-    memcpy(all_data + header.data_len, data, total_data_size);
-
-    // 更新表头
+    // 更新表头并写入
     header.data_len = new_data_len;
     header.struct_nums = new_data_len / header.struct_size;
-    header.data_crc = calculate_crc32(all_data, new_data_len);
-
-    // 写入新表头
-    if (write_with_chunks(new_table_addr, (uint8_t*)&header, sizeof(header)) != 0) {
-        TRACE_DEBUG("Failed to write new table header for batch write to '%s'\n", table_name);
-        free(all_data);
-        return -1;
-    }
-
-    // 写入所有数据
-    if (write_with_chunks(new_table_addr + sizeof(header), all_data, new_data_len) != 0) {
+    if (stream_table_image(new_table_addr, &header, &source) != 0) {
         TRACE_DEBUG("Failed to write table data for batch write to '%s'\n", table_name);
-        free(all_data);
         return -1;
     }
 
-    free(all_data);
-
     // 更新管理表信息
     table_info->addr = new_table_addr;
     table_info->size = header.table_size;
     table_info->used_size = sizeof(table_header_t) + new_data_len;
 
     // 保存管理表
-    result = save_manager_table();
+    result = save_manager_table(idx);
     if (result != 0) {
         TRACE_DEBUG("Failed to save manager table after batch write to '%s'\n", table_name);
         return result;
     }
 
+    STATS_ADD(user_bytes, total_data_size);
     TRACE_DEBUG("Batch write to table '%s': added %u items, new total size: %u bytes\n", 
                table_name, count, new_data_len);
     return 0;
 }
 
+// === I/O统计 ===
+
+int fast_flash_get_stats(flash_stats_t *stats) {
+    if (!stats) {
+        return -1;
+    }
+    *stats = g_stats;
+    return 0;
+}
+
+int fast_flash_get_table_stats(const char *table_name, flash_io_stats_t *stats) {
+    if (!table_name || !stats || !g_part->manager_loaded) {
+        return -1;
+    }
+
+    int idx = find_table_index(table_name);
+    if (idx < 0) {
+        return -1;
+    }
+
+    *stats = g_part->table_stats[idx];
+    return 0;
+}
+
+void fast_flash_reset_stats(void) {
+    memset(&g_stats, 0, sizeof(g_stats));
+    for (int i = 0; i < g_partition_count; i++) {
+        memset(g_partitions[i].table_stats, 0, sizeof(flash_io_stats_t) * g_max_tables);
+    }
+}
+
+const char *fast_flash_api_name(flash_api_t api) {
+    static const char *names[FF_API_COUNT] = {
+        "init", "create_table", "delete_table", "write", "write_by_index",
+        "append", "clear", "write_batch", "read", "gc", "validate"
+    };
+    return (api >= 0 && api < FF_API_COUNT) ? names[api] : "unknown";
+}
+
+static void print_io_stats(const char *label, const flash_io_stats_t *io) {
+    uint64_t programmed = io->data_bytes + io->metadata_bytes + io->relocation_bytes;
+    printf("%-16s %7u %10llu %10llu %10llu %10llu %6u %10llu %10llu %11.1f",
+           label, io->calls, (unsigned long long)io->user_bytes, (unsigned long long)io->data_bytes,
+           (unsigned long long)io->metadata_bytes, (unsigned long long)io->relocation_bytes,
+           io->erase_count, (unsigned long long)io->erase_bytes, (unsigned long long)io->crc_bytes,
+           io->energy_nj / 1000.0);
+    if (io->calls > 0) {
+        printf(" %9.1f", io->energy_nj / 1000.0 / io->calls);
+    } else {
+        printf("         -");
+    }
+    if (io->user_bytes > 0) {
+        printf(" %8.1f %7.1f\n", (double)io->energy_nj / io->user_bytes, (double)programmed / io->user_bytes);
+    } else {
+        printf("        -       -\n");
+    }
+}
+
+void fast_flash_print_stats(void) {
+    printf("\n=== Fast Flash I/O Statistics ===\n");
+    printf("%-16s %7s %10s %10s %10s %10s %6s %10s %10s %11s %9s %8s %7s\n",
+           "", "calls", "user", "data", "metadata", "relocate", "erases", "erased", "crc",
+           "energy_uJ", "uJ/call", "nJ/B", "WA");
+    print_io_stats("total", &g_stats.total);
+    for (int i = 0; i < FF_API_COUNT; i++) {
+        if (g_stats.per_api[i].calls > 0) {
+            print_io_stats(fast_flash_api_name((flash_api_t)i), &g_stats.per_api[i]);
+        }
+    }
+    if (g_part->manager_loaded) {
+        for (int i = 0; i < g_max_tables; i++) {
+            const flash_table_info_t *table = &g_part->manager_table->tables[i];
+            if (table->magic == MAGIC_NUMBER_TABLE && table->status == TABLE_STATUS_VALID) {
+                char label[TABLE_NAME_MAX_LEN + 8];
+                snprintf(label, sizeof(label), "table %.*s", TABLE_NAME_MAX_LEN, table->name);
+                print_io_stats(label, &g_part->table_stats[i]);
+            }
+        }
+    }
+    printf("=================================\n");
+}
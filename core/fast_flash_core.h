@@ -9,9 +9,32 @@ extern "C" {
 
     // 核心初始化函数
     int fast_flash_init(const flash_ops_t *ops, uint32_t total_size, bool allow_erase);
+    int fast_flash_init_ex(const flash_ops_t *ops, uint32_t total_size, bool allow_erase,
+                           const flash_geometry_t *geometry);  // geometry可为NULL
+    int fast_flash_init_partitions(const flash_ops_t *ops, const flash_partition_t *partitions, int count,
+                                   bool allow_erase, const flash_geometry_t *geometry);  // 每个分区独立的管理表链表和GC
+
+    // 核心内存区：在初始化之前调用，之后管理表、各表统计和GC临时数组都从buf分配，不再使用堆；
+    // 下次初始化时检查大小是否够用。buf为NULL时恢复使用堆（定义FAST_FLASH_NO_HEAP时必须提供内存区）
+    int fast_flash_set_arena(void *buf, uint32_t size);
+    uint32_t fast_flash_arena_size(const flash_partition_t *partitions, int count,
+                                   const flash_geometry_t *geometry);  // 需要的内存区大小，参数无效时返回0
+    void fast_flash_get_arena_usage(uint32_t *used, uint32_t *peak);  // 当前和最大使用量（使用堆时为0）
+
+    // 延迟挂载：在初始化之前调用，分页目录（max_tables大于FF_CATALOG_PAGE_TABLES）挂载时只读入管理表和目录页地址，
+    // 目录页在第一次访问其中的表时再读入；warm_up在空闲时读入当前分区最多max_pages个还没读入的目录页，
+    // 返回剩余页数（0表示全部读入），失败返回-1。
+    // 目录页CRC和表项总数的检查推迟到读入时：立即挂载发现最新节点的目录页损坏或表项总数不一致时回退到上一个管理表节点，
+    // 延迟挂载则不能回退，读入目录页失败的操作返回-1，表项总数不一致时分区停用，需要关闭延迟挂载后重新初始化
+    void fast_flash_set_lazy_mount(bool lazy);
+    int fast_flash_warm_up(uint32_t max_pages);
+
+    // 分区选择：之后的表操作、GC和空间统计都作用于所选分区
+    int fast_flash_select_partition(const char *name);
 
     // 表管理函数
     int fast_flash_create_table(const char *name, uint32_t struct_size, uint32_t max_structs);
+    int fast_flash_create_table_ex(const char *name, uint32_t struct_size, uint32_t max_structs, uint8_t flags);  // flags: FF_TABLE_HOT/COLD/APPEND_ONLY
     int fast_flash_delete_table(const char *name);
     int fast_flash_write_table_data(const char *table_name, const void *data, uint32_t size);
     int fast_flash_read_table_data(const char *table_name, uint32_t index, void *buffer, uint32_t size);
@@ -43,6 +66,13 @@ extern "C" {
     int fast_flash_validate_table_data(const char *table_name);
     int fast_flash_repair_table(const char *table_name);
 
+    // I/O统计：整体和各API自上次重置起累计，各表自挂载（或建表）起累计
+    int fast_flash_get_stats(flash_stats_t *stats);
+    int fast_flash_get_table_stats(const char *table_name, flash_io_stats_t *stats);
+    void fast_flash_reset_stats(void);
+    const char *fast_flash_api_name(flash_api_t api);
+    void fast_flash_print_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
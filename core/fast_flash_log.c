@@ -1,25 +1,332 @@
 #include "fast_flash_log.h"
 #include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
 
-static log_level_t current_log_level = LOG_LEVEL_INFO;
+static log_level_t current_log_level = (FAST_FLASH_LOG_LEVEL < 0) ? LOG_LEVEL_ERROR : (log_level_t)FAST_FLASH_LOG_LEVEL;
 
 void flash_log_set_level(log_level_t level) {
     current_log_level = level;
 }
 
+log_level_t flash_log_get_level(void) {
+    return current_log_level;
+}
+
 void flash_log_print(log_level_t level, const char *format, ...) {
     if (level > current_log_level) {
         return;
     }
-    
+
     va_list args;
     va_start(args, format);
-    
-    // 根据级别选择输出流
+
+    // 根据级别选择输出流，只有错误和警告需要立即刷新
     FILE *output = (level <= LOG_LEVEL_WARN) ? stderr : stdout;
-    
+
     vfprintf(output, format, args);
-    fflush(output);
-    
+    if (level <= LOG_LEVEL_WARN) {
+        fflush(output);
+    }
+
+    va_end(args);
+}
+
+// ===== 延迟二进制日志 =====
+// 记录格式：[长度u16][级别u8][保留u8][格式串地址][参数...]
+// 参数按格式串中的转换说明依次保存：整数4或8字节，浮点8字节，字符串为[长度u8][内容]
+
+#define LOG_RECORD_MAX     256     // 单条记录上限，参数超出时截断
+#define LOG_STRING_MAX     32      // %s参数最多保存的字节数
+
+typedef struct {
+    uint16_t length;
+    uint8_t  level;
+    uint8_t  truncated;
+    const char *format;
+} log_record_header_t;
+
+static uint8_t log_ring[FAST_FLASH_LOG_RING_SIZE];
+static uint32_t log_ring_head = 0;    // 下一条记录的写入位置
+static uint32_t log_ring_tail = 0;    // 最旧记录的位置
+static uint32_t log_ring_used = 0;
+static uint32_t log_ring_dropped = 0;
+
+// 一个转换说明：长度修饰符决定参数宽度，*表示宽度/精度来自参数
+typedef struct {
+    char     conv;        // 转换字符，0表示格式串结束
+    char     length;      // 0, 'h', 'l', 'L'(ll), 'z', 'j'
+    uint8_t  stars;       // *的个数
+    int      precision;   // 固定精度，-1表示未指定，-2表示来自参数
+    const char *start;    // 指向'%'
+    const char *end;      // 转换字符之后
+} log_spec_t;
+
+// 从p开始查找下一个转换说明（跳过%%）
+static const char *log_next_spec(const char *p, log_spec_t *spec) {
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        memset(spec, 0, sizeof(*spec));
+        spec->precision = -1;
+        spec->start = p++;
+        while (*p && strchr("-+ #0", *p)) p++;
+        if (*p == '*') { spec->stars++; p++; }
+        while (*p >= '0' && *p <= '9') p++;
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                spec->stars++;
+                spec->precision = -2;
+                p++;
+            } else {
+                spec->precision = 0;
+                while (*p >= '0' && *p <= '9') spec->precision = spec->precision * 10 + (*p++ - '0');
+            }
+        }
+        if (*p == 'l' && p[1] == 'l') { spec->length = 'L'; p += 2; }
+        else if (*p == 'h' && p[1] == 'h') { spec->length = 'h'; p += 2; }
+        else if (*p && strchr("hlzj", *p)) { spec->length = *p++; }
+        spec->conv = *p;
+        spec->end = *p ? p + 1 : p;
+        return spec->end;
+    }
+    spec->conv = 0;
+    return p;
+}
+
+static int log_is_wide(const log_spec_t *spec) {
+    return spec->length == 'L' || spec->length == 'j' ||
+           ((spec->length == 'l' || spec->length == 'z') && sizeof(long) == 8);
+}
+
+static void log_ring_put(const uint8_t *data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        log_ring[log_ring_head] = data[i];
+        log_ring_head = (log_ring_head + 1) % FAST_FLASH_LOG_RING_SIZE;
+    }
+    log_ring_used += size;
+}
+
+static void log_ring_get(uint32_t pos, uint8_t *data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        data[i] = log_ring[(pos + i) % FAST_FLASH_LOG_RING_SIZE];
+    }
+}
+
+static void log_ring_drop_oldest(void) {
+    log_record_header_t header;
+    log_ring_get(log_ring_tail, (uint8_t*)&header, sizeof(header));
+    log_ring_tail = (log_ring_tail + header.length) % FAST_FLASH_LOG_RING_SIZE;
+    log_ring_used -= header.length;
+    log_ring_dropped++;
+}
+
+void flash_log_record(log_level_t level, const char *format, ...) {
+    if (level > current_log_level) {
+        return;
+    }
+
+    uint8_t record[LOG_RECORD_MAX];
+    log_record_header_t header = { 0, (uint8_t)level, 0, format };
+    uint32_t pos = sizeof(header);
+
+    va_list args;
+    va_start(args, format);
+    log_spec_t spec;
+    const char *p = log_next_spec(format, &spec);
+    while (spec.conv) {
+        int precision = (spec.precision == -2) ? -1 : spec.precision;
+        uint32_t need = 4 * spec.stars + 8;
+        if (spec.conv == 's') {
+            need = 4 * spec.stars + 1 + LOG_STRING_MAX;
+        }
+        if (pos + need > sizeof(record)) {
+            header.truncated = 1;
+            break;
+        }
+        for (int i = 0; i < spec.stars; i++) {
+            int32_t star = va_arg(args, int);
+            memcpy(record + pos, &star, 4);
+            pos += 4;
+            if (i == spec.stars - 1 && spec.precision == -2) {
+                precision = star;   // 精度限制%s保存的字节数（表名等不以0结尾）
+            }
+        }
+        if (spec.conv == 's') {
+            const char *str = va_arg(args, const char*);
+            uint32_t len = 0;
+            uint32_t limit = (precision >= 0 && precision < LOG_STRING_MAX) ? (uint32_t)precision : LOG_STRING_MAX;
+            if (!str) str = "(null)";
+            while (len < limit && str[len]) len++;
+            record[pos++] = (uint8_t)len;
+            memcpy(record + pos, str, len);
+            pos += len;
+        } else if (strchr("fFeEgGaA", spec.conv)) {
+            double value = va_arg(args, double);
+            memcpy(record + pos, &value, 8);
+            pos += 8;
+        } else if (spec.conv == 'p') {
+            uint64_t value = (uint64_t)(uintptr_t)va_arg(args, void*);
+            memcpy(record + pos, &value, 8);
+            pos += 8;
+        } else if (log_is_wide(&spec)) {
+            uint64_t value = va_arg(args, unsigned long long);
+            memcpy(record + pos, &value, 8);
+            pos += 8;
+        } else {
+            uint32_t value = va_arg(args, unsigned int);
+            memcpy(record + pos, &value, 4);
+            pos += 4;
+        }
+        p = log_next_spec(p, &spec);
+    }
     va_end(args);
-}
\ No newline at end of file
+
+    header.length = (uint16_t)pos;
+    memcpy(record, &header, sizeof(header));
+    if (pos > FAST_FLASH_LOG_RING_SIZE) {
+        log_ring_dropped++;
+        return;
+    }
+    while (FAST_FLASH_LOG_RING_SIZE - log_ring_used < pos) {
+        log_ring_drop_oldest();
+    }
+    log_ring_put(record, pos);
+}
+
+// 输出格式串中的字面文本（%%还原为%）
+static size_t log_put_literal(char *out, size_t n, size_t out_size, const char *lit, const char *end) {
+    while (lit < end && *lit && n + 1 < out_size) {
+        if (lit[0] == '%' && lit[1] == '%') {
+            lit++;
+        }
+        out[n++] = *lit++;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// 按格式串把一条记录格式化为文本
+static void log_format_record(const uint8_t *record, char *out, size_t out_size) {
+    log_record_header_t header;
+    memcpy(&header, record, sizeof(header));
+    const uint8_t *arg = record + sizeof(header);
+    const uint8_t *arg_end = record + header.length;
+    size_t n = 0;
+
+    log_spec_t spec;
+    const char *lit = header.format;
+    const char *p = log_next_spec(lit, &spec);
+    while (spec.conv && n + 1 < out_size) {
+        // 转换说明之前的字面文本
+        n = log_put_literal(out, n, out_size, lit, spec.start);
+
+        int32_t stars[2] = { 0, 0 };
+        uint32_t need = 4 * spec.stars + (spec.conv == 's' ? 1 : (log_is_wide(&spec) || strchr("fFeEgGaAp", spec.conv)) ? 8 : 4);
+        if (arg + need > arg_end) {
+            lit = spec.start;
+            break;
+        }
+        for (int i = 0; i < spec.stars && i < 2; i++) {
+            memcpy(&stars[i], arg, 4);
+            arg += 4;
+        }
+
+        char fmt[32];
+        size_t spec_len = (size_t)(spec.end - spec.start);
+        if (spec_len >= sizeof(fmt)) spec_len = sizeof(fmt) - 1;
+        memcpy(fmt, spec.start, spec_len);
+        fmt[spec_len] = '\0';
+
+        char text[LOG_STRING_MAX + 1];
+        uint64_t wide = 0;
+        uint32_t narrow = 0;
+        double real = 0;
+        if (spec.conv == 's') {
+            uint32_t len = *arg++;
+            memcpy(text, arg, len);
+            text[len] = '\0';
+            arg += len;
+        } else if (strchr("fFeEgGaA", spec.conv)) {
+            memcpy(&real, arg, 8);
+            arg += 8;
+        } else if (spec.conv == 'p' || log_is_wide(&spec)) {
+            memcpy(&wide, arg, 8);
+            arg += 8;
+        } else {
+            memcpy(&narrow, arg, 4);
+            arg += 4;
+        }
+
+#define LOG_EMIT_ARG(value) \
+        (spec.stars == 0 ? snprintf(out + n, out_size - n, fmt, value) : \
+         spec.stars == 1 ? snprintf(out + n, out_size - n, fmt, stars[0], value) : \
+                           snprintf(out + n, out_size - n, fmt, stars[0], stars[1], value))
+
+        int written;
+        if (spec.conv == 's') {
+            written = LOG_EMIT_ARG(text);
+        } else if (strchr("fFeEgGaA", spec.conv)) {
+            written = LOG_EMIT_ARG(real);
+        } else if (spec.conv == 'p') {
+            written = LOG_EMIT_ARG((void*)(uintptr_t)wide);
+        } else if (spec.length == 'L' || spec.length == 'j') {
+            written = LOG_EMIT_ARG((unsigned long long)wide);
+        } else if (spec.length == 'l') {
+            written = LOG_EMIT_ARG(log_is_wide(&spec) ? (unsigned long)wide : (unsigned long)narrow);
+        } else if (spec.length == 'z') {
+            written = LOG_EMIT_ARG(log_is_wide(&spec) ? (size_t)wide : (size_t)narrow);
+        } else {
+            written = LOG_EMIT_ARG(narrow);
+        }
+#undef LOG_EMIT_ARG
+        if (written > 0) {
+            n += (size_t)written;
+        }
+        if (n >= out_size) {
+            n = out_size - 1;
+        }
+        lit = spec.end;
+        p = log_next_spec(p, &spec);
+    }
+
+    if (header.truncated || spec.conv) {
+        snprintf(out + n, out_size - n, "...\n");
+    } else {
+        log_put_literal(out, n, out_size, lit, lit + strlen(lit));
+    }
+}
+
+int flash_log_flush(FILE *out) {
+    int count = 0;
+    uint8_t record[LOG_RECORD_MAX];
+    char line[512];
+
+    while (log_ring_used > 0) {
+        log_record_header_t header;
+        log_ring_get(log_ring_tail, (uint8_t*)&header, sizeof(header));
+        log_ring_get(log_ring_tail, record, header.length);
+        log_ring_tail = (log_ring_tail + header.length) % FAST_FLASH_LOG_RING_SIZE;
+        log_ring_used -= header.length;
+
+        if (out) {
+            log_format_record(record, line, sizeof(line));
+            fputs(line, out);
+        }
+        count++;
+    }
+    log_ring_head = log_ring_tail = 0;
+    log_ring_dropped = 0;
+    return count;
+}
+
+uint32_t flash_log_dropped(void) {
+    return log_ring_dropped;
+}
@@ -2,6 +2,7 @@
 #define FAST_FLASH_LOG_H
 
 #include <stdio.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,15 +16,51 @@ typedef enum {
     LOG_LEVEL_DEBUG = 3
 } log_level_t;
 
-// 平台相关的日志函数
+// 编译期日志阈值：高于该级别的TRACE_*调用点整体去掉（-1去掉全部日志）。
+// 数值与log_level_t一致；定义RS_FLASH_DEBUG_OFF时默认去掉DEBUG日志。
+#ifndef FAST_FLASH_LOG_LEVEL
+#ifdef RS_FLASH_DEBUG_OFF
+#define FAST_FLASH_LOG_LEVEL      2
+#else
+#define FAST_FLASH_LOG_LEVEL      3
+#endif
+#endif
+
+// 延迟二进制日志的环形缓冲区大小（字节），写满时覆盖最旧的记录
+#ifndef FAST_FLASH_LOG_RING_SIZE
+#define FAST_FLASH_LOG_RING_SIZE  4096
+#endif
+
+// 平台相关的日志函数（运行时级别默认等于编译期阈值）
 void flash_log_set_level(log_level_t level);
+log_level_t flash_log_get_level(void);
 void flash_log_print(log_level_t level, const char *format, ...);
 
+// 延迟二进制日志：记录时只保存格式串地址（格式ID）和原始参数，不做格式化和输出；
+// 格式化推迟到flash_log_flush（空闲时、退出前或测试结束后调用）
+void flash_log_record(log_level_t level, const char *format, ...);
+int flash_log_flush(FILE *out);          // 格式化并输出所有记录后清空，out为NULL时只清空；返回记录数
+uint32_t flash_log_dropped(void);        // 因缓冲区写满被覆盖的记录数
+
+// 定义FAST_FLASH_LOG_DEFERRED时TRACE_*写入环形缓冲区，否则立即输出
+#ifdef FAST_FLASH_LOG_DEFERRED
+#define FF_LOG_EMIT flash_log_record
+#else
+#define FF_LOG_EMIT flash_log_print
+#endif
+
+// 阈值以上的调用点展开为if (0)：参数仍做类型检查，但不生成调用
+#define FF_LOG_AT(threshold, level, ...) do { \
+    if (FAST_FLASH_LOG_LEVEL >= (threshold)) { \
+        FF_LOG_EMIT(level, __VA_ARGS__); \
+    } \
+} while (0)
+
 // 简化的宏定义
-#define TRACE_ERROR(...) flash_log_print(LOG_LEVEL_ERROR, "[ERROR] " __VA_ARGS__)
-#define TRACE_WARN(...)  flash_log_print(LOG_LEVEL_WARN,  "[WARN]  " __VA_ARGS__)
-#define TRACE_INFO(...)   flash_log_print(LOG_LEVEL_INFO,  "[INFO]  " __VA_ARGS__)
-#define TRACE_DEBUG(...)  flash_log_print(LOG_LEVEL_DEBUG, "[DEBUG] " __VA_ARGS__)
+#define TRACE_ERROR(...) FF_LOG_AT(0, LOG_LEVEL_ERROR, "[ERROR] " __VA_ARGS__)
+#define TRACE_WARN(...)  FF_LOG_AT(1, LOG_LEVEL_WARN,  "[WARN]  " __VA_ARGS__)
+#define TRACE_INFO(...)   FF_LOG_AT(2, LOG_LEVEL_INFO,  "[INFO]  " __VA_ARGS__)
+#define TRACE_DEBUG(...)  FF_LOG_AT(3, LOG_LEVEL_DEBUG, "[DEBUG] " __VA_ARGS__)
 
 // 默认使用INFO级别
 #define TRACE(...)        TRACE_INFO(__VA_ARGS__)
@@ -32,4 +69,4 @@ void flash_log_print(log_level_t level, const char *format, ...);
 }
 #endif
 
-#endif // FAST_FLASH_LOG_H
\ No newline at end of file
+#endif // FAST_FLASH_LOG_H
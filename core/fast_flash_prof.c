@@ -0,0 +1,143 @@
+#include "fast_flash_prof.h"
+
+#ifdef FF_PROBES_ENABLED
+
+#include "fast_flash_core.h"
+#include "fast_flash_trace.h"
+#include <stdio.h>
+#include <string.h>
+
+static flash_prof_clock_t g_prof_clock = NULL;
+
+static const char *phase_names[FF_PHASE_COUNT] = {
+    "header_read", "data_read", "crc", "allocate", "program",
+    "erase", "manager_save", "mount", "gc_prepare", "gc_copy"
+};
+
+void fast_flash_prof_set_clock(flash_prof_clock_t clock) {
+    g_prof_clock = clock;
+}
+
+bool flash_prof_active(void) {
+    return g_prof_clock != NULL;
+}
+
+uint32_t flash_prof_enter(void) {
+    return g_prof_clock ? g_prof_clock() : 0;
+}
+
+const char *fast_flash_phase_name(flash_phase_t phase) {
+    return ((int)phase >= 0 && phase < FF_PHASE_COUNT) ? phase_names[phase] : "unknown";
+}
+
+#ifdef FAST_FLASH_PROFILE
+
+static flash_prof_stat_t g_prof_api[FF_API_COUNT];
+static flash_prof_stat_t g_prof_phase[FF_PHASE_COUNT];
+
+// 耗时 -> 桶下标（0us单独一桶，之后按2的幂分桶）
+static uint32_t prof_bucket_of(uint32_t us) {
+    uint32_t bucket = 0;
+    while (us) {
+        bucket++;
+        us >>= 1;
+    }
+    return bucket;
+}
+
+static void prof_add(flash_prof_stat_t *stat, uint32_t us) {
+    if (stat->count == 0 || us < stat->min_us) {
+        stat->min_us = us;
+    }
+    if (us > stat->max_us) {
+        stat->max_us = us;
+    }
+    stat->count++;
+    stat->total_us += us;
+    stat->buckets[prof_bucket_of(us)]++;
+}
+
+void fast_flash_prof_reset(void) {
+    memset(g_prof_api, 0, sizeof(g_prof_api));
+    memset(g_prof_phase, 0, sizeof(g_prof_phase));
+}
+
+const flash_prof_stat_t *fast_flash_prof_get_api(flash_api_t api) {
+    return ((int)api >= 0 && api < FF_API_COUNT) ? &g_prof_api[api] : NULL;
+}
+
+const flash_prof_stat_t *fast_flash_prof_get_phase(flash_phase_t phase) {
+    return ((int)phase >= 0 && phase < FF_PHASE_COUNT) ? &g_prof_phase[phase] : NULL;
+}
+
+// 百分位：返回累计计数达到目标的桶的上界，限制在[min, max]之内
+uint32_t fast_flash_prof_percentile(const flash_prof_stat_t *stat, uint32_t percent) {
+    if (!stat || stat->count == 0) {
+        return 0;
+    }
+    uint64_t rank = ((uint64_t)stat->count * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < FF_PROF_BUCKETS; b++) {
+        seen += stat->buckets[b];
+        if (seen >= rank) {
+            uint32_t value = (b == 0) ? 0 : (uint32_t)(((uint64_t)1 << b) - 1);
+            if (value > stat->max_us) value = stat->max_us;
+            if (value < stat->min_us) value = stat->min_us;
+            return value;
+        }
+    }
+    return stat->max_us;
+}
+
+static void prof_print_row(const char *label, const flash_prof_stat_t *stat) {
+    printf("  %-16s %8u %12llu %8u %8u %8u %8u\n", label, stat->count,
+           (unsigned long long)stat->total_us, stat->min_us,
+           fast_flash_prof_percentile(stat, 50), fast_flash_prof_percentile(stat, 99), stat->max_us);
+}
+
+void fast_flash_prof_print(void) {
+    printf("Profile (us)          count        total      min      p50      p99      max\n");
+    for (int i = 0; i < FF_API_COUNT; i++) {
+        if (g_prof_api[i].count) {
+            prof_print_row(fast_flash_api_name((flash_api_t)i), &g_prof_api[i]);
+        }
+    }
+    for (int i = 0; i < FF_PHASE_COUNT; i++) {
+        if (g_prof_phase[i].count) {
+            prof_print_row(phase_names[i], &g_prof_phase[i]);
+        }
+    }
+}
+
+#endif // FAST_FLASH_PROFILE
+
+void flash_prof_leave_api(flash_prof_scope_t *scope) {
+    if (!g_prof_clock || scope->id < 0 || scope->id >= FF_API_COUNT) {
+        return;
+    }
+    uint32_t elapsed = g_prof_clock() - scope->start;
+#ifdef FAST_FLASH_PROFILE
+    prof_add(&g_prof_api[scope->id], elapsed);
+#endif
+#ifdef FAST_FLASH_TRACE
+    flash_trace_record(FF_TRACE_API, fast_flash_api_name((flash_api_t)scope->id), scope->start, elapsed, 0, 0);
+#endif
+}
+
+void flash_prof_leave_phase(flash_prof_scope_t *scope) {
+    if (!g_prof_clock || scope->id < 0 || scope->id >= FF_PHASE_COUNT) {
+        return;
+    }
+    uint32_t elapsed = g_prof_clock() - scope->start;
+#ifdef FAST_FLASH_PROFILE
+    prof_add(&g_prof_phase[scope->id], elapsed);
+#endif
+#ifdef FAST_FLASH_TRACE
+    flash_trace_record(FF_TRACE_PHASE, phase_names[scope->id], scope->start, elapsed, 0, 0);
+#endif
+}
+
+#endif // FF_PROBES_ENABLED
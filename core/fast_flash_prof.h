@@ -0,0 +1,93 @@
+#ifndef FAST_FLASH_PROF_H
+#define FAST_FLASH_PROF_H
+
+#include "fast_flash_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 耗时剖析：在每个公共API和内部阶段的入口/出口打时间戳，按API和阶段统计次数、耗时和直方图。
+// 时钟由用户提供（微秒，允许回绕）；定义FAST_FLASH_PROFILE时才编译，否则探针展开为空。
+// 定义FAST_FLASH_TRACE时同一组探针还把每个API和阶段作为时间线事件记录（见fast_flash_trace.h）。
+
+// 内部阶段（阶段可以嵌套，例如管理表保存包含CRC和编程，耗时按包含子阶段统计）
+typedef enum {
+    FF_PHASE_HEADER_READ = 0,  // 读取表头
+    FF_PHASE_DATA_READ,        // 读取表数据
+    FF_PHASE_CRC,              // CRC计算
+    FF_PHASE_ALLOCATE,         // 分配表空间
+    FF_PHASE_PROGRAM,          // 编程（每次设备写入）
+    FF_PHASE_ERASE,            // 擦除（每次设备擦除）
+    FF_PHASE_MANAGER_SAVE,     // 保存管理表
+    FF_PHASE_MOUNT,            // 挂载：遍历管理表链表并加载
+    FF_PHASE_GC_PREPARE,       // GC：准备目标扇区
+    FF_PHASE_GC_COPY,          // GC：搬运一张表
+    FF_PHASE_COUNT
+} flash_phase_t;
+
+// 用户时钟：返回单调递增的微秒计数
+typedef uint32_t (*flash_prof_clock_t)(void);
+
+// 耗时直方图：第0桶为0us，第b桶覆盖[2^(b-1), 2^b)us
+#define FF_PROF_BUCKETS   33
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[FF_PROF_BUCKETS];
+} flash_prof_stat_t;
+
+#if defined(FAST_FLASH_PROFILE) || defined(FAST_FLASH_TRACE)
+#define FF_PROBES_ENABLED
+#endif
+
+#ifdef FF_PROBES_ENABLED
+
+// 设置时钟，NULL表示停止采样（探针只剩一次判断）
+void fast_flash_prof_set_clock(flash_prof_clock_t clock);
+bool flash_prof_active(void);
+const char *fast_flash_phase_name(flash_phase_t phase);
+
+// 探针（由核心调用）：enter返回时间戳，leave记录从该时间戳到现在的耗时
+typedef struct {
+    int      id;
+    uint32_t start;
+} flash_prof_scope_t;
+
+uint32_t flash_prof_enter(void);
+void flash_prof_leave_api(flash_prof_scope_t *scope);
+void flash_prof_leave_phase(flash_prof_scope_t *scope);
+
+// 作用域探针：变量离开作用域时（包括每个return）自动记录
+#define FF_PROF_API(api) \
+    flash_prof_scope_t ff_prof_api_scope __attribute__((cleanup(flash_prof_leave_api))) = { (int)(api), flash_prof_enter() }
+#define FF_PROF_PHASE(phase) \
+    flash_prof_scope_t ff_prof_phase_scope __attribute__((cleanup(flash_prof_leave_phase))) = { (int)(phase), flash_prof_enter() }
+
+#else
+
+#define FF_PROF_API(api)     ((void)0)
+#define FF_PROF_PHASE(phase) ((void)0)
+
+#endif // FF_PROBES_ENABLED
+
+#ifdef FAST_FLASH_PROFILE
+
+void fast_flash_prof_reset(void);
+
+// 查询
+const flash_prof_stat_t *fast_flash_prof_get_api(flash_api_t api);
+const flash_prof_stat_t *fast_flash_prof_get_phase(flash_phase_t phase);
+uint32_t fast_flash_prof_percentile(const flash_prof_stat_t *stat, uint32_t percent);
+void fast_flash_prof_print(void);
+
+#endif // FAST_FLASH_PROFILE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FAST_FLASH_PROF_H
@@ -0,0 +1,299 @@
+#include "fast_flash_record.h"
+#include <string.h>
+
+// 每种操作的字段：是否有名字、整数参数个数、是否有数据摘要（FF_REC_INIT单独处理）
+typedef struct {
+    const char *name;
+    uint8_t has_name;
+    uint8_t args;
+    uint8_t has_digest;
+} record_layout_t;
+
+static const record_layout_t record_layouts[FF_REC_OP_COUNT] = {
+    [FF_REC_INIT]             = { "init",             0, 0, 0 },
+    [FF_REC_SELECT_PARTITION] = { "select_partition", 1, 0, 0 },
+    [FF_REC_CREATE_TABLE]     = { "create_table",     1, 3, 0 },
+    [FF_REC_DELETE_TABLE]     = { "delete_table",     1, 0, 0 },
+    [FF_REC_WRITE]            = { "write",            1, 1, 1 },
+    [FF_REC_READ]             = { "read",             1, 2, 0 },
+    [FF_REC_WRITE_BY_INDEX]   = { "write_by_index",   1, 2, 1 },
+    [FF_REC_APPEND]           = { "append",           1, 1, 1 },
+    [FF_REC_CLEAR]            = { "clear",            1, 1, 0 },
+    [FF_REC_WRITE_BATCH]      = { "write_batch",      1, 2, 1 },
+    [FF_REC_GET_COUNT]        = { "get_count",        1, 0, 0 },
+    [FF_REC_SET_ERASE]        = { "set_erase",        0, 1, 0 },
+    [FF_REC_GC]               = { "gc",               0, 0, 0 },
+    [FF_REC_VALIDATE]         = { "validate",         1, 0, 0 },
+    [FF_REC_REPAIR]           = { "repair",           1, 0, 0 },
+};
+
+const char *fast_flash_record_op_name(flash_record_op_t op) {
+    return (op > 0 && op < FF_REC_OP_COUNT) ? record_layouts[op].name : "unknown";
+}
+
+// FNV-1a
+uint32_t fast_flash_record_digest(const void *data, uint32_t size) {
+    const uint8_t *p = (const uint8_t*)data;
+    uint32_t hash = 2166136261u;
+    if (!p) {
+        return 0;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// ===== 解码 =====
+
+typedef struct {
+    const uint8_t *buf;
+    uint32_t size;
+    uint32_t pos;
+    int      status;     // 0正常，1数据不完整，-1格式错误
+} record_reader_t;
+
+static uint64_t get_varint(record_reader_t *r) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (r->pos >= r->size) {
+            r->status = 1;
+            return 0;
+        }
+        uint8_t byte = r->buf[r->pos++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    r->status = -1;
+    return 0;
+}
+
+static void get_name(record_reader_t *r, char *name) {
+    if (r->pos >= r->size) {
+        r->status = 1;
+        return;
+    }
+    uint8_t len = r->buf[r->pos++];
+    if (len > TABLE_NAME_MAX_LEN) {
+        r->status = -1;
+        return;
+    }
+    if (r->pos + len > r->size) {
+        r->status = 1;
+        return;
+    }
+    memcpy(name, r->buf + r->pos, len);
+    name[len] = '\0';
+    r->pos += len;
+}
+
+static uint32_t get_u32(record_reader_t *r) {
+    if (r->pos + 4 > r->size) {
+        r->status = 1;
+        return 0;
+    }
+    const uint8_t *p = r->buf + r->pos;
+    r->pos += 4;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+int fast_flash_record_check_header(const uint8_t *buf, uint32_t size) {
+    if (!buf || size < FF_RECORD_HEADER_SIZE || memcmp(buf, FF_RECORD_MAGIC, 4) != 0 ||
+        buf[4] != FF_RECORD_VERSION) {
+        return -1;
+    }
+    return FF_RECORD_HEADER_SIZE;
+}
+
+int fast_flash_record_decode(const uint8_t *buf, uint32_t size, flash_record_t *record) {
+    if (!buf || !record) {
+        return -1;
+    }
+    if (size == 0) {
+        return 0;
+    }
+
+    record_reader_t r = { buf, size, 0, 0 };
+    memset(record, 0, sizeof(*record));
+    record->op = buf[r.pos++];
+    if (record->op == 0 || record->op >= FF_REC_OP_COUNT) {
+        return -1;
+    }
+
+    if (record->op == FF_REC_INIT) {
+        record->args[0] = get_varint(&r);
+        record->geometry.sector_size = (uint32_t)get_varint(&r);
+        record->geometry.page_size = (uint32_t)get_varint(&r);
+        record->geometry.write_granularity = (uint32_t)get_varint(&r);
+        record->geometry.max_tables = (uint32_t)get_varint(&r);
+        for (int i = 0; i < FF_MAX_ERASE_SIZES; i++) {
+            record->geometry.erase_sizes[i] = (uint32_t)get_varint(&r);
+        }
+        uint64_t count = get_varint(&r);
+        if (r.status == 0 && count > FF_MAX_PARTITIONS) {
+            return -1;
+        }
+        record->partition_count = (int)count;
+        for (int i = 0; i < record->partition_count && r.status == 0; i++) {
+            char name[TABLE_NAME_MAX_LEN + 1];
+            get_name(&r, name);
+            memcpy(record->partitions[i].name, name, TABLE_NAME_MAX_LEN);
+            record->partitions[i].offset = (uint32_t)get_varint(&r);
+            record->partitions[i].size = (uint32_t)get_varint(&r);
+        }
+    } else {
+        const record_layout_t *layout = &record_layouts[record->op];
+        if (layout->has_name) {
+            get_name(&r, record->name);
+        }
+        for (int i = 0; i < layout->args && r.status == 0; i++) {
+            record->args[i] = get_varint(&r);
+        }
+        if (layout->has_digest && r.status == 0) {
+            record->digest = get_u32(&r);
+        }
+    }
+
+    if (r.status != 0) {
+        return (r.status > 0) ? 0 : -1;
+    }
+    return (int)r.pos;
+}
+
+#ifdef FAST_FLASH_RECORD
+
+// ===== 录制 =====
+
+static flash_record_sink_t g_record_sink = NULL;
+static void *g_record_ctx = NULL;
+static uint32_t g_record_count = 0;
+static bool g_record_busy = false;      // 输出函数执行期间不录制
+
+typedef struct {
+    uint8_t  buf[FF_RECORD_MAX_SIZE];
+    uint32_t pos;
+} record_writer_t;
+
+static void put_u8(record_writer_t *w, uint8_t value) {
+    if (w->pos < sizeof(w->buf)) {
+        w->buf[w->pos++] = value;
+    }
+}
+
+static void put_varint(record_writer_t *w, uint64_t value) {
+    while (value >= 0x80) {
+        put_u8(w, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put_u8(w, (uint8_t)value);
+}
+
+static void put_name(record_writer_t *w, const char *name) {
+    uint8_t len = 0;
+    while (name && len < TABLE_NAME_MAX_LEN && name[len]) {
+        len++;
+    }
+    put_u8(w, len);
+    for (uint8_t i = 0; i < len; i++) {
+        put_u8(w, (uint8_t)name[i]);
+    }
+}
+
+static void put_u32(record_writer_t *w, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        put_u8(w, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+static void record_emit(const record_writer_t *w) {
+    g_record_busy = true;
+    g_record_sink(w->buf, w->pos, g_record_ctx);
+    g_record_busy = false;
+    g_record_count++;
+}
+
+void fast_flash_record_start(flash_record_sink_t sink, void *ctx) {
+    g_record_sink = sink;
+    g_record_ctx = ctx;
+    g_record_count = 0;
+    if (sink) {
+        record_writer_t w = { .pos = 0 };
+        for (int i = 0; i < 4; i++) {
+            put_u8(&w, (uint8_t)FF_RECORD_MAGIC[i]);
+        }
+        put_u8(&w, FF_RECORD_VERSION);
+        g_record_busy = true;
+        sink(w.buf, w.pos, ctx);
+        g_record_busy = false;
+    }
+}
+
+void fast_flash_record_stop(void) {
+    g_record_sink = NULL;
+    g_record_ctx = NULL;
+}
+
+uint32_t fast_flash_record_count(void) {
+    return g_record_count;
+}
+
+void flash_record_call(flash_record_op_t op, const char *name, uint64_t a0, uint64_t a1, uint64_t a2,
+                       const void *data, uint32_t data_size) {
+    if (!g_record_sink || g_record_busy || op <= FF_REC_INIT || op >= FF_REC_OP_COUNT) {
+        return;
+    }
+
+    const record_layout_t *layout = &record_layouts[op];
+    const uint64_t args[3] = { a0, a1, a2 };
+    record_writer_t w = { .pos = 0 };
+    put_u8(&w, (uint8_t)op);
+    if (layout->has_name) {
+        put_name(&w, name);
+    }
+    for (int i = 0; i < layout->args; i++) {
+        put_varint(&w, args[i]);
+    }
+    if (layout->has_digest) {
+        put_u32(&w, fast_flash_record_digest(data, data_size));
+    }
+    record_emit(&w);
+}
+
+void flash_record_init(const flash_partition_t *partitions, int count, bool allow_erase,
+                       const flash_geometry_t *geometry) {
+    if (!g_record_sink || g_record_busy) {
+        return;
+    }
+    if (!partitions || count < 0 || count > FF_MAX_PARTITIONS) {
+        count = 0;
+    }
+
+    flash_geometry_t defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    if (!geometry) {
+        geometry = &defaults;
+    }
+
+    record_writer_t w = { .pos = 0 };
+    put_u8(&w, FF_REC_INIT);
+    put_varint(&w, allow_erase ? 1 : 0);
+    put_varint(&w, geometry->sector_size);
+    put_varint(&w, geometry->page_size);
+    put_varint(&w, geometry->write_granularity);
+    put_varint(&w, geometry->max_tables);
+    for (int i = 0; i < FF_MAX_ERASE_SIZES; i++) {
+        put_varint(&w, geometry->erase_sizes[i]);
+    }
+    put_varint(&w, (uint64_t)count);
+    for (int i = 0; i < count; i++) {
+        put_name(&w, partitions[i].name);
+        put_varint(&w, partitions[i].offset);
+        put_varint(&w, partitions[i].size);
+    }
+    record_emit(&w);
+}
+
+#endif // FAST_FLASH_RECORD
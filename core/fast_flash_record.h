@@ -0,0 +1,92 @@
+#ifndef FAST_FLASH_RECORD_H
+#define FAST_FLASH_RECORD_H
+
+#include "fast_flash_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 负载录制：把每次公共API调用（操作、表名、参数、数据大小）编码为紧凑的二进制记录，
+// 通过用户提供的输出函数写出（串口、RAM缓冲区、文件等），在主机上用fast_flash_replay按不同配置回放。
+// 数据内容不录制，只录制32位摘要：回放时按摘要生成数据，原来相同的数据回放时仍然相同，
+// "数据未变化跳过写入"等依赖内容的行为得以保留。
+// 定义FAST_FLASH_RECORD时核心才调用录制钩子，否则钩子展开为空；解码函数总是编译，供主机工具使用。
+// 只读的内存查询（表信息、表列表、表是否存在、容量查询）不访问Flash，不录制。
+
+// 格式：文件头 = "FFRC" + 版本（1字节）；之后每条记录 = 操作码（1字节） + 该操作码的字段。
+// 整数字段为LEB128变长编码，名字为 长度（1字节） + 字符（不含结尾0），数据摘要为4字节小端FNV-1a。
+#define FF_RECORD_MAGIC          "FFRC"
+#define FF_RECORD_VERSION        1
+#define FF_RECORD_HEADER_SIZE    5
+#define FF_RECORD_MAX_SIZE       192   // 单条记录编码后的最大字节数
+
+typedef enum {
+    FF_REC_INIT = 1,            // allow_erase, 几何参数（4 + FF_MAX_ERASE_SIZES个）, 分区数, 每个分区（名字, 偏移, 大小）
+    FF_REC_SELECT_PARTITION,    // 名字
+    FF_REC_CREATE_TABLE,        // 表名, struct_size, max_structs, flags
+    FF_REC_DELETE_TABLE,        // 表名
+    FF_REC_WRITE,               // 表名, size, 摘要
+    FF_REC_READ,                // 表名, index, size
+    FF_REC_WRITE_BY_INDEX,      // 表名, index, size, 摘要
+    FF_REC_APPEND,              // 表名, size, 摘要
+    FF_REC_CLEAR,               // 表名, clear_mask
+    FF_REC_WRITE_BATCH,         // 表名, struct_size, count, 摘要
+    FF_REC_GET_COUNT,           // 表名
+    FF_REC_SET_ERASE,           // allowed
+    FF_REC_GC,                  // 无字段
+    FF_REC_VALIDATE,            // 表名
+    FF_REC_REPAIR,              // 表名
+    FF_REC_OP_COUNT
+} flash_record_op_t;
+
+// 解码后的一条记录
+typedef struct {
+    uint8_t  op;
+    char     name[TABLE_NAME_MAX_LEN + 1];
+    uint64_t args[3];           // 按上面的字段顺序（FF_REC_INIT：args[0]为allow_erase）
+    uint32_t digest;            // 写入类操作的数据摘要
+    flash_geometry_t  geometry; // 以下只用于FF_REC_INIT
+    flash_partition_t partitions[FF_MAX_PARTITIONS];
+    int      partition_count;
+} flash_record_t;
+
+const char *fast_flash_record_op_name(flash_record_op_t op);
+uint32_t fast_flash_record_digest(const void *data, uint32_t size);
+
+// 检查文件头：成功返回头长度，否则返回-1
+int fast_flash_record_check_header(const uint8_t *buf, uint32_t size);
+// 解码一条记录：成功返回消耗的字节数，数据不完整返回0，格式错误返回-1
+int fast_flash_record_decode(const uint8_t *buf, uint32_t size, flash_record_t *record);
+
+#ifdef FAST_FLASH_RECORD
+
+// 输出函数：每条记录调用一次（文件头单独一次），录制期间它内部对本库的调用不会被录制
+typedef void (*flash_record_sink_t)(const uint8_t *data, uint32_t size, void *ctx);
+
+void fast_flash_record_start(flash_record_sink_t sink, void *ctx);  // 写出文件头并开始录制
+void fast_flash_record_stop(void);
+uint32_t fast_flash_record_count(void);                            // 本次录制的记录数
+
+// 录制钩子（由核心调用）
+void flash_record_call(flash_record_op_t op, const char *name, uint64_t a0, uint64_t a1, uint64_t a2,
+                       const void *data, uint32_t data_size);
+void flash_record_init(const flash_partition_t *partitions, int count, bool allow_erase,
+                       const flash_geometry_t *geometry);
+
+#define FF_RECORD(op, name, a0, a1, a2, data, size) flash_record_call(op, name, a0, a1, a2, data, size)
+#define FF_RECORD_INIT(partitions, count, allow_erase, geometry) \
+    flash_record_init(partitions, count, allow_erase, geometry)
+
+#else
+
+#define FF_RECORD(op, name, a0, a1, a2, data, size)              ((void)0)
+#define FF_RECORD_INIT(partitions, count, allow_erase, geometry) ((void)0)
+
+#endif // FAST_FLASH_RECORD
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FAST_FLASH_RECORD_H
@@ -0,0 +1,88 @@
+#include "fast_flash_trace.h"
+
+#ifdef FAST_FLASH_TRACE
+
+#include "fast_flash_prof.h"
+#include <string.h>
+
+static flash_trace_event_t g_trace_events[FAST_FLASH_TRACE_EVENTS];
+static uint32_t g_trace_next = 0;      // 下一个写入位置
+static uint32_t g_trace_count = 0;
+static uint32_t g_trace_dropped = 0;
+
+static const char *category_names[FF_TRACE_CATEGORY_COUNT] = { "api", "phase", "device" };
+
+void fast_flash_trace_reset(void) {
+    memset(g_trace_events, 0, sizeof(g_trace_events));
+    g_trace_next = 0;
+    g_trace_count = 0;
+    g_trace_dropped = 0;
+}
+
+uint32_t fast_flash_trace_count(void) {
+    return g_trace_count;
+}
+
+uint32_t fast_flash_trace_dropped(void) {
+    return g_trace_dropped;
+}
+
+const flash_trace_event_t *fast_flash_trace_get(uint32_t index) {
+    if (index >= g_trace_count) {
+        return NULL;
+    }
+    uint32_t oldest = (g_trace_next + FAST_FLASH_TRACE_EVENTS - g_trace_count) % FAST_FLASH_TRACE_EVENTS;
+    return &g_trace_events[(oldest + index) % FAST_FLASH_TRACE_EVENTS];
+}
+
+void flash_trace_record(flash_trace_category_t category, const char *name,
+                        uint32_t ts_us, uint32_t dur_us, uint32_t addr, uint32_t size) {
+    flash_trace_event_t *event = &g_trace_events[g_trace_next];
+    event->name = name;
+    event->ts_us = ts_us;
+    event->dur_us = dur_us;
+    event->addr = addr;
+    event->size = size;
+    event->category = (uint8_t)category;
+
+    g_trace_next = (g_trace_next + 1) % FAST_FLASH_TRACE_EVENTS;
+    if (g_trace_count < FAST_FLASH_TRACE_EVENTS) {
+        g_trace_count++;
+    } else {
+        g_trace_dropped++;
+    }
+}
+
+void flash_trace_device(const char *name, uint32_t dur_us, uint32_t addr, uint32_t size) {
+    if (flash_prof_active()) {
+        flash_trace_record(FF_TRACE_DEVICE, name, flash_prof_enter() - dur_us, dur_us, addr, size);
+    }
+}
+
+// 核心事件在线程1（API和阶段按时间嵌套显示），设备事件在线程2
+int fast_flash_trace_write_json(FILE *out) {
+    if (!out) {
+        return -1;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"fast_flash\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"core\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"flash device\"}}");
+
+    for (uint32_t i = 0; i < g_trace_count; i++) {
+        const flash_trace_event_t *event = fast_flash_trace_get(i);
+        int device = (event->category == FF_TRACE_DEVICE);
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":1,\"tid\":%d",
+                event->name, category_names[event->category], event->ts_us, event->dur_us, device ? 2 : 1);
+        if (device) {
+            fprintf(out, ",\"args\":{\"addr\":\"0x%08X\",\"size\":%u}", event->addr, event->size);
+        }
+        fprintf(out, "}");
+    }
+
+    fprintf(out, "\n],\"otherData\":{\"dropped_events\":%u}}\n", g_trace_dropped);
+    return 0;
+}
+
+#endif // FAST_FLASH_TRACE
@@ -0,0 +1,62 @@
+#ifndef FAST_FLASH_TRACE_H
+#define FAST_FLASH_TRACE_H
+
+#include "fast_flash_types.h"
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 时间线追踪：核心API、内部阶段和设备操作作为带时长的事件写入环形缓冲区，
+// 导出为Chrome trace-event JSON（chrome://tracing、ui.perfetto.dev可直接打开）。
+// 定义FAST_FLASH_TRACE时才编译；时间戳来自fast_flash_prof_set_clock设置的时钟。
+
+// 环形缓冲区事件数，写满时覆盖最旧的事件
+#ifndef FAST_FLASH_TRACE_EVENTS
+#define FAST_FLASH_TRACE_EVENTS   4096
+#endif
+
+typedef enum {
+    FF_TRACE_API = 0,      // 公共API（核心轨道）
+    FF_TRACE_PHASE,        // 内部阶段（核心轨道，嵌套在API之内）
+    FF_TRACE_DEVICE,       // 设备读写擦除（设备轨道，由适配层记录）
+    FF_TRACE_CATEGORY_COUNT
+} flash_trace_category_t;
+
+typedef struct {
+    const char *name;      // 静态字符串
+    uint32_t ts_us;        // 开始时间
+    uint32_t dur_us;       // 持续时间
+    uint32_t addr;         // 设备事件：地址
+    uint32_t size;         // 设备事件：字节数
+    uint8_t  category;
+} flash_trace_event_t;
+
+#ifdef FAST_FLASH_TRACE
+
+void fast_flash_trace_reset(void);
+uint32_t fast_flash_trace_count(void);      // 缓冲区中的事件数
+uint32_t fast_flash_trace_dropped(void);    // 被覆盖的事件数
+const flash_trace_event_t *fast_flash_trace_get(uint32_t index);  // 按时间先后，0为最旧
+int fast_flash_trace_write_json(FILE *out);
+
+// 记录一个已结束的事件
+void flash_trace_record(flash_trace_category_t category, const char *name,
+                        uint32_t ts_us, uint32_t dur_us, uint32_t addr, uint32_t size);
+// 适配层在设备操作完成后调用：dur_us为器件耗时，开始时间按当前时钟倒推
+void flash_trace_device(const char *name, uint32_t dur_us, uint32_t addr, uint32_t size);
+
+#define FF_TRACE_DEVICE(name, dur_us, addr, size) flash_trace_device(name, dur_us, addr, size)
+
+#else
+
+#define FF_TRACE_DEVICE(name, dur_us, addr, size) ((void)0)
+
+#endif // FAST_FLASH_TRACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FAST_FLASH_TRACE_H
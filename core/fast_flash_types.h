@@ -8,14 +8,31 @@
 extern "C" {
 #endif
 
-// Flash 基本配置
+// Flash 基本配置（默认值，运行时可通过 flash_geometry_t 覆盖）
 #define FLASH_SECTOR_SIZE         0x1000      // 4KB 扇区大小
-#define FLASH_WRITE_CHUNK_SIZE    1024        // 每次写入1KB
+#define FLASH_WRITE_CHUNK_SIZE    1024        // 每次写入1KB（默认编程页大小）
 #define MAX_TABLES_ALL_SECTOR     24           //最多表数量  这个跟空间利用率有关 建议改小
+#define FF_MAX_TABLES_LIMIT       4096        // 运行时最多表数量上限（分页目录的页地址数组要放进一个管理表）
+#define FF_CATALOG_PAGE_TABLES    32          // 目录页容纳的表项数量，max_tables超过它时管理表改为分页目录
+#define FF_MAX_WRITE_GRANULARITY  32          // 支持的最大编程粒度
+#ifndef FF_STREAM_BUFFER_SIZE
+#define FF_STREAM_BUFFER_SIZE     256         // 表数据搬运/清除/校验的流式缓冲区大小（最大编程粒度的整数倍）
+#endif
 #define TABLE_NAME_MAX_LEN        8           // 表名最大长度
 #define MAGIC_NUMBER_TABLE        0x0531      // 表魔数
 #define MAGIC_NUMBER_MANAGER      0xAAAA      // 管理表魔数 "AA"
-#define MANAGER_TABLE_VERSION     1           // 管理表版本
+#define MAGIC_NUMBER_CATALOG      0xCA7A      // 目录页魔数
+#define FF_MAX_ERASE_SIZES        4           // 最多支持的擦除粒度种类
+#define FF_MAX_PARTITIONS         4           // 最多分区数量
+#define MANAGER_TABLE_VERSION     2           // 管理表版本（v2：增加分类写入头，记录几何参数，表头CRC，字段自然对齐，只存有效表项，分页目录；
+                                              // 挂载时自动迁移v1）
+
+// 表创建标志（放置提示），低两位为温度类别
+#define FF_TABLE_HOT              0x00        // 频繁改写的表（计数器、当前状态），与管理表共用写入流
+#define FF_TABLE_COLD             0x01        // 很少改写的表（校准参数等）
+#define FF_TABLE_APPEND_ONLY      0x02        // 只追加的表（历史记录），不允许按索引修改和清除
+#define FF_TABLE_CLASS_MASK       0x03
+#define FF_TABLE_CLASS_COUNT      3           // 温度类别数量，每个类别有独立的打开扇区
 
 // 表状态枚举
 typedef enum {
@@ -35,30 +52,52 @@ typedef struct __attribute__((packed)) {
     uint32_t data_crc;            // 数据CRC校验
 } table_header_t;
 
-// Flash表信息（管理表中存储）
-typedef struct __attribute__((packed)) {
+// Flash表信息（管理表中存储），字段自然对齐
+typedef struct {
     char     name[TABLE_NAME_MAX_LEN]; // 表名
     uint32_t addr;                // 表在Flash中的起始地址
     uint32_t size;                // 表分配的空间大小
     uint32_t used_size;           // 已使用大小
     uint16_t magic;               // 表魔数
     uint8_t  status;              // 表状态
-    uint8_t  reserved;            // 保留字段
-    uint32_t next_manager_addr;   // 下一个管理表地址（链表）
+    uint8_t  flags;               // 表创建标志（FF_TABLE_*）
 } flash_table_info_t;
 
-// 管理表结构体
-typedef struct __attribute__((packed)) {
+// 管理表结构体（字段自然对齐，Flash中的映像与RAM中的布局相同）
+// 内联目录（max_tables不超过FF_CATALOG_PAGE_TABLES）：Flash中表头之后是table_count个有效表项；
+// 分页目录：表头之后是page_count个目录页地址，表项按槽位每FF_CATALOG_PAGE_TABLES个一页单独存放，保存时只重写修改过的页。
+// RAM中tables为max_tables个槽位，删除的槽位留空
+typedef struct {
     uint16_t magic;                    // 管理表魔数
-    uint32_t crc;                      // CRC32校验（放在魔数后面）
     uint8_t  version;                  // 版本号
-    uint8_t  table_count;              // 有效表数量
+    uint8_t  reserved;                 // 保留（0）
+    uint32_t crc;                      // CRC32校验（从header_crc到映像末尾）
+    uint32_t header_crc;               // 表头CRC（magic到reserved、table_count到write_granularity），挂载时只读表头遍历链表
+    uint16_t table_count;              // 有效表数量
+    uint16_t page_count;               // 目录页地址数量（0表示内联目录）
     uint32_t total_size;               // Flash总大小
     uint32_t used_size;                // 已使用大小
     uint32_t next_manager_addr;        // 下一个管理表预留地址
-    flash_table_info_t tables[MAX_TABLES_ALL_SECTOR]; // 表信息数组
+    uint32_t next_manager_size;        // 下一个管理表预留大小（比当前多一个表项或一个目录页）
+    uint32_t next_free_sector;         // 下一个未分配扇区（各类别共享的分配前沿）
+    uint32_t class_heads[FF_TABLE_CLASS_COUNT]; // 各类别打开扇区的写入位置，0表示未打开
+    uint32_t sector_size;              // 创建时的扇区大小
+    uint16_t max_tables;               // 表槽位数量
+    uint16_t write_granularity;        // 创建时的编程粒度
+    flash_table_info_t tables[];       // 表信息数组
 } flash_manager_table_t;
 
+// 分页目录的目录页（Flash中页头之后是count个有效表项，依次对应该页从头开始的槽位）
+// 表按表名散列选择目录页，页满时放入后面第一个有空槽位的页，散列页记录这样的表最远放到了后面第几页，
+// 按名查找只需读入散列页和它之后probe个页
+typedef struct {
+    uint16_t magic;                    // 目录页魔数
+    uint16_t page;                     // 页号
+    uint16_t count;                    // 有效表项数量
+    uint16_t probe;                    // 散列到本页的表最远放在本页之后第几页（0表示都在本页）
+    uint32_t crc;                      // CRC32校验（magic到probe和全部表项）
+} flash_catalog_page_t;
+
 // 公共表结构（对外API使用）
 typedef struct {
     char     name[TABLE_NAME_MAX_LEN];
@@ -67,14 +106,88 @@ typedef struct {
     uint32_t used_size;
     uint16_t magic;
     uint8_t  status;
+    uint8_t  flags;
 } flash_table_t;
 
+// Flash几何与容量配置（运行时），字段为0时使用上面的默认值
+typedef struct {
+    uint32_t sector_size;        // 最小擦除单元大小，表不跨扇区
+    uint32_t page_size;          // 编程页大小，分块写入不跨页
+    uint32_t write_granularity;  // 最小编程单位（2的幂），表和管理表地址按此对齐
+    uint32_t max_tables;         // 管理表容纳的表数量，决定管理表在Flash和RAM中的大小
+    uint32_t erase_sizes[FF_MAX_ERASE_SIZES]; // 支持的擦除粒度（字节，从小到大，0表示结束），均为扇区大小的整数倍
+} flash_geometry_t;
+
+// I/O统计按入口API归类
+typedef enum {
+    FF_API_INIT = 0,          // 初始化/挂载
+    FF_API_CREATE_TABLE,
+    FF_API_DELETE_TABLE,
+    FF_API_WRITE,             // fast_flash_write_table_data
+    FF_API_WRITE_BY_INDEX,
+    FF_API_APPEND,
+    FF_API_CLEAR,
+    FF_API_WRITE_BATCH,
+    FF_API_READ,              // 读取、查询表数据数量
+    FF_API_GC,
+    FF_API_VALIDATE,          // 校验和修复
+    FF_API_COUNT
+} flash_api_t;
+
+// I/O计数：写放大 = (data_bytes + metadata_bytes + relocation_bytes) / user_bytes
+typedef struct {
+    uint32_t calls;              // API调用次数
+    uint64_t user_bytes;         // 用户提交的数据字节数（成功的写入）
+    uint64_t data_bytes;         // 表头和数据的编程字节数（含对齐填充）
+    uint64_t metadata_bytes;     // 管理表和目录页的编程字节数
+    uint64_t relocation_bytes;   // GC搬运的编程字节数
+    uint64_t read_bytes;         // 读取字节数
+    uint32_t erase_count;        // 擦除次数
+    uint64_t erase_bytes;        // 擦除字节数
+    uint64_t crc_bytes;          // 参与CRC计算的字节数
+    uint64_t energy_nj;          // 器件能耗（纳焦），由flash_ops_t.energy的差值得到
+} flash_io_stats_t;
+
+typedef struct {
+    flash_io_stats_t total;
+    flash_io_stats_t per_api[FF_API_COUNT];
+} flash_stats_t;
+
+// 分区描述：Flash中一段独立管理的地址区间（按扇区对齐）
+typedef struct {
+    char     name[TABLE_NAME_MAX_LEN]; // 分区名
+    uint32_t offset;                   // 起始地址
+    uint32_t size;                     // 分区大小
+} flash_partition_t;
+
+// 核心内存区（arena）大小上限：count个分区、每个分区最多max_tables张表、最大分区part_size字节时，
+// 管理表、目录索引、各表统计和GC临时数组需要的字节数（编译期可用，用于定义静态缓冲区；精确值见fast_flash_arena_size）
+#define FF_ARENA_ALIGN(n)         (((n) + 7u) & ~7u)
+#define FF_ARENA_GC_ITEM_SIZE     20          // 一个GC搬运计划项的大小
+#define FF_CATALOG_PAGES(max_tables) \
+    ((max_tables) > FF_CATALOG_PAGE_TABLES ? ((max_tables) + FF_CATALOG_PAGE_TABLES - 1) / FF_CATALOG_PAGE_TABLES : 0)
+#define FF_NAME_INDEX_SIZE(max_tables)  (2 * (max_tables) + 1)   // 表名散列索引的桶数量（装载率不超过一半）
+#define FF_CATALOG_RAM_SIZE(max_tables) \
+    (FF_CATALOG_PAGES(max_tables) * sizeof(uint32_t) + FF_NAME_INDEX_SIZE(max_tables) * sizeof(uint16_t) + \
+     2 * ((FF_CATALOG_PAGES(max_tables) + 7) / 8) + FF_CATALOG_PAGES(max_tables))
+#define FF_ARENA_SIZE(count, max_tables, part_size, sector_size) \
+    ((count) * (FF_ARENA_ALIGN(sizeof(flash_manager_table_t) + (max_tables) * sizeof(flash_table_info_t) + FF_MAX_WRITE_GRANULARITY) + \
+                FF_ARENA_ALIGN((max_tables) * sizeof(flash_io_stats_t)) + FF_ARENA_ALIGN(FF_CATALOG_RAM_SIZE(max_tables))) + \
+     2 * FF_ARENA_ALIGN((max_tables) * FF_ARENA_GC_ITEM_SIZE) + \
+     FF_ARENA_ALIGN(FF_CATALOG_PAGES(max_tables) * sizeof(uint32_t)) + \
+     FF_ARENA_ALIGN(((part_size) / (sector_size) + 7) / 8) + \
+     FF_ARENA_ALIGN((part_size) / (sector_size) * sizeof(uint32_t)))
+
 // Flash设备操作接口
 typedef struct {
     int (*init)(void);
     int (*read)(uint32_t addr, uint8_t *buf, uint32_t size);
     int (*write)(uint32_t addr, const uint8_t *buf, uint32_t size);
     int (*erase)(uint32_t addr, uint32_t size);
+    int (*sync)(void);     // 可选：持久化屏障，返回后之前的写入和擦除都已落盘；NULL表示写入即持久
+    int (*copy)(uint32_t dst, uint32_t src, uint32_t size);  // 可选：器件内部复制（控制器/DMA），dst已擦除、不跨编程页、
+                                                             // 与src不重叠；NULL时核心读出再写入
+    uint64_t (*energy)(void);  // 可选：器件累计能耗（纳焦），核心按每次操作前后的差值记账；NULL表示不统计能耗
 } flash_ops_t;
 
 #ifdef __cplusplus
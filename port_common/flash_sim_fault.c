@@ -0,0 +1,184 @@
+#include "flash_sim_fault.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const flash_ops_t *fault_inner = NULL;
+static flash_fault_plan_t fault_plan;
+static bool fault_armed = false;
+static bool fault_tripped = false;
+static uint32_t fault_ops = 0;
+static uint32_t fault_rng = 1;
+
+static uint32_t fault_rand(void) {
+    uint32_t x = fault_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    fault_rng = x;
+    return x;
+}
+
+void flash_fault_attach(const flash_ops_t *inner) {
+    fault_inner = inner;
+    flash_fault_disarm();
+}
+
+void flash_fault_arm(const flash_fault_plan_t *plan) {
+    memset(&fault_plan, 0, sizeof(fault_plan));
+    if (plan) {
+        fault_plan = *plan;
+    }
+    fault_rng = fault_plan.seed ? fault_plan.seed : 1;
+    fault_ops = 0;
+    fault_tripped = false;
+    fault_armed = true;
+}
+
+void flash_fault_disarm(void) {
+    fault_armed = false;
+    fault_tripped = false;
+}
+
+uint32_t flash_fault_op_count(void) {
+    return fault_ops;
+}
+
+bool flash_fault_tripped(void) {
+    return fault_tripped;
+}
+
+const char *flash_fault_mode_name(flash_fault_mode_t mode) {
+    static const char *names[FLASH_FAULT_MODE_COUNT] = { "cut", "tear-page", "tear-bits" };
+    return (mode < FLASH_FAULT_MODE_COUNT) ? names[mode] : "unknown";
+}
+
+// 计数一次编程/擦除，返回true表示这一次掉电
+static bool fault_should_cut(void) {
+    if (!fault_armed) {
+        return false;
+    }
+    fault_ops++;
+    if (fault_plan.cut_at != 0 && fault_ops == fault_plan.cut_at) {
+        fault_tripped = true;
+        return true;
+    }
+    return false;
+}
+
+static int fault_init(void) {
+    if (!fault_inner || fault_tripped) {
+        return -1;
+    }
+    return fault_inner->init ? fault_inner->init() : 0;
+}
+
+static int fault_read(uint32_t addr, uint8_t *buf, uint32_t size) {
+    if (!fault_inner || fault_tripped) {
+        return -1;
+    }
+    return fault_inner->read(addr, buf, size);
+}
+
+// 编程被打断：写入前done个字节，断点字节只写入部分0位
+static void tear_write(uint32_t addr, const uint8_t *buf, uint32_t size) {
+    uint32_t done = size ? fault_rand() % size : 0;
+    if (done > 0) {
+        fault_inner->write(addr, buf, done);
+    }
+    if (fault_plan.mode == FLASH_FAULT_TEAR_BITS && done < size) {
+        uint8_t old;
+        if (fault_inner->read(addr + done, &old, 1) == 0) {
+            uint8_t to_program = (uint8_t)(old & ~buf[done]);
+            uint8_t partial = (uint8_t)(old & ~(to_program & (uint8_t)fault_rand()));
+            fault_inner->write(addr + done, &partial, 1);
+        }
+    }
+}
+
+// 擦除被打断：前done个字节已擦除，断点字节部分位恢复为1，其余保持原值
+static void tear_erase(uint32_t addr, uint32_t size) {
+    uint8_t *old = malloc(size);
+    if (!old || fault_inner->read(addr, old, size) != 0 || fault_inner->erase(addr, size) != 0) {
+        free(old);
+        return;
+    }
+    uint32_t done = size ? fault_rand() % size : 0;
+    if (fault_plan.mode == FLASH_FAULT_TEAR_BITS && done < size) {
+        old[done] |= (uint8_t)fault_rand();
+    }
+    if (done < size) {
+        fault_inner->write(addr + done, old + done, size - done);
+    }
+    free(old);
+}
+
+static int fault_write(uint32_t addr, const uint8_t *buf, uint32_t size) {
+    if (!fault_inner || fault_tripped) {
+        return -1;
+    }
+    if (fault_should_cut()) {
+        if (fault_plan.mode != FLASH_FAULT_CUT) {
+            tear_write(addr, buf, size);
+        }
+        return -1;
+    }
+    return fault_inner->write(addr, buf, size);
+}
+
+static int fault_erase(uint32_t addr, uint32_t size) {
+    if (!fault_inner || fault_tripped) {
+        return -1;
+    }
+    if (fault_should_cut()) {
+        if (fault_plan.mode != FLASH_FAULT_CUT) {
+            tear_erase(addr, size);
+        }
+        return -1;
+    }
+    return fault_inner->erase(addr, size);
+}
+
+// 复制被打断：按编程撕裂处理（先取出源数据）；被包装的器件不支持复制时读出再写入
+static int fault_copy(uint32_t dst, uint32_t src, uint32_t size) {
+    if (!fault_inner || fault_tripped) {
+        return -1;
+    }
+    bool cut = fault_should_cut();
+    if (!cut && fault_inner->copy) {
+        return fault_inner->copy(dst, src, size);
+    }
+    uint8_t *buf = malloc(size);
+    if (!buf || fault_inner->read(src, buf, size) != 0) {
+        free(buf);
+        return -1;
+    }
+    int result = -1;
+    if (!cut) {
+        result = fault_inner->write(dst, buf, size);
+    } else if (fault_plan.mode != FLASH_FAULT_CUT) {
+        tear_write(dst, buf, size);
+    }
+    free(buf);
+    return result;
+}
+
+static int fault_sync(void) {
+    if (!fault_inner || fault_tripped) {
+        return -1;
+    }
+    return fault_inner->sync ? fault_inner->sync() : 0;
+}
+
+static uint64_t fault_energy(void) {
+    return (fault_inner && fault_inner->energy) ? fault_inner->energy() : 0;
+}
+
+const flash_ops_t flash_sim_fault_ops = {
+    .init = fault_init,
+    .read = fault_read,
+    .write = fault_write,
+    .erase = fault_erase,
+    .sync = fault_sync,
+    .copy = fault_copy,
+    .energy = fault_energy,
+};
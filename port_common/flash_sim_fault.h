@@ -0,0 +1,46 @@
+#ifndef FLASH_SIM_FAULT_H
+#define FLASH_SIM_FAULT_H
+
+#include "../core/fast_flash_types.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 掉电注入：包装另一个flash_ops_t（内存模拟器件或平台适配层），在布防后的第N次编程/擦除时模拟掉电。
+// 掉电后所有操作（包括读取）都返回-1，直到flash_fault_disarm()恢复供电，之后按重新上电处理（重新挂载）。
+//
+// 掉电方式：
+//   CUT        第N次操作完全没有执行
+//   TEAR_PAGE  第N次编程只写入了前面随机长度的字节；擦除只擦除了前面随机长度的字节
+//   TEAR_BITS  在TEAR_PAGE的基础上，断点处的字节只完成了一部分位（编程：部分0位已写入；擦除：部分位已恢复为1）
+// 撕裂的位置由种子决定，同一计划可以复现。器件内部复制按一次编程计数和撕裂。
+
+typedef enum {
+    FLASH_FAULT_CUT = 0,
+    FLASH_FAULT_TEAR_PAGE,
+    FLASH_FAULT_TEAR_BITS,
+    FLASH_FAULT_MODE_COUNT
+} flash_fault_mode_t;
+
+typedef struct {
+    uint32_t cut_at;            // 布防后第几次编程/擦除时掉电（从1开始），0表示不掉电（只计数）
+    flash_fault_mode_t mode;
+    uint32_t seed;              // 撕裂位置
+} flash_fault_plan_t;
+
+extern const flash_ops_t flash_sim_fault_ops;
+
+void flash_fault_attach(const flash_ops_t *inner);     // 被包装的器件
+void flash_fault_arm(const flash_fault_plan_t *plan);  // 清零计数并布防
+void flash_fault_disarm(void);                         // 恢复供电，之后不再注入
+uint32_t flash_fault_op_count(void);                   // 布防后的编程/擦除次数（含掉电的那一次）
+bool flash_fault_tripped(void);                        // 已经掉电
+const char *flash_fault_mode_name(flash_fault_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_SIM_FAULT_H
@@ -0,0 +1,170 @@
+#include "flash_sim_latency.h"
+#include <string.h>
+
+// 每种操作：下标0汇总所有大小，1..FLASH_LAT_SIZE_CLASSES对应各个大小分档
+static flash_latency_hist_t hists[FLASH_LAT_OP_COUNT][FLASH_LAT_SIZE_CLASSES + 1];
+
+static const char *op_names[FLASH_LAT_OP_COUNT] = { "read", "write", "erase" };
+static const char *io_class_names[FLASH_LAT_SIZE_CLASSES] = { "<=16B", "<=256B", "<=4KB", ">4KB" };
+static const char *erase_class_names[FLASH_LAT_SIZE_CLASSES] = { "<=4KB", "<=32KB", "<=64KB", ">64KB" };
+
+static int size_class_of(flash_lat_op_t op, uint32_t size) {
+    if (op == FLASH_LAT_ERASE) {
+        if (size <= 4 * 1024) return 0;
+        if (size <= 32 * 1024) return 1;
+        if (size <= 64 * 1024) return 2;
+        return 3;
+    }
+    if (size <= 16) return 0;
+    if (size <= 256) return 1;
+    if (size <= 4 * 1024) return 2;
+    return 3;
+}
+
+static uint32_t highest_bit(uint32_t value) {
+    uint32_t bit = 0;
+    while (value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+// 延迟 -> 桶下标：小于8us的值各占一个桶，之后每个2的幂区间分8档
+static uint32_t bucket_of(uint32_t value) {
+    if (value < FLASH_LAT_SUB_BUCKETS) {
+        return value;
+    }
+    uint32_t msb = highest_bit(value);
+    uint32_t shift = msb - FLASH_LAT_SUB_BITS;
+    return (msb - FLASH_LAT_SUB_BITS + 1) * FLASH_LAT_SUB_BUCKETS + ((value >> shift) & (FLASH_LAT_SUB_BUCKETS - 1));
+}
+
+// 桶下标 -> 该桶覆盖的最大延迟
+static uint32_t bucket_upper(uint32_t bucket) {
+    if (bucket < FLASH_LAT_SUB_BUCKETS) {
+        return bucket;
+    }
+    uint32_t group = bucket / FLASH_LAT_SUB_BUCKETS;
+    uint32_t sub = bucket % FLASH_LAT_SUB_BUCKETS;
+    uint32_t shift = group - 1;
+    uint64_t lower = (uint64_t)(FLASH_LAT_SUB_BUCKETS + sub) << shift;
+    uint64_t upper = lower + ((uint64_t)1 << shift) - 1;
+    return upper > UINT32_MAX ? UINT32_MAX : (uint32_t)upper;
+}
+
+static void hist_add(flash_latency_hist_t *hist, uint32_t latency_us) {
+    if (hist->samples == 0 || latency_us < hist->min_us) {
+        hist->min_us = latency_us;
+    }
+    if (latency_us > hist->max_us) {
+        hist->max_us = latency_us;
+    }
+    hist->samples++;
+    hist->total_us += latency_us;
+    hist->buckets[bucket_of(latency_us)]++;
+}
+
+// 百分位：返回累计计数达到目标的桶的上界，限制在[min, max]之内
+static uint32_t hist_percentile(const flash_latency_hist_t *hist, uint32_t percent) {
+    if (hist->samples == 0) {
+        return 0;
+    }
+    uint64_t rank = ((uint64_t)hist->samples * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < FLASH_LAT_BUCKETS; b++) {
+        seen += hist->buckets[b];
+        if (seen >= rank) {
+            uint32_t value = bucket_upper(b);
+            if (value > hist->max_us) value = hist->max_us;
+            if (value < hist->min_us) value = hist->min_us;
+            return value;
+        }
+    }
+    return hist->max_us;
+}
+
+void flash_latency_record(flash_lat_op_t op, uint32_t size, uint32_t latency_us) {
+    if (op >= FLASH_LAT_OP_COUNT) {
+        return;
+    }
+    hist_add(&hists[op][0], latency_us);
+    hist_add(&hists[op][1 + size_class_of(op, size)], latency_us);
+}
+
+void flash_latency_reset(void) {
+    memset(hists, 0, sizeof(hists));
+}
+
+const flash_latency_hist_t *flash_latency_get_hist(flash_lat_op_t op, int size_class) {
+    if (op >= FLASH_LAT_OP_COUNT || size_class < FLASH_LAT_ALL_SIZES || size_class >= FLASH_LAT_SIZE_CLASSES) {
+        return NULL;
+    }
+    return &hists[op][size_class + 1];
+}
+
+int flash_latency_get_summary(flash_lat_op_t op, int size_class, flash_latency_summary_t *summary) {
+    const flash_latency_hist_t *hist = flash_latency_get_hist(op, size_class);
+    if (!hist || !summary) {
+        return -1;
+    }
+
+    summary->samples = hist->samples;
+    summary->min_us = hist->min_us;
+    summary->p50_us = hist_percentile(hist, 50);
+    summary->p90_us = hist_percentile(hist, 90);
+    summary->p99_us = hist_percentile(hist, 99);
+    summary->max_us = hist->max_us;
+    summary->avg_us = hist->samples ? (double)hist->total_us / hist->samples : 0.0;
+    return 0;
+}
+
+const char *flash_latency_op_name(flash_lat_op_t op) {
+    return op < FLASH_LAT_OP_COUNT ? op_names[op] : "unknown";
+}
+
+const char *flash_latency_size_class_name(flash_lat_op_t op, int size_class) {
+    if (size_class == FLASH_LAT_ALL_SIZES) {
+        return "all";
+    }
+    if (op >= FLASH_LAT_OP_COUNT || size_class < 0 || size_class >= FLASH_LAT_SIZE_CLASSES) {
+        return "unknown";
+    }
+    return op == FLASH_LAT_ERASE ? erase_class_names[size_class] : io_class_names[size_class];
+}
+
+void flash_latency_print(void) {
+    printf("Latency (us)        samples      min      p50      p90      p99      max\n");
+    for (int op = 0; op < FLASH_LAT_OP_COUNT; op++) {
+        for (int sc = FLASH_LAT_ALL_SIZES; sc < FLASH_LAT_SIZE_CLASSES; sc++) {
+            flash_latency_summary_t s;
+            flash_latency_get_summary((flash_lat_op_t)op, sc, &s);
+            if (s.samples == 0) {
+                continue;
+            }
+            printf("  %-5s %-8s %10u %8u %8u %8u %8u %8u\n",
+                   flash_latency_op_name((flash_lat_op_t)op), flash_latency_size_class_name((flash_lat_op_t)op, sc),
+                   s.samples, s.min_us, s.p50_us, s.p90_us, s.p99_us, s.max_us);
+        }
+    }
+}
+
+void flash_latency_write_json(FILE *out) {
+    fprintf(out, "{");
+    for (int op = 0; op < FLASH_LAT_OP_COUNT; op++) {
+        fprintf(out, "%s\"%s\":[", op ? "," : "", flash_latency_op_name((flash_lat_op_t)op));
+        for (int sc = FLASH_LAT_ALL_SIZES; sc < FLASH_LAT_SIZE_CLASSES; sc++) {
+            flash_latency_summary_t s;
+            flash_latency_get_summary((flash_lat_op_t)op, sc, &s);
+            fprintf(out, "%s{\"size\":\"%s\",\"samples\":%u,\"min_us\":%u,\"avg_us\":%.1f,"
+                         "\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,\"max_us\":%u}",
+                    sc == FLASH_LAT_ALL_SIZES ? "" : ",",
+                    flash_latency_size_class_name((flash_lat_op_t)op, sc),
+                    s.samples, s.min_us, s.avg_us, s.p50_us, s.p90_us, s.p99_us, s.max_us);
+        }
+        fprintf(out, "]");
+    }
+    fprintf(out, "}");
+}
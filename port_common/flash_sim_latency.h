@@ -0,0 +1,65 @@
+#ifndef FLASH_SIM_LATENCY_H
+#define FLASH_SIM_LATENCY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 模拟器延迟直方图：按操作类型和操作大小分档记录每次操作的器件延迟（微秒），
+// 对数-线性分桶（每个2的幂区间再分8档，相对误差不超过12.5%），用于查看p50/p90/p99/max
+
+typedef enum {
+    FLASH_LAT_READ = 0,
+    FLASH_LAT_WRITE,
+    FLASH_LAT_ERASE,
+    FLASH_LAT_OP_COUNT
+} flash_lat_op_t;
+
+// 操作大小分档：读写按 <=16B / <=256B / <=4KB / 更大，擦除按 <=4KB / <=32KB / <=64KB / 更大
+#define FLASH_LAT_SIZE_CLASSES   4
+#define FLASH_LAT_ALL_SIZES      (-1)
+
+#define FLASH_LAT_SUB_BITS       3
+#define FLASH_LAT_SUB_BUCKETS    (1u << FLASH_LAT_SUB_BITS)
+#define FLASH_LAT_BUCKETS        ((32 - FLASH_LAT_SUB_BITS + 1) * FLASH_LAT_SUB_BUCKETS)
+
+typedef struct {
+    uint32_t samples;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[FLASH_LAT_BUCKETS];
+} flash_latency_hist_t;
+
+typedef struct {
+    uint32_t samples;
+    uint32_t min_us;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    double   avg_us;
+} flash_latency_summary_t;
+
+// 记录与清除（由模拟器适配层在每次操作后调用）
+void flash_latency_record(flash_lat_op_t op, uint32_t size, uint32_t latency_us);
+void flash_latency_reset(void);
+
+// 查询：size_class为FLASH_LAT_ALL_SIZES时汇总所有大小
+int flash_latency_get_summary(flash_lat_op_t op, int size_class, flash_latency_summary_t *summary);
+const flash_latency_hist_t *flash_latency_get_hist(flash_lat_op_t op, int size_class);
+const char *flash_latency_op_name(flash_lat_op_t op);
+const char *flash_latency_size_class_name(flash_lat_op_t op, int size_class);
+
+// 输出
+void flash_latency_print(void);
+void flash_latency_write_json(FILE *out);   // 输出一个JSON对象（不含换行）
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_SIM_LATENCY_H
@@ -0,0 +1,156 @@
+#include "flash_sim_mem.h"
+#include "flash_sim_timing.h"
+#include "flash_sim_latency.h"
+#include "../core/fast_flash_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *sim_mem = NULL;
+static uint32_t sim_size = 0;
+static uint32_t sim_sector_size = 0;
+static uint32_t *sim_erase_counts = NULL;   // 每个扇区的擦除次数
+static bool sim_quiet = false;
+
+int flash_sim_mem_create(uint32_t total_size, uint32_t sector_size) {
+    if (total_size == 0 || sector_size == 0 || total_size % sector_size != 0) {
+        return -1;
+    }
+    uint8_t *mem = realloc(sim_mem, total_size);
+    if (!mem) {
+        return -1;
+    }
+    sim_mem = mem;
+    uint32_t *counts = realloc(sim_erase_counts, (total_size / sector_size) * sizeof(uint32_t));
+    if (!counts) {
+        return -1;
+    }
+    sim_erase_counts = counts;
+    memset(sim_erase_counts, 0, (total_size / sector_size) * sizeof(uint32_t));
+    sim_size = total_size;
+    sim_sector_size = sector_size;
+    memset(sim_mem, 0xFF, sim_size);
+    return 0;
+}
+
+void flash_sim_mem_destroy(void) {
+    free(sim_mem);
+    free(sim_erase_counts);
+    sim_mem = NULL;
+    sim_erase_counts = NULL;
+    sim_size = 0;
+}
+
+void flash_sim_mem_erase_all(void) {
+    if (sim_mem) {
+        memset(sim_mem, 0xFF, sim_size);
+    }
+}
+
+uint32_t flash_sim_mem_size(void) {
+    return sim_size;
+}
+
+void flash_sim_mem_set_quiet(bool quiet) {
+    sim_quiet = quiet;
+}
+
+uint32_t flash_sim_mem_sector_count(void) {
+    return sim_sector_size ? sim_size / sim_sector_size : 0;
+}
+
+uint32_t flash_sim_mem_erase_count(uint32_t sector) {
+    return (sim_erase_counts && sector < flash_sim_mem_sector_count()) ? sim_erase_counts[sector] : 0;
+}
+
+const uint32_t *flash_sim_mem_erase_counts(void) {
+    return sim_erase_counts;
+}
+
+void flash_sim_mem_reset_erase_counts(void) {
+    if (sim_erase_counts) {
+        memset(sim_erase_counts, 0, flash_sim_mem_sector_count() * sizeof(uint32_t));
+    }
+}
+
+static int sim_init(void) {
+    return sim_mem ? 0 : -1;
+}
+
+static int sim_read(uint32_t addr, uint8_t *buf, uint32_t size) {
+    if ((uint64_t)addr + size > sim_size) {
+        return -1;
+    }
+    memcpy(buf, sim_mem + addr, size);
+    uint32_t read_time_us = flash_timing_read(size);
+    flash_latency_record(FLASH_LAT_READ, size, read_time_us);
+    FF_TRACE_DEVICE("read", read_time_us, addr, size);
+    flash_timing_read_energy(size, read_time_us);
+    return 0;
+}
+
+static int sim_write(uint32_t addr, const uint8_t *buf, uint32_t size) {
+    if ((uint64_t)addr + size > sim_size) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        if ((sim_mem[addr + i] & buf[i]) != buf[i]) {
+            if (!sim_quiet) {
+                printf("Flash write error: cannot change 0 to 1 at addr=0x%08X\n", addr + i);
+            }
+            return -1;
+        }
+    }
+    memcpy(sim_mem + addr, buf, size);
+    uint32_t write_time_us = flash_timing_write(size);
+    flash_latency_record(FLASH_LAT_WRITE, size, write_time_us);
+    FF_TRACE_DEVICE("write", write_time_us, addr, size);
+    flash_timing_write_energy(size, write_time_us);
+    return 0;
+}
+
+// 器件内部复制：数据不经过总线，按一次编程计时和计能耗
+static int sim_copy(uint32_t dst, uint32_t src, uint32_t size) {
+    if ((uint64_t)dst + size > sim_size || (uint64_t)src + size > sim_size) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        if ((sim_mem[dst + i] & sim_mem[src + i]) != sim_mem[src + i]) {
+            if (!sim_quiet) {
+                printf("Flash copy error: cannot change 0 to 1 at addr=0x%08X\n", dst + i);
+            }
+            return -1;
+        }
+    }
+    memmove(sim_mem + dst, sim_mem + src, size);
+    uint32_t copy_time_us = flash_timing_write(size);
+    flash_latency_record(FLASH_LAT_WRITE, size, copy_time_us);
+    FF_TRACE_DEVICE("copy", copy_time_us, dst, size);
+    flash_timing_write_energy(size, copy_time_us);
+    return 0;
+}
+
+static int sim_erase(uint32_t addr, uint32_t size) {
+    if ((uint64_t)addr + size > sim_size || addr % sim_sector_size != 0 || size % sim_sector_size != 0) {
+        return -1;
+    }
+    memset(sim_mem + addr, 0xFF, size);
+    for (uint32_t sector = addr / sim_sector_size; sector < (addr + size) / sim_sector_size; sector++) {
+        sim_erase_counts[sector]++;
+    }
+    uint32_t erase_time_us = flash_timing_erase(size);
+    flash_latency_record(FLASH_LAT_ERASE, size, erase_time_us);
+    FF_TRACE_DEVICE("erase", erase_time_us, addr, size);
+    flash_timing_erase_energy(size, erase_time_us);
+    return 0;
+}
+
+const flash_ops_t flash_sim_mem_ops = {
+    .init = sim_init,
+    .read = sim_read,
+    .write = sim_write,
+    .erase = sim_erase,
+    .sync = NULL,
+    .copy = sim_copy,
+    .energy = flash_timing_energy_nj,
+};
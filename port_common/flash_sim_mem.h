@@ -0,0 +1,35 @@
+#ifndef FLASH_SIM_MEM_H
+#define FLASH_SIM_MEM_H
+
+#include "../core/fast_flash_types.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 内存模拟的NOR Flash：编程只能把1写成0，擦除恢复为0xFF，擦除按扇区对齐。
+// 每次操作按时序模型推进虚拟时钟并记录延迟直方图，不落盘，用于主机上的基准测试和负载回放。
+// 支持器件内部复制（flash_ops_t.copy），复制按一次编程计时，数据不经过总线。
+
+extern const flash_ops_t flash_sim_mem_ops;
+
+// 分配容量为total_size的模拟器件并擦除为全0xFF（重复调用时重新分配）
+int flash_sim_mem_create(uint32_t total_size, uint32_t sector_size);
+void flash_sim_mem_destroy(void);
+void flash_sim_mem_erase_all(void);   // 恢复为全0xFF（不计时）
+uint32_t flash_sim_mem_size(void);
+void flash_sim_mem_set_quiet(bool quiet);   // 不打印非空白编程错误（掉电测试中会大量出现）
+
+// 每个扇区的累计擦除次数（用于寿命估算）：多扇区擦除给覆盖的每个扇区各计一次，
+// flash_sim_mem_erase_all不计数；重新create时清零
+uint32_t flash_sim_mem_sector_count(void);
+uint32_t flash_sim_mem_erase_count(uint32_t sector);
+const uint32_t *flash_sim_mem_erase_counts(void);
+void flash_sim_mem_reset_erase_counts(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_SIM_MEM_H
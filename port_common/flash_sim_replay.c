@@ -0,0 +1,184 @@
+#include "flash_sim_replay.h"
+#include "flash_sim_mem.h"
+#include "../core/fast_flash_core.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_MAX_RECORD_DATA (1024 * 1024)   // 单次写入数据的上限（防止损坏的录制文件申请过大内存）
+
+static uint8_t *data_buf = NULL;
+static uint32_t data_buf_size = 0;
+static bool device_ready = false;
+static flash_geometry_t used_geometry;
+
+static uint8_t *get_buffer(uint32_t size) {
+    if (size > REPLAY_MAX_RECORD_DATA) {
+        return NULL;
+    }
+    if (size > data_buf_size) {
+        uint8_t *buf = realloc(data_buf, size);
+        if (!buf) {
+            return NULL;
+        }
+        data_buf = buf;
+        data_buf_size = size;
+    }
+    return data_buf;
+}
+
+// 按摘要生成数据：摘要相同则内容相同
+static uint8_t *make_payload(uint32_t digest, uint32_t size) {
+    uint8_t *buf = get_buffer(size ? size : 1);
+    if (!buf) {
+        return NULL;
+    }
+    uint32_t x = digest ? digest : 0x9E3779B9u;
+    for (uint32_t i = 0; i < size; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        buf[i] = (uint8_t)x;
+    }
+    return buf;
+}
+
+static int replay_init(const flash_record_t *rec, const flash_replay_overrides_t *ov) {
+    flash_geometry_t geometry = rec->geometry;
+    if (ov->geometry.sector_size) geometry.sector_size = ov->geometry.sector_size;
+    if (ov->geometry.page_size) geometry.page_size = ov->geometry.page_size;
+    if (ov->geometry.write_granularity) geometry.write_granularity = ov->geometry.write_granularity;
+    if (ov->geometry.max_tables) geometry.max_tables = ov->geometry.max_tables;
+    if (ov->geometry.erase_sizes[0]) {
+        memcpy(geometry.erase_sizes, ov->geometry.erase_sizes, sizeof(geometry.erase_sizes));
+    } else if (ov->geometry.sector_size) {
+        // 只改了扇区大小：去掉不是新扇区整数倍的擦除粒度
+        int kept = 0;
+        for (int i = 0; i < FF_MAX_ERASE_SIZES && geometry.erase_sizes[i]; i++) {
+            if (geometry.erase_sizes[i] % geometry.sector_size == 0) {
+                geometry.erase_sizes[kept++] = geometry.erase_sizes[i];
+            }
+        }
+        for (int i = kept; i < FF_MAX_ERASE_SIZES; i++) {
+            geometry.erase_sizes[i] = 0;
+        }
+    }
+    used_geometry = geometry;
+
+    flash_partition_t partitions[FF_MAX_PARTITIONS];
+    int count = rec->partition_count;
+    memcpy(partitions, rec->partitions, sizeof(partitions));
+    if (ov->capacity) {
+        if (count == 1 && partitions[0].offset == 0) {
+            partitions[0].size = ov->capacity;
+        } else if (!device_ready) {
+            printf("Capacity override only applies to single-partition traces, ignored\n");
+        }
+    }
+
+    // 器件容量：覆盖所有分区
+    if (!device_ready) {
+        uint32_t sector = geometry.sector_size ? geometry.sector_size : FLASH_SECTOR_SIZE;
+        uint32_t end = 0;
+        for (int i = 0; i < count; i++) {
+            if (partitions[i].offset + partitions[i].size > end) {
+                end = partitions[i].offset + partitions[i].size;
+            }
+        }
+        end = (end + sector - 1) / sector * sector;
+        if (flash_sim_mem_create(end ? end : sector, sector) != 0) {
+            printf("Failed to allocate %u KB simulated flash\n", end / 1024);
+            return -1;
+        }
+        device_ready = true;
+    }
+
+    return fast_flash_init_partitions(&flash_sim_mem_ops, partitions, count, rec->args[0] != 0, &geometry);
+}
+
+int flash_sim_replay_execute(const flash_record_t *rec, const flash_replay_overrides_t *overrides) {
+    static const flash_replay_overrides_t none;
+    const char *name = rec->name;
+    uint8_t *buf;
+
+    if (!overrides) {
+        overrides = &none;
+    }
+
+    switch (rec->op) {
+    case FF_REC_INIT:
+        return replay_init(rec, overrides);
+    case FF_REC_SELECT_PARTITION:
+        return fast_flash_select_partition(name);
+    case FF_REC_CREATE_TABLE:
+        return fast_flash_create_table_ex(name, (uint32_t)rec->args[0], (uint32_t)rec->args[1], (uint8_t)rec->args[2]);
+    case FF_REC_DELETE_TABLE:
+        return fast_flash_delete_table(name);
+    case FF_REC_WRITE:
+        buf = make_payload(rec->digest, (uint32_t)rec->args[0]);
+        return buf ? fast_flash_write_table_data(name, buf, (uint32_t)rec->args[0]) : -1;
+    case FF_REC_READ:
+        buf = get_buffer((uint32_t)rec->args[1] ? (uint32_t)rec->args[1] : 1);
+        return buf ? fast_flash_read_table_data(name, (uint32_t)rec->args[0], buf, (uint32_t)rec->args[1]) : -1;
+    case FF_REC_WRITE_BY_INDEX:
+        buf = make_payload(rec->digest, (uint32_t)rec->args[1]);
+        return buf ? fast_flash_write_table_data_by_index(name, (uint32_t)rec->args[0], buf, (uint32_t)rec->args[1]) : -1;
+    case FF_REC_APPEND:
+        buf = make_payload(rec->digest, (uint32_t)rec->args[0]);
+        return buf ? fast_flash_append_table_data(name, buf, (uint32_t)rec->args[0]) : -1;
+    case FF_REC_CLEAR:
+        return fast_flash_clear_table_data(name, rec->args[0]);
+    case FF_REC_WRITE_BATCH: {
+        uint64_t size = rec->args[0] * rec->args[1];
+        buf = (size <= REPLAY_MAX_RECORD_DATA) ? make_payload(rec->digest, (uint32_t)size) : NULL;
+        return buf ? fast_flash_write_table_data_batch(name, buf, (uint32_t)rec->args[0], (uint32_t)rec->args[1]) : -1;
+    }
+    case FF_REC_GET_COUNT:
+        fast_flash_get_table_count(name);
+        return 0;
+    case FF_REC_SET_ERASE:
+        fast_flash_set_erase_allowed(rec->args[0] != 0);
+        return 0;
+    case FF_REC_GC:
+        return fast_flash_gc();
+    case FF_REC_VALIDATE:
+        return fast_flash_validate_table_data(name);
+    case FF_REC_REPAIR:
+        return fast_flash_repair_table(name);
+    default:
+        return -1;
+    }
+}
+
+bool flash_sim_replay_ready(void) {
+    return device_ready;
+}
+
+const flash_geometry_t *flash_sim_replay_geometry(void) {
+    return &used_geometry;
+}
+
+void flash_sim_replay_release(void) {
+    free(data_buf);
+    data_buf = NULL;
+    data_buf_size = 0;
+    device_ready = false;
+}
+
+uint8_t *flash_sim_replay_load(const char *path, uint32_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *buf = (length > 0) ? malloc((size_t)length) : NULL;
+    if (buf && fread(buf, 1, (size_t)length, file) != (size_t)length) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(file);
+    *size = buf ? (uint32_t)length : 0;
+    return buf;
+}
@@ -0,0 +1,34 @@
+#ifndef FLASH_SIM_REPLAY_H
+#define FLASH_SIM_REPLAY_H
+
+#include "../core/fast_flash_record.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 在内存模拟器件（flash_sim_mem）上执行录制的调用（见core/fast_flash_record.h），
+// 由回放工具和寿命模拟共用。第一次执行初始化记录时按分区范围创建模拟器件，之后的初始化记录相当于重新上电挂载。
+// 写入数据按录制的摘要生成：录制时相同的数据回放时仍然相同。
+
+// 回放配置：非0字段覆盖录制的值
+typedef struct {
+    uint32_t capacity;              // 单分区录制的分区大小（字节）
+    flash_geometry_t geometry;      // 只改扇区大小时，去掉不是新扇区整数倍的擦除粒度
+} flash_replay_overrides_t;
+
+// 执行一条记录，返回对应API的返回值（没有返回值的API返回0）
+int flash_sim_replay_execute(const flash_record_t *record, const flash_replay_overrides_t *overrides);
+bool flash_sim_replay_ready(void);                      // 已执行过初始化记录（模拟器件已创建）
+const flash_geometry_t *flash_sim_replay_geometry(void); // 最近一次初始化实际使用的几何参数
+void flash_sim_replay_release(void);                    // 释放数据缓冲区，下次初始化记录重新创建器件
+
+// 读入整个录制文件（调用者free），失败返回NULL
+uint8_t *flash_sim_replay_load(const char *path, uint32_t *size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_SIM_REPLAY_H
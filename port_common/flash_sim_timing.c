@@ -0,0 +1,153 @@
+#include "flash_sim_timing.h"
+#include <stddef.h>
+
+// Winbond W25Q（数据手册典型值到最大值）
+const flash_timing_profile_t flash_timing_winbond_w25q = {
+    .name = "winbond-w25q",
+    .write_min_us = 700,        .write_max_us = 3000,
+    .erase_4k_min_us = 45000,   .erase_4k_max_us = 400000,
+    .erase_32k_min_us = 120000, .erase_32k_max_us = 1600000,
+    .erase_64k_min_us = 150000, .erase_64k_max_us = 2000000,
+    .read_ns_per_byte = 50,
+    // 3.3V，编程/擦除20mA，读取15mA（104MHz Quad读取），MCU睡眠等待约1mA
+    .program_nj = 46200,
+    .erase_4k_nj = 2970000,     .erase_32k_nj = 7920000,    .erase_64k_nj = 9900000,
+    .read_pj_per_byte = 2475,
+    .standby_uw = 3300,
+};
+
+// GigaDevice GD25Q
+const flash_timing_profile_t flash_timing_gigadevice_gd25q = {
+    .name = "gigadevice-gd25q",
+    .write_min_us = 600,        .write_max_us = 2400,
+    .erase_4k_min_us = 50000,   .erase_4k_max_us = 300000,
+    .erase_32k_min_us = 150000, .erase_32k_max_us = 1200000,
+    .erase_64k_min_us = 250000, .erase_64k_max_us = 1600000,
+    .read_ns_per_byte = 40,
+    // 3.3V，编程/擦除20mA，读取15mA，MCU睡眠等待约1mA
+    .program_nj = 39600,
+    .erase_4k_nj = 3300000,     .erase_32k_nj = 9900000,    .erase_64k_nj = 16500000,
+    .read_pj_per_byte = 1980,
+    .standby_uw = 3300,
+};
+
+const flash_timing_profile_t flash_timing_ideal = {
+    .name = "ideal",
+};
+
+static const flash_timing_profile_t *current_profile = &flash_timing_winbond_w25q;
+static uint32_t rng_state = FLASH_TIMING_DEFAULT_SEED;
+static uint64_t virtual_now_us = 0;
+static uint64_t energy_total_nj = 0;
+
+// xorshift32伪随机数
+static uint32_t rng_next(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+// [min, max]之间取值
+static uint32_t random_range_us(uint32_t min_us, uint32_t max_us) {
+    if (max_us <= min_us) {
+        return min_us;
+    }
+    return min_us + rng_next() % (max_us - min_us + 1);
+}
+
+void flash_timing_set_profile(const flash_timing_profile_t *profile) {
+    current_profile = profile ? profile : &flash_timing_winbond_w25q;
+}
+
+const flash_timing_profile_t *flash_timing_get_profile(void) {
+    return current_profile;
+}
+
+void flash_timing_seed(uint32_t seed) {
+    // xorshift的状态不能为0
+    rng_state = seed ? seed : FLASH_TIMING_DEFAULT_SEED;
+}
+
+uint64_t flash_timing_now_us(void) {
+    return virtual_now_us;
+}
+
+void flash_timing_reset_clock(void) {
+    virtual_now_us = 0;
+}
+
+void flash_timing_advance_us(uint64_t us) {
+    virtual_now_us += us;
+}
+
+uint32_t flash_timing_write(uint32_t size) {
+    (void)size;  // 一次编程操作不超过一页，耗时与长度关系不大
+    uint32_t us = random_range_us(current_profile->write_min_us, current_profile->write_max_us);
+    virtual_now_us += us;
+    return us;
+}
+
+uint32_t flash_timing_erase(uint32_t size) {
+    uint32_t us;
+    if (size <= 4 * 1024) {
+        us = random_range_us(current_profile->erase_4k_min_us, current_profile->erase_4k_max_us);
+    } else if (size <= 32 * 1024) {
+        us = random_range_us(current_profile->erase_32k_min_us, current_profile->erase_32k_max_us);
+    } else {
+        us = 0;
+        for (uint32_t done = 0; done < size; done += 64 * 1024) {
+            us += random_range_us(current_profile->erase_64k_min_us, current_profile->erase_64k_max_us);
+        }
+    }
+    virtual_now_us += us;
+    return us;
+}
+
+uint32_t flash_timing_read(uint32_t size) {
+    uint32_t us = (uint32_t)(((uint64_t)size * current_profile->read_ns_per_byte) / 1000);
+    virtual_now_us += us;
+    return us;
+}
+
+// 器件忙期间的待机能耗：微瓦×微秒=皮焦
+static uint32_t standby_nj(uint32_t busy_us) {
+    return (uint32_t)(((uint64_t)current_profile->standby_uw * busy_us) / 1000);
+}
+
+uint32_t flash_timing_write_energy(uint32_t size, uint32_t busy_us) {
+    (void)size;
+    uint32_t nj = current_profile->program_nj + standby_nj(busy_us);
+    energy_total_nj += nj;
+    return nj;
+}
+
+uint32_t flash_timing_erase_energy(uint32_t size, uint32_t busy_us) {
+    uint32_t nj;
+    if (size <= 4 * 1024) {
+        nj = current_profile->erase_4k_nj;
+    } else if (size <= 32 * 1024) {
+        nj = current_profile->erase_32k_nj;
+    } else {
+        nj = current_profile->erase_64k_nj * ((size + 64 * 1024 - 1) / (64 * 1024));
+    }
+    nj += standby_nj(busy_us);
+    energy_total_nj += nj;
+    return nj;
+}
+
+uint32_t flash_timing_read_energy(uint32_t size, uint32_t busy_us) {
+    uint32_t nj = (uint32_t)(((uint64_t)size * current_profile->read_pj_per_byte) / 1000) + standby_nj(busy_us);
+    energy_total_nj += nj;
+    return nj;
+}
+
+uint64_t flash_timing_energy_nj(void) {
+    return energy_total_nj;
+}
+
+void flash_timing_reset_energy(void) {
+    energy_total_nj = 0;
+}
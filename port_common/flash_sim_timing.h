@@ -0,0 +1,68 @@
+#ifndef FLASH_SIM_TIMING_H
+#define FLASH_SIM_TIMING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 模拟器时序模型：按器件参数计算每次操作的延迟并推进虚拟时钟，不真正等待。
+// 延迟在[min, max]之间按可设置种子的伪随机数取值，同一种子的运行结果完全一致。
+// 能耗模型：每次操作的器件能耗（编程按次、擦除按粒度、读取按字节）加上器件忙期间系统的待机能耗（按实际耗时）。
+
+// 器件时序参数（单位：微秒）
+typedef struct {
+    const char *name;
+    uint32_t write_min_us;        // 一次编程操作（不超过一页）
+    uint32_t write_max_us;
+    uint32_t erase_4k_min_us;     // 4KB扇区擦除
+    uint32_t erase_4k_max_us;
+    uint32_t erase_32k_min_us;    // 32KB块擦除
+    uint32_t erase_32k_max_us;
+    uint32_t erase_64k_min_us;    // 64KB块擦除（更大的擦除按64KB块累加）
+    uint32_t erase_64k_max_us;
+    uint32_t read_ns_per_byte;    // 读取每字节耗时（纳秒）
+    // 能耗参数（纳焦，按数据手册的典型电流×电压×典型时间）
+    uint32_t program_nj;          // 一次编程操作
+    uint32_t erase_4k_nj;
+    uint32_t erase_32k_nj;
+    uint32_t erase_64k_nj;        // 更大的擦除按64KB块累加
+    uint32_t read_pj_per_byte;    // 读取每字节（皮焦）
+    uint32_t standby_uw;          // 等待器件忙期间系统的待机功耗（微瓦）
+} flash_timing_profile_t;
+
+// 内置器件参数
+extern const flash_timing_profile_t flash_timing_winbond_w25q;   // Winbond W25Q系列（默认）
+extern const flash_timing_profile_t flash_timing_gigadevice_gd25q; // GigaDevice GD25Q系列
+extern const flash_timing_profile_t flash_timing_ideal;          // 零延迟，只统计次数
+
+#define FLASH_TIMING_DEFAULT_SEED  0x5EED1234u
+
+// 配置
+void flash_timing_set_profile(const flash_timing_profile_t *profile);  // NULL恢复默认
+const flash_timing_profile_t *flash_timing_get_profile(void);
+void flash_timing_seed(uint32_t seed);
+
+// 虚拟时钟
+uint64_t flash_timing_now_us(void);
+void flash_timing_reset_clock(void);
+void flash_timing_advance_us(uint64_t us);
+
+// 计算一次操作的延迟（微秒）并推进虚拟时钟
+uint32_t flash_timing_write(uint32_t size);
+uint32_t flash_timing_erase(uint32_t size);
+uint32_t flash_timing_read(uint32_t size);
+
+// 计算一次操作的能耗（纳焦，busy_us为上面返回的延迟）并累加到器件能耗计数
+uint32_t flash_timing_write_energy(uint32_t size, uint32_t busy_us);
+uint32_t flash_timing_erase_energy(uint32_t size, uint32_t busy_us);
+uint32_t flash_timing_read_energy(uint32_t size, uint32_t busy_us);
+uint64_t flash_timing_energy_nj(void);
+void flash_timing_reset_energy(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_SIM_TIMING_H
@@ -0,0 +1,350 @@
+#define _POSIX_C_SOURCE 200809L
+#include "flash_adapter_posix.h"
+#include "../core/fast_flash_log.h"
+#include "../core/fast_flash_trace.h"
+#include "../port_common/flash_sim_timing.h"
+#include "../port_common/flash_sim_latency.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 镜像文件映射
+static const char *flash_file_name = POSIX_FLASH_FILE_NAME;
+static uint32_t flash_size = POSIX_FLASH_TOTAL_SIZE;
+static int flash_fd = -1;
+static uint8_t *flash_map = NULL;
+
+// 上次同步以来修改过的区间，posix_flash_sync只msync这一段
+static uint32_t dirty_start = UINT32_MAX;
+static uint32_t dirty_end = 0;
+
+// 性能统计
+static posix_flash_perf_stats_t perf_stats = {0};
+
+int posix_flash_configure(const char *file_name, uint32_t total_size) {
+    if (flash_map) {
+        printf("POSIX flash already initialized, configure before init\n");
+        return -1;
+    }
+    if (!file_name || total_size == 0 || total_size % FLASH_SECTOR_SIZE != 0) {
+        return -1;
+    }
+
+    flash_file_name = file_name;
+    flash_size = total_size;
+    return 0;
+}
+
+uint32_t posix_flash_get_size(void) {
+    return flash_size;
+}
+
+// 获取当前时间（毫秒），返回模拟器的虚拟时钟（器件时间）
+uint32_t posix_get_time_ms(void) {
+    return (uint32_t)(flash_timing_now_us() / 1000);
+}
+
+// 扩展待同步区间
+static void mark_dirty(uint32_t addr, uint32_t size) {
+    if (addr < dirty_start) {
+        dirty_start = addr;
+    }
+    if (addr + size > dirty_end) {
+        dirty_end = addr + size;
+    }
+}
+
+// 持久化屏障：msync修改过的区间（按系统页对齐）
+int posix_flash_sync(void) {
+    if (!flash_map) {
+        return -1;
+    }
+    if (dirty_start >= dirty_end) {
+        return 0;
+    }
+
+    uint32_t page_size = (uint32_t)sysconf(_SC_PAGESIZE);
+    uint32_t start = dirty_start - dirty_start % page_size;
+    uint32_t length = dirty_end - start;
+    if (msync(flash_map + start, length, MS_SYNC) != 0) {
+        printf("Failed to sync flash range 0x%08X, size=%u\n", start, length);
+        return -1;
+    }
+
+    perf_stats.sync_operations++;
+    perf_stats.bytes_synced += length;
+    dirty_start = UINT32_MAX;
+    dirty_end = 0;
+    return 0;
+}
+
+void posix_flash_reset_perf_stats(void) {
+    memset(&perf_stats, 0, sizeof(perf_stats));
+    flash_latency_reset();
+}
+
+void posix_flash_get_perf_stats(posix_flash_perf_stats_t *stats) {
+    if (stats) {
+        *stats = perf_stats;
+    }
+}
+
+void posix_flash_print_perf_stats(void) {
+    uint64_t total_us = perf_stats.total_write_time_us + perf_stats.total_erase_time_us + perf_stats.total_read_time_us;
+
+    printf("\n=== Flash Performance Statistics (%s, simulated) ===\n", flash_timing_get_profile()->name);
+    printf("Write Operations: %u (Total: %.1f ms)\n", perf_stats.write_operations, perf_stats.total_write_time_us / 1000.0);
+    printf("Erase Operations: %u (Total: %.1f ms)\n", perf_stats.erase_operations, perf_stats.total_erase_time_us / 1000.0);
+    printf("Read Operations: %u (Total: %.1f ms)\n", perf_stats.read_operations, perf_stats.total_read_time_us / 1000.0);
+    printf("Bytes Written: %u (%.2f KB)\n", perf_stats.bytes_written, perf_stats.bytes_written / 1024.0f);
+    printf("Bytes Erased: %u (%.2f KB)\n", perf_stats.bytes_erased, perf_stats.bytes_erased / 1024.0f);
+    printf("Bytes Read: %u (%.2f KB)\n", perf_stats.bytes_read, perf_stats.bytes_read / 1024.0f);
+    printf("Sync Operations: %u (%.2f KB synced)\n", perf_stats.sync_operations, perf_stats.bytes_synced / 1024.0f);
+    printf("Total Device Time: %.1f ms (%.2f seconds)\n", total_us / 1000.0, total_us / 1000000.0);
+    printf("Total Device Energy: %.1f mJ\n", perf_stats.total_energy_nj / 1000000.0);
+    flash_latency_print();
+    printf("===================================\n\n");
+}
+
+void posix_flash_write_perf_stats_json(FILE *out) {
+    fprintf(out, "{\"profile\":\"%s\",\"write_operations\":%u,\"erase_operations\":%u,\"read_operations\":%u,"
+                 "\"bytes_written\":%u,\"bytes_erased\":%u,\"bytes_read\":%u,"
+                 "\"sync_operations\":%u,\"bytes_synced\":%u,"
+                 "\"write_time_us\":%llu,\"erase_time_us\":%llu,\"read_time_us\":%llu,\"energy_nj\":%llu,\"latency\":",
+            flash_timing_get_profile()->name,
+            perf_stats.write_operations, perf_stats.erase_operations, perf_stats.read_operations,
+            perf_stats.bytes_written, perf_stats.bytes_erased, perf_stats.bytes_read,
+            perf_stats.sync_operations, perf_stats.bytes_synced,
+            (unsigned long long)perf_stats.total_write_time_us,
+            (unsigned long long)perf_stats.total_erase_time_us,
+            (unsigned long long)perf_stats.total_read_time_us,
+            (unsigned long long)perf_stats.total_energy_nj);
+    flash_latency_write_json(out);
+    fprintf(out, "}\n");
+}
+
+int posix_flash_init(void) {
+    // 重复初始化时保持现有映射
+    if (flash_map) {
+        return 0;
+    }
+
+    flash_fd = open(flash_file_name, O_RDWR | O_CREAT, 0644);
+    if (flash_fd < 0) {
+        printf("Failed to open flash simulation file: %s\n", flash_file_name);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(flash_fd, &st) != 0) {
+        close(flash_fd);
+        flash_fd = -1;
+        return -1;
+    }
+
+    // 新文件或容量变大时扩展文件，扩展部分按擦除状态填充0xFF
+    off_t old_size = st.st_size;
+    if (old_size < (off_t)flash_size && ftruncate(flash_fd, flash_size) != 0) {
+        printf("Failed to resize flash simulation file: %s\n", flash_file_name);
+        close(flash_fd);
+        flash_fd = -1;
+        return -1;
+    }
+
+    flash_map = mmap(NULL, flash_size, PROT_READ | PROT_WRITE, MAP_SHARED, flash_fd, 0);
+    if (flash_map == MAP_FAILED) {
+        printf("Failed to map flash simulation file: %s\n", flash_file_name);
+        flash_map = NULL;
+        close(flash_fd);
+        flash_fd = -1;
+        return -1;
+    }
+
+    if (old_size < (off_t)flash_size) {
+        memset(flash_map + old_size, 0xFF, flash_size - old_size);
+    }
+
+    printf("POSIX Flash Adapter initialized, file: %s, size: %u KB\n", flash_file_name, flash_size / 1024);
+
+    // 重置性能统计
+    posix_flash_reset_perf_stats();
+
+    return 0;
+}
+
+void posix_flash_deinit(void) {
+    if (flash_map) {
+        posix_flash_sync();
+        munmap(flash_map, flash_size);
+        flash_map = NULL;
+    }
+    if (flash_fd >= 0) {
+        close(flash_fd);
+        flash_fd = -1;
+    }
+}
+
+int posix_flash_read(uint32_t addr, uint8_t *buf, uint32_t size) {
+    if (!flash_map || !buf) {
+        return -1;
+    }
+
+    if ((uint64_t)addr + size > flash_size) {
+        printf("Read out of bounds: addr=0x%08X, size=%u\n", addr, size);
+        return -1;
+    }
+
+    memcpy(buf, flash_map + addr, size);
+
+    // 更新统计
+    perf_stats.read_operations++;
+    perf_stats.bytes_read += size;
+    uint32_t read_time_us = flash_timing_read(size);
+    perf_stats.total_read_time_us += read_time_us;
+    flash_latency_record(FLASH_LAT_READ, size, read_time_us);
+    FF_TRACE_DEVICE("read", read_time_us, addr, size);
+    uint32_t read_energy_nj = flash_timing_read_energy(size, read_time_us);
+    perf_stats.total_energy_nj += read_energy_nj;
+
+    TRACE_DEBUG("Flash read: addr=0x%08X, size=%u\n", addr, size);
+    return 0;
+}
+
+int posix_flash_write(uint32_t addr, const uint8_t *buf, uint32_t size) {
+    if (!flash_map || !buf) {
+        return -1;
+    }
+
+    if ((uint64_t)addr + size > flash_size) {
+        printf("Write out of bounds: addr=0x%08X, size=%u\n", addr, size);
+        return -1;
+    }
+
+    // 模拟NOR Flash特性：只能将1写成0，不能将0写成1（先检查，失败时不改变内容）
+    for (uint32_t i = 0; i < size; i++) {
+        if ((flash_map[addr + i] & buf[i]) != buf[i]) {
+            printf("Flash write error: cannot change 0 to 1 at addr=0x%08X\n", addr + i);
+            return -1;
+        }
+    }
+    memcpy(flash_map + addr, buf, size);
+    mark_dirty(addr, size);
+
+    // 更新统计
+    perf_stats.write_operations++;
+    perf_stats.bytes_written += size;
+    uint32_t write_time_us = flash_timing_write(size);
+    perf_stats.total_write_time_us += write_time_us;
+    flash_latency_record(FLASH_LAT_WRITE, size, write_time_us);
+    FF_TRACE_DEVICE("write", write_time_us, addr, size);
+    uint32_t write_energy_nj = flash_timing_write_energy(size, write_time_us);
+    perf_stats.total_energy_nj += write_energy_nj;
+
+    TRACE_DEBUG("Flash write: addr=0x%08X, size=%u\n", addr, size);
+    return 0;
+}
+
+int posix_flash_erase(uint32_t addr, uint32_t size) {
+    if (!flash_map) {
+        return -1;
+    }
+
+    // 只能按扇区擦除
+    if (addr % FLASH_SECTOR_SIZE != 0 || size == 0 || size % FLASH_SECTOR_SIZE != 0) {
+        printf("Erase not sector aligned: addr=0x%08X, size=%u\n", addr, size);
+        return -1;
+    }
+
+    if ((uint64_t)addr + size > flash_size) {
+        printf("Erase out of bounds: addr=0x%08X, size=%u\n", addr, size);
+        return -1;
+    }
+
+    // 擦除：设置为全0xFF
+    memset(flash_map + addr, 0xFF, size);
+    mark_dirty(addr, size);
+
+    // 更新统计
+    perf_stats.erase_operations++;
+    perf_stats.bytes_erased += size;
+    uint32_t erase_time_us = flash_timing_erase(size);
+    perf_stats.total_erase_time_us += erase_time_us;
+    flash_latency_record(FLASH_LAT_ERASE, size, erase_time_us);
+    FF_TRACE_DEVICE("erase", erase_time_us, addr, size);
+    uint32_t erase_energy_nj = flash_timing_erase_energy(size, erase_time_us);
+    perf_stats.total_energy_nj += erase_energy_nj;
+
+    TRACE_DEBUG("Flash erase: addr=0x%08X, size=%u\n", addr, size);
+    return 0;
+}
+
+int posix_flash_reset(void) {
+    // 确保Flash文件已初始化
+    if (!flash_map && posix_flash_init() != 0) {
+        return -1;
+    }
+
+    memset(flash_map, 0xFF, flash_size);
+    mark_dirty(0, flash_size);
+    if (posix_flash_sync() != 0) {
+        return -1;
+    }
+    printf("Flash reset completed\n");
+    return 0;
+}
+
+int posix_flash_dump(uint32_t addr, uint32_t size) {
+    if (!flash_map) {
+        return -1;
+    }
+
+    if ((uint64_t)addr + size > flash_size) {
+        printf("Dump out of bounds\n");
+        return -1;
+    }
+
+    printf("Flash dump from 0x%08X, size: %u\n", addr, size);
+    for (uint32_t i = 0; i < size; i++) {
+        if (i % 16 == 0) {
+            printf("\n%08X: ", addr + i);
+        }
+        printf("%02X ", flash_map[addr + i]);
+    }
+    printf("\n");
+
+    return 0;
+}
+
+// 在程序退出时自动同步并解除映射
+static void cleanup_flash(void) {
+    if (flash_map) {
+        posix_flash_deinit();
+
+        // 打印最终的性能统计
+        posix_flash_print_perf_stats();
+    }
+}
+
+// 注册清理函数
+static void __attribute__((constructor)) register_cleanup(void) {
+    atexit(cleanup_flash);
+}
+
+// 擦除粒度（与Windows模拟器一致）
+const flash_geometry_t posix_flash_geometry = {
+    .erase_sizes = { 4 * 1024, 32 * 1024, 64 * 1024, 0 }
+};
+
+// Flash操作接口
+const flash_ops_t posix_flash_ops = {
+    .init  = posix_flash_init,
+    .read  = posix_flash_read,
+    .write = posix_flash_write,
+    .erase = posix_flash_erase,
+    .sync  = posix_flash_sync,
+    .energy = flash_timing_energy_nj
+};
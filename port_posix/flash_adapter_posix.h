@@ -0,0 +1,66 @@
+#ifndef FLASH_ADAPTER_POSIX_H
+#define FLASH_ADAPTER_POSIX_H
+
+#include "../core/fast_flash_types.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// POSIX平台Flash适配器接口（mmap映射镜像文件模拟NOR Flash）
+extern const flash_ops_t posix_flash_ops;
+// 模拟器支持的擦除粒度（4KB扇区 / 32KB块 / 64KB块）
+extern const flash_geometry_t posix_flash_geometry;
+
+// POSIX平台默认配置
+#define POSIX_FLASH_FILE_NAME    "flash_simulation.bin"
+#define POSIX_FLASH_TOTAL_SIZE   (64 * 1024)    // 64KB模拟Flash
+#define POSIX_FLASH_SECTOR_COUNT (POSIX_FLASH_TOTAL_SIZE / FLASH_SECTOR_SIZE)
+
+// 指定镜像文件和容量（在posix_flash_init之前调用，默认POSIX_FLASH_FILE_NAME / POSIX_FLASH_TOTAL_SIZE）
+int posix_flash_configure(const char *file_name, uint32_t total_size);
+uint32_t posix_flash_get_size(void);
+uint32_t posix_get_time_ms(void);        // 模拟器虚拟时钟（毫秒），见port_common/flash_sim_timing.h
+
+// POSIX平台特定函数
+int posix_flash_init(void);
+int posix_flash_read(uint32_t addr, uint8_t *buf, uint32_t size);
+int posix_flash_write(uint32_t addr, const uint8_t *buf, uint32_t size);
+int posix_flash_erase(uint32_t addr, uint32_t size);
+int posix_flash_sync(void);             // 持久化屏障：msync上次同步以来修改过的区间
+void posix_flash_deinit(void);          // 同步并解除映射
+
+// 用于测试的辅助函数
+int posix_flash_reset(void);             // 重置整个Flash区域
+int posix_flash_dump(uint32_t addr, uint32_t size); // 调试输出Flash内容
+
+// 性能统计结构（时间为时序模型计算的器件时间）
+typedef struct {
+    uint64_t total_write_time_us;       // 总写入时间（微秒）
+    uint64_t total_erase_time_us;       // 总擦除时间（微秒）
+    uint64_t total_read_time_us;        // 总读取时间（微秒）
+    uint64_t total_energy_nj;           // 器件能耗（纳焦，能耗模型计算）
+    uint32_t write_operations;          // 写入操作次数
+    uint32_t erase_operations;          // 擦除操作次数
+    uint32_t read_operations;           // 读取操作次数
+    uint32_t bytes_written;             // 写入字节数
+    uint32_t bytes_erased;              // 擦除字节数
+    uint32_t bytes_read;                // 读取字节数
+    uint32_t sync_operations;           // 同步次数
+    uint32_t bytes_synced;              // 同步的字节数
+} posix_flash_perf_stats_t;
+
+// 性能统计函数
+void posix_flash_reset_perf_stats(void);
+void posix_flash_get_perf_stats(posix_flash_perf_stats_t *stats);
+void posix_flash_print_perf_stats(void);
+void posix_flash_write_perf_stats_json(FILE *out);   // 统计和延迟直方图（p50/p90/p99/max）输出为一行JSON
+// 按操作类型/大小查询延迟分布见port_common/flash_sim_latency.h
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_ADAPTER_POSIX_H
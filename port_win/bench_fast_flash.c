@@ -0,0 +1,676 @@
+#include "../core/fast_flash_core.h"
+#include "../port_common/flash_sim_timing.h"
+#include "../port_common/flash_sim_latency.h"
+#include "../port_common/flash_sim_mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 性能基准：在内存模拟的NOR Flash上（虚拟时钟时序模型）运行参数化的工作负载，
+// 统计每次操作的器件时间（p50/p99/max）、主机CPU时间、写放大和器件能耗，结果可输出为JSON用于比较不同版本。
+//
+// 工作负载：
+//   append   不同表大小下追加写入的吞吐
+//   read     按序号随机读取的延迟
+//   update   按序号随机改写（空间不足时GC，GC时间计入该次操作）
+//   mixed    按update_mix比例混合改写和读取
+//   gc       不同填充率下的GC停顿时间（整理区之外没有暂存扇区时GC放弃全部数据，记为failed）
+//   mount    不同管理表链表长度下的挂载时间
+
+#define BENCH_SCHEMA_VERSION   1
+#define BENCH_MAX_SWEEP        8
+#define BENCH_MAX_RESULTS      64
+#define BENCH_MAX_RECORD_SIZE  2048
+#define BENCH_MAX_UPDATES      200000   // 等待空间耗尽时的改写次数上限
+
+// ===== 配置 =====
+typedef struct {
+    uint32_t capacity;                       // 字节
+    uint32_t sector_size;
+    uint32_t record_size;
+    uint32_t tables;
+    uint32_t records[BENCH_MAX_SWEEP];       // append：每张表的记录数
+    int      records_count;
+    double   fill[BENCH_MAX_SWEEP];          // gc：有效数据占容量的比例
+    int      fill_count;
+    uint32_t chain[BENCH_MAX_SWEEP];         // mount：管理表链表长度
+    int      chain_count;
+    double   update_mix;                     // mixed：改写所占比例
+    uint32_t ops;                            // read/update/mixed的操作次数
+    uint32_t gc_rounds;                      // gc：每个填充率测量的GC次数
+    uint32_t seed;
+    const flash_timing_profile_t *profile;
+    const char *workloads;                   // 逗号分隔，NULL表示全部
+    const char *json_path;                   // "-"表示标准输出
+    bool     quiet;                          // 不打印结果表（并行扫描时由fast_flash_sweep汇总）
+    bool     no_copy;                        // 不使用器件内部复制（GC和改写经主机读出再写入）
+} bench_config_t;
+
+typedef struct {
+    const char *workload;
+    const char *param_name;
+    double   param;
+    uint32_t ops;
+    uint32_t failed;
+    uint32_t gc_count;
+    double   device_us_per_op;               // 虚拟时钟（器件时间）
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    double   cpu_ns_per_op;                  // 主机CPU时间（核心代码开销）
+    double   ops_per_sec;                    // 按器件时间计算的吞吐
+    uint64_t user_bytes;
+    uint64_t programmed_bytes;
+    uint64_t relocation_bytes;
+    uint64_t read_bytes;
+    uint64_t erase_bytes;
+    double   write_amplification;
+    uint64_t energy_nj;                      // 器件能耗（能耗模型，见flash_sim_timing.h）
+    double   energy_uj_per_op;
+    double   energy_nj_per_user_byte;
+} bench_result_t;
+
+static bench_config_t cfg;
+static bench_result_t results[BENCH_MAX_RESULTS];
+static int result_count = 0;
+
+// 一次测量：逐次操作的器件时间样本和起止时的计数
+typedef struct {
+    uint32_t *samples;
+    uint32_t  count;
+    uint32_t  capacity;
+    uint32_t  failed;
+    uint32_t  gc_count;
+    int       stats_api;             // 字节计数取自该API，-1表示全部
+    uint64_t  op_device_start;
+    clock_t   op_cpu_start;
+    uint64_t  device_us;             // 被测操作的器件时间之和（不含准备阶段）
+    clock_t   cpu_clock;             // 被测操作的CPU时间之和
+} bench_run_t;
+
+static uint32_t rng_state = 1;
+
+static uint32_t bench_rand(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+// 当前格式化使用的几何参数（重新挂载时需要相同的参数）
+static flash_geometry_t geometry;
+
+// 被测器件：内存模拟器件，--no-copy时去掉内部复制
+static flash_ops_t bench_ops;
+
+static int bench_format(uint32_t max_tables) {
+    memset(&geometry, 0, sizeof(geometry));
+    geometry.sector_size = cfg.sector_size;
+    geometry.page_size = 256;
+    geometry.max_tables = max_tables;
+    // 块擦除粒度：扇区本身和32KB/64KB块（必须是扇区的整数倍）
+    static const uint32_t block_sizes[] = { 32 * 1024, 64 * 1024 };
+    int erase_count = 0;
+    geometry.erase_sizes[erase_count++] = cfg.sector_size;
+    for (size_t i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i++) {
+        if (block_sizes[i] > cfg.sector_size && block_sizes[i] % cfg.sector_size == 0) {
+            geometry.erase_sizes[erase_count++] = block_sizes[i];
+        }
+    }
+
+    flash_sim_mem_erase_all();
+    flash_timing_reset_clock();
+    flash_timing_seed(cfg.seed);
+    return fast_flash_init_ex(&bench_ops, cfg.capacity, true, &geometry);
+}
+
+static void table_name(char *name, uint32_t index) {
+    snprintf(name, TABLE_NAME_MAX_LEN, "T%u", index % 100000u);
+}
+
+static void fill_record(uint8_t *record, uint32_t seq) {
+    for (uint32_t i = 0; i < cfg.record_size; i++) {
+        record[i] = (uint8_t)(seq * 31 + i);
+    }
+}
+
+static int run_begin(bench_run_t *run, uint32_t expected_ops) {
+    memset(run, 0, sizeof(*run));
+    run->capacity = expected_ops ? expected_ops : 1;
+    run->samples = malloc(run->capacity * sizeof(uint32_t));
+    if (!run->samples) {
+        return -1;
+    }
+    run->stats_api = -1;
+    fast_flash_reset_stats();
+    flash_latency_reset();
+    return 0;
+}
+
+static void run_op_begin(bench_run_t *run) {
+    run->op_cpu_start = clock();
+    run->op_device_start = flash_timing_now_us();
+}
+
+static void run_sample(bench_run_t *run) {
+    uint32_t elapsed = (uint32_t)(flash_timing_now_us() - run->op_device_start);
+    run->cpu_clock += clock() - run->op_cpu_start;
+    run->device_us += elapsed;
+    if (run->count < run->capacity) {
+        run->samples[run->count++] = elapsed;
+    }
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_end(bench_run_t *run, const char *workload, const char *param_name, double param) {
+    double cpu_ns = (double)run->cpu_clock * 1e9 / CLOCKS_PER_SEC;
+    uint64_t device_us = run->device_us;
+
+    if (result_count >= BENCH_MAX_RESULTS) {
+        free(run->samples);
+        return;
+    }
+    bench_result_t *r = &results[result_count++];
+    memset(r, 0, sizeof(*r));
+    r->workload = workload;
+    r->param_name = param_name;
+    r->param = param;
+    r->ops = run->count;
+    r->failed = run->failed;
+    r->gc_count = run->gc_count;
+
+    if (run->count > 0) {
+        qsort(run->samples, run->count, sizeof(uint32_t), compare_u32);
+        r->p50_us = run->samples[(run->count - 1) * 50 / 100];
+        r->p99_us = run->samples[(run->count - 1) * 99 / 100];
+        r->max_us = run->samples[run->count - 1];
+        r->device_us_per_op = (double)device_us / run->count;
+        r->cpu_ns_per_op = cpu_ns / run->count;
+        r->ops_per_sec = device_us ? run->count * 1e6 / device_us : 0.0;
+    }
+
+    flash_stats_t stats;
+    fast_flash_get_stats(&stats);
+    const flash_io_stats_t *io = (run->stats_api < 0) ? &stats.total : &stats.per_api[run->stats_api];
+    r->user_bytes = io->user_bytes;
+    r->programmed_bytes = io->data_bytes + io->metadata_bytes + io->relocation_bytes;
+    r->relocation_bytes = io->relocation_bytes;
+    r->read_bytes = io->read_bytes;
+    r->erase_bytes = io->erase_bytes;
+    r->write_amplification = r->user_bytes ? (double)r->programmed_bytes / r->user_bytes : 0.0;
+    r->energy_nj = io->energy_nj;
+    r->energy_uj_per_op = run->count ? io->energy_nj / 1000.0 / run->count : 0.0;
+    r->energy_nj_per_user_byte = r->user_bytes ? (double)io->energy_nj / r->user_bytes : 0.0;
+
+    free(run->samples);
+    run->samples = NULL;
+}
+
+// 空间不足时执行GC并重试（GC时间计入该次操作）
+static int update_with_gc(bench_run_t *run, const char *name, uint32_t index, const uint8_t *record) {
+    int rc = fast_flash_write_table_data_by_index(name, index, record, cfg.record_size);
+    if (rc == -2 && fast_flash_gc() == 0) {
+        run->gc_count++;
+        rc = fast_flash_write_table_data_by_index(name, index, record, cfg.record_size);
+    }
+    return rc;
+}
+
+// 建表并写满（不计入测量）
+static int populate(uint32_t tables, uint32_t records, bool compact) {
+    char name[TABLE_NAME_MAX_LEN];
+    uint8_t *batch = malloc((size_t)records * cfg.record_size);
+    if (!batch) {
+        return -1;
+    }
+
+    int rc = 0;
+    for (uint32_t t = 0; t < tables && rc == 0; t++) {
+        table_name(name, t);
+        for (uint32_t i = 0; i < records; i++) {
+            fill_record(batch + (size_t)i * cfg.record_size, t + i);
+        }
+        rc = fast_flash_create_table(name, cfg.record_size, records);
+        if (rc == -2 && fast_flash_gc() == 0) {
+            rc = fast_flash_create_table(name, cfg.record_size, records);
+        }
+        if (rc == 0) {
+            rc = fast_flash_write_table_data_batch(name, batch, cfg.record_size, records);
+            if (rc == -2 && fast_flash_gc() == 0) {
+                rc = fast_flash_write_table_data_batch(name, batch, cfg.record_size, records);
+            }
+        }
+        // 每张表写完后整理一次，让初始布局紧密排布（否则每张表独占一个扇区，高填充率下没有暂存扇区）
+        if (rc == 0 && compact) {
+            rc = fast_flash_gc();
+        }
+    }
+    free(batch);
+    return rc;
+}
+
+static bool tables_present(uint32_t tables) {
+    char name[TABLE_NAME_MAX_LEN];
+    for (uint32_t t = 0; t < tables; t++) {
+        table_name(name, t);
+        if (!fast_flash_table_exists(name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 每张表最多能放的记录数（表不跨扇区）
+static uint32_t max_records_per_table(void) {
+    return (cfg.sector_size - sizeof(table_header_t)) / cfg.record_size;
+}
+
+static int bench_append(void) {
+    char name[TABLE_NAME_MAX_LEN];
+    uint8_t record[BENCH_MAX_RECORD_SIZE];
+
+    for (int s = 0; s < cfg.records_count; s++) {
+        uint32_t records = cfg.records[s];
+        if (records == 0 || records > max_records_per_table()) {
+            printf("append: %u records of %u bytes do not fit a sector, skipped\n", records, cfg.record_size);
+            continue;
+        }
+        if (bench_format(cfg.tables + 1) != 0) {
+            return -1;
+        }
+        for (uint32_t t = 0; t < cfg.tables; t++) {
+            table_name(name, t);
+            if (fast_flash_create_table(name, cfg.record_size, records) != 0) {
+                return -1;
+            }
+        }
+
+        bench_run_t run;
+        if (run_begin(&run, cfg.tables * records) != 0) {
+            return -1;
+        }
+        for (uint32_t i = 0; i < records; i++) {
+            for (uint32_t t = 0; t < cfg.tables; t++) {
+                table_name(name, t);
+                fill_record(record, i);
+                run_op_begin(&run);
+                int rc = fast_flash_append_table_data(name, record, cfg.record_size);
+                if (rc == -2 && fast_flash_gc() == 0) {
+                    run.gc_count++;
+                    rc = fast_flash_append_table_data(name, record, cfg.record_size);
+                }
+                if (rc != 0) {
+                    run.failed++;
+                }
+                run_sample(&run);
+            }
+        }
+        run_end(&run, "append", "records", records);
+    }
+    return 0;
+}
+
+// 读取、改写和混合负载共用的初始数据：tables张表，每张写满
+static uint32_t steady_records(void) {
+    uint32_t records = 64;
+    if (records > max_records_per_table()) {
+        records = max_records_per_table();
+    }
+    return records;
+}
+
+static int bench_steady(const char *workload, double update_mix) {
+    char name[TABLE_NAME_MAX_LEN];
+    uint8_t record[BENCH_MAX_RECORD_SIZE];
+    uint32_t records = steady_records();
+
+    if (bench_format(cfg.tables + 1) != 0 || populate(cfg.tables, records, false) != 0) {
+        printf("%s: failed to populate %u tables\n", workload, cfg.tables);
+        return -1;
+    }
+
+    bench_run_t run;
+    if (run_begin(&run, cfg.ops) != 0) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < cfg.ops; i++) {
+        uint32_t t = bench_rand() % cfg.tables;
+        uint32_t index = bench_rand() % records;
+        bool is_update = (bench_rand() % 10000) < (uint32_t)(update_mix * 10000);
+        table_name(name, t);
+
+        run_op_begin(&run);
+        int rc;
+        if (is_update) {
+            fill_record(record, i + 1000);
+            rc = update_with_gc(&run, name, index, record);
+        } else {
+            rc = fast_flash_read_table_data(name, index, record, cfg.record_size);
+        }
+        if (rc != 0) {
+            run.failed++;
+        }
+        run_sample(&run);
+    }
+    run_end(&run, workload, "update_mix", update_mix);
+    return 0;
+}
+
+static int bench_gc(void) {
+    char name[TABLE_NAME_MAX_LEN];
+    uint8_t record[BENCH_MAX_RECORD_SIZE];
+    // 每张表占半个扇区，两张表放满一个扇区
+    uint32_t records = (cfg.sector_size / 2 - sizeof(table_header_t)) / cfg.record_size;
+
+    for (int s = 0; s < cfg.fill_count; s++) {
+        double fill = cfg.fill[s];
+        uint32_t tables = (uint32_t)(fill * cfg.capacity / (cfg.sector_size / 2));
+        if (records == 0 || tables == 0 || tables >= FF_MAX_TABLES_LIMIT) {
+            printf("gc: fill %.2f not representable with %u-byte records, skipped\n", fill, cfg.record_size);
+            continue;
+        }
+        if (bench_format(tables + 1) != 0 || populate(tables, records, true) != 0) {
+            printf("gc: failed to populate fill %.2f (%u tables)\n", fill, tables);
+            continue;
+        }
+
+        bench_run_t run;
+        if (run_begin(&run, cfg.gc_rounds) != 0) {
+            return -1;
+        }
+        run.stats_api = FF_API_GC;  // 只统计GC本身
+        uint32_t seq = 0;
+        for (uint32_t round = 0; round < cfg.gc_rounds; round++) {
+            // 改写直到空间耗尽，然后测量一次GC
+            int rc = 0;
+            for (uint32_t i = 0; i < BENCH_MAX_UPDATES && rc == 0; i++) {
+                table_name(name, bench_rand() % tables);
+                fill_record(record, ++seq);
+                rc = fast_flash_write_table_data_by_index(name, bench_rand() % records, record, cfg.record_size);
+            }
+            if (rc != -2) {
+                run.failed++;
+                break;
+            }
+            run_op_begin(&run);
+            if (fast_flash_gc() != 0) {
+                run.failed++;
+                break;
+            }
+            run.gc_count++;
+            run_sample(&run);
+            // 没有暂存扇区时GC会放弃全部数据并返回成功，需要检查表是否还在
+            if (!tables_present(tables)) {
+                run.failed++;
+                break;
+            }
+        }
+        run_end(&run, "gc", "fill", fill);
+    }
+    return 0;
+}
+
+static int bench_mount(void) {
+    uint8_t record[BENCH_MAX_RECORD_SIZE];
+
+    for (int s = 0; s < cfg.chain_count; s++) {
+        uint32_t chain = cfg.chain[s];
+        if (bench_format(4) != 0 || populate(1, 4, false) != 0) {
+            return -1;
+        }
+        // 每次改写保存一次管理表，链表长度加一
+        uint32_t saves = 0;
+        while (saves < chain) {
+            fill_record(record, saves + 1);
+            if (fast_flash_write_table_data_by_index("T0", saves % 4, record, cfg.record_size) != 0) {
+                break;
+            }
+            saves++;
+        }
+
+        bench_run_t run;
+        if (run_begin(&run, 1) != 0) {
+            return -1;
+        }
+        run_op_begin(&run);
+        if (fast_flash_init_ex(&bench_ops, cfg.capacity, true, &geometry) != 0 ||
+            fast_flash_validate_table_data("T0") != 0) {
+            run.failed++;
+        }
+        run_sample(&run);
+        run_end(&run, "mount", "chain", saves);
+    }
+    return 0;
+}
+
+// ===== 输出 =====
+static void print_results(void) {
+    printf("\n%-8s %-11s %8s %7s %5s %11s %8s %8s %9s %11s %9s %8s %7s\n",
+           "workload", "param", "ops", "failed", "gc", "dev_us/op", "p50_us", "p99_us", "max_us", "cpu_ns/op",
+           "uJ/op", "nJ/B", "WA");
+    for (int i = 0; i < result_count; i++) {
+        const bench_result_t *r = &results[i];
+        char param[32];
+        snprintf(param, sizeof(param), "%s=%g", r->param_name, r->param);
+        printf("%-8s %-11s %8u %7u %5u %11.1f %8u %8u %9u %11.0f %9.1f %8.1f %7.2f\n",
+               r->workload, param, r->ops, r->failed, r->gc_count, r->device_us_per_op,
+               r->p50_us, r->p99_us, r->max_us, r->cpu_ns_per_op, r->energy_uj_per_op,
+               r->energy_nj_per_user_byte, r->write_amplification);
+    }
+}
+
+static void write_json(FILE *out) {
+    fprintf(out, "{\"schema\":%d,\"config\":{\"capacity\":%u,\"sector_size\":%u,\"record_size\":%u,\"tables\":%u,"
+                 "\"ops\":%u,\"update_mix\":%.3f,\"gc_rounds\":%u,\"seed\":%u,\"profile\":\"%s\",\"device_copy\":%s},\n\"results\":[",
+            BENCH_SCHEMA_VERSION, cfg.capacity, cfg.sector_size, cfg.record_size, cfg.tables, cfg.ops, cfg.update_mix,
+            cfg.gc_rounds, cfg.seed, cfg.profile->name, cfg.no_copy ? "false" : "true");
+    for (int i = 0; i < result_count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(out, "%s\n{\"workload\":\"%s\",\"%s\":%g,\"ops\":%u,\"failed\":%u,\"gc_count\":%u,"
+                     "\"device_us_per_op\":%.2f,\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u,"
+                     "\"cpu_ns_per_op\":%.0f,\"ops_per_sec\":%.2f,\"user_bytes\":%llu,\"programmed_bytes\":%llu,"
+                     "\"relocation_bytes\":%llu,\"read_bytes\":%llu,\"erase_bytes\":%llu,\"write_amplification\":%.3f,"
+                     "\"energy_nj\":%llu,\"energy_uj_per_op\":%.3f,\"energy_nj_per_user_byte\":%.3f}",
+                i ? "," : "", r->workload, r->param_name, r->param, r->ops, r->failed, r->gc_count,
+                r->device_us_per_op, r->p50_us, r->p99_us, r->max_us, r->cpu_ns_per_op, r->ops_per_sec,
+                (unsigned long long)r->user_bytes, (unsigned long long)r->programmed_bytes,
+                (unsigned long long)r->relocation_bytes, (unsigned long long)r->read_bytes,
+                (unsigned long long)r->erase_bytes, r->write_amplification,
+                (unsigned long long)r->energy_nj, r->energy_uj_per_op, r->energy_nj_per_user_byte);
+    }
+    fprintf(out, "\n]}\n");
+}
+
+// ===== 命令行 =====
+static int parse_u32_list(const char *text, uint32_t *values) {
+    int count = 0;
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", text);
+    for (char *tok = strtok(buf, ","); tok && count < BENCH_MAX_SWEEP; tok = strtok(NULL, ",")) {
+        values[count++] = (uint32_t)strtoul(tok, NULL, 0);
+    }
+    return count;
+}
+
+static int parse_double_list(const char *text, double *values) {
+    int count = 0;
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%s", text);
+    for (char *tok = strtok(buf, ","); tok && count < BENCH_MAX_SWEEP; tok = strtok(NULL, ",")) {
+        values[count++] = strtod(tok, NULL);
+    }
+    return count;
+}
+
+static bool workload_enabled(const char *name) {
+    if (!cfg.workloads) {
+        return true;
+    }
+    size_t len = strlen(name);
+    for (const char *p = cfg.workloads; (p = strstr(p, name)) != NULL; p += len) {
+        if ((p == cfg.workloads || p[-1] == ',') && (p[len] == '\0' || p[len] == ',')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void usage(void) {
+    printf("usage: fast_flash_bench [options]\n"
+           "  --capacity KB        simulated flash size (default 128)\n"
+           "  --sector N           sector size in bytes, power of two (default 4096)\n"
+           "  --record-size N      record size in bytes (default 32)\n"
+           "  --tables N           tables for append/read/update/mixed (default 8)\n"
+           "  --records LIST       append: records per table (default 16,64,120)\n"
+           "  --fill LIST          gc: live data / capacity (default 0.25,0.5,0.75,0.9)\n"
+           "  --chain LIST         mount: manager table chain lengths (default 1,16,64,256)\n"
+           "  --update-mix R       mixed: fraction of updates vs reads (default 0.5)\n"
+           "  --ops N              operations for read/update/mixed (default 2000)\n"
+           "  --gc-rounds N        GCs measured per fill level (default 5)\n"
+           "  --seed N             RNG seed for workload and device timing\n"
+           "  --profile NAME       winbond | gigadevice | ideal\n"
+           "  --workloads LIST     subset of append,read,update,mixed,gc,mount\n"
+           "  --json FILE          write results as JSON (- for stdout)\n"
+           "  --quick              small sweep for smoke testing\n"
+           "  --quiet              do not print the result table\n"
+           "  --no-copy            disable the device-side copy (relocate through host RAM)\n");
+}
+
+static int parse_args(int argc, char **argv) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.capacity = 128 * 1024;
+    cfg.sector_size = 4096;
+    cfg.record_size = 32;
+    cfg.tables = 8;
+    cfg.records_count = parse_u32_list("16,64,120", cfg.records);
+    cfg.fill_count = parse_double_list("0.25,0.5,0.75,0.9", cfg.fill);
+    cfg.chain_count = parse_u32_list("1,16,64,256", cfg.chain);
+    cfg.update_mix = 0.5;
+    cfg.ops = 2000;
+    cfg.gc_rounds = 5;
+    cfg.seed = FLASH_TIMING_DEFAULT_SEED;
+    cfg.profile = &flash_timing_winbond_w25q;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--quick") == 0) {
+            cfg.records_count = parse_u32_list("16,64", cfg.records);
+            cfg.fill_count = parse_double_list("0.25,0.5", cfg.fill);
+            cfg.chain_count = parse_u32_list("1,32", cfg.chain);
+            cfg.ops = 200;
+            cfg.gc_rounds = 2;
+            continue;
+        }
+        if (strcmp(arg, "--quiet") == 0) {
+            cfg.quiet = true;
+            continue;
+        }
+        if (strcmp(arg, "--no-copy") == 0) {
+            cfg.no_copy = true;
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0 || !value) {
+            usage();
+            return -1;
+        }
+        i++;
+        if (strcmp(arg, "--capacity") == 0) cfg.capacity = (uint32_t)strtoul(value, NULL, 0) * 1024;
+        else if (strcmp(arg, "--sector") == 0) cfg.sector_size = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--record-size") == 0) cfg.record_size = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--tables") == 0) cfg.tables = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--records") == 0) cfg.records_count = parse_u32_list(value, cfg.records);
+        else if (strcmp(arg, "--fill") == 0) cfg.fill_count = parse_double_list(value, cfg.fill);
+        else if (strcmp(arg, "--chain") == 0) cfg.chain_count = parse_u32_list(value, cfg.chain);
+        else if (strcmp(arg, "--update-mix") == 0) cfg.update_mix = strtod(value, NULL);
+        else if (strcmp(arg, "--ops") == 0) cfg.ops = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--gc-rounds") == 0) cfg.gc_rounds = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--seed") == 0) cfg.seed = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--workloads") == 0) cfg.workloads = value;
+        else if (strcmp(arg, "--json") == 0) cfg.json_path = value;
+        else if (strcmp(arg, "--profile") == 0) {
+            if (strcmp(value, "winbond") == 0) cfg.profile = &flash_timing_winbond_w25q;
+            else if (strcmp(value, "gigadevice") == 0) cfg.profile = &flash_timing_gigadevice_gd25q;
+            else if (strcmp(value, "ideal") == 0) cfg.profile = &flash_timing_ideal;
+            else {
+                printf("Unknown timing profile '%s'\n", value);
+                return -1;
+            }
+        } else {
+            usage();
+            return -1;
+        }
+    }
+
+    if (cfg.sector_size < 1024 || (cfg.sector_size & (cfg.sector_size - 1)) != 0 ||
+        cfg.capacity < 4 * cfg.sector_size || cfg.capacity % cfg.sector_size != 0 ||
+        cfg.record_size == 0 || cfg.record_size > cfg.sector_size / 2 || cfg.record_size > BENCH_MAX_RECORD_SIZE ||
+        cfg.tables == 0 || cfg.tables >= FF_MAX_TABLES_LIMIT || cfg.update_mix < 0 || cfg.update_mix > 1) {
+        printf("Invalid benchmark configuration\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) != 0) {
+        return -1;
+    }
+
+    if (flash_sim_mem_create(cfg.capacity, cfg.sector_size) != 0) {
+        printf("Failed to allocate %u KB simulated flash\n", cfg.capacity / 1024);
+        return -1;
+    }
+    flash_timing_set_profile(cfg.profile);
+    rng_state = cfg.seed ? cfg.seed : 1;
+    bench_ops = flash_sim_mem_ops;
+    if (cfg.no_copy) {
+        bench_ops.copy = NULL;
+    }
+
+    if (!cfg.quiet) {
+        printf("Fast Flash Benchmark (%u KB, %u-byte records, profile %s, seed 0x%08X)\n",
+               cfg.capacity / 1024, cfg.record_size, cfg.profile->name, cfg.seed);
+    }
+
+    int rc = 0;
+    if (workload_enabled("append")) rc |= bench_append();
+    if (workload_enabled("read")) rc |= bench_steady("read", 0.0);
+    if (workload_enabled("update")) rc |= bench_steady("update", 1.0);
+    if (workload_enabled("mixed")) rc |= bench_steady("mixed", cfg.update_mix);
+    if (workload_enabled("gc")) rc |= bench_gc();
+    if (workload_enabled("mount")) rc |= bench_mount();
+
+    if (!cfg.quiet) {
+        print_results();
+    }
+
+    if (cfg.json_path) {
+        FILE *out = strcmp(cfg.json_path, "-") == 0 ? stdout : fopen(cfg.json_path, "w");
+        if (!out) {
+            printf("Failed to open %s\n", cfg.json_path);
+            rc = -1;
+        } else {
+            write_json(out);
+            if (out != stdout) {
+                fclose(out);
+            }
+        }
+    }
+
+    flash_sim_mem_destroy();
+    for (int i = 0; i < result_count && rc == 0; i++) {
+        if (results[i].failed) {
+            rc = -1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,245 @@
+#include "../core/fast_flash_core.h"
+#include "../core/fast_flash_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 大容量NOR Flash基准测试：在内存中模拟16MB / 128MB器件，
+// 比较不同容量下单次更新、挂载和GC的耗时与I/O量，用于确认开销只与有效数据相关
+
+// 内存模拟的NOR Flash（编程只能把1写成0，擦除恢复为0xFF）
+static uint8_t *ram_flash = NULL;
+static uint32_t ram_flash_size = 0;
+
+// I/O统计
+typedef struct {
+    uint64_t read_bytes;
+    uint64_t write_bytes;
+    uint64_t erase_bytes;
+    uint32_t read_ops;
+    uint32_t write_ops;
+    uint32_t erase_ops;
+} bench_io_t;
+
+static bench_io_t io_stats;
+
+static int ram_flash_init(void) {
+    return ram_flash ? 0 : -1;
+}
+
+static int ram_flash_read(uint32_t addr, uint8_t *buf, uint32_t size) {
+    if ((uint64_t)addr + size > ram_flash_size) {
+        return -1;
+    }
+    memcpy(buf, ram_flash + addr, size);
+    io_stats.read_bytes += size;
+    io_stats.read_ops++;
+    return 0;
+}
+
+static int ram_flash_write(uint32_t addr, const uint8_t *buf, uint32_t size) {
+    if ((uint64_t)addr + size > ram_flash_size) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        ram_flash[addr + i] &= buf[i];
+    }
+    io_stats.write_bytes += size;
+    io_stats.write_ops++;
+    return 0;
+}
+
+static int ram_flash_erase(uint32_t addr, uint32_t size) {
+    if ((uint64_t)addr + size > ram_flash_size || addr % FLASH_SECTOR_SIZE != 0) {
+        return -1;
+    }
+    memset(ram_flash + addr, 0xFF, size);
+    io_stats.erase_bytes += size;
+    io_stats.erase_ops++;
+    return 0;
+}
+
+static const flash_ops_t ram_flash_ops = {
+    .init = ram_flash_init,
+    .read = ram_flash_read,
+    .write = ram_flash_write,
+    .erase = ram_flash_erase,
+};
+
+static const flash_geometry_t bench_geometry = {
+    .erase_sizes = { 4 * 1024, 32 * 1024, 64 * 1024, 0 },
+};
+
+// 工作负载参数
+#define BENCH_HOT_TABLES     8
+#define BENCH_COLD_TABLES    4
+#define BENCH_LOG_TABLES     4
+#define BENCH_UPDATES        2000
+
+typedef struct {
+    const char *phase;
+    double      total_us;
+    uint32_t    count;
+    bench_io_t  io;
+} bench_result_t;
+
+static double elapsed_us(clock_t start) {
+    return (double)(clock() - start) * 1000000.0 / CLOCKS_PER_SEC;
+}
+
+static void bench_begin(bench_result_t *result, const char *phase) {
+    memset(result, 0, sizeof(*result));
+    result->phase = phase;
+    memset(&io_stats, 0, sizeof(io_stats));
+}
+
+static void bench_end(bench_result_t *result, clock_t start, uint32_t count) {
+    result->total_us = elapsed_us(start);
+    result->count = count;
+    result->io = io_stats;
+}
+
+static void bench_print(uint32_t capacity, const bench_result_t *result) {
+    uint32_t n = result->count ? result->count : 1;
+    printf("%6u MB  %-8s %8u %12.1f %12llu %12llu %12llu\n",
+           capacity >> 20, result->phase, result->count, result->total_us / n,
+           (unsigned long long)(result->io.read_bytes / n),
+           (unsigned long long)(result->io.write_bytes / n),
+           (unsigned long long)(result->io.erase_bytes / n));
+}
+
+static int bench_capacity(uint32_t capacity) {
+    ram_flash = malloc(capacity);
+    if (!ram_flash) {
+        printf("Failed to allocate %u MB simulated flash\n", capacity >> 20);
+        return -1;
+    }
+    ram_flash_size = capacity;
+    memset(ram_flash, 0xFF, capacity);
+
+    bench_result_t result;
+    clock_t start;
+    char name[TABLE_NAME_MAX_LEN];
+    uint8_t record[64];
+    int rc = 0;
+
+    // 首次挂载（空白器件）
+    bench_begin(&result, "format");
+    start = clock();
+    if (fast_flash_init_ex(&ram_flash_ops, capacity, true, &bench_geometry) != 0) {
+        printf("Failed to format %u MB flash\n", capacity >> 20);
+        free(ram_flash);
+        return -1;
+    }
+    bench_end(&result, start, 1);
+    flash_log_set_level(LOG_LEVEL_ERROR);
+    bench_print(capacity, &result);
+
+    // 建表：热数据、冷数据、日志
+    for (int i = 0; i < BENCH_HOT_TABLES + BENCH_COLD_TABLES + BENCH_LOG_TABLES && rc == 0; i++) {
+        uint8_t flags = FF_TABLE_HOT;
+        uint32_t struct_size = 32, max_structs = 16;
+        if (i >= BENCH_HOT_TABLES + BENCH_COLD_TABLES) {
+            flags = FF_TABLE_APPEND_ONLY;
+            struct_size = 16;
+            max_structs = 128;
+        } else if (i >= BENCH_HOT_TABLES) {
+            flags = FF_TABLE_COLD;
+            struct_size = 64;
+            max_structs = 32;
+        }
+        snprintf(name, sizeof(name), "B%d", i);
+        memset(record, i, sizeof(record));
+        rc = fast_flash_create_table_ex(name, struct_size, max_structs, flags);
+        for (uint32_t j = 0; j < max_structs / 2 && rc == 0; j++) {
+            rc = fast_flash_append_table_data(name, record, struct_size);
+        }
+    }
+    if (rc != 0) {
+        printf("Failed to populate tables (%d)\n", rc);
+        free(ram_flash);
+        return -1;
+    }
+
+    // 热数据按索引改写（空间不足时执行GC后重试，GC耗时计入更新）
+    uint32_t gc_count = 0;
+    bench_begin(&result, "update");
+    start = clock();
+    for (uint32_t i = 0; i < BENCH_UPDATES && rc == 0; i++) {
+        snprintf(name, sizeof(name), "B%u", i % BENCH_HOT_TABLES);
+        memset(record, (int)i, sizeof(record));
+        rc = fast_flash_write_table_data_by_index(name, i % 8, record, 32);
+        if (rc == -2 && fast_flash_gc() == 0) {
+            gc_count++;
+            rc = fast_flash_write_table_data_by_index(name, i % 8, record, 32);
+        }
+    }
+    bench_end(&result, start, BENCH_UPDATES);
+    bench_print(capacity, &result);
+    if (gc_count > 0) {
+        printf("%6u MB  (%u GC during updates)\n", capacity >> 20, gc_count);
+    }
+
+    // 重新挂载（管理表链表长度 = 上次GC以来的保存次数）
+    bench_begin(&result, "mount");
+    start = clock();
+    rc |= fast_flash_init_ex(&ram_flash_ops, capacity, true, &bench_geometry);
+    bench_end(&result, start, 1);
+    flash_log_set_level(LOG_LEVEL_ERROR);
+    bench_print(capacity, &result);
+
+    // 垃圾回收
+    bench_begin(&result, "gc");
+    start = clock();
+    rc |= fast_flash_gc();
+    bench_end(&result, start, 1);
+    bench_print(capacity, &result);
+
+    // GC之后再次挂载
+    bench_begin(&result, "remount");
+    start = clock();
+    rc |= fast_flash_init_ex(&ram_flash_ops, capacity, true, &bench_geometry);
+    bench_end(&result, start, 1);
+    flash_log_set_level(LOG_LEVEL_ERROR);
+    bench_print(capacity, &result);
+
+    for (int i = 0; i < BENCH_HOT_TABLES + BENCH_COLD_TABLES + BENCH_LOG_TABLES && rc == 0; i++) {
+        snprintf(name, sizeof(name), "B%d", i);
+        rc = fast_flash_validate_table_data(name);
+    }
+    if (rc != 0) {
+        printf("Benchmark failed at %u MB (%d)\n", capacity >> 20, rc);
+    }
+
+    free(ram_flash);
+    ram_flash = NULL;
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    // 默认比较1MB / 16MB / 128MB，也可以在命令行指定容量（MB）
+    uint32_t capacities[8] = { 1, 16, 128 };
+    int count = 3;
+    if (argc > 1) {
+        count = 0;
+        for (int i = 1; i < argc && count < 8; i++) {
+            capacities[count++] = (uint32_t)atoi(argv[i]);
+        }
+    }
+
+    printf("Fast Flash Large Capacity Benchmark\n");
+    printf("===================================\n");
+    printf("capacity   phase       count   us/op        read/op      write/op     erase/op\n");
+
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        if (capacities[i] == 0 || capacities[i] > 2048) {
+            printf("Invalid capacity %u MB\n", capacities[i]);
+            return -1;
+        }
+        result |= bench_capacity(capacities[i] << 20);
+    }
+
+    return result;
+}
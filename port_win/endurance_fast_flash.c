@@ -0,0 +1,623 @@
+#include "../core/fast_flash_core.h"
+#include "../core/fast_flash_record.h"
+#include "../port_common/flash_sim_timing.h"
+#include "../port_common/flash_sim_mem.h"
+#include "../port_common/flash_sim_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 寿命估算：在内存模拟的NOR Flash上按使用时间（模拟日历时间，与器件虚拟时钟相互独立）驱动核心，
+// 统计每个扇区的擦除次数，按观测窗口内的磨损速度外推第一个扇区达到擦写寿命的时间。
+// 只执行事件本身，不等待事件之间的空闲时间，模拟数月到数年的使用只需要几秒。
+//
+// 负载来源：
+//   模型   热计数器按固定周期改写、日志表按周期追加（写满后删除重建）、配置表每天整体重写若干次
+//   录制   把fast_flash_record录制的调用序列当作一个周期（--trace-period）的负载循环回放
+// 两种负载都按应用的通常做法处理空间不足：返回-2时执行一次GC后重试。
+// 前warmup天不计入磨损统计（首次写满之前没有GC，擦除速度偏低）。
+
+#define ENDURANCE_SCHEMA_VERSION  1
+#define ENDURANCE_SECTOR_SIZE     4096
+#define ENDURANCE_SECONDS_PER_DAY 86400.0
+#define ENDURANCE_HOTTEST         5        // 报告中列出的最热扇区数
+
+// ===== 配置 =====
+typedef struct {
+    uint32_t capacity;                 // 字节（模型负载）
+    uint32_t endurance;                // 每个扇区的擦写寿命
+    double   days;                     // 观测窗口（模拟天数，不含warmup）
+    double   warmup_days;
+    double   reboots_per_day;          // 重新上电挂载
+    uint32_t counters;                 // 热计数器个数
+    uint32_t counter_size;
+    double   counter_period;           // 秒，每次改写一个随机计数器
+    uint32_t log_size;                 // 日志记录大小
+    uint32_t log_records;              // 日志表容量（写满后删除重建）
+    double   log_period;               // 秒
+    uint32_t config_size;
+    double   configs_per_day;
+    const char *trace_path;            // 非NULL时使用录制负载
+    double   trace_period;             // 小时，录制负载的一个周期
+    uint32_t seed;
+    const flash_timing_profile_t *profile;
+    const char *json_path;             // "-"表示标准输出
+} endurance_config_t;
+
+static endurance_config_t cfg;
+
+// ===== 运行状态 =====
+typedef struct {
+    double   now;                      // 模拟时间（秒，从warmup结束算起，warmup期间为负）
+    uint64_t ops;
+    uint32_t errors;
+    uint32_t gc_count;
+    uint32_t reboots;
+    uint32_t log_rotations;
+    bool     data_lost;                // GC放弃了数据（整理区之外没有暂存扇区）
+    bool     worn_out;                 // 窗口内已有扇区达到寿命
+    uint64_t device_us;                // 观测窗口内的器件时间
+} endurance_state_t;
+
+static endurance_state_t st;
+static flash_geometry_t geometry;
+static uint8_t record_buf[ENDURANCE_SECTOR_SIZE];
+static uint32_t counter_values[256];
+
+static uint32_t rng_state = 1;
+
+static uint32_t endurance_rand(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+// 空间不足时GC并重试
+static int with_gc(int rc, int (*retry)(void)) {
+    if (rc == -2 && fast_flash_gc() == 0) {
+        st.gc_count++;
+        rc = retry();
+    }
+    return rc;
+}
+
+// ===== 模型负载 =====
+static uint32_t pending_counter;
+
+static int counter_write(void) {
+    uint32_t index = pending_counter;
+    memset(record_buf, 0, cfg.counter_size);
+    memcpy(record_buf, &counter_values[index], sizeof(uint32_t));
+    return fast_flash_write_table_data_by_index("CNT", index, record_buf, cfg.counter_size);
+}
+
+static int log_append(void) {
+    memset(record_buf, (uint8_t)st.ops, cfg.log_size);
+    memcpy(record_buf, &st.ops, sizeof(st.ops) < cfg.log_size ? sizeof(st.ops) : cfg.log_size);
+    return fast_flash_append_table_data("LOG", record_buf, cfg.log_size);
+}
+
+static int log_create(void) {
+    return fast_flash_create_table_ex("LOG", cfg.log_size, cfg.log_records, FF_TABLE_APPEND_ONLY);
+}
+
+static int config_write(void) {
+    uint8_t *buf = malloc(cfg.config_size);
+    if (!buf) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < cfg.config_size; i++) {
+        buf[i] = (uint8_t)(st.ops + i);
+    }
+    int rc = fast_flash_table_exists("CFG") && fast_flash_get_table_count("CFG") > 0
+                 ? fast_flash_write_table_data_by_index("CFG", 0, buf, cfg.config_size)
+                 : fast_flash_write_table_data("CFG", buf, cfg.config_size);
+    free(buf);
+    return rc;
+}
+
+static int model_format(void) {
+    memset(&geometry, 0, sizeof(geometry));
+    geometry.sector_size = ENDURANCE_SECTOR_SIZE;
+    geometry.page_size = 256;
+    geometry.erase_sizes[0] = 4 * 1024;
+    geometry.erase_sizes[1] = 32 * 1024;
+    geometry.erase_sizes[2] = 64 * 1024;
+
+    if (fast_flash_init_ex(&flash_sim_mem_ops, cfg.capacity, true, &geometry) != 0) {
+        return -1;
+    }
+    if (fast_flash_create_table_ex("CFG", cfg.config_size, 1, FF_TABLE_COLD) != 0 || config_write() != 0 ||
+        fast_flash_create_table_ex("CNT", cfg.counter_size, cfg.counters, FF_TABLE_HOT) != 0 || log_create() != 0) {
+        return -1;
+    }
+    memset(record_buf, 0, cfg.counter_size);
+    for (uint32_t i = 0; i < cfg.counters; i++) {
+        if (fast_flash_append_table_data("CNT", record_buf, cfg.counter_size) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static bool model_tables_present(void) {
+    return fast_flash_table_exists("CFG") && fast_flash_table_exists("CNT") && fast_flash_table_exists("LOG");
+}
+
+static int model_counter_event(void) {
+    pending_counter = endurance_rand() % cfg.counters;
+    counter_values[pending_counter]++;
+    return with_gc(counter_write(), counter_write);
+}
+
+static int model_log_event(void) {
+    if (fast_flash_get_table_count("LOG") >= cfg.log_records) {
+        st.log_rotations++;
+        if (fast_flash_delete_table("LOG") != 0 || with_gc(log_create(), log_create) != 0) {
+            return -1;
+        }
+    }
+    return with_gc(log_append(), log_append);
+}
+
+static int model_config_event(void) {
+    return with_gc(config_write(), config_write);
+}
+
+static int model_reboot(void) {
+    return fast_flash_init_ex(&flash_sim_mem_ops, cfg.capacity, true, &geometry);
+}
+
+// ===== 录制负载 =====
+static uint8_t *trace = NULL;
+static uint32_t trace_size = 0;
+static int trace_start = 0;
+
+static const flash_record_t *retry_record;
+
+static int trace_retry(void) {
+    return flash_sim_replay_execute(retry_record, NULL);
+}
+
+static bool is_write_op(uint8_t op) {
+    return op == FF_REC_CREATE_TABLE || op == FF_REC_WRITE || op == FF_REC_WRITE_BY_INDEX ||
+           op == FF_REC_APPEND || op == FF_REC_WRITE_BATCH;
+}
+
+// 回放一个周期的录制负载；第一个周期之后的初始化记录相当于重新上电挂载
+static int trace_run_period(void) {
+    int pos = trace_start;
+    while ((uint32_t)pos < trace_size) {
+        flash_record_t rec;
+        int used = fast_flash_record_decode(trace + pos, trace_size - (uint32_t)pos, &rec);
+        if (used <= 0) {
+            printf("%s record at offset %d\n", used == 0 ? "Truncated" : "Invalid", pos);
+            return -1;
+        }
+        pos += used;
+        if (rec.op != FF_REC_INIT && !flash_sim_replay_ready()) {
+            printf("Trace does not start with init\n");
+            return -1;
+        }
+
+        int rc = flash_sim_replay_execute(&rec, NULL);
+        if (rc == -2 && is_write_op(rec.op)) {
+            retry_record = &rec;
+            rc = with_gc(rc, trace_retry);
+        }
+        if (rec.op == FF_REC_INIT && rc != 0) {
+            printf("Trace init failed\n");
+            return -1;
+        }
+        st.ops++;
+        if (rc != 0) {
+            st.errors++;
+        }
+    }
+    return 0;
+}
+
+// ===== 磨损统计 =====
+typedef struct {
+    uint32_t sectors;
+    uint64_t total;
+    uint32_t max;
+    uint32_t min;
+    uint32_t hottest[ENDURANCE_HOTTEST];   // 扇区号，按擦除次数降序
+    int      hottest_count;
+} wear_summary_t;
+
+static void wear_summarize(wear_summary_t *w) {
+    const uint32_t *counts = flash_sim_mem_erase_counts();
+    memset(w, 0, sizeof(*w));
+    w->sectors = flash_sim_mem_sector_count();
+    w->min = UINT32_MAX;
+    for (uint32_t s = 0; s < w->sectors; s++) {
+        uint32_t c = counts[s];
+        w->total += c;
+        if (c > w->max) w->max = c;
+        if (c < w->min) w->min = c;
+
+        // 插入排序维护最热的几个扇区
+        int pos = w->hottest_count;
+        while (pos > 0 && counts[w->hottest[pos - 1]] < c) {
+            if (pos < ENDURANCE_HOTTEST) {
+                w->hottest[pos] = w->hottest[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < ENDURANCE_HOTTEST) {
+            w->hottest[pos] = s;
+            if (w->hottest_count < ENDURANCE_HOTTEST) {
+                w->hottest_count++;
+            }
+        }
+    }
+    if (w->sectors == 0) {
+        w->min = 0;
+    }
+}
+
+static double seconds_to_years(double seconds) {
+    return seconds / (ENDURANCE_SECONDS_PER_DAY * 365.25);
+}
+
+// 按观测窗口的磨损速度外推：第一个扇区达到寿命的年数；理想磨损均衡（擦除均匀分布到所有扇区）的年数
+static void wear_project(const wear_summary_t *w, double *first_years, double *ideal_years) {
+    double elapsed = st.now;
+    *first_years = 0.0;
+    *ideal_years = 0.0;
+    if (elapsed <= 0.0) {
+        return;
+    }
+    if (w->max > 0) {
+        *first_years = seconds_to_years((double)cfg.endurance * elapsed / w->max);
+    }
+    if (w->total > 0) {
+        *ideal_years = seconds_to_years((double)cfg.endurance * w->sectors * elapsed / (double)w->total);
+    }
+}
+
+// ===== 运行 =====
+static int run_event(int (*event)(void)) {
+    uint32_t gc_before = st.gc_count;
+    int rc = event();
+    st.ops++;
+    if (rc != 0) {
+        st.errors++;
+    }
+    if (st.gc_count != gc_before && !model_tables_present()) {
+        st.data_lost = true;
+    }
+    return rc;
+}
+
+static uint32_t wear_max(void) {
+    const uint32_t *counts = flash_sim_mem_erase_counts();
+    uint32_t sectors = flash_sim_mem_sector_count();
+    uint32_t max = 0;
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (counts[s] > max) max = counts[s];
+    }
+    return max;
+}
+
+static void end_warmup(void) {
+    flash_sim_mem_reset_erase_counts();
+    st.device_us = 0;
+    st.ops = 0;
+    st.errors = 0;
+    st.gc_count = 0;
+    st.reboots = 0;
+    st.log_rotations = 0;
+}
+
+// 事件驱动推进模拟时间：每次取最早到期的事件执行
+static int run_simulation(void) {
+    enum { EV_COUNTER, EV_LOG, EV_CONFIG, EV_REBOOT, EV_TRACE, EV_COUNT };
+    double period[EV_COUNT] = { 0 };
+    double next[EV_COUNT];
+    double start = -cfg.warmup_days * ENDURANCE_SECONDS_PER_DAY;
+    double end = cfg.days * ENDURANCE_SECONDS_PER_DAY;
+    bool warm = (cfg.warmup_days <= 0.0);
+
+    if (cfg.trace_path) {
+        period[EV_TRACE] = cfg.trace_period * 3600.0;
+    } else {
+        period[EV_COUNTER] = cfg.counters ? cfg.counter_period : 0.0;
+        period[EV_LOG] = cfg.log_period;
+        period[EV_CONFIG] = cfg.configs_per_day > 0 ? ENDURANCE_SECONDS_PER_DAY / cfg.configs_per_day : 0.0;
+        period[EV_REBOOT] = cfg.reboots_per_day > 0 ? ENDURANCE_SECONDS_PER_DAY / cfg.reboots_per_day : 0.0;
+    }
+    for (int e = 0; e < EV_COUNT; e++) {
+        next[e] = start + period[e];
+    }
+    if (cfg.trace_path) {
+        next[EV_TRACE] = start;       // 录制负载从第一个周期开始
+    }
+
+    while (!st.data_lost) {
+        int ev = -1;
+        for (int e = 0; e < EV_COUNT; e++) {
+            if (period[e] > 0.0 && (ev < 0 || next[e] < next[ev])) {
+                ev = e;
+            }
+        }
+        if (ev < 0 || next[ev] >= end) {
+            break;
+        }
+        st.now = next[ev];
+        next[ev] += period[ev];
+        if (!warm && st.now >= 0.0) {
+            end_warmup();
+            warm = true;
+        }
+
+        uint64_t device_start = flash_timing_now_us();
+        int rc = 0;
+        switch (ev) {
+        case EV_COUNTER: rc = run_event(model_counter_event); break;
+        case EV_LOG:     rc = run_event(model_log_event); break;
+        case EV_CONFIG:  rc = run_event(model_config_event); break;
+        case EV_REBOOT:
+            st.reboots++;
+            rc = run_event(model_reboot);
+            break;
+        case EV_TRACE:
+            if (trace_run_period() != 0) {
+                return -1;
+            }
+            break;
+        }
+        if (ev == EV_REBOOT && rc != 0) {
+            printf("Remount failed at day %.2f\n", st.now / ENDURANCE_SECONDS_PER_DAY);
+            return -1;
+        }
+        if (warm) {
+            st.device_us += flash_timing_now_us() - device_start;
+            if (wear_max() >= cfg.endurance) {
+                st.worn_out = true;
+                break;
+            }
+        }
+    }
+    if (st.now < 0.0) {
+        st.now = 0.0;
+    }
+    if (!st.worn_out && !st.data_lost) {
+        st.now = end;
+    }
+    return 0;
+}
+
+// ===== 输出 =====
+static void print_report(const wear_summary_t *w, double wall_seconds) {
+    double first_years, ideal_years;
+    wear_project(w, &first_years, &ideal_years);
+    double mean = w->sectors ? (double)w->total / w->sectors : 0.0;
+    double sim_seconds = st.now;
+
+    printf("\nsimulated %.2f days in %.2f s wall (%.0fx real time)\n", sim_seconds / ENDURANCE_SECONDS_PER_DAY,
+           wall_seconds, wall_seconds > 0 ? sim_seconds / wall_seconds : 0.0);
+    printf("ops %llu, errors %u, gc %u, reboots %u, log rotations %u\n", (unsigned long long)st.ops, st.errors,
+           st.gc_count, st.reboots, st.log_rotations);
+    printf("device busy %.3f s (duty cycle %.5f%%)\n", st.device_us / 1e6,
+           sim_seconds > 0 ? st.device_us / (sim_seconds * 1e6) * 100.0 : 0.0);
+    printf("erases per sector: max %u, mean %.2f, min %u over %u sectors (wear ratio %.2f)\n", w->max, mean, w->min,
+           w->sectors, mean > 0 ? w->max / mean : 0.0);
+    printf("hottest sectors:");
+    for (int i = 0; i < w->hottest_count; i++) {
+        printf(" #%u=%u", w->hottest[i], flash_sim_mem_erase_count(w->hottest[i]));
+    }
+    printf("\n");
+
+    if (st.data_lost) {
+        printf("GC dropped all data at day %.2f (no spare sector), projection not available\n",
+               sim_seconds / ENDURANCE_SECONDS_PER_DAY);
+    } else if (st.worn_out) {
+        printf("first sector reached %u erases after %.2f days (%.3f years)\n", cfg.endurance,
+               sim_seconds / ENDURANCE_SECONDS_PER_DAY, seconds_to_years(sim_seconds));
+    } else if (w->max == 0) {
+        printf("no erases in the window, lifetime not limited by this workload\n");
+    } else {
+        printf("projected first sector worn out (%u cycles): %.2f years (ideal wear leveling %.2f years)\n",
+               cfg.endurance, first_years, ideal_years);
+    }
+}
+
+static void write_json(FILE *out, const wear_summary_t *w, double wall_seconds) {
+    double first_years, ideal_years;
+    wear_project(w, &first_years, &ideal_years);
+    double mean = w->sectors ? (double)w->total / w->sectors : 0.0;
+
+    fprintf(out, "{\"schema\":%d,\"workload\":\"%s\",\"config\":{\"capacity\":%u,\"endurance\":%u,\"days\":%.3f,"
+                 "\"warmup_days\":%.3f,\"reboots_per_day\":%.3f,\"seed\":%u,\"profile\":\"%s\"},\n",
+            ENDURANCE_SCHEMA_VERSION, cfg.trace_path ? cfg.trace_path : "model", flash_sim_mem_size(), cfg.endurance,
+            cfg.days, cfg.warmup_days, cfg.reboots_per_day, cfg.seed, cfg.profile->name);
+    fprintf(out, "\"simulated_days\":%.3f,\"wall_seconds\":%.3f,\"ops\":%llu,\"errors\":%u,\"gc_count\":%u,"
+                 "\"device_us\":%llu,\"data_lost\":%s,\"worn_out\":%s,\n",
+            st.now / ENDURANCE_SECONDS_PER_DAY, wall_seconds, (unsigned long long)st.ops, st.errors, st.gc_count,
+            (unsigned long long)st.device_us, st.data_lost ? "true" : "false", st.worn_out ? "true" : "false");
+    fprintf(out, "\"erase_total\":%llu,\"erase_max\":%u,\"erase_mean\":%.3f,\"erase_min\":%u,\"wear_ratio\":%.3f,"
+                 "\"projected_years\":%.3f,\"ideal_years\":%.3f,\n\"sector_erases\":[",
+            (unsigned long long)w->total, w->max, mean, w->min, mean > 0 ? w->max / mean : 0.0,
+            st.data_lost ? 0.0 : first_years, ideal_years);
+    for (uint32_t s = 0; s < w->sectors; s++) {
+        fprintf(out, "%s%u", s ? "," : "", flash_sim_mem_erase_count(s));
+    }
+    fprintf(out, "]}\n");
+}
+
+// ===== 命令行 =====
+static void usage(void) {
+    printf("usage: fast_flash_endurance [options]\n"
+           "  --days N             observation window in simulated days (default 30)\n"
+           "  --warmup-days N      simulated days excluded from wear statistics (default 1)\n"
+           "  --endurance N        erase cycles per sector (default 100000)\n"
+           "  --reboots-per-day N  remounts per day for the model workload (default 1)\n"
+           "  --capacity KB        simulated flash size for the model workload (default 128)\n"
+           "  --counters N         hot counters (default 8)\n"
+           "  --counter-size N     counter record size in bytes (default 16)\n"
+           "  --counter-period S   seconds between counter updates (default 60)\n"
+           "  --log-size N         log record size in bytes (default 32)\n"
+           "  --log-records N      log capacity before rotation (default 100)\n"
+           "  --log-period S       seconds between log appends (default 300)\n"
+           "  --config-size N      config blob size in bytes (default 256)\n"
+           "  --configs-per-day N  config rewrites per day (default 4)\n"
+           "  --trace FILE         use a recorded workload instead of the model\n"
+           "  --trace-period H     simulated hours covered by one pass of the trace (default 24)\n"
+           "  --seed N             RNG seed for workload and device timing\n"
+           "  --profile NAME       winbond | gigadevice | ideal\n"
+           "  --json FILE          write results as JSON (- for stdout)\n");
+}
+
+static int parse_args(int argc, char **argv) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.capacity = 128 * 1024;
+    cfg.endurance = 100000;
+    cfg.days = 30;
+    cfg.warmup_days = 1;
+    cfg.reboots_per_day = 1;
+    cfg.counters = 8;
+    cfg.counter_size = 16;
+    cfg.counter_period = 60;
+    cfg.log_size = 32;
+    cfg.log_records = 100;
+    cfg.log_period = 300;
+    cfg.config_size = 256;
+    cfg.configs_per_day = 4;
+    cfg.trace_period = 24;
+    cfg.seed = FLASH_TIMING_DEFAULT_SEED;
+    cfg.profile = &flash_timing_winbond_w25q;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0 || !value) {
+            usage();
+            return -1;
+        }
+        i++;
+        if (strcmp(arg, "--days") == 0) cfg.days = strtod(value, NULL);
+        else if (strcmp(arg, "--warmup-days") == 0) cfg.warmup_days = strtod(value, NULL);
+        else if (strcmp(arg, "--endurance") == 0) cfg.endurance = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--reboots-per-day") == 0) cfg.reboots_per_day = strtod(value, NULL);
+        else if (strcmp(arg, "--capacity") == 0) cfg.capacity = (uint32_t)strtoul(value, NULL, 0) * 1024;
+        else if (strcmp(arg, "--counters") == 0) cfg.counters = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--counter-size") == 0) cfg.counter_size = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--counter-period") == 0) cfg.counter_period = strtod(value, NULL);
+        else if (strcmp(arg, "--log-size") == 0) cfg.log_size = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--log-records") == 0) cfg.log_records = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--log-period") == 0) cfg.log_period = strtod(value, NULL);
+        else if (strcmp(arg, "--config-size") == 0) cfg.config_size = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--configs-per-day") == 0) cfg.configs_per_day = strtod(value, NULL);
+        else if (strcmp(arg, "--trace") == 0) cfg.trace_path = value;
+        else if (strcmp(arg, "--trace-period") == 0) cfg.trace_period = strtod(value, NULL);
+        else if (strcmp(arg, "--seed") == 0) cfg.seed = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--json") == 0) cfg.json_path = value;
+        else if (strcmp(arg, "--profile") == 0) {
+            if (strcmp(value, "winbond") == 0) cfg.profile = &flash_timing_winbond_w25q;
+            else if (strcmp(value, "gigadevice") == 0) cfg.profile = &flash_timing_gigadevice_gd25q;
+            else if (strcmp(value, "ideal") == 0) cfg.profile = &flash_timing_ideal;
+            else {
+                printf("Unknown timing profile '%s'\n", value);
+                return -1;
+            }
+        } else {
+            usage();
+            return -1;
+        }
+    }
+
+    uint32_t max_record = ENDURANCE_SECTOR_SIZE - (uint32_t)sizeof(table_header_t);
+    if (cfg.days <= 0 || cfg.warmup_days < 0 || cfg.endurance == 0 || cfg.reboots_per_day < 0 ||
+        (cfg.trace_path && cfg.trace_period <= 0)) {
+        printf("Invalid endurance configuration\n");
+        return -1;
+    }
+    if (!cfg.trace_path &&
+        (cfg.capacity < 4 * ENDURANCE_SECTOR_SIZE || cfg.capacity % ENDURANCE_SECTOR_SIZE != 0 ||
+         cfg.counters > sizeof(counter_values) / sizeof(counter_values[0]) ||
+         cfg.counter_size < sizeof(uint32_t) || cfg.counters * cfg.counter_size > max_record ||
+         cfg.log_size == 0 || cfg.log_records == 0 || cfg.log_size * cfg.log_records > max_record ||
+         cfg.config_size == 0 || cfg.config_size > max_record ||
+         cfg.counter_period <= 0 || cfg.log_period <= 0 || cfg.configs_per_day < 0)) {
+        printf("Invalid workload model (each table must fit in one %u-byte sector)\n", ENDURANCE_SECTOR_SIZE);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) != 0) {
+        return -1;
+    }
+
+    flash_timing_set_profile(cfg.profile);
+    flash_timing_reset_clock();
+    flash_timing_seed(cfg.seed);
+    rng_state = cfg.seed ? cfg.seed : 1;
+
+    if (cfg.trace_path) {
+        trace = flash_sim_replay_load(cfg.trace_path, &trace_size);
+        trace_start = trace ? fast_flash_record_check_header(trace, trace_size) : -1;
+        if (trace_start < 0) {
+            printf("Failed to read trace '%s'\n", cfg.trace_path);
+            free(trace);
+            return -1;
+        }
+        printf("Fast Flash Endurance (trace %s every %.1f h, %u cycles, profile %s)\n", cfg.trace_path,
+               cfg.trace_period, cfg.endurance, cfg.profile->name);
+    } else {
+        if (flash_sim_mem_create(cfg.capacity, ENDURANCE_SECTOR_SIZE) != 0) {
+            printf("Failed to allocate %u KB simulated flash\n", cfg.capacity / 1024);
+            return -1;
+        }
+        if (model_format() != 0) {
+            printf("Failed to create the model tables\n");
+            flash_sim_mem_destroy();
+            return -1;
+        }
+        printf("Fast Flash Endurance (%u KB, %u counters/%.0f s, log %u B/%.0f s, %.1f configs/day, %u cycles, profile %s)\n",
+               cfg.capacity / 1024, cfg.counters, cfg.counter_period, cfg.log_size, cfg.log_period,
+               cfg.configs_per_day, cfg.endurance, cfg.profile->name);
+    }
+    if (cfg.warmup_days <= 0) {
+        end_warmup();
+    }
+
+    clock_t wall_start = clock();
+    int rc = run_simulation();
+    double wall_seconds = (double)(clock() - wall_start) / CLOCKS_PER_SEC;
+
+    if (rc == 0) {
+        wear_summary_t w;
+        wear_summarize(&w);
+        print_report(&w, wall_seconds);
+
+        if (cfg.json_path) {
+            FILE *out = strcmp(cfg.json_path, "-") == 0 ? stdout : fopen(cfg.json_path, "w");
+            if (!out) {
+                printf("Failed to open %s\n", cfg.json_path);
+                rc = -1;
+            } else {
+                write_json(out, &w, wall_seconds);
+                if (out != stdout) {
+                    fclose(out);
+                }
+            }
+        }
+        if (st.data_lost) {
+            rc = -1;
+        }
+    }
+
+    flash_sim_replay_release();
+    free(trace);
+    flash_sim_mem_destroy();
+    return rc;
+}
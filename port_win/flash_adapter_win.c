@@ -1,74 +1,25 @@
 #include "flash_adapter_win.h"
 #include "../core/fast_flash_log.h"
+#include "../core/fast_flash_trace.h"
+#include "../port_common/flash_sim_timing.h"
+#include "../port_common/flash_sim_latency.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
-#include <windows.h>
 
 static FILE *flash_file = NULL;
-static uint8_t flash_cache[WIN_FLASH_TOTAL_SIZE] = {0};  // 内存缓存，模拟Flash
-static bool cache_dirty = false;
+static uint8_t flash_cache[WIN_FLASH_TOTAL_SIZE] = {0};  // 内存缓存，模拟Flash（以缓存为准）
+
+// 脏页位图：写入/擦除只标记修改过的页，win_flash_sync时只回写这些页
+#define WIN_FLASH_PAGE_COUNT   (WIN_FLASH_TOTAL_SIZE / WIN_FLASH_SYNC_PAGE_SIZE)
+static uint32_t dirty_pages[(WIN_FLASH_PAGE_COUNT + 31) / 32] = {0};
 
 // 性能统计
 static win_flash_perf_stats_t perf_stats = {0};
 
-// Winbond Flash模拟参数（单位：毫秒）
-#define WINBOND_WRITE_MIN_MS      0.7f
-#define WINBOND_WRITE_MAX_MS      3.0f
-#define WINBOND_ERASE_4K_MIN_MS   45.0f
-#define WINBOND_ERASE_4K_MAX_MS   400.0f
-#define WINBOND_ERASE_32K_MIN_MS  120.0f
-#define WINBOND_ERASE_32K_MAX_MS  1600.0f
-#define WINBOND_ERASE_64K_MIN_MS  150.0f
-#define WINBOND_ERASE_64K_MAX_MS  2000.0f
-#define READ_TIME_PER_BYTE_US     0.05f  // 每字节读取时间（微秒）
-
-// 生成随机数在指定范围内的函数
-static float random_range(float min_val, float max_val) {
-    return min_val + ((float)rand() / RAND_MAX) * (max_val - min_val);
-}
-
-// 获取当前时间（毫秒）
+// 获取当前时间（毫秒），返回模拟器的虚拟时钟（器件时间）
 uint32_t get_time_ms(void) {
-    return GetTickCount64();
-}
-
-// 获取当前时间（微秒）
-static uint64_t get_time_us(void) {
-    LARGE_INTEGER frequency, counter;
-    QueryPerformanceFrequency(&frequency);
-    QueryPerformanceCounter(&counter);
-    return (counter.QuadPart * 1000000) / frequency.QuadPart;
-}
-
-// 模拟延时（毫秒）
-static void sleep_ms(uint32_t ms) {
-    Sleep(ms);
-}
-
-// 模拟延时（微秒）
-static void sleep_us(uint64_t us) {
-    if (us >= 1000) {
-        Sleep(us / 1000);
-    } else {
-        // 对于小于1ms的延时，使用忙等待
-        uint64_t start = get_time_us();
-        while (get_time_us() - start < us) {
-            // 忙等待
-        }
-    }
-}
-
-// 计算擦除时间
-static float calculate_erase_time(uint32_t size) {
-    if (size <= 4 * 1024) {
-        return random_range(WINBOND_ERASE_4K_MIN_MS, WINBOND_ERASE_4K_MAX_MS);
-    } else if (size <= 32 * 1024) {
-        return random_range(WINBOND_ERASE_32K_MIN_MS, WINBOND_ERASE_32K_MAX_MS);
-    } else {
-        return random_range(WINBOND_ERASE_64K_MIN_MS, WINBOND_ERASE_64K_MAX_MS);
-    }
+    return (uint32_t)(flash_timing_now_us() / 1000);
 }
 
 // 加载Flash文件到缓存
@@ -85,29 +36,69 @@ static int load_flash_to_cache(void) {
         memset(&flash_cache[read_size], 0xFF, WIN_FLASH_TOTAL_SIZE - read_size);
     }
     
-    cache_dirty = false;
+    memset(dirty_pages, 0, sizeof(dirty_pages));
     return 0;
 }
 
-// 保存缓存到Flash文件
-static int save_cache_to_flash(void) {
-    if (!flash_file || !cache_dirty) {
-        return 0;
+// 标记[addr, addr+size)所在的页需要回写
+static void mark_dirty(uint32_t addr, uint32_t size) {
+    if (size == 0) {
+        return;
     }
-    
-    fseek(flash_file, 0, SEEK_SET);
-    size_t written = fwrite(flash_cache, 1, WIN_FLASH_TOTAL_SIZE, flash_file);
-    fflush(flash_file);
-    
-    if (written == WIN_FLASH_TOTAL_SIZE) {
-        cache_dirty = false;
-        return 0;
+    uint32_t first = addr / WIN_FLASH_SYNC_PAGE_SIZE;
+    uint32_t last = (addr + size - 1) / WIN_FLASH_SYNC_PAGE_SIZE;
+    for (uint32_t page = first; page <= last; page++) {
+        dirty_pages[page / 32] |= 1u << (page % 32);
     }
-    return -1;
+}
+
+static bool page_dirty(uint32_t page) {
+    return (dirty_pages[page / 32] & (1u << (page % 32))) != 0;
+}
+
+// 持久化屏障：把连续的脏页合并后写回文件
+int win_flash_sync(void) {
+    if (!flash_file) {
+        return -1;
+    }
+
+    uint32_t page = 0;
+    bool written = false;
+    while (page < WIN_FLASH_PAGE_COUNT) {
+        if (!page_dirty(page)) {
+            page++;
+            continue;
+        }
+        uint32_t run_end = page + 1;
+        while (run_end < WIN_FLASH_PAGE_COUNT && page_dirty(run_end)) {
+            run_end++;
+        }
+
+        uint32_t offset = page * WIN_FLASH_SYNC_PAGE_SIZE;
+        uint32_t length = (run_end - page) * WIN_FLASH_SYNC_PAGE_SIZE;
+        if (fseek(flash_file, (long)offset, SEEK_SET) != 0 ||
+            fwrite(&flash_cache[offset], 1, length, flash_file) != length) {
+            printf("Failed to write back flash range 0x%08X, size=%u\n", offset, length);
+            return -1;
+        }
+        perf_stats.bytes_synced += length;
+        written = true;
+        page = run_end;
+    }
+
+    if (written) {
+        if (fflush(flash_file) != 0) {
+            return -1;
+        }
+        memset(dirty_pages, 0, sizeof(dirty_pages));
+        perf_stats.sync_operations++;
+    }
+    return 0;
 }
 
 void win_flash_reset_perf_stats(void) {
     memset(&perf_stats, 0, sizeof(perf_stats));
+    flash_latency_reset();
 }
 
 void win_flash_get_perf_stats(win_flash_perf_stats_t *stats) {
@@ -117,28 +108,50 @@ void win_flash_get_perf_stats(win_flash_perf_stats_t *stats) {
 }
 
 void win_flash_print_perf_stats(void) {
-    printf("\n=== Flash Performance Statistics ===\n");
-    printf("Write Operations: %u (Total: %u ms, Avg: %.2f ms)\n", 
-           perf_stats.write_operations, perf_stats.total_write_time_ms,
-           perf_stats.write_operations > 0 ? (float)perf_stats.total_write_time_ms / perf_stats.write_operations : 0.0f);
-    printf("Erase Operations: %u (Total: %u ms, Avg: %.2f ms)\n", 
-           perf_stats.erase_operations, perf_stats.total_erase_time_ms,
-           perf_stats.erase_operations > 0 ? (float)perf_stats.total_erase_time_ms / perf_stats.erase_operations : 0.0f);
-    printf("Read Operations: %u (Total: %u ms, Avg: %.2f ms)\n", 
-           perf_stats.read_operations, perf_stats.total_read_time_ms,
-           perf_stats.read_operations > 0 ? (float)perf_stats.total_read_time_ms / perf_stats.read_operations : 0.0f);
+    uint64_t total_us = perf_stats.total_write_time_us + perf_stats.total_erase_time_us + perf_stats.total_read_time_us;
+
+    printf("\n=== Flash Performance Statistics (%s, simulated) ===\n", flash_timing_get_profile()->name);
+    printf("Write Operations: %u (Total: %.1f ms, Avg: %.2f ms)\n", 
+           perf_stats.write_operations, perf_stats.total_write_time_us / 1000.0,
+           perf_stats.write_operations > 0 ? perf_stats.total_write_time_us / 1000.0 / perf_stats.write_operations : 0.0);
+    printf("Erase Operations: %u (Total: %.1f ms, Avg: %.2f ms)\n", 
+           perf_stats.erase_operations, perf_stats.total_erase_time_us / 1000.0,
+           perf_stats.erase_operations > 0 ? perf_stats.total_erase_time_us / 1000.0 / perf_stats.erase_operations : 0.0);
+    printf("Read Operations: %u (Total: %.1f ms, Avg: %.2f ms)\n", 
+           perf_stats.read_operations, perf_stats.total_read_time_us / 1000.0,
+           perf_stats.read_operations > 0 ? perf_stats.total_read_time_us / 1000.0 / perf_stats.read_operations : 0.0);
     printf("Bytes Written: %u (%.2f KB)\n", perf_stats.bytes_written, perf_stats.bytes_written / 1024.0f);
     printf("Bytes Erased: %u (%.2f KB)\n", perf_stats.bytes_erased, perf_stats.bytes_erased / 1024.0f);
     printf("Bytes Read: %u (%.2f KB)\n", perf_stats.bytes_read, perf_stats.bytes_read / 1024.0f);
-    printf("Total Time: %u ms (%.2f seconds)\n", 
-           perf_stats.total_write_time_ms + perf_stats.total_erase_time_ms + perf_stats.total_read_time_ms,
-           (perf_stats.total_write_time_ms + perf_stats.total_erase_time_ms + perf_stats.total_read_time_ms) / 1000.0f);
+    printf("Sync Operations: %u (%.2f KB written back)\n", perf_stats.sync_operations, perf_stats.bytes_synced / 1024.0f);
+    printf("Total Device Time: %.1f ms (%.2f seconds)\n", total_us / 1000.0, total_us / 1000000.0);
+    printf("Total Device Energy: %.1f mJ\n", perf_stats.total_energy_nj / 1000000.0);
+    flash_latency_print();
     printf("===================================\n\n");
 }
 
+void win_flash_write_perf_stats_json(FILE *out) {
+    fprintf(out, "{\"profile\":\"%s\",\"write_operations\":%u,\"erase_operations\":%u,\"read_operations\":%u,"
+                 "\"bytes_written\":%u,\"bytes_erased\":%u,\"bytes_read\":%u,"
+                 "\"sync_operations\":%u,\"bytes_synced\":%u,"
+                 "\"write_time_us\":%llu,\"erase_time_us\":%llu,\"read_time_us\":%llu,\"energy_nj\":%llu,\"latency\":",
+            flash_timing_get_profile()->name,
+            perf_stats.write_operations, perf_stats.erase_operations, perf_stats.read_operations,
+            perf_stats.bytes_written, perf_stats.bytes_erased, perf_stats.bytes_read,
+            perf_stats.sync_operations, perf_stats.bytes_synced,
+            (unsigned long long)perf_stats.total_write_time_us,
+            (unsigned long long)perf_stats.total_erase_time_us,
+            (unsigned long long)perf_stats.total_read_time_us,
+            (unsigned long long)perf_stats.total_energy_nj);
+    flash_latency_write_json(out);
+    fprintf(out, "}\n");
+}
+
 int win_flash_init(void) {
-    // 初始化随机数种子
-    srand((unsigned int)time(NULL));
+    // 重复初始化时保持现有缓存（缓存中可能有尚未回写的修改）
+    if (flash_file) {
+        return 0;
+    }
     
     // 尝试打开现有文件，如果不存在则创建
     flash_file = fopen(WIN_FLASH_FILE_NAME, "rb+");
@@ -166,11 +179,12 @@ int win_flash_init(void) {
     }
     
     printf("Windows Flash Adapter initialized, file: %s\n", WIN_FLASH_FILE_NAME);
-    printf("Flash simulation with performance timing enabled\n");
-    printf("Write latency: %.1f-%.1f ms (Winbond spec)\n", WINBOND_WRITE_MIN_MS, WINBOND_WRITE_MAX_MS);
-    printf("Erase 4KB: %.0f-%.0f ms\n", WINBOND_ERASE_4K_MIN_MS, WINBOND_ERASE_4K_MAX_MS);
-    printf("Erase 32KB: %.0f-%.0f ms\n", WINBOND_ERASE_32K_MIN_MS, WINBOND_ERASE_32K_MAX_MS);
-    printf("Erase 64KB: %.0f-%.0f ms\n", WINBOND_ERASE_64K_MIN_MS, WINBOND_ERASE_64K_MAX_MS);
+    const flash_timing_profile_t *profile = flash_timing_get_profile();
+    printf("Flash simulation with virtual timing (profile: %s)\n", profile->name);
+    printf("Write latency: %.1f-%.1f ms\n", profile->write_min_us / 1000.0, profile->write_max_us / 1000.0);
+    printf("Erase 4KB: %.0f-%.0f ms\n", profile->erase_4k_min_us / 1000.0, profile->erase_4k_max_us / 1000.0);
+    printf("Erase 32KB: %.0f-%.0f ms\n", profile->erase_32k_min_us / 1000.0, profile->erase_32k_max_us / 1000.0);
+    printf("Erase 64KB: %.0f-%.0f ms\n", profile->erase_64k_min_us / 1000.0, profile->erase_64k_max_us / 1000.0);
     printf("\n");
     
     // 重置性能统计
@@ -189,25 +203,20 @@ int win_flash_read(uint32_t addr, uint8_t *buf, uint32_t size) {
         return -1;
     }
     
-    // 确保缓存是最新的
-    if (cache_dirty) {
-        save_cache_to_flash();
-        load_flash_to_cache();
-    }
-    
-    // 模拟读取时间
-    uint64_t start_time = get_time_us();
     memcpy(buf, &flash_cache[addr], size);
-    uint64_t read_time_us = (uint64_t)(size * READ_TIME_PER_BYTE_US);
-    sleep_us(read_time_us);
-    uint64_t end_time = get_time_us();
+    // 模拟读取时间（推进虚拟时钟，不实际等待）
+    uint32_t read_time_us = flash_timing_read(size);
+    flash_latency_record(FLASH_LAT_READ, size, read_time_us);
+    FF_TRACE_DEVICE("read", read_time_us, addr, size);
+    uint32_t read_energy_nj = flash_timing_read_energy(size, read_time_us);
+    perf_stats.total_energy_nj += read_energy_nj;
     
     // 更新统计
     perf_stats.read_operations++;
     perf_stats.bytes_read += size;
-    perf_stats.total_read_time_ms += (uint32_t)((end_time - start_time) / 1000);
+    perf_stats.total_read_time_us += read_time_us;
     
-    TRACE_DEBUG("Flash read: addr=0x%08X, size=%u, time=%llu us\n", addr, size, end_time - start_time);
+    TRACE_DEBUG("Flash read: addr=0x%08X, size=%u, time=%u us\n", addr, size, read_time_us);
     
     return 0;
 }
@@ -222,38 +231,29 @@ int win_flash_write(uint32_t addr, const uint8_t *buf, uint32_t size) {
         return -1;
     }
     
-    // 模拟写入时间（每个写操作都有随机延迟）
-    uint32_t start_time = get_time_ms();
-    float write_delay_ms = random_range(WINBOND_WRITE_MIN_MS, WINBOND_WRITE_MAX_MS);
-    sleep_ms((uint32_t)write_delay_ms);
-    
-    // 模拟NOR Flash特性：只能将1写成0，不能将0写成1
+    // 模拟NOR Flash特性：只能将1写成0，不能将0写成1（先检查，失败时不改变内容）
     for (uint32_t i = 0; i < size; i++) {
-        uint8_t old_val = flash_cache[addr + i];
-        uint8_t new_val = buf[i];
-        
-        // 如果需要将0改成1，这是不允许的
-        if ((old_val & new_val) != new_val) {
+        if ((flash_cache[addr + i] & buf[i]) != buf[i]) {
             printf("Flash write error: cannot change 0 to 1 at addr=0x%08X\n", addr + i);
             return -1;
         }
-        
-        flash_cache[addr + i] = new_val;
     }
+    memcpy(&flash_cache[addr], buf, size);
+    mark_dirty(addr, size);
     
-    cache_dirty = true;
-    save_cache_to_flash();
-    load_flash_to_cache();
-    
-    uint32_t end_time = get_time_ms();
+    // 模拟写入时间（每个写操作都有随机延迟，推进虚拟时钟）
+    uint32_t write_time_us = flash_timing_write(size);
+    flash_latency_record(FLASH_LAT_WRITE, size, write_time_us);
+    FF_TRACE_DEVICE("write", write_time_us, addr, size);
+    uint32_t write_energy_nj = flash_timing_write_energy(size, write_time_us);
+    perf_stats.total_energy_nj += write_energy_nj;
     
     // 更新统计
     perf_stats.write_operations++;
     perf_stats.bytes_written += size;
-    perf_stats.total_write_time_ms += (end_time - start_time);
+    perf_stats.total_write_time_us += write_time_us;
     
-    printf("Flash write: addr=0x%08X, size=%u, time=%u ms (simulated %.1f ms)\n", 
-           addr, size, end_time - start_time, write_delay_ms);
+    TRACE_DEBUG("Flash write: addr=0x%08X, size=%u, simulated %u us\n", addr, size, write_time_us);
     
     return 0;
 }
@@ -277,24 +277,23 @@ int win_flash_erase(uint32_t addr, uint32_t size) {
         return -1;
     }
     
-    // 模拟擦除时间
-    uint32_t start_time = get_time_ms();
-    float erase_delay_ms = calculate_erase_time(aligned_size);
-    sleep_ms((uint32_t)erase_delay_ms);
-    
     // 擦除：设置为全0xFF
     memset(&flash_cache[aligned_addr], 0xFF, aligned_size);
-    cache_dirty = true;
+    mark_dirty(aligned_addr, aligned_size);
     
-    uint32_t end_time = get_time_ms();
+    // 模拟擦除时间（按擦除粒度取值，推进虚拟时钟）
+    uint32_t erase_time_us = flash_timing_erase(aligned_size);
+    flash_latency_record(FLASH_LAT_ERASE, aligned_size, erase_time_us);
+    FF_TRACE_DEVICE("erase", erase_time_us, aligned_addr, aligned_size);
+    uint32_t erase_energy_nj = flash_timing_erase_energy(aligned_size, erase_time_us);
+    perf_stats.total_energy_nj += erase_energy_nj;
     
     // 更新统计
     perf_stats.erase_operations++;
     perf_stats.bytes_erased += aligned_size;
-    perf_stats.total_erase_time_ms += (end_time - start_time);
+    perf_stats.total_erase_time_us += erase_time_us;
     
-    printf("Flash erase: addr=0x%08X, size=%u, time=%u ms (simulated %.1f ms)\n", 
-           aligned_addr, aligned_size, end_time - start_time, erase_delay_ms);
+    TRACE_DEBUG("Flash erase: addr=0x%08X, size=%u, simulated %u us\n", aligned_addr, aligned_size, erase_time_us);
     
     return 0;
 }
@@ -307,15 +306,13 @@ int win_flash_reset(void) {
         }
     }
     
-    uint32_t start_time = get_time_ms();
-    
     memset(flash_cache, 0xFF, WIN_FLASH_TOTAL_SIZE);
-    cache_dirty = true;
-    save_cache_to_flash();
-    
-    uint32_t end_time = get_time_ms();
+    mark_dirty(0, WIN_FLASH_TOTAL_SIZE);
+    if (win_flash_sync() != 0) {
+        return -1;
+    }
     
-    printf("Flash reset completed in %u ms\n", end_time - start_time);
+    printf("Flash reset completed\n");
     return 0;
 }
 
@@ -341,10 +338,10 @@ int win_flash_dump(uint32_t addr, uint32_t size) {
     return 0;
 }
 
-// 在程序退出时自动保存
+// 在程序退出时回写剩余的脏页
 static void cleanup_flash(void) {
     if (flash_file) {
-        save_cache_to_flash();
+        win_flash_sync();
         fclose(flash_file);
         flash_file = NULL;
         
@@ -358,10 +355,17 @@ static void __attribute__((constructor)) register_cleanup(void) {
     atexit(cleanup_flash);
 }
 
+// 擦除粒度，与上面的Winbond擦除时间参数对应
+const flash_geometry_t win_flash_geometry = {
+    .erase_sizes = { 4 * 1024, 32 * 1024, 64 * 1024, 0 }
+};
+
 // Flash操作接口
 const flash_ops_t win_flash_ops = {
     .init  = win_flash_init,
     .read  = win_flash_read,
     .write = win_flash_write,
-    .erase = win_flash_erase
+    .erase = win_flash_erase,
+    .sync  = win_flash_sync,
+    .energy = flash_timing_energy_nj
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "../core/fast_flash_types.h"
 #include <stdint.h>
+#include <stdio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,39 +11,48 @@ extern "C" {
 
 // Windows平台Flash适配器接口
 extern const flash_ops_t win_flash_ops;
+// 模拟器支持的擦除粒度（4KB扇区 / 32KB块 / 64KB块）
+extern const flash_geometry_t win_flash_geometry;
 
 // Windows平台特定配置
 #define WIN_FLASH_FILE_NAME    "flash_simulation.bin"
 #define WIN_FLASH_TOTAL_SIZE   (64 * 1024)    // 64KB模拟Flash
 #define WIN_FLASH_SECTOR_COUNT (WIN_FLASH_TOTAL_SIZE / FLASH_SECTOR_SIZE)
+#define WIN_FLASH_SYNC_PAGE_SIZE 256           // 脏页跟踪和回写的粒度
 
 // Windows平台特定函数
 int win_flash_init(void);
 int win_flash_read(uint32_t addr, uint8_t *buf, uint32_t size);
 int win_flash_write(uint32_t addr, const uint8_t *buf, uint32_t size);
 int win_flash_erase(uint32_t addr, uint32_t size);
+int win_flash_sync(void);               // 持久化屏障：把修改过的页写回镜像文件
 
 // 用于测试的辅助函数
 int win_flash_reset(void);              // 重置整个Flash区域
 int win_flash_dump(uint32_t addr, uint32_t size); // 调试输出Flash内容
-uint32_t get_time_ms(void);
-// 性能统计结构
+uint32_t get_time_ms(void);             // 模拟器虚拟时钟（毫秒），见port_common/flash_sim_timing.h
+// 性能统计结构（时间为时序模型计算的器件时间）
 typedef struct {
-    uint32_t total_write_time_ms;      // 总写入时间（毫秒）
-    uint32_t total_erase_time_ms;       // 总擦除时间（毫秒）
-    uint32_t total_read_time_ms;       // 总读取时间（毫秒）
+    uint64_t total_write_time_us;      // 总写入时间（微秒）
+    uint64_t total_erase_time_us;      // 总擦除时间（微秒）
+    uint64_t total_read_time_us;       // 总读取时间（微秒）
+    uint64_t total_energy_nj;          // 器件能耗（纳焦，能耗模型计算）
     uint32_t write_operations;          // 写入操作次数
     uint32_t erase_operations;         // 擦除操作次数
     uint32_t read_operations;          // 读取操作次数
     uint32_t bytes_written;            // 写入字节数
     uint32_t bytes_erased;             // 擦除字节数
     uint32_t bytes_read;               // 读取字节数
+    uint32_t sync_operations;          // 回写镜像文件的次数
+    uint32_t bytes_synced;             // 回写镜像文件的字节数
 } win_flash_perf_stats_t;
 
 // 性能统计函数
 void win_flash_reset_perf_stats(void);
 void win_flash_get_perf_stats(win_flash_perf_stats_t *stats);
 void win_flash_print_perf_stats(void);
+void win_flash_write_perf_stats_json(FILE *out);   // 统计和延迟直方图（p50/p90/p99/max）输出为一行JSON
+// 按操作类型/大小查询延迟分布见port_common/flash_sim_latency.h
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,617 @@
+#include "../core/fast_flash_core.h"
+#include "../port_common/flash_sim_timing.h"
+#include "../port_common/flash_sim_mem.h"
+#include "../port_common/flash_sim_fault.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 掉电测试：在内存模拟器件外包一层掉电注入（port_common/flash_sim_fault），按种子生成确定的操作序列
+// （建表、追加、按序号改写、批量写入、清除、删表、GC），在第N次编程/擦除时掉电，重新上电挂载后与参考模型比较：
+//   1. 挂载成功
+//   2. 数据库状态等于掉电那一步执行前或执行后的状态（每个API要么完整生效要么完全没有生效）
+//   3. 每张存在的表校验通过，没有模型之外的表
+//   4. 挂载后可以继续写入（再执行几步并重新比较）
+// 掉电点可以穷举（每一次编程/擦除 × 每种掉电方式）或随机抽样。
+
+#define POWERCUT_SCHEMA_VERSION  1
+#define POWERCUT_TABLES          3
+#define POWERCUT_MAX_TABLE_DATA  1024
+#define POWERCUT_AFTER_STEPS     4        // 重新挂载后继续执行的步数
+#define POWERCUT_MAX_REPORTED    20       // 打印的失败用例数上限
+
+// ===== 配置 =====
+typedef struct {
+    uint32_t capacity;
+    uint32_t steps;                       // 每个用例的操作序列长度
+    uint32_t seed;                        // 操作序列
+    uint32_t random_cases;                // 0表示穷举
+    uint32_t first_cut;                   // 穷举范围（从1开始，0表示不限）
+    uint32_t last_cut;
+    int      mode;                        // -1表示全部掉电方式
+    uint32_t max_failed;                  // 允许的失败用例数（已知问题）
+    bool     verbose;
+    const char *json_path;                // "-"表示标准输出
+} powercut_config_t;
+
+static powercut_config_t cfg;
+static flash_geometry_t geometry;
+
+// ===== 参考模型 =====
+typedef struct {
+    const char *name;
+    uint32_t struct_size;
+    uint32_t max_structs;
+    uint8_t  flags;
+    bool     exists;
+    uint32_t count;
+    uint8_t  data[POWERCUT_MAX_TABLE_DATA];
+} model_table_t;
+
+typedef struct {
+    model_table_t t[POWERCUT_TABLES];
+} model_t;
+
+static const model_table_t table_defs[POWERCUT_TABLES] = {
+    { "CNT", 16, 16, FF_TABLE_HOT,         false, 0, { 0 } },
+    { "CFG", 64,  4, FF_TABLE_COLD,        false, 0, { 0 } },
+    { "LOG", 24, 32, FF_TABLE_APPEND_ONLY, false, 0, { 0 } },
+};
+
+enum { T_CNT, T_CFG, T_LOG };
+
+typedef enum {
+    STEP_CREATE = 0,
+    STEP_DELETE,
+    STEP_APPEND,
+    STEP_UPDATE,
+    STEP_BATCH,
+    STEP_CLEAR,
+    STEP_GC,
+    STEP_KIND_COUNT
+} step_kind_t;
+
+static const char *step_names[STEP_KIND_COUNT] = { "create", "delete", "append", "update", "batch", "clear", "gc" };
+
+typedef struct {
+    step_kind_t kind;
+    int      table;
+    uint32_t index;                       // update：序号；batch：条数
+    uint64_t mask;                        // clear
+    uint8_t  data[POWERCUT_MAX_TABLE_DATA];
+} step_t;
+
+static uint32_t rng_state = 1;
+
+static uint32_t powercut_rand(void) {
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng_state = x;
+    return x;
+}
+
+static void model_reset(model_t *m) {
+    memcpy(m->t, table_defs, sizeof(m->t));
+}
+
+static void fill_data(uint8_t *data, uint32_t size) {
+    for (uint32_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)powercut_rand();
+    }
+}
+
+// 按当前模型状态生成下一步（只生成在模型中合法的操作）
+static void step_generate(const model_t *m, step_t *s) {
+    memset(s, 0, sizeof(*s));
+    for (int t = 0; t < POWERCUT_TABLES; t++) {
+        if (!m->t[t].exists) {
+            s->kind = STEP_CREATE;
+            s->table = t;
+            return;
+        }
+    }
+
+    const model_table_t *cnt = &m->t[T_CNT];
+    const model_table_t *cfg_table = &m->t[T_CFG];
+    const model_table_t *log = &m->t[T_LOG];
+    uint32_t r = powercut_rand() % 100;
+
+    if (r < 45) {
+        s->table = T_CNT;
+        if (cnt->count < cnt->max_structs && (cnt->count == 0 || r < 15)) {
+            s->kind = STEP_APPEND;
+        } else if (r < 38 || cnt->count == 0) {
+            s->kind = STEP_UPDATE;
+            s->index = powercut_rand() % cnt->count;
+        } else {
+            s->kind = STEP_CLEAR;
+            s->mask = 1ULL << (powercut_rand() % cnt->count);
+        }
+    } else if (r < 65) {
+        s->table = T_LOG;
+        s->kind = (log->count < log->max_structs) ? STEP_APPEND : STEP_DELETE;
+    } else if (r < 85) {
+        s->table = T_CFG;
+        if (cfg_table->count < cfg_table->max_structs) {
+            s->kind = STEP_BATCH;
+            s->index = 1 + powercut_rand() % (cfg_table->max_structs - cfg_table->count);
+        } else if (r < 80) {
+            s->kind = STEP_UPDATE;
+            s->index = powercut_rand() % cfg_table->count;
+        } else {
+            s->kind = STEP_CLEAR;
+            s->mask = 0x3;
+        }
+    } else if (r < 93) {
+        s->kind = STEP_GC;
+        s->table = -1;
+    } else {
+        s->kind = STEP_DELETE;
+        s->table = T_CFG;
+    }
+
+    if (s->kind == STEP_APPEND || s->kind == STEP_UPDATE) {
+        fill_data(s->data, m->t[s->table].struct_size);
+    } else if (s->kind == STEP_BATCH) {
+        fill_data(s->data, m->t[s->table].struct_size * s->index);
+    }
+}
+
+static void model_apply(model_t *m, const step_t *s) {
+    if (s->table < 0) {
+        return;
+    }
+    model_table_t *t = &m->t[s->table];
+    uint32_t size = t->struct_size;
+
+    switch (s->kind) {
+    case STEP_CREATE:
+        t->exists = true;
+        t->count = 0;
+        break;
+    case STEP_DELETE:
+        t->exists = false;
+        t->count = 0;
+        break;
+    case STEP_APPEND:
+        memcpy(t->data + t->count * size, s->data, size);
+        t->count++;
+        break;
+    case STEP_UPDATE:
+        memcpy(t->data + s->index * size, s->data, size);
+        break;
+    case STEP_BATCH:
+        memcpy(t->data + t->count * size, s->data, size * s->index);
+        t->count += s->index;
+        break;
+    case STEP_CLEAR: {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < t->count; i++) {
+            if (!(s->mask & (1ULL << i))) {
+                memmove(t->data + kept * size, t->data + i * size, size);
+                kept++;
+            }
+        }
+        t->count = kept;
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static int step_call(const step_t *s) {
+    const model_table_t *def = (s->table >= 0) ? &table_defs[s->table] : NULL;
+    switch (s->kind) {
+    case STEP_CREATE: return fast_flash_create_table_ex(def->name, def->struct_size, def->max_structs, def->flags);
+    case STEP_DELETE: return fast_flash_delete_table(def->name);
+    case STEP_APPEND: return fast_flash_append_table_data(def->name, s->data, def->struct_size);
+    case STEP_UPDATE: return fast_flash_write_table_data_by_index(def->name, s->index, s->data, def->struct_size);
+    case STEP_BATCH:  return fast_flash_write_table_data_batch(def->name, s->data, def->struct_size, s->index);
+    case STEP_CLEAR:  return fast_flash_clear_table_data(def->name, s->mask);
+    case STEP_GC:     return fast_flash_gc();
+    default:          return -1;
+    }
+}
+
+// 空间不足时GC并重试（应用的通常做法）
+static int step_execute(const step_t *s) {
+    int rc = step_call(s);
+    if (rc == -2 && s->kind != STEP_GC && fast_flash_gc() == 0) {
+        rc = step_call(s);
+    }
+    return rc;
+}
+
+static void step_describe(const step_t *s, char *buf, size_t size) {
+    const char *name = (s->table >= 0) ? table_defs[s->table].name : "-";
+    if (s->kind == STEP_UPDATE || s->kind == STEP_BATCH) {
+        snprintf(buf, size, "%s %s %u", step_names[s->kind], name, s->index);
+    } else if (s->kind == STEP_CLEAR) {
+        snprintf(buf, size, "%s %s 0x%llx", step_names[s->kind], name, (unsigned long long)s->mask);
+    } else {
+        snprintf(buf, size, "%s %s", step_names[s->kind], name);
+    }
+}
+
+// ===== 检查 =====
+// 从Flash读出模型中各表的实际状态
+static const char *model_read_actual(model_t *actual) {
+    static uint8_t record[POWERCUT_MAX_TABLE_DATA];
+    flash_table_t list[FF_MAX_TABLES_LIMIT];
+
+    model_reset(actual);
+    int listed = fast_flash_list_tables(list, FF_MAX_TABLES_LIMIT);
+    if (listed < 0) {
+        return "list tables failed";
+    }
+    for (int i = 0; i < listed; i++) {
+        bool known = false;
+        for (int t = 0; t < POWERCUT_TABLES; t++) {
+            known |= (strncmp(list[i].name, table_defs[t].name, TABLE_NAME_MAX_LEN) == 0);
+        }
+        if (!known) {
+            return "unexpected table";
+        }
+    }
+
+    for (int t = 0; t < POWERCUT_TABLES; t++) {
+        model_table_t *a = &actual->t[t];
+        a->exists = fast_flash_table_exists(a->name);
+        if (!a->exists) {
+            continue;
+        }
+        if (fast_flash_validate_table_data(a->name) != 0) {
+            return "table validation failed";
+        }
+        a->count = fast_flash_get_table_count(a->name);
+        if (a->count > a->max_structs) {
+            return "record count out of range";
+        }
+        for (uint32_t i = 0; i < a->count; i++) {
+            if (fast_flash_read_table_data(a->name, i, record, a->struct_size) != 0) {
+                return "read failed";
+            }
+            memcpy(a->data + i * a->struct_size, record, a->struct_size);
+        }
+    }
+    return NULL;
+}
+
+static bool model_equal(const model_t *a, const model_t *b) {
+    for (int t = 0; t < POWERCUT_TABLES; t++) {
+        const model_table_t *x = &a->t[t];
+        const model_table_t *y = &b->t[t];
+        if (x->exists != y->exists || (x->exists && (x->count != y->count ||
+            memcmp(x->data, y->data, x->count * x->struct_size) != 0))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int powercut_mount(bool allow_erase) {
+    return fast_flash_init_ex(&flash_sim_fault_ops, cfg.capacity, allow_erase, &geometry);
+}
+
+// ===== 用例 =====
+typedef struct {
+    uint32_t cut_at;
+    flash_fault_mode_t mode;
+    uint32_t fault_seed;
+    int      step;                        // 掉电时执行到第几步，-1表示格式化期间
+    char     step_desc[48];
+    const char *failure;                  // NULL表示通过
+} powercut_case_t;
+
+// 运行一个用例；cut_at为0时不掉电，返回整个序列的编程/擦除次数
+static uint32_t run_case(powercut_case_t *c) {
+    model_t cur, pre, post, actual;
+    step_t step;
+    flash_fault_plan_t plan = { c->cut_at, c->mode, c->fault_seed };
+
+    c->step = -1;
+    c->step_desc[0] = '\0';
+    c->failure = NULL;
+    rng_state = cfg.seed ? cfg.seed : 1;
+    model_reset(&cur);
+
+    flash_fault_disarm();
+    flash_sim_mem_erase_all();
+    flash_fault_arm(&plan);
+
+    // 格式化期间掉电：重新上电后应为空库
+    pre = cur;
+    post = cur;
+    if (powercut_mount(true) != 0 && !flash_fault_tripped()) {
+        c->failure = "format failed";
+        return flash_fault_op_count();
+    }
+
+    for (uint32_t i = 0; i < cfg.steps && !flash_fault_tripped(); i++) {
+        step_generate(&cur, &step);
+        pre = cur;
+        post = cur;
+        model_apply(&post, &step);
+        c->step = (int)i;
+        step_describe(&step, c->step_desc, sizeof(c->step_desc));
+
+        int rc = step_execute(&step);
+        if (flash_fault_tripped()) {
+            break;
+        }
+        if (rc != 0) {
+            c->failure = "step failed without power loss";
+            return flash_fault_op_count();
+        }
+        cur = post;
+    }
+
+    uint32_t ops = flash_fault_op_count();
+    if (!flash_fault_tripped()) {
+        return ops;                       // 掉电点在序列之后
+    }
+
+    // 恢复供电，重新挂载并与模型比较
+    flash_fault_disarm();
+    if (powercut_mount(true) != 0) {
+        c->failure = "remount failed";
+        return ops;
+    }
+    if ((c->failure = model_read_actual(&actual)) != NULL) {
+        return ops;
+    }
+    if (model_equal(&actual, &pre)) {
+        cur = pre;
+    } else if (model_equal(&actual, &post)) {
+        cur = post;
+    } else {
+        c->failure = "state is neither before nor after the interrupted step";
+        return ops;
+    }
+
+    // 掉电后的库仍然可用：继续执行几步并重新挂载比较
+    for (int i = 0; i < POWERCUT_AFTER_STEPS; i++) {
+        step_generate(&cur, &step);
+        if (step_execute(&step) != 0) {
+            c->failure = "write after remount failed";
+            return ops;
+        }
+        model_apply(&cur, &step);
+    }
+    if (powercut_mount(false) != 0) {
+        c->failure = "second remount failed";
+        return ops;
+    }
+    if ((c->failure = model_read_actual(&actual)) == NULL && !model_equal(&actual, &cur)) {
+        c->failure = "state after recovery writes does not match";
+    }
+    return ops;
+}
+
+// ===== 统计 =====
+#define POWERCUT_MAX_FAILURE_KINDS 16
+
+typedef struct {
+    uint32_t cases;
+    uint32_t failed;
+    uint32_t per_mode_cases[FLASH_FAULT_MODE_COUNT];
+    uint32_t per_mode_failed[FLASH_FAULT_MODE_COUNT];
+    const char *kinds[POWERCUT_MAX_FAILURE_KINDS];
+    uint32_t kind_counts[POWERCUT_MAX_FAILURE_KINDS];
+    int      kind_count;
+    powercut_case_t reported[POWERCUT_MAX_REPORTED];
+    int      reported_count;
+} powercut_summary_t;
+
+static powercut_summary_t summary;
+
+static void summary_add(const powercut_case_t *c) {
+    summary.cases++;
+    summary.per_mode_cases[c->mode]++;
+    if (!c->failure) {
+        return;
+    }
+    summary.failed++;
+    summary.per_mode_failed[c->mode]++;
+
+    int k = 0;
+    while (k < summary.kind_count && strcmp(summary.kinds[k], c->failure) != 0) {
+        k++;
+    }
+    if (k == summary.kind_count && k < POWERCUT_MAX_FAILURE_KINDS) {
+        summary.kinds[summary.kind_count++] = c->failure;
+    }
+    if (k < POWERCUT_MAX_FAILURE_KINDS) {
+        summary.kind_counts[k]++;
+    }
+    if (summary.reported_count < POWERCUT_MAX_REPORTED) {
+        summary.reported[summary.reported_count++] = *c;
+    }
+    if (cfg.verbose) {
+        printf("FAIL cut %u (%s, seed %u) at step %d '%s': %s\n", c->cut_at, flash_fault_mode_name(c->mode),
+               c->fault_seed, c->step, c->step_desc, c->failure);
+    }
+}
+
+static void print_summary(uint32_t total_ops) {
+    printf("\nsequence: %u steps, %u program/erase operations\n", cfg.steps, total_ops);
+    printf("cases %u, failed %u\n", summary.cases, summary.failed);
+    for (int m = 0; m < FLASH_FAULT_MODE_COUNT; m++) {
+        if (summary.per_mode_cases[m]) {
+            printf("  %-10s %6u cases, %u failed\n", flash_fault_mode_name((flash_fault_mode_t)m),
+                   summary.per_mode_cases[m], summary.per_mode_failed[m]);
+        }
+    }
+    for (int k = 0; k < summary.kind_count; k++) {
+        printf("  %6u x %s\n", summary.kind_counts[k], summary.kinds[k]);
+    }
+    if (!cfg.verbose) {
+        for (int i = 0; i < summary.reported_count; i++) {
+            const powercut_case_t *c = &summary.reported[i];
+            printf("FAIL cut %u (%s, seed %u) at step %d '%s': %s\n", c->cut_at, flash_fault_mode_name(c->mode),
+                   c->fault_seed, c->step, c->step_desc, c->failure);
+        }
+    }
+}
+
+static void write_json(FILE *out, uint32_t total_ops) {
+    fprintf(out, "{\"schema\":%d,\"config\":{\"capacity\":%u,\"steps\":%u,\"seed\":%u,\"random_cases\":%u},\n",
+            POWERCUT_SCHEMA_VERSION, cfg.capacity, cfg.steps, cfg.seed, cfg.random_cases);
+    fprintf(out, "\"operations\":%u,\"cases\":%u,\"failed\":%u,\"failures\":[", total_ops, summary.cases, summary.failed);
+    for (int i = 0; i < summary.reported_count; i++) {
+        const powercut_case_t *c = &summary.reported[i];
+        fprintf(out, "%s\n{\"cut_at\":%u,\"mode\":\"%s\",\"fault_seed\":%u,\"step\":%d,\"op\":\"%s\",\"failure\":\"%s\"}",
+                i ? "," : "", c->cut_at, flash_fault_mode_name(c->mode), c->fault_seed, c->step, c->step_desc,
+                c->failure);
+    }
+    fprintf(out, "\n]}\n");
+}
+
+// ===== 命令行 =====
+static void usage(void) {
+    printf("usage: fast_flash_powercut [options]\n"
+           "  --capacity KB        simulated flash size (default 64)\n"
+           "  --steps N            operations in the generated sequence (default 60)\n"
+           "  --seed N             sequence seed\n"
+           "  --random N           N random cut points instead of all of them\n"
+           "  --from N / --to N    exhaustive range of cut points (1-based)\n"
+           "  --mode NAME          cut | tear-page | tear-bits (default: all)\n"
+           "  --json FILE          write results as JSON (- for stdout)\n"
+           "  --max-failed N       exit 0 if at most N cases fail (known failures)\n"
+           "  --verbose            print every failed case\n");
+}
+
+static int parse_args(int argc, char **argv) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.capacity = 64 * 1024;
+    cfg.steps = 60;
+    cfg.seed = FLASH_TIMING_DEFAULT_SEED;
+    cfg.mode = -1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--verbose") == 0) {
+            cfg.verbose = true;
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0 || !value) {
+            usage();
+            return -1;
+        }
+        i++;
+        if (strcmp(arg, "--capacity") == 0) cfg.capacity = (uint32_t)strtoul(value, NULL, 0) * 1024;
+        else if (strcmp(arg, "--steps") == 0) cfg.steps = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--seed") == 0) cfg.seed = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--random") == 0) cfg.random_cases = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--from") == 0) cfg.first_cut = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--to") == 0) cfg.last_cut = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--json") == 0) cfg.json_path = value;
+        else if (strcmp(arg, "--max-failed") == 0) cfg.max_failed = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--mode") == 0) {
+            cfg.mode = -1;
+            for (int m = 0; m < FLASH_FAULT_MODE_COUNT; m++) {
+                if (strcmp(value, flash_fault_mode_name((flash_fault_mode_t)m)) == 0) {
+                    cfg.mode = m;
+                }
+            }
+            if (cfg.mode < 0) {
+                printf("Unknown mode '%s'\n", value);
+                return -1;
+            }
+        } else {
+            usage();
+            return -1;
+        }
+    }
+
+    if (cfg.capacity < 8 * FLASH_SECTOR_SIZE || cfg.capacity % FLASH_SECTOR_SIZE != 0 || cfg.steps == 0) {
+        printf("Invalid power-cut configuration\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) != 0) {
+        return -1;
+    }
+
+    memset(&geometry, 0, sizeof(geometry));
+    geometry.sector_size = FLASH_SECTOR_SIZE;
+    geometry.page_size = 256;
+    geometry.erase_sizes[0] = 4 * 1024;
+    geometry.erase_sizes[1] = 32 * 1024;
+    geometry.erase_sizes[2] = 64 * 1024;
+
+    if (flash_sim_mem_create(cfg.capacity, FLASH_SECTOR_SIZE) != 0) {
+        printf("Failed to allocate %u KB simulated flash\n", cfg.capacity / 1024);
+        return -1;
+    }
+    flash_timing_set_profile(&flash_timing_ideal);
+    flash_sim_mem_set_quiet(!cfg.verbose);
+    flash_fault_attach(&flash_sim_mem_ops);
+
+    // 不掉电运行一次：确认序列本身正确，并得到编程/擦除总次数
+    powercut_case_t c;
+    memset(&c, 0, sizeof(c));
+    uint32_t total_ops = run_case(&c);
+    if (c.failure) {
+        printf("Sequence fails without power loss at step %d '%s': %s\n", c.step, c.step_desc, c.failure);
+        flash_sim_mem_destroy();
+        return -1;
+    }
+
+    int first_mode = (cfg.mode < 0) ? 0 : cfg.mode;
+    int last_mode = (cfg.mode < 0) ? FLASH_FAULT_MODE_COUNT - 1 : cfg.mode;
+    printf("Fast Flash power-cut test (%u KB, %u steps, seed 0x%08X, %u cut points)\n", cfg.capacity / 1024,
+           cfg.steps, cfg.seed, total_ops);
+
+    if (cfg.random_cases) {
+        uint32_t picker = (cfg.seed ^ 0xA5A5A5A5u) ? (cfg.seed ^ 0xA5A5A5A5u) : 1;
+        for (uint32_t i = 0; i < cfg.random_cases; i++) {
+            picker ^= picker << 13;
+            picker ^= picker >> 17;
+            picker ^= picker << 5;
+            c.cut_at = 1 + picker % total_ops;
+            c.mode = (flash_fault_mode_t)(first_mode + (int)((picker >> 8) % (uint32_t)(last_mode - first_mode + 1)));
+            c.fault_seed = picker;
+            run_case(&c);
+            summary_add(&c);
+        }
+    } else {
+        uint32_t first = cfg.first_cut ? cfg.first_cut : 1;
+        uint32_t last = (cfg.last_cut && cfg.last_cut < total_ops) ? cfg.last_cut : total_ops;
+        for (uint32_t cut = first; cut <= last; cut++) {
+            for (int m = first_mode; m <= last_mode; m++) {
+                c.cut_at = cut;
+                c.mode = (flash_fault_mode_t)m;
+                c.fault_seed = cut * 2654435761u + (uint32_t)m;
+                run_case(&c);
+                summary_add(&c);
+            }
+        }
+    }
+
+    print_summary(total_ops);
+
+    int rc = (summary.failed > cfg.max_failed) ? -1 : 0;
+    if (cfg.json_path) {
+        FILE *out = strcmp(cfg.json_path, "-") == 0 ? stdout : fopen(cfg.json_path, "w");
+        if (!out) {
+            printf("Failed to open %s\n", cfg.json_path);
+            rc = -1;
+        } else {
+            write_json(out, total_ops);
+            if (out != stdout) {
+                fclose(out);
+            }
+        }
+    }
+
+    flash_sim_mem_destroy();
+    return rc;
+}
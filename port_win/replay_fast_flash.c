@@ -0,0 +1,284 @@
+#include "../core/fast_flash_core.h"
+#include "../core/fast_flash_record.h"
+#include "../port_common/flash_sim_timing.h"
+#include "../port_common/flash_sim_latency.h"
+#include "../port_common/flash_sim_mem.h"
+#include "../port_common/flash_sim_replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 负载回放：读取设备上录制的调用序列（见core/fast_flash_record.h），在内存模拟的NOR Flash上
+// 按指定的几何参数和器件时序重新执行，报告每类操作的延迟（虚拟时钟）、擦除次数和写放大。
+// 数据内容按录制的摘要生成：录制时相同的数据回放时仍然相同。
+
+#define REPLAY_SCHEMA_VERSION  1
+
+// ===== 配置 =====
+typedef struct {
+    const char *trace_path;
+    flash_replay_overrides_t overrides;        // 覆盖录制的容量和几何参数
+    uint32_t seed;
+    const flash_timing_profile_t *profile;
+    const char *json_path;                     // "-"表示标准输出
+    bool verbose;                              // 打印每个失败的操作
+} replay_config_t;
+
+static replay_config_t cfg;
+
+// ===== 每类操作的统计 =====
+typedef struct {
+    uint32_t  count;
+    uint32_t  errors;
+    uint64_t  total_us;
+    uint32_t *samples;
+    uint32_t  capacity;
+} op_stats_t;
+
+static op_stats_t op_stats[FF_REC_OP_COUNT];
+
+static void op_stats_add(op_stats_t *stats, uint32_t us, bool error) {
+    stats->count++;
+    stats->total_us += us;
+    if (error) {
+        stats->errors++;
+    }
+    if (stats->count > stats->capacity) {
+        uint32_t capacity = stats->capacity ? stats->capacity * 2 : 256;
+        uint32_t *samples = realloc(stats->samples, capacity * sizeof(uint32_t));
+        if (!samples) {
+            return;
+        }
+        stats->samples = samples;
+        stats->capacity = capacity;
+    }
+    stats->samples[stats->count - 1] = us;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t op_stats_percentile(const op_stats_t *stats, uint32_t percent) {
+    uint32_t n = (stats->count < stats->capacity) ? stats->count : stats->capacity;
+    return n ? stats->samples[(n - 1) * percent / 100] : 0;
+}
+
+// ===== 输出 =====
+static void print_report(uint32_t records, uint64_t device_us, const flash_stats_t *stats) {
+    printf("\n%-16s %8s %7s %12s %10s %10s %10s\n", "op", "count", "errors", "avg_us", "p50_us", "p99_us", "max_us");
+    for (int op = 1; op < FF_REC_OP_COUNT; op++) {
+        op_stats_t *s = &op_stats[op];
+        if (s->count == 0) {
+            continue;
+        }
+        printf("%-16s %8u %7u %12.1f %10u %10u %10u\n", fast_flash_record_op_name((flash_record_op_t)op),
+               s->count, s->errors, (double)s->total_us / s->count,
+               op_stats_percentile(s, 50), op_stats_percentile(s, 99), op_stats_percentile(s, 100));
+    }
+
+    const flash_io_stats_t *io = &stats->total;
+    uint64_t programmed = io->data_bytes + io->metadata_bytes + io->relocation_bytes;
+    printf("\nrecords %u, device time %.3f s\n", records, device_us / 1e6);
+    printf("user %llu B, programmed %llu B (relocation %llu B), read %llu B\n",
+           (unsigned long long)io->user_bytes, (unsigned long long)programmed,
+           (unsigned long long)io->relocation_bytes, (unsigned long long)io->read_bytes);
+    printf("erases %u (%llu B), write amplification %.2f\n", io->erase_count,
+           (unsigned long long)io->erase_bytes, io->user_bytes ? (double)programmed / io->user_bytes : 0.0);
+}
+
+static void write_json(FILE *out, uint32_t records, uint64_t device_us, const flash_stats_t *stats) {
+    const flash_io_stats_t *io = &stats->total;
+    uint64_t programmed = io->data_bytes + io->metadata_bytes + io->relocation_bytes;
+    const flash_geometry_t *used_geometry = flash_sim_replay_geometry();
+
+    // 几何参数为实际使用的值，0表示核心默认值
+    fprintf(out, "{\"schema\":%d,\"trace\":\"%s\",\"records\":%u,\"config\":{\"capacity\":%u,\"sector_size\":%u,"
+                 "\"page_size\":%u,\"write_granularity\":%u,\"max_tables\":%u,\"seed\":%u,\"profile\":\"%s\"},\n",
+            REPLAY_SCHEMA_VERSION, cfg.trace_path, records, flash_sim_mem_size(), used_geometry->sector_size,
+            used_geometry->page_size, used_geometry->write_granularity, used_geometry->max_tables, cfg.seed,
+            cfg.profile->name);
+    fprintf(out, "\"device_us\":%llu,\"user_bytes\":%llu,\"programmed_bytes\":%llu,\"relocation_bytes\":%llu,"
+                 "\"read_bytes\":%llu,\"erase_count\":%u,\"erase_bytes\":%llu,\"write_amplification\":%.3f,\n\"ops\":[",
+            (unsigned long long)device_us, (unsigned long long)io->user_bytes, (unsigned long long)programmed,
+            (unsigned long long)io->relocation_bytes, (unsigned long long)io->read_bytes, io->erase_count,
+            (unsigned long long)io->erase_bytes, io->user_bytes ? (double)programmed / io->user_bytes : 0.0);
+    bool first = true;
+    for (int op = 1; op < FF_REC_OP_COUNT; op++) {
+        op_stats_t *s = &op_stats[op];
+        if (s->count == 0) {
+            continue;
+        }
+        fprintf(out, "%s\n{\"op\":\"%s\",\"count\":%u,\"errors\":%u,\"total_us\":%llu,\"p50_us\":%u,\"p99_us\":%u,\"max_us\":%u}",
+                first ? "" : ",", fast_flash_record_op_name((flash_record_op_t)op), s->count, s->errors,
+                (unsigned long long)s->total_us, op_stats_percentile(s, 50), op_stats_percentile(s, 99),
+                op_stats_percentile(s, 100));
+        first = false;
+    }
+    fprintf(out, "\n]}\n");
+}
+
+// ===== 命令行 =====
+static void usage(void) {
+    printf("usage: fast_flash_replay TRACE [options]\n"
+           "  --capacity KB        flash size for single-partition traces (default: as recorded)\n"
+           "  --sector N           sector size in bytes\n"
+           "  --page N             program page size in bytes\n"
+           "  --granularity N      write granularity in bytes\n"
+           "  --max-tables N       manager table capacity\n"
+           "  --erase-sizes LIST   supported erase sizes in bytes, e.g. 4096,32768,65536\n"
+           "  --seed N             RNG seed for device timing\n"
+           "  --profile NAME       winbond | gigadevice | ideal\n"
+           "  --json FILE          write results as JSON (- for stdout)\n"
+           "  --verbose            print every failed call\n");
+}
+
+static int parse_args(int argc, char **argv) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.seed = FLASH_TIMING_DEFAULT_SEED;
+    cfg.profile = &flash_timing_winbond_w25q;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (arg[0] != '-') {
+            cfg.trace_path = arg;
+            continue;
+        }
+        if (strcmp(arg, "--verbose") == 0) {
+            cfg.verbose = true;
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0 || !value) {
+            usage();
+            return -1;
+        }
+        i++;
+        if (strcmp(arg, "--capacity") == 0) cfg.overrides.capacity = (uint32_t)strtoul(value, NULL, 0) * 1024;
+        else if (strcmp(arg, "--sector") == 0) cfg.overrides.geometry.sector_size = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--page") == 0) cfg.overrides.geometry.page_size = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--granularity") == 0) cfg.overrides.geometry.write_granularity = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--max-tables") == 0) cfg.overrides.geometry.max_tables = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--erase-sizes") == 0) {
+            char buf[128];
+            int count = 0;
+            snprintf(buf, sizeof(buf), "%s", value);
+            for (char *tok = strtok(buf, ","); tok && count < FF_MAX_ERASE_SIZES; tok = strtok(NULL, ",")) {
+                cfg.overrides.geometry.erase_sizes[count++] = (uint32_t)strtoul(tok, NULL, 0);
+            }
+        }
+        else if (strcmp(arg, "--seed") == 0) cfg.seed = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--json") == 0) cfg.json_path = value;
+        else if (strcmp(arg, "--profile") == 0) {
+            if (strcmp(value, "winbond") == 0) cfg.profile = &flash_timing_winbond_w25q;
+            else if (strcmp(value, "gigadevice") == 0) cfg.profile = &flash_timing_gigadevice_gd25q;
+            else if (strcmp(value, "ideal") == 0) cfg.profile = &flash_timing_ideal;
+            else {
+                printf("Unknown profile '%s'\n", value);
+                return -1;
+            }
+        }
+        else {
+            usage();
+            return -1;
+        }
+    }
+
+    if (!cfg.trace_path) {
+        usage();
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) != 0) {
+        return -1;
+    }
+
+    uint32_t size = 0;
+    uint8_t *trace = flash_sim_replay_load(cfg.trace_path, &size);
+    int pos = trace ? fast_flash_record_check_header(trace, size) : -1;
+    if (pos < 0) {
+        printf("Failed to read trace '%s'\n", cfg.trace_path);
+        free(trace);
+        return -1;
+    }
+
+    flash_timing_set_profile(cfg.profile);
+    flash_timing_reset_clock();
+    flash_timing_seed(cfg.seed);
+    flash_latency_reset();
+    fast_flash_reset_stats();
+
+    printf("Replaying %s (%u bytes, profile %s, seed 0x%08X)\n", cfg.trace_path, size, cfg.profile->name, cfg.seed);
+
+    int rc = 0;
+    uint32_t records = 0;
+    uint64_t start_us = flash_timing_now_us();
+    while ((uint32_t)pos < size) {
+        flash_record_t rec;
+        int used = fast_flash_record_decode(trace + pos, size - (uint32_t)pos, &rec);
+        if (used <= 0) {
+            printf("%s record at offset %d, replay stopped\n", used == 0 ? "Truncated" : "Invalid", pos);
+            rc = -1;
+            break;
+        }
+        pos += used;
+        records++;
+
+        if (rec.op != FF_REC_INIT && !flash_sim_replay_ready()) {
+            printf("Trace does not start with init, replay stopped\n");
+            rc = -1;
+            break;
+        }
+
+        uint64_t op_start = flash_timing_now_us();
+        int result = flash_sim_replay_execute(&rec, &cfg.overrides);
+        op_stats_add(&op_stats[rec.op], (uint32_t)(flash_timing_now_us() - op_start), result != 0);
+        if (result != 0 && cfg.verbose) {
+            printf("#%u %s '%s' -> %d\n", records, fast_flash_record_op_name((flash_record_op_t)rec.op), rec.name, result);
+        }
+        if (rec.op == FF_REC_INIT && result != 0) {
+            printf("Init failed with this configuration, replay stopped\n");
+            rc = -1;
+            break;
+        }
+    }
+    uint64_t device_us = flash_timing_now_us() - start_us;
+
+    for (int op = 1; op < FF_REC_OP_COUNT; op++) {
+        op_stats_t *s = &op_stats[op];
+        uint32_t n = (s->count < s->capacity) ? s->count : s->capacity;
+        if (n) {
+            qsort(s->samples, n, sizeof(uint32_t), compare_u32);
+        }
+    }
+
+    flash_stats_t stats;
+    fast_flash_get_stats(&stats);
+    print_report(records, device_us, &stats);
+
+    if (cfg.json_path) {
+        FILE *out = strcmp(cfg.json_path, "-") == 0 ? stdout : fopen(cfg.json_path, "w");
+        if (!out) {
+            printf("Failed to open %s\n", cfg.json_path);
+            rc = -1;
+        } else {
+            write_json(out, records, device_us, &stats);
+            if (out != stdout) {
+                fclose(out);
+            }
+        }
+    }
+
+    for (int op = 1; op < FF_REC_OP_COUNT; op++) {
+        free(op_stats[op].samples);
+    }
+    flash_sim_replay_release();
+    free(trace);
+    flash_sim_mem_destroy();
+    return rc;
+}
@@ -0,0 +1,626 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "../port_common/flash_sim_timing.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+extern char **environ;
+#endif
+
+// 参数扫描：把容量、扇区大小、记录大小、表数量、器件时序和种子的组合展开成网格，
+// 每个组合启动一个独立的fast_flash_bench进程（各自的内存镜像和配置），按CPU核数并行运行，
+// 最后把每次运行的JSON结果（延迟、擦除、写放大、能耗）汇总成一份报告（同一配置不同种子取平均）。
+//
+// 用进程而不是线程并行：核心和模拟器都使用全局状态，一个进程只能有一个数据库实例。
+// 模拟器使用虚拟时钟，不会真实等待，所以总耗时只取决于核心代码的CPU时间。
+
+#define SWEEP_SCHEMA_VERSION   1
+#define SWEEP_MAX_VALUES       16
+#define SWEEP_MAX_JOBS         256
+#define SWEEP_MAX_ARGS         32
+#define SWEEP_MAX_POINTS       64       // 每次运行的结果条数上限（与fast_flash_bench一致）
+
+// ===== 配置 =====
+typedef struct {
+    const char *bench_path;                  // fast_flash_bench可执行文件
+    const char *out_dir;                     // 每次运行的JSON结果存放目录
+    const char *json_path;                   // 汇总报告，"-"表示标准输出
+    const char *workloads;                   // 原样传给fast_flash_bench
+    uint32_t capacity[SWEEP_MAX_VALUES];     // KB
+    int      capacity_count;
+    uint32_t sector[SWEEP_MAX_VALUES];
+    int      sector_count;
+    uint32_t record_size[SWEEP_MAX_VALUES];
+    int      record_size_count;
+    uint32_t tables[SWEEP_MAX_VALUES];
+    int      tables_count;
+    const char *profile[SWEEP_MAX_VALUES];
+    int      profile_count;
+    uint32_t seeds;                          // 每个配置运行的种子数
+    uint32_t seed;                           // 第一个种子，之后依次加1
+    uint32_t jobs;                           // 并行进程数
+    bool     quick;
+    bool     keep;                           // 保留每次运行的JSON文件
+} sweep_config_t;
+
+// 一次运行：网格中的一个点加一个种子
+typedef struct {
+    uint32_t capacity;
+    uint32_t sector;
+    uint32_t record_size;
+    uint32_t tables;
+    const char *profile;
+    uint32_t seed;
+    int      config_id;                      // 去掉种子后的配置编号（用于汇总）
+    char     json_file[512];
+    int      exit_code;                      // 进程退出码，负数表示未能启动或被信号终止
+    bool     done;
+    char    *json;                           // 结果文件内容
+} sweep_run_t;
+
+// 一条结果：某次运行中的一个工作负载/参数点
+typedef struct {
+    char     workload[16];
+    char     param_name[16];
+    double   param;
+    uint32_t ops;
+    uint32_t failed;
+    double   device_us_per_op;
+    double   p99_us;
+    double   erase_bytes;
+    double   write_amplification;
+    double   energy_uj_per_op;
+} sweep_point_t;
+
+static sweep_config_t cfg;
+static sweep_run_t *runs = NULL;
+static uint32_t run_count = 0;
+
+// ===== 命令行 =====
+static int parse_u32_list(const char *text, uint32_t *values) {
+    int count = 0;
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", text);
+    for (char *tok = strtok(buf, ","); tok && count < SWEEP_MAX_VALUES; tok = strtok(NULL, ",")) {
+        values[count++] = (uint32_t)strtoul(tok, NULL, 0);
+    }
+    return count;
+}
+
+// 字符串列表直接切分argv中的字符串
+static int parse_str_list(char *text, const char **values) {
+    int count = 0;
+    for (char *tok = strtok(text, ","); tok && count < SWEEP_MAX_VALUES; tok = strtok(NULL, ",")) {
+        values[count++] = tok;
+    }
+    return count;
+}
+
+static uint32_t cpu_count(void) {
+#ifdef _WIN32
+    const char *env = getenv("NUMBER_OF_PROCESSORS");
+    long n = env ? strtol(env, NULL, 10) : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (n > 0) ? (uint32_t)n : 1;
+}
+
+// 默认在本程序所在目录查找fast_flash_bench
+static const char *default_bench_path(const char *argv0) {
+    static char path[512];
+#ifdef _WIN32
+    const char *name = "fast_flash_bench.exe";
+#else
+    const char *name = "fast_flash_bench";
+#endif
+    const char *slash = strrchr(argv0, '/');
+#ifdef _WIN32
+    const char *backslash = strrchr(argv0, '\\');
+    if (backslash && (!slash || backslash > slash)) {
+        slash = backslash;
+    }
+#endif
+    if (!slash) {
+#ifdef _WIN32
+        return name;
+#else
+        snprintf(path, sizeof(path), "./%s", name);
+        return path;
+#endif
+    }
+    snprintf(path, sizeof(path), "%.*s%s", (int)(slash - argv0 + 1), argv0, name);
+    return path;
+}
+
+static void usage(void) {
+    printf("usage: fast_flash_sweep [options]\n"
+           "  --capacity LIST      simulated flash sizes in KB (default 128)\n"
+           "  --sector LIST        sector sizes in bytes (default 4096)\n"
+           "  --record-size LIST   record sizes in bytes (default 32)\n"
+           "  --tables LIST        table counts (default 8)\n"
+           "  --profile LIST       device timing profiles: winbond,gigadevice,ideal (default winbond)\n"
+           "  --seeds N            seeds per configuration, results averaged (default 3)\n"
+           "  --seed N             first seed, following runs use seed+1, seed+2, ...\n"
+           "  --workloads LIST     passed to fast_flash_bench\n"
+           "  --quick              run fast_flash_bench --quick\n"
+           "  --jobs N             parallel processes (default: CPU count)\n"
+           "  --bench PATH         fast_flash_bench executable (default: next to this program)\n"
+           "  --out DIR            directory for per-run JSON files (default .)\n"
+           "  --keep               keep per-run JSON files\n"
+           "  --json FILE          write the aggregated report as JSON (- for stdout)\n");
+}
+
+static int parse_args(int argc, char **argv) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.out_dir = ".";
+    cfg.seeds = 3;
+    cfg.seed = FLASH_TIMING_DEFAULT_SEED;
+    cfg.jobs = cpu_count();
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--quick") == 0) {
+            cfg.quick = true;
+            continue;
+        }
+        if (strcmp(arg, "--keep") == 0) {
+            cfg.keep = true;
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            usage();
+            exit(0);
+        }
+        if (!value) {
+            usage();
+            return -1;
+        }
+        if (strcmp(arg, "--capacity") == 0) cfg.capacity_count = parse_u32_list(value, cfg.capacity);
+        else if (strcmp(arg, "--sector") == 0) cfg.sector_count = parse_u32_list(value, cfg.sector);
+        else if (strcmp(arg, "--record-size") == 0) cfg.record_size_count = parse_u32_list(value, cfg.record_size);
+        else if (strcmp(arg, "--tables") == 0) cfg.tables_count = parse_u32_list(value, cfg.tables);
+        else if (strcmp(arg, "--profile") == 0) cfg.profile_count = parse_str_list(value, cfg.profile);
+        else if (strcmp(arg, "--seeds") == 0) cfg.seeds = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--seed") == 0) cfg.seed = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--workloads") == 0) cfg.workloads = value;
+        else if (strcmp(arg, "--jobs") == 0) cfg.jobs = (uint32_t)strtoul(value, NULL, 0);
+        else if (strcmp(arg, "--bench") == 0) cfg.bench_path = value;
+        else if (strcmp(arg, "--out") == 0) cfg.out_dir = value;
+        else if (strcmp(arg, "--json") == 0) cfg.json_path = value;
+        else {
+            usage();
+            return -1;
+        }
+        i++;
+    }
+
+    if (!cfg.bench_path) cfg.bench_path = default_bench_path(argv[0]);
+    if (!cfg.capacity_count) cfg.capacity_count = parse_u32_list("128", cfg.capacity);
+    if (!cfg.sector_count) cfg.sector_count = parse_u32_list("4096", cfg.sector);
+    if (!cfg.record_size_count) cfg.record_size_count = parse_u32_list("32", cfg.record_size);
+    if (!cfg.tables_count) cfg.tables_count = parse_u32_list("8", cfg.tables);
+    if (!cfg.profile_count) {
+        cfg.profile[0] = "winbond";
+        cfg.profile_count = 1;
+    }
+    if (cfg.seeds == 0 || cfg.jobs == 0) {
+        printf("Invalid sweep configuration\n");
+        return -1;
+    }
+    if (cfg.jobs > SWEEP_MAX_JOBS) {
+        cfg.jobs = SWEEP_MAX_JOBS;
+    }
+    return 0;
+}
+
+// ===== 网格 =====
+static int build_grid(void) {
+    uint32_t configs = (uint32_t)(cfg.capacity_count * cfg.sector_count * cfg.record_size_count *
+                                  cfg.tables_count * cfg.profile_count);
+    run_count = configs * cfg.seeds;
+    runs = calloc(run_count, sizeof(sweep_run_t));
+    if (!runs) {
+        printf("Failed to allocate %u runs\n", run_count);
+        return -1;
+    }
+
+    uint32_t n = 0;
+    int config_id = 0;
+    for (int c = 0; c < cfg.capacity_count; c++)
+    for (int s = 0; s < cfg.sector_count; s++)
+    for (int r = 0; r < cfg.record_size_count; r++)
+    for (int t = 0; t < cfg.tables_count; t++)
+    for (int p = 0; p < cfg.profile_count; p++, config_id++)
+    for (uint32_t k = 0; k < cfg.seeds; k++, n++) {
+        sweep_run_t *run = &runs[n];
+        run->capacity = cfg.capacity[c];
+        run->sector = cfg.sector[s];
+        run->record_size = cfg.record_size[r];
+        run->tables = cfg.tables[t];
+        run->profile = cfg.profile[p];
+        run->seed = cfg.seed + k;
+        run->config_id = config_id;
+        run->exit_code = -1;
+        snprintf(run->json_file, sizeof(run->json_file), "%s/sweep_run_%u.json", cfg.out_dir, n);
+    }
+    return 0;
+}
+
+// ===== 进程 =====
+typedef struct {
+    char  text[SWEEP_MAX_ARGS][64];
+    char *argv[SWEEP_MAX_ARGS + 1];
+    int   count;
+} arg_list_t;
+
+static void arg_add(arg_list_t *args, const char *fmt, ...) {
+    if (args->count >= SWEEP_MAX_ARGS) {
+        return;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(args->text[args->count], sizeof(args->text[0]), fmt, ap);
+    va_end(ap);
+    args->argv[args->count] = args->text[args->count];
+    args->count++;
+    args->argv[args->count] = NULL;
+}
+
+static void build_args(const sweep_run_t *run, arg_list_t *args) {
+    memset(args, 0, sizeof(*args));
+    // 路径可能超过单个参数缓冲区，直接引用
+    args->argv[args->count++] = (char*)cfg.bench_path;
+    arg_add(args, "--quiet");
+    if (cfg.quick) arg_add(args, "--quick");
+    arg_add(args, "--capacity");    arg_add(args, "%u", run->capacity);
+    arg_add(args, "--sector");      arg_add(args, "%u", run->sector);
+    arg_add(args, "--record-size"); arg_add(args, "%u", run->record_size);
+    arg_add(args, "--tables");      arg_add(args, "%u", run->tables);
+    arg_add(args, "--profile");     arg_add(args, "%s", run->profile);
+    arg_add(args, "--seed");        arg_add(args, "%u", run->seed);
+    if (cfg.workloads) {
+        arg_add(args, "--workloads"); arg_add(args, "%s", cfg.workloads);
+    }
+    args->argv[args->count++] = "--json";
+    args->argv[args->count++] = (char*)run->json_file;
+    args->argv[args->count] = NULL;
+}
+
+#ifdef _WIN32
+typedef intptr_t proc_t;
+#else
+typedef pid_t proc_t;
+#endif
+
+static int spawn_run(const sweep_run_t *run, proc_t *proc) {
+    arg_list_t args;
+    build_args(run, &args);
+    remove(run->json_file);
+#ifdef _WIN32
+    intptr_t handle = _spawnv(_P_NOWAIT, cfg.bench_path, (const char * const *)args.argv);
+    if (handle == -1) {
+        return -1;
+    }
+    *proc = handle;
+    return 0;
+#else
+    pid_t pid;
+    if (posix_spawn(&pid, cfg.bench_path, NULL, NULL, args.argv, environ) != 0) {
+        return -1;
+    }
+    *proc = pid;
+    return 0;
+#endif
+}
+
+// 等待任意一个子进程结束，返回它在slots中的位置
+static int wait_any(const proc_t *procs, uint32_t count, int *exit_code) {
+#ifdef _WIN32
+    // _cwait只能等待指定进程：依次等待最早启动的那个
+    (void)count;
+    int status = 0;
+    if (_cwait(&status, procs[0], 0) == -1) {
+        *exit_code = -1;
+    } else {
+        *exit_code = status;
+    }
+    return 0;
+#else
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid <= 0) {
+        return -1;
+    }
+    *exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    for (uint32_t i = 0; i < count; i++) {
+        if (procs[i] == pid) {
+            return (int)i;
+        }
+    }
+    return -1;
+#endif
+}
+
+static char *load_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *buf = (length > 0) ? malloc((size_t)length + 1) : NULL;
+    if (buf && fread(buf, 1, (size_t)length, file) != (size_t)length) {
+        free(buf);
+        buf = NULL;
+    }
+    if (buf) {
+        buf[length] = '\0';
+        // 去掉末尾换行，便于嵌入汇总报告
+        while (length > 0 && (buf[length - 1] == '\n' || buf[length - 1] == '\r')) {
+            buf[--length] = '\0';
+        }
+    }
+    fclose(file);
+    return buf;
+}
+
+static void finish_run(sweep_run_t *run, int exit_code) {
+    run->done = true;
+    run->exit_code = exit_code;
+    run->json = load_file(run->json_file);
+    if (!cfg.keep) {
+        remove(run->json_file);
+    }
+}
+
+static int run_all(void) {
+    proc_t procs[SWEEP_MAX_JOBS];
+    uint32_t slots[SWEEP_MAX_JOBS];
+    uint32_t active = 0;
+    uint32_t next = 0;
+    uint32_t finished = 0;
+
+    while (finished < run_count) {
+        while (active < cfg.jobs && next < run_count) {
+            if (spawn_run(&runs[next], &procs[active]) != 0) {
+                printf("Failed to start %s\n", cfg.bench_path);
+                finish_run(&runs[next], -1);
+                finished++;
+                next++;
+                continue;
+            }
+            slots[active++] = next++;
+        }
+        if (active == 0) {
+            continue;
+        }
+        int exit_code;
+        int slot = wait_any(procs, active, &exit_code);
+        if (slot < 0) {
+            printf("Lost track of child processes\n");
+            return -1;
+        }
+        finish_run(&runs[slots[slot]], exit_code);
+        finished++;
+        // 后面的进程依次前移（Windows按启动顺序等待，需要保持顺序）
+        for (uint32_t i = (uint32_t)slot; i + 1 < active; i++) {
+            procs[i] = procs[i + 1];
+            slots[i] = slots[i + 1];
+        }
+        active--;
+        if (finished % 16 == 0 || finished == run_count) {
+            printf("\r%u/%u runs", finished, run_count);
+            fflush(stdout);
+        }
+    }
+    printf("\n");
+    return 0;
+}
+
+// ===== 结果解析（只解析fast_flash_bench写出的固定格式） =====
+static double json_number(const char *obj, const char *end, const char *key) {
+    char pattern[40];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(obj, pattern);
+    if (!p || p > end) {
+        return 0;
+    }
+    return strtod(p + strlen(pattern), NULL);
+}
+
+static int parse_points(const char *json, sweep_point_t *points) {
+    int count = 0;
+    const char *p = json ? strstr(json, "\"results\":[") : NULL;
+    while (p && count < SWEEP_MAX_POINTS && (p = strstr(p, "{\"workload\":\"")) != NULL) {
+        const char *end = strchr(p, '}');
+        if (!end) {
+            break;
+        }
+        sweep_point_t *pt = &points[count];
+        memset(pt, 0, sizeof(*pt));
+        // {"workload":"name","param":value,...
+        const char *name = p + strlen("{\"workload\":\"");
+        if (sscanf(name, "%15[^\"]\",\"%15[^\"]\":%lf", pt->workload, pt->param_name, &pt->param) != 3) {
+            break;
+        }
+        pt->ops = (uint32_t)json_number(p, end, "ops");
+        pt->failed = (uint32_t)json_number(p, end, "failed");
+        pt->device_us_per_op = json_number(p, end, "device_us_per_op");
+        pt->p99_us = json_number(p, end, "p99_us");
+        pt->erase_bytes = json_number(p, end, "erase_bytes");
+        pt->write_amplification = json_number(p, end, "write_amplification");
+        pt->energy_uj_per_op = json_number(p, end, "energy_uj_per_op");
+        count++;
+        p = end;
+    }
+    return count;
+}
+
+// ===== 汇总：同一配置、同一工作负载点在不同种子上的平均值 =====
+typedef struct {
+    int      config_id;
+    const sweep_run_t *first;                // 配置参数取自第一次运行
+    sweep_point_t point;                     // 累加值
+    double   p99_max;
+    uint32_t samples;
+} sweep_summary_t;
+
+static sweep_summary_t *summary = NULL;
+static uint32_t summary_count = 0;
+static uint32_t broken_runs = 0;            // 没有产生结果的运行
+
+static int aggregate(void) {
+    static sweep_point_t points[SWEEP_MAX_POINTS];
+    summary = calloc((size_t)run_count * SWEEP_MAX_POINTS, sizeof(sweep_summary_t));
+    if (!summary) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < run_count; i++) {
+        const sweep_run_t *run = &runs[i];
+        int count = parse_points(run->json, points);
+        if (count == 0) {
+            broken_runs++;
+            continue;
+        }
+        for (int j = 0; j < count; j++) {
+            const sweep_point_t *pt = &points[j];
+            sweep_summary_t *s = NULL;
+            for (uint32_t k = 0; k < summary_count; k++) {
+                if (summary[k].config_id == run->config_id && strcmp(summary[k].point.workload, pt->workload) == 0 &&
+                    strcmp(summary[k].point.param_name, pt->param_name) == 0 && summary[k].point.param == pt->param) {
+                    s = &summary[k];
+                    break;
+                }
+            }
+            if (!s) {
+                s = &summary[summary_count++];
+                s->config_id = run->config_id;
+                s->first = run;
+                memcpy(s->point.workload, pt->workload, sizeof(pt->workload));
+                memcpy(s->point.param_name, pt->param_name, sizeof(pt->param_name));
+                s->point.param = pt->param;
+            }
+            s->samples++;
+            s->point.ops += pt->ops;
+            s->point.failed += pt->failed;
+            s->point.device_us_per_op += pt->device_us_per_op;
+            s->point.p99_us += pt->p99_us;
+            s->point.erase_bytes += pt->erase_bytes;
+            s->point.write_amplification += pt->write_amplification;
+            s->point.energy_uj_per_op += pt->energy_uj_per_op;
+            if (pt->p99_us > s->p99_max) {
+                s->p99_max = pt->p99_us;
+            }
+        }
+    }
+    return 0;
+}
+
+// ===== 输出 =====
+static void print_summary(double wall_s) {
+    printf("\n%-6s %-6s %-6s %-6s %-10s %-8s %-11s %5s %7s %11s %10s %10s %10s %9s %7s\n",
+           "cap_KB", "sector", "record", "tables", "profile", "workload", "param", "seeds", "failed",
+           "dev_us/op", "p99_us", "p99_max", "erase_KB", "uJ/op", "WA");
+    for (uint32_t i = 0; i < summary_count; i++) {
+        const sweep_summary_t *s = &summary[i];
+        double n = s->samples;
+        char param[32];
+        snprintf(param, sizeof(param), "%s=%g", s->point.param_name, s->point.param);
+        printf("%-6u %-6u %-6u %-6u %-10s %-8s %-11s %5u %7u %11.1f %10.0f %10.0f %10.1f %9.1f %7.2f\n",
+               s->first->capacity, s->first->sector, s->first->record_size, s->first->tables, s->first->profile,
+               s->point.workload, param, s->samples, s->point.failed, s->point.device_us_per_op / n,
+               s->point.p99_us / n, s->p99_max, s->point.erase_bytes / n / 1024, s->point.energy_uj_per_op / n,
+               s->point.write_amplification / n);
+    }
+    printf("\n%u runs (%u configurations x %u seeds), %u jobs, %.1f s wall time",
+           run_count, run_count / cfg.seeds, cfg.seeds, cfg.jobs, wall_s);
+    if (broken_runs) {
+        printf(", %u runs produced no results", broken_runs);
+    }
+    printf("\n");
+}
+
+static void write_json(FILE *out, double wall_s) {
+    fprintf(out, "{\"schema\":%d,\"config\":{\"runs\":%u,\"seeds\":%u,\"jobs\":%u,\"quick\":%s,\"wall_s\":%.2f},\n\"summary\":[",
+            SWEEP_SCHEMA_VERSION, run_count, cfg.seeds, cfg.jobs, cfg.quick ? "true" : "false", wall_s);
+    for (uint32_t i = 0; i < summary_count; i++) {
+        const sweep_summary_t *s = &summary[i];
+        double n = s->samples;
+        fprintf(out, "%s\n{\"capacity\":%u,\"sector_size\":%u,\"record_size\":%u,\"tables\":%u,\"profile\":\"%s\","
+                     "\"workload\":\"%s\",\"%s\":%g,\"seeds\":%u,\"ops\":%u,\"failed\":%u,\"device_us_per_op\":%.2f,"
+                     "\"p99_us\":%.1f,\"p99_max_us\":%.0f,\"erase_bytes\":%.0f,\"energy_uj_per_op\":%.3f,"
+                     "\"write_amplification\":%.3f}",
+                i ? "," : "", s->first->capacity * 1024, s->first->sector, s->first->record_size, s->first->tables,
+                s->first->profile, s->point.workload, s->point.param_name, s->point.param, s->samples, s->point.ops,
+                s->point.failed, s->point.device_us_per_op / n, s->point.p99_us / n, s->p99_max,
+                s->point.erase_bytes / n, s->point.energy_uj_per_op / n, s->point.write_amplification / n);
+    }
+    fprintf(out, "\n],\n\"runs\":[");
+    for (uint32_t i = 0; i < run_count; i++) {
+        const sweep_run_t *run = &runs[i];
+        fprintf(out, "%s\n{\"index\":%u,\"config_id\":%d,\"seed\":%u,\"exit_code\":%d,\"bench\":%s}",
+                i ? "," : "", i, run->config_id, run->seed, run->exit_code, run->json ? run->json : "null");
+    }
+    fprintf(out, "\n]}\n");
+}
+
+int main(int argc, char **argv) {
+    if (parse_args(argc, argv) != 0) {
+        return -1;
+    }
+    if (build_grid() != 0) {
+        return -1;
+    }
+
+    printf("Fast Flash Sweep (%u runs, %u jobs, %s)\n", run_count, cfg.jobs, cfg.bench_path);
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+    int rc = run_all();
+    timespec_get(&end, TIME_UTC);
+    double wall_s = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (rc == 0) {
+        rc = aggregate();
+    }
+    if (rc == 0) {
+        print_summary(wall_s);
+        if (cfg.json_path) {
+            FILE *out = strcmp(cfg.json_path, "-") == 0 ? stdout : fopen(cfg.json_path, "w");
+            if (!out) {
+                printf("Failed to open %s\n", cfg.json_path);
+                rc = -1;
+            } else {
+                write_json(out, wall_s);
+                if (out != stdout) {
+                    fclose(out);
+                }
+            }
+        }
+    }
+
+    // 工作负载中的failed（如GC放弃数据）只在报告中体现；没有产生结果的运行（配置无效、崩溃）才算失败
+    if (broken_runs) {
+        rc = -1;
+    }
+    for (uint32_t i = 0; i < run_count; i++) {
+        free(runs[i].json);
+    }
+    free(runs);
+    free(summary);
+    return rc;
+}
@@ -1,9 +1,51 @@
 #include "../core/fast_flash_core.h"
-#include "flash_adapter_win.h"
 #include "../core/fast_flash_log.h"
+#include "../core/fast_flash_prof.h"
+#include "../core/fast_flash_trace.h"
+#include "../core/fast_flash_record.h"
+
+// 测试套件可以运行在Windows模拟器或POSIX模拟器上（定义FAST_FLASH_PORT_POSIX时使用port_posix）
+#ifdef FAST_FLASH_PORT_POSIX
+#include "../port_posix/flash_adapter_posix.h"
+#define SIM_FLASH_TOTAL_SIZE        POSIX_FLASH_TOTAL_SIZE
+#define SIM_FLASH_FILE_NAME         POSIX_FLASH_FILE_NAME
+#define sim_flash_ops               posix_flash_ops
+#define sim_flash_geometry          posix_flash_geometry
+#define sim_flash_init              posix_flash_init
+#define sim_flash_read              posix_flash_read
+#define sim_flash_reset             posix_flash_reset
+#define sim_flash_sync              posix_flash_sync
+#define sim_flash_perf_stats_t      posix_flash_perf_stats_t
+#define sim_flash_get_perf_stats    posix_flash_get_perf_stats
+#define sim_flash_reset_perf_stats  posix_flash_reset_perf_stats
+#define sim_flash_print_perf_stats  posix_flash_print_perf_stats
+#define sim_flash_write_perf_stats_json posix_flash_write_perf_stats_json
+#define sim_get_time_ms             posix_get_time_ms
+#else
+#include "flash_adapter_win.h"
+#define SIM_FLASH_TOTAL_SIZE        WIN_FLASH_TOTAL_SIZE
+#define SIM_FLASH_FILE_NAME         WIN_FLASH_FILE_NAME
+#define sim_flash_ops               win_flash_ops
+#define sim_flash_geometry          win_flash_geometry
+#define sim_flash_init              win_flash_init
+#define sim_flash_read              win_flash_read
+#define sim_flash_reset             win_flash_reset
+#define sim_flash_sync              win_flash_sync
+#define sim_flash_perf_stats_t      win_flash_perf_stats_t
+#define sim_flash_get_perf_stats    win_flash_get_perf_stats
+#define sim_flash_reset_perf_stats  win_flash_reset_perf_stats
+#define sim_flash_print_perf_stats  win_flash_print_perf_stats
+#define sim_flash_write_perf_stats_json win_flash_write_perf_stats_json
+#define sim_get_time_ms             get_time_ms
+#endif
+#include "../port_common/flash_sim_timing.h"
+#include "../port_common/flash_sim_latency.h"
+#include "../port_common/flash_sim_fault.h"
+#include "../port_common/flash_sim_mem.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 // 测试用的数据结构
 typedef struct {
@@ -186,7 +228,7 @@ int test_persistence(void) {
     uint32_t original_used_size = fast_flash_get_used_size();
     
     // 重新初始化（模拟重启）
-    if (fast_flash_init(&win_flash_ops, WIN_FLASH_TOTAL_SIZE, false) != 0) {
+    if (fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, false) != 0) {
         printf("Failed to reinitialize flash\n");
         return -1;
     }
@@ -494,8 +536,8 @@ int test_new_table_management_functions(void) {
     print_test_data(&current_data);
     
     // 记录当前写入操作次数
-    win_flash_perf_stats_t stats_before;
-    win_flash_get_perf_stats(&stats_before);
+    sim_flash_perf_stats_t stats_before;
+    sim_flash_get_perf_stats(&stats_before);
     printf("Write operations before identical write: %u\n", stats_before.write_operations);
     
     // 尝试写入与当前数据完全相同的数据
@@ -506,8 +548,8 @@ int test_new_table_management_functions(void) {
     }
     
     // 检查写入操作次数是否没有增加（说明优化生效）
-    win_flash_perf_stats_t stats_after;
-    win_flash_get_perf_stats(&stats_after);
+    sim_flash_perf_stats_t stats_after;
+    sim_flash_get_perf_stats(&stats_after);
     printf("Write operations after identical write: %u\n", stats_after.write_operations);
     
     if (stats_after.write_operations != stats_before.write_operations) {
@@ -523,7 +565,7 @@ int test_new_table_management_functions(void) {
     // 测试8：写入不同数据时应该正常执行
     printf("\n--- Test 8: Normal write with different data ---\n");
     
-    win_flash_get_perf_stats(&stats_before);
+    sim_flash_get_perf_stats(&stats_before);
     
     test_data_t different_data = {700, "DifferentData", 333.33f, true};
     result = fast_flash_write_table_data_by_index("MGRTEST", 1, &different_data, sizeof(test_data_t));
@@ -532,7 +574,7 @@ int test_new_table_management_functions(void) {
         return -1;
     }
     
-    win_flash_get_perf_stats(&stats_after);
+    sim_flash_get_perf_stats(&stats_after);
     
     if (stats_after.write_operations <= stats_before.write_operations) {
         printf("Write operations did not increase for different data, got %u\n", 
@@ -613,7 +655,7 @@ int test_clear_table_data_function(void) {
     uint64_t clear_mask = (1ULL << 1) | (1ULL << 3);  // 清除索引1和3
     int result = fast_flash_clear_table_data("CLEART", clear_mask);
     if (result != 0) {
-        printf("Failed to clear data with mask 0x%016llX\n", clear_mask);
+        printf("Failed to clear data with mask 0x%016llX\n", (unsigned long long)clear_mask);
         return -1;
     }
     
@@ -713,7 +755,7 @@ int test_clear_table_data_function(void) {
     uint64_t invalid_mask = (1ULL << 10);  // 尝试清除第10个index（不存在）
     result = fast_flash_clear_table_data("BATCHTE", invalid_mask);
     if (result != -2) {  // 期望返回超出范围错误
-        printf("Expected out of range error (-2) for mask 0x%016llX, got %d\n", invalid_mask, result);
+        printf("Expected out of range error (-2) for mask 0x%016llX, got %d\n", (unsigned long long)invalid_mask, result);
         return -1;
     }
     printf("Out of range clear test passed, correctly returned error %d\n", result);
@@ -924,7 +966,7 @@ int test_batch_write_function(void) {
     }
     
     // 重置性能统计
-    win_flash_reset_perf_stats();
+    sim_flash_reset_perf_stats();
     
     // 批量写入10条数据
     test_data_t perf_batch_data[10];
@@ -935,9 +977,9 @@ int test_batch_write_function(void) {
         perf_batch_data[i].active = (i % 2 == 0);
     }
     
-    uint32_t start_time = get_time_ms();
+    uint32_t start_time = sim_get_time_ms();
     result = fast_flash_write_table_data_batch("PERFTST", perf_batch_data, sizeof(test_data_t), 10);
-    uint32_t batch_time = get_time_ms() - start_time;
+    uint32_t batch_time = sim_get_time_ms() - start_time;
     
     if (result != 0) {
         printf("Failed to perform batch write for performance test\n");
@@ -981,6 +1023,2194 @@ int test_batch_write_function(void) {
     return 0;
 }
 
+int test_table_placement_classes(void) {
+    printf("\n=== Testing Hot/Cold Table Placement ===\n");
+
+    // 无效标志应被拒绝
+    if (fast_flash_create_table_ex("BADFLAG", sizeof(uint32_t), 4, 0x80) != -1) {
+        printf("Expected invalid flags to be rejected\n");
+        return -1;
+    }
+
+    if (fast_flash_create_table_ex("CALIB", sizeof(uint32_t), 8, FF_TABLE_COLD) != 0 ||
+        fast_flash_create_table_ex("HISTORY", sizeof(sensor_data_t), 8, FF_TABLE_APPEND_ONLY) != 0 ||
+        fast_flash_create_table_ex("COUNTER", sizeof(uint32_t), 4, FF_TABLE_HOT) != 0) {
+        printf("Failed to create placement test tables\n");
+        return -1;
+    }
+
+    uint32_t calib_values[] = {11, 22, 33};
+    for (int i = 0; i < 3; i++) {
+        if (fast_flash_write_table_data("CALIB", &calib_values[i], sizeof(uint32_t)) != 0) {
+            printf("Failed to write CALIB item %d\n", i);
+            return -1;
+        }
+    }
+
+    sensor_data_t history_items[] = {
+        {2000, 20.5f, 40, 1},
+        {2001, 21.0f, 41, 1}
+    };
+    for (int i = 0; i < 2; i++) {
+        if (fast_flash_append_table_data("HISTORY", &history_items[i], sizeof(sensor_data_t)) != 0) {
+            printf("Failed to append HISTORY item %d\n", i);
+            return -1;
+        }
+    }
+
+    uint32_t counter = 0;
+    if (fast_flash_write_table_data("COUNTER", &counter, sizeof(counter)) != 0) {
+        printf("Failed to write COUNTER\n");
+        return -1;
+    }
+    for (counter = 1; counter <= 5; counter++) {
+        if (fast_flash_write_table_data_by_index("COUNTER", 0, &counter, sizeof(counter)) != 0) {
+            printf("Failed to update COUNTER to %u\n", counter);
+            return -1;
+        }
+    }
+
+    // 不同温度类别的表应位于不同扇区
+    flash_table_t calib_info, history_info, counter_info;
+    if (fast_flash_get_table_info("CALIB", &calib_info) != 0 ||
+        fast_flash_get_table_info("HISTORY", &history_info) != 0 ||
+        fast_flash_get_table_info("COUNTER", &counter_info) != 0) {
+        printf("Failed to get placement table info\n");
+        return -1;
+    }
+    printf("CALIB at 0x%08X, HISTORY at 0x%08X, COUNTER at 0x%08X\n",
+           calib_info.addr, history_info.addr, counter_info.addr);
+    if (calib_info.addr / FLASH_SECTOR_SIZE == counter_info.addr / FLASH_SECTOR_SIZE ||
+        history_info.addr / FLASH_SECTOR_SIZE == counter_info.addr / FLASH_SECTOR_SIZE ||
+        calib_info.addr / FLASH_SECTOR_SIZE == history_info.addr / FLASH_SECTOR_SIZE) {
+        printf("Tables of different classes share a sector\n");
+        return -1;
+    }
+    if (calib_info.flags != FF_TABLE_COLD || history_info.flags != FF_TABLE_APPEND_ONLY) {
+        printf("Table flags not reported correctly\n");
+        return -1;
+    }
+
+    // 只追加的表不允许按索引修改和清除
+    if (fast_flash_write_table_data_by_index("HISTORY", 0, &history_items[1], sizeof(sensor_data_t)) != -1 ||
+        fast_flash_clear_table_data("HISTORY", 0x1) != -1) {
+        printf("Append-only table accepted a rewrite\n");
+        return -1;
+    }
+
+    // GC后冷数据表已整理到位，再次GC时不应搬运
+    fast_flash_set_erase_allowed(true);
+    if (fast_flash_gc() != 0) {
+        printf("First placement GC failed\n");
+        return -1;
+    }
+    fast_flash_get_table_info("CALIB", &calib_info);
+
+    for (counter = 6; counter <= 10; counter++) {
+        if (fast_flash_write_table_data_by_index("COUNTER", 0, &counter, sizeof(counter)) != 0) {
+            printf("Failed to update COUNTER to %u after GC\n", counter);
+            return -1;
+        }
+    }
+
+    if (fast_flash_gc() != 0) {
+        printf("Second placement GC failed\n");
+        return -1;
+    }
+
+    flash_table_t calib_after;
+    fast_flash_get_table_info("CALIB", &calib_after);
+    if (calib_after.addr != calib_info.addr) {
+        printf("Cold table moved by GC: 0x%08X -> 0x%08X\n", calib_info.addr, calib_after.addr);
+        return -1;
+    }
+
+    // 重启后标志和数据保持
+    if (fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true) != 0) {
+        printf("Failed to reinitialize flash\n");
+        return -1;
+    }
+    if (fast_flash_get_table_info("HISTORY", &history_info) != 0 || history_info.flags != FF_TABLE_APPEND_ONLY) {
+        printf("HISTORY flags lost after restart\n");
+        return -1;
+    }
+    const char *names[] = {"CALIB", "HISTORY", "COUNTER", "TEST", "SENSOR"};
+    for (int i = 0; i < 5; i++) {
+        if (fast_flash_validate_table_data(names[i]) != 0) {
+            printf("%s table corrupted after placement GC\n", names[i]);
+            return -1;
+        }
+    }
+    if (fast_flash_read_table_data("COUNTER", 0, &counter, sizeof(counter)) != 0 || counter != 10) {
+        printf("COUNTER value wrong after restart: %u\n", counter);
+        return -1;
+    }
+
+    printf("Hot/cold table placement test passed!\n");
+    return 0;
+}
+
+int test_block_erase_coalescing(void) {
+    printf("\n=== Testing Block Erase Coalescing ===\n");
+
+    // 非扇区整数倍的擦除粒度应被拒绝
+    flash_geometry_t bad_geometry = { .erase_sizes = { 4 * 1024, 6 * 1024, 0 } };
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &bad_geometry) != -1) {
+        printf("Expected invalid geometry to be rejected\n");
+        return -1;
+    }
+
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to reinitialize flash with block erase geometry\n");
+        return -1;
+    }
+
+    // 反复改写一张大表直到Flash写满，使整理区之后的扇区都变脏
+    uint8_t record[512];
+    memset(record, 0x5A, sizeof(record));
+    if (fast_flash_create_table("BULK", sizeof(record), 6) != 0) {
+        printf("Failed to create BULK table\n");
+        return -1;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (fast_flash_write_table_data("BULK", record, sizeof(record)) != 0) {
+            printf("Failed to write BULK record %d\n", i);
+            return -1;
+        }
+    }
+    int result = 0;
+    for (int i = 0; i < 32 && result == 0; i++) {
+        record[0] = (uint8_t)i;
+        result = fast_flash_write_table_data_by_index("BULK", i % 6, record, sizeof(record));
+    }
+    if (result != -2) {
+        printf("Expected flash to fill up, got %d\n", result);
+        return -1;
+    }
+
+    sim_flash_perf_stats_t before, after;
+    sim_flash_get_perf_stats(&before);
+    if (fast_flash_gc() != 0) {
+        printf("GC failed on full flash\n");
+        return -1;
+    }
+    sim_flash_get_perf_stats(&after);
+
+    uint32_t erase_ops = after.erase_operations - before.erase_operations;
+    uint32_t erased = after.bytes_erased - before.bytes_erased;
+    printf("GC erased %u bytes in %u operations\n", erased, erase_ops);
+    if (erase_ops == 0 || erased / erase_ops <= FLASH_SECTOR_SIZE) {
+        printf("GC did not use any block erase\n");
+        return -1;
+    }
+
+    if (fast_flash_validate_table_data("BULK") != 0 || fast_flash_validate_table_data("CALIB") != 0) {
+        printf("Table corrupted after block erase GC\n");
+        return -1;
+    }
+
+    if (fast_flash_delete_table("BULK") != 0) {
+        printf("Failed to delete BULK table\n");
+        return -1;
+    }
+
+    printf("Block erase coalescing test passed!\n");
+    return 0;
+}
+
+int test_runtime_geometry(void) {
+    printf("\n=== Testing Runtime Geometry ===\n");
+
+    // 8字节编程粒度、256字节编程页、最多4张表
+    flash_geometry_t small_geometry = {
+        .page_size = 256,
+        .write_granularity = 8,
+        .max_tables = 4,
+        .erase_sizes = { 4 * 1024, 32 * 1024, 64 * 1024, 0 },
+    };
+
+    flash_geometry_t bad_geometry = small_geometry;
+    bad_geometry.write_granularity = 6;
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &bad_geometry) != -1) {
+        printf("Expected non power-of-two granularity to be rejected\n");
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &small_geometry) != 0) {
+        printf("Failed to initialize flash with small geometry\n");
+        return -1;
+    }
+
+    // 结构体大小为奇数，表起始地址仍须按编程粒度对齐
+    const char *names[] = { "G0", "G1", "G2", "G3" };
+    uint8_t record[5];
+    for (int t = 0; t < 4; t++) {
+        if (fast_flash_create_table(names[t], sizeof(record), 8) != 0) {
+            printf("Failed to create table %s\n", names[t]);
+            return -1;
+        }
+        for (int i = 0; i < 3; i++) {
+            memset(record, t * 16 + i, sizeof(record));
+            if (fast_flash_append_table_data(names[t], record, sizeof(record)) != 0) {
+                printf("Failed to append to table %s\n", names[t]);
+                return -1;
+            }
+        }
+    }
+
+    if (fast_flash_create_table("G4", sizeof(record), 8) == 0) {
+        printf("Expected fifth table to be rejected with max_tables = 4\n");
+        return -1;
+    }
+
+    memset(record, 0xA5, sizeof(record));
+    if (fast_flash_write_table_data_by_index("G1", 1, record, sizeof(record)) != 0 ||
+        fast_flash_gc() != 0) {
+        printf("Failed to update table or run GC with small geometry\n");
+        return -1;
+    }
+
+    // 重新挂载后数据保持不变
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &small_geometry) != 0) {
+        printf("Failed to remount with small geometry\n");
+        return -1;
+    }
+    for (int t = 0; t < 4; t++) {
+        flash_table_t info;
+        if (fast_flash_get_table_info(names[t], &info) != 0 || info.addr % 8 != 0 ||
+            fast_flash_validate_table_data(names[t]) != 0) {
+            printf("Table %s misaligned or corrupted\n", names[t]);
+            return -1;
+        }
+    }
+    uint8_t readback[5];
+    if (fast_flash_read_table_data("G1", 1, readback, sizeof(readback)) != 0 ||
+        memcmp(readback, record, sizeof(record)) != 0) {
+        printf("Updated record lost after remount\n");
+        return -1;
+    }
+
+    // 几何参数不一致时不能挂载（也不能当作空白设备重新格式化）
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != -1) {
+        printf("Expected mount with mismatched geometry to fail\n");
+        return -1;
+    }
+
+    // 恢复默认几何参数
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore default geometry\n");
+        return -1;
+    }
+
+    printf("Runtime geometry test passed!\n");
+    return 0;
+}
+
+// 表数据大于流式缓冲区时，追加/改写/清除/批量写入/GC都应分段搬运且数据与CRC正确
+static int check_stream_table(const char *name, const uint8_t *shadow, uint32_t struct_size, uint32_t count) {
+    uint8_t readback[300];
+    if (fast_flash_get_table_count(name) != count || fast_flash_validate_table_data(name) != 0) {
+        printf("Table %s count or CRC mismatch\n", name);
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (fast_flash_read_table_data(name, i, readback, struct_size) != 0 ||
+            memcmp(readback, shadow + i * struct_size, struct_size) != 0) {
+            printf("Table %s record %u mismatch\n", name, i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int test_streaming_relocation(void) {
+    printf("\n=== Testing Streaming Relocation ===\n");
+
+    // 8字节编程粒度：表头尾部与数据开头共用编程单位
+    flash_geometry_t geometry = {
+        .page_size = 256,
+        .write_granularity = 8,
+        .max_tables = 4,
+        .erase_sizes = { 4 * 1024, 32 * 1024, 64 * 1024, 0 },
+    };
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &geometry) != 0) {
+        printf("Failed to initialize flash for streaming test\n");
+        return -1;
+    }
+
+    // 小记录、多条：整表远大于流式缓冲区
+    enum { SMALL = 37, SMALL_MAX = 64 };
+    static uint8_t small[SMALL * SMALL_MAX];
+    uint32_t count = 0;
+    if (fast_flash_create_table("STRM", SMALL, SMALL_MAX) != 0) {
+        printf("Failed to create table STRM\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < 30; i++) {
+        for (uint32_t b = 0; b < SMALL; b++) {
+            small[count * SMALL + b] = (uint8_t)(i * 7 + b);
+        }
+        if (fast_flash_append_table_data("STRM", small + count * SMALL, SMALL) != 0) {
+            printf("Failed to append record %u\n", i);
+            return -1;
+        }
+        count++;
+    }
+
+    memset(small + 17 * SMALL, 0x5A, SMALL);
+    if (fast_flash_write_table_data_by_index("STRM", 17, small + 17 * SMALL, SMALL) != 0) {
+        printf("Failed to update record 17\n");
+        return -1;
+    }
+
+    // 清除分散的记录，保留的记录分成多段
+    uint64_t clear_mask = (1ULL << 0) | (1ULL << 3) | (1ULL << 4) | (1ULL << 12) | (1ULL << 29);
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!(clear_mask & (1ULL << i))) {
+            memmove(small + kept * SMALL, small + i * SMALL, SMALL);
+            kept++;
+        }
+    }
+    count = kept;
+    if (fast_flash_clear_table_data("STRM", clear_mask) != 0) {
+        printf("Failed to clear records\n");
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < 10; i++) {
+        memset(small + (count + i) * SMALL, 0xC0 + i, SMALL);
+    }
+    if (fast_flash_write_table_data_batch("STRM", small + count * SMALL, SMALL, 10) != 0) {
+        printf("Failed to batch write records\n");
+        return -1;
+    }
+    count += 10;
+    if (check_stream_table("STRM", small, SMALL, count) != 0) {
+        return -1;
+    }
+
+    // 单条记录大于流式缓冲区
+    enum { LARGE = 300, LARGE_MAX = 8 };
+    static uint8_t large[LARGE * LARGE_MAX];
+    if (fast_flash_create_table("WIDE", LARGE, LARGE_MAX) != 0) {
+        printf("Failed to create table WIDE\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < 4; i++) {
+        for (uint32_t b = 0; b < LARGE; b++) {
+            large[i * LARGE + b] = (uint8_t)(i + b * 3);
+        }
+        if (fast_flash_append_table_data("WIDE", large + i * LARGE, LARGE) != 0) {
+            printf("Failed to append wide record %u\n", i);
+            return -1;
+        }
+    }
+    flash_table_t before, after;
+    fast_flash_get_table_info("WIDE", &before);
+    if (fast_flash_write_table_data_by_index("WIDE", 2, large + 2 * LARGE, LARGE) != 0 ||
+        fast_flash_get_table_info("WIDE", &after) != 0 || after.addr != before.addr) {
+        printf("Identical wide record should not be rewritten\n");
+        return -1;
+    }
+    large[2 * LARGE + LARGE - 1] ^= 0xFF;
+    if (fast_flash_write_table_data_by_index("WIDE", 2, large + 2 * LARGE, LARGE) != 0 ||
+        fast_flash_clear_table_data("WIDE", 1ULL << 1) != 0) {
+        printf("Failed to update or clear wide table\n");
+        return -1;
+    }
+    memmove(large + LARGE, large + 2 * LARGE, 2 * LARGE);
+
+    if (fast_flash_gc() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &geometry) != 0 ||
+        check_stream_table("STRM", small, SMALL, count) != 0 ||
+        check_stream_table("WIDE", large, LARGE, 3) != 0) {
+        printf("Streamed tables corrupted after GC and remount\n");
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore default geometry\n");
+        return -1;
+    }
+
+    printf("Streaming relocation test passed!\n");
+    return 0;
+}
+
+// 不使用堆的构建（FAST_FLASH_NO_HEAP）中，测试默认使用的内存区：最多分区数、默认表数量
+#ifdef FAST_FLASH_NO_HEAP
+static uint8_t g_test_arena[FF_ARENA_SIZE(FF_MAX_PARTITIONS, MAX_TABLES_ALL_SECTOR, SIM_FLASH_TOTAL_SIZE, FLASH_SECTOR_SIZE)];
+#endif
+
+static void restore_default_arena(void) {
+#ifdef FAST_FLASH_NO_HEAP
+    fast_flash_set_arena(g_test_arena, sizeof(g_test_arena));
+#else
+    fast_flash_set_arena(NULL, 0);
+#endif
+}
+
+int test_static_arena(void) {
+    printf("\n=== Testing Static Arena ===\n");
+
+    // 编译期的上限必须覆盖运行时计算的需求
+    static uint8_t arena[FF_ARENA_SIZE(1, 8, SIM_FLASH_TOTAL_SIZE, FLASH_SECTOR_SIZE)];
+    flash_geometry_t geometry = sim_flash_geometry;
+    geometry.max_tables = 8;
+    flash_partition_t whole = { .offset = 0, .size = SIM_FLASH_TOTAL_SIZE };
+    uint32_t required = fast_flash_arena_size(&whole, 1, &geometry);
+    if (required == 0 || required > sizeof(arena)) {
+        printf("FF_ARENA_SIZE (%u) below required arena size (%u)\n", (unsigned)sizeof(arena), required);
+        return -1;
+    }
+
+    // 内存区不够时初始化失败
+    if (fast_flash_set_arena(arena, required - 8) != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &geometry) != -1) {
+        printf("Expected init with undersized arena to fail\n");
+        restore_default_arena();
+        return -1;
+    }
+
+    if (fast_flash_set_arena(arena, sizeof(arena)) != 0 || sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &geometry) != 0) {
+        printf("Failed to initialize flash with static arena\n");
+        restore_default_arena();
+        return -1;
+    }
+    uint32_t mounted_used, used, peak;
+    fast_flash_get_arena_usage(&mounted_used, NULL);
+
+    const char *names[] = { "A0", "A1", "A2", "A3" };
+    uint32_t value = 0;
+    for (int t = 0; t < 4; t++) {
+        if (fast_flash_create_table(names[t], sizeof(value), 16) != 0) {
+            printf("Failed to create table %s\n", names[t]);
+            restore_default_arena();
+            return -1;
+        }
+    }
+    for (int round = 0; round < 200; round++) {
+        value = (uint32_t)round;
+        const char *name = names[round % 4];
+        int result = (fast_flash_get_table_count(name) < 8) ?
+                     fast_flash_append_table_data(name, &value, sizeof(value)) :
+                     fast_flash_write_table_data_by_index(name, round % 8, &value, sizeof(value));
+        if (result == -2) {
+            result = fast_flash_gc();
+            if (result == 0) {
+                round--;
+            }
+        }
+        if (result != 0) {
+            printf("Write failed at round %d\n", round);
+            restore_default_arena();
+            return -1;
+        }
+    }
+    if (fast_flash_gc() != 0) {
+        printf("GC failed with static arena\n");
+        restore_default_arena();
+        return -1;
+    }
+
+    // GC的临时数组结束后归还，峰值不超过初始化时检查的大小
+    fast_flash_get_arena_usage(&used, &peak);
+    if (used != mounted_used || peak > required) {
+        printf("Arena usage wrong: used=%u (mounted %u) peak=%u required=%u\n", used, mounted_used, peak, required);
+        restore_default_arena();
+        return -1;
+    }
+
+    // 用同一块内存区重新挂载
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &geometry) != 0) {
+        printf("Failed to remount with static arena\n");
+        restore_default_arena();
+        return -1;
+    }
+    for (int t = 0; t < 4; t++) {
+        if (fast_flash_get_table_count(names[t]) != 8 || fast_flash_validate_table_data(names[t]) != 0) {
+            printf("Table %s lost after remount\n", names[t]);
+            restore_default_arena();
+            return -1;
+        }
+    }
+
+    restore_default_arena();
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore default configuration\n");
+        return -1;
+    }
+
+    printf("Static arena test passed!\n");
+    return 0;
+}
+
+// 器件内部复制：测试中用读出再写入模拟控制器的复制，只统计调用次数
+static uint32_t g_device_copies = 0;
+
+static int test_device_copy_op(uint32_t dst, uint32_t src, uint32_t size) {
+    uint8_t buf[1024];
+    if (size > sizeof(buf) || sim_flash_read(src, buf, size) != 0) {
+        return -1;
+    }
+    g_device_copies++;
+    return sim_flash_ops.write(dst, buf, size);
+}
+
+// 同一负载分别在有/没有复制操作的器件上运行，结果应完全一致
+static int run_copy_workload(const flash_ops_t *ops, const flash_geometry_t *geometry,
+                             uint8_t *contents, flash_io_stats_t *io) {
+    enum { RECORD = 37 };
+    uint8_t record[RECORD];
+    if (sim_flash_reset() != 0 || fast_flash_init_ex(ops, SIM_FLASH_TOTAL_SIZE, true, geometry) != 0 ||
+        fast_flash_create_table("CP", RECORD, 48) != 0) {
+        return -1;
+    }
+    fast_flash_reset_stats();
+
+    for (uint32_t i = 0; i < 24; i++) {
+        memset(record, (int)i, sizeof(record));
+        if (fast_flash_append_table_data("CP", record, sizeof(record)) != 0) {
+            return -1;
+        }
+    }
+    memset(record, 0xA5, sizeof(record));
+    if (fast_flash_write_table_data_by_index("CP", 0, record, sizeof(record)) != 0 ||
+        fast_flash_write_table_data_by_index("CP", 11, record, sizeof(record)) != 0 ||
+        fast_flash_write_table_data_by_index("CP", 23, record, sizeof(record)) != 0 ||
+        fast_flash_clear_table_data("CP", (1ULL << 2) | (1ULL << 3) | (1ULL << 15)) != 0) {
+        return -1;
+    }
+    uint8_t batch[RECORD * 4];
+    memset(batch, 0x3C, sizeof(batch));
+    if (fast_flash_write_table_data_batch("CP", batch, RECORD, 4) != 0 || fast_flash_gc() != 0 ||
+        fast_flash_validate_table_data("CP") != 0) {
+        return -1;
+    }
+    flash_stats_t stats;
+    fast_flash_get_stats(&stats);
+    *io = stats.total;
+
+    uint32_t count = fast_flash_get_table_count("CP");
+    if (count != 25) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (fast_flash_read_table_data("CP", i, contents + i * RECORD, RECORD) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int test_device_copy(void) {
+    printf("\n=== Testing Device Copy ===\n");
+
+    // 8字节编程粒度、奇数记录长度：复制区间两端的编程单位要由主机拼接
+    flash_geometry_t geometry = sim_flash_geometry;
+    geometry.page_size = 256;
+    geometry.write_granularity = 8;
+    geometry.max_tables = 4;
+
+    flash_ops_t copy_ops = sim_flash_ops;
+    copy_ops.copy = test_device_copy_op;
+
+    static uint8_t with_copy[37 * 25], without_copy[37 * 25];
+    flash_io_stats_t io_copy, io_host;
+    g_device_copies = 0;
+    if (run_copy_workload(&copy_ops, &geometry, with_copy, &io_copy) != 0 ||
+        run_copy_workload(&sim_flash_ops, &geometry, without_copy, &io_host) != 0) {
+        printf("Copy workload failed\n");
+        return -1;
+    }
+
+    if (memcmp(with_copy, without_copy, sizeof(with_copy)) != 0) {
+        printf("Device copy produced different table contents\n");
+        return -1;
+    }
+    // 复制的数据不经过主机：读取量和CRC计算量都应明显减少，编程量不变
+    if (g_device_copies == 0 || io_copy.read_bytes >= io_host.read_bytes || io_copy.crc_bytes >= io_host.crc_bytes ||
+        io_copy.data_bytes + io_copy.relocation_bytes != io_host.data_bytes + io_host.relocation_bytes) {
+        printf("Unexpected device copy stats: copies=%u read %llu/%llu crc %llu/%llu\n", g_device_copies,
+               (unsigned long long)io_copy.read_bytes, (unsigned long long)io_host.read_bytes,
+               (unsigned long long)io_copy.crc_bytes, (unsigned long long)io_host.crc_bytes);
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore default configuration\n");
+        return -1;
+    }
+
+    printf("Device copy test passed! (read %llu -> %llu bytes, crc %llu -> %llu bytes)\n",
+           (unsigned long long)io_host.read_bytes, (unsigned long long)io_copy.read_bytes,
+           (unsigned long long)io_host.crc_bytes, (unsigned long long)io_copy.crc_bytes);
+    return 0;
+}
+
+// 一次追加写入的管理表字节数
+static uint64_t append_metadata_bytes(const char *name, uint32_t value) {
+    flash_stats_t stats;
+    fast_flash_reset_stats();
+    if (fast_flash_append_table_data(name, &value, sizeof(value)) != 0 || fast_flash_get_stats(&stats) != 0) {
+        return 0;
+    }
+    return stats.per_api[FF_API_APPEND].metadata_bytes;
+}
+
+int test_manager_format(void) {
+    printf("\n=== Testing Compact Manager Table Format ===\n");
+
+    if (offsetof(flash_manager_table_t, tables) % 4 != 0 || sizeof(flash_table_info_t) % 4 != 0 ||
+        offsetof(flash_table_info_t, addr) % 4 != 0 || offsetof(flash_manager_table_t, crc) % 4 != 0) {
+        printf("Manager table fields are not naturally aligned\n");
+        return -1;
+    }
+
+    // 管理表只写表头和有效表项，删除的槽位不写入
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0 ||
+        fast_flash_create_table("F0", sizeof(uint32_t), 8) != 0 ||
+        fast_flash_create_table("F1", sizeof(uint32_t), 8) != 0 ||
+        fast_flash_create_table("F2", sizeof(uint32_t), 8) != 0) {
+        printf("Failed to create tables\n");
+        return -1;
+    }
+    uint64_t three = append_metadata_bytes("F0", 0xF0);
+    if (three != sizeof(flash_manager_table_t) + 3 * sizeof(flash_table_info_t)) {
+        printf("Manager table with 3 tables wrote %llu bytes\n", (unsigned long long)three);
+        return -1;
+    }
+    uint64_t two = 0;
+    if (fast_flash_delete_table("F1") != 0 ||
+        (two = append_metadata_bytes("F2", 0xF2)) != sizeof(flash_manager_table_t) + 2 * sizeof(flash_table_info_t)) {
+        printf("Manager table with a deleted slot wrote %llu bytes\n", (unsigned long long)two);
+        return -1;
+    }
+
+    uint32_t value = 0;
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0 ||
+        fast_flash_table_exists("F1") || fast_flash_get_table_count("F0") != 1 ||
+        fast_flash_read_table_data("F2", 0, &value, sizeof(value)) != 0 || value != 0xF2 ||
+        fast_flash_create_table("F3", sizeof(uint32_t), 8) != 0 || fast_flash_append_table_data("F3", &value, sizeof(value)) != 0) {
+        printf("Compact manager table not reloaded\n");
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore default configuration\n");
+        return -1;
+    }
+
+    printf("Manager format test passed! (%llu -> %llu bytes per save with 3 -> 2 tables)\n",
+           (unsigned long long)three, (unsigned long long)two);
+    return 0;
+}
+
+// 表数量超过一个目录页时管理表改为分页目录：每次创建只重写一个目录页和记录页地址的管理表
+#define LARGE_CATALOG_FLASH   (1024 * 1024)
+#define LARGE_CATALOG_TABLES  1024
+
+static int large_catalog_create(const char *name) {
+    int result = fast_flash_create_table(name, sizeof(uint32_t), 4);
+    if (result == -2 && fast_flash_gc() == 0) {
+        result = fast_flash_create_table(name, sizeof(uint32_t), 4);
+    }
+    return result;
+}
+
+static int large_catalog_append(const char *name, uint32_t value) {
+    int result = fast_flash_append_table_data(name, &value, sizeof(value));
+    if (result == -2 && fast_flash_gc() == 0) {
+        result = fast_flash_append_table_data(name, &value, sizeof(value));
+    }
+    return result;
+}
+
+static int large_catalog_run(const flash_geometry_t *geometry, uint64_t *max_create_bytes) {
+    char name[TABLE_NAME_MAX_LEN];
+    uint32_t value = 0;
+    if (flash_sim_mem_create(LARGE_CATALOG_FLASH, FLASH_SECTOR_SIZE) != 0 ||
+        fast_flash_init_ex(&flash_sim_mem_ops, LARGE_CATALOG_FLASH, true, geometry) != 0) {
+        printf("Failed to initialize large catalog\n");
+        return -1;
+    }
+
+    // 每次创建写入的元数据：新表所在的目录页（放到后面的页时还有散列页）和管理表，与已有表数量无关
+    uint32_t page_bytes = sizeof(flash_catalog_page_t) + FF_CATALOG_PAGE_TABLES * sizeof(flash_table_info_t);
+    uint32_t node_bytes = sizeof(flash_manager_table_t) + FF_CATALOG_PAGES(LARGE_CATALOG_TABLES) * sizeof(uint32_t);
+    for (uint32_t i = 0; i < 1000; i++) {
+        flash_stats_t stats;
+        snprintf(name, sizeof(name), "C%04u", (unsigned)i);
+        fast_flash_reset_stats();
+        if (large_catalog_create(name) != 0 || fast_flash_get_stats(&stats) != 0) {
+            printf("Failed to create table %s\n", name);
+            return -1;
+        }
+        if (stats.per_api[FF_API_GC].calls == 0 && stats.per_api[FF_API_CREATE_TABLE].metadata_bytes > *max_create_bytes) {
+            *max_create_bytes = stats.per_api[FF_API_CREATE_TABLE].metadata_bytes;
+        }
+        if (large_catalog_append(name, i) != 0) {
+            printf("Failed to append to table %s\n", name);
+            return -1;
+        }
+        // 每张表的最新副本分散在各扇区，写满后GC找不到暂存扇区，定期整理
+        if (i % 128 == 127 && fast_flash_gc() != 0) {
+            printf("GC failed after %u tables\n", (unsigned)i + 1);
+            return -1;
+        }
+    }
+    if (*max_create_bytes == 0 || *max_create_bytes > 2 * page_bytes + node_bytes) {
+        printf("Creating a table wrote %llu metadata bytes (limit %u)\n",
+               (unsigned long long)*max_create_bytes, 2 * page_bytes + node_bytes);
+        return -1;
+    }
+
+    // 删除每隔7张表中的一张，再用新名字填回空出的槽位
+    for (uint32_t i = 0; i < 1000; i += 7) {
+        snprintf(name, sizeof(name), "C%04u", (unsigned)i);
+        if (fast_flash_delete_table(name) != 0) {
+            printf("Failed to delete table %s\n", name);
+            return -1;
+        }
+    }
+    for (uint32_t i = 0; i < 1000; i += 7) {
+        snprintf(name, sizeof(name), "D%04u", (unsigned)i);
+        if (large_catalog_create(name) != 0 || large_catalog_append(name, i + 0xD000) != 0) {
+            printf("Failed to recreate table %s\n", name);
+            return -1;
+        }
+    }
+
+    // GC后重新挂载，按名字逐个查找
+    if (fast_flash_gc() != 0 || large_catalog_create("LAST") != 0 ||
+        fast_flash_init_ex(&flash_sim_mem_ops, LARGE_CATALOG_FLASH, true, geometry) != 0) {
+        printf("Failed to remount large catalog\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < 1000; i++) {
+        bool deleted = (i % 7 == 0);
+        snprintf(name, sizeof(name), "C%04u", (unsigned)i);
+        if (fast_flash_table_exists(name) == deleted) {
+            printf("Table %s %s after remount\n", name, deleted ? "reappeared" : "lost");
+            return -1;
+        }
+        if (deleted) {
+            snprintf(name, sizeof(name), "D%04u", (unsigned)i);
+        }
+        uint32_t expected = deleted ? i + 0xD000 : i;
+        if (fast_flash_read_table_data(name, 0, &value, sizeof(value)) != 0 || value != expected) {
+            printf("Table %s value mismatch after remount\n", name);
+            return -1;
+        }
+    }
+
+    // 槽位用完后创建失败
+    for (uint32_t i = 0; i < LARGE_CATALOG_TABLES - 1001; i++) {
+        snprintf(name, sizeof(name), "E%04u", (unsigned)i);
+        if (large_catalog_create(name) != 0) {
+            printf("Failed to fill catalog at %s\n", name);
+            return -1;
+        }
+    }
+    if (fast_flash_create_table("FULL", sizeof(uint32_t), 4) != -1 ||
+        fast_flash_init_ex(&flash_sim_mem_ops, LARGE_CATALOG_FLASH, true, geometry) != 0 ||
+        !fast_flash_table_exists("E0000") || !fast_flash_table_exists("LAST") || fast_flash_table_exists("FULL")) {
+        printf("Full catalog not handled\n");
+        return -1;
+    }
+    return 0;
+}
+
+int test_large_catalog(void) {
+    printf("\n=== Testing Large Paged Catalog ===\n");
+
+    static uint8_t arena[FF_ARENA_SIZE(1, LARGE_CATALOG_TABLES, LARGE_CATALOG_FLASH, FLASH_SECTOR_SIZE)];
+    flash_geometry_t geometry;
+    memset(&geometry, 0, sizeof(geometry));
+    geometry.sector_size = FLASH_SECTOR_SIZE;
+    geometry.max_tables = LARGE_CATALOG_TABLES;
+    flash_partition_t whole = { .offset = 0, .size = LARGE_CATALOG_FLASH };
+    uint32_t required = fast_flash_arena_size(&whole, 1, &geometry);
+    if (required == 0 || required > sizeof(arena) || fast_flash_set_arena(arena, sizeof(arena)) != 0) {
+        printf("FF_ARENA_SIZE (%u) below required arena size (%u)\n", (unsigned)sizeof(arena), required);
+        return -1;
+    }
+
+    uint64_t max_create_bytes = 0;
+    int result = large_catalog_run(&geometry, &max_create_bytes);
+    flash_sim_mem_destroy();
+    restore_default_arena();
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore default configuration\n");
+        return -1;
+    }
+    if (result != 0) {
+        return -1;
+    }
+
+    printf("Large catalog test passed! (%u tables, at most %llu metadata bytes per create)\n",
+           LARGE_CATALOG_TABLES, (unsigned long long)max_create_bytes);
+    return 0;
+}
+
+static uint32_t test_crc32(const uint8_t *data, uint32_t length) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+#define LAZY_MOUNT_TABLES 600
+
+// 把地址0的管理表节点（GC之后唯一的节点）记录的表数量加1，重新计算表头CRC和整表CRC，
+// 使它与目录页中的表项总数不一致
+static int lazy_mount_corrupt_count(void) {
+    static uint8_t sector[FLASH_SECTOR_SIZE];
+    uint8_t header_bytes[sizeof(flash_manager_table_t)];
+    flash_manager_table_t header;
+    if (flash_sim_mem_ops.read(0, sector, sizeof(sector)) != 0) {
+        return -1;
+    }
+    memcpy(&header, sector, sizeof(header));
+    header.table_count++;
+
+    uint32_t head = offsetof(flash_manager_table_t, crc);
+    uint32_t tail = sizeof(header) - offsetof(flash_manager_table_t, table_count);
+    memcpy(header_bytes, &header, head);
+    memcpy(header_bytes + head, &header.table_count, tail);
+    header.header_crc = test_crc32(header_bytes, head + tail);
+    memcpy(sector, &header, sizeof(header));
+    uint32_t body = sizeof(header) - offsetof(flash_manager_table_t, header_crc) + header.page_count * sizeof(uint32_t);
+    header.crc = test_crc32(sector + offsetof(flash_manager_table_t, header_crc), body);
+    memcpy(sector, &header, sizeof(header));
+
+    if (flash_sim_mem_ops.erase(0, sizeof(sector)) != 0 || flash_sim_mem_ops.write(0, sector, sizeof(sector)) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// 按当前的延迟挂载设置重新挂载，返回挂载读取的字节数
+static int lazy_mount_remount(const flash_geometry_t *geometry, uint64_t *read_bytes) {
+    flash_stats_t stats;
+    fast_flash_reset_stats();
+    if (fast_flash_init_ex(&flash_sim_mem_ops, LARGE_CATALOG_FLASH, true, geometry) != 0 ||
+        fast_flash_get_stats(&stats) != 0) {
+        return -1;
+    }
+    *read_bytes = stats.per_api[FF_API_INIT].read_bytes;
+    return 0;
+}
+
+static int lazy_mount_run(const flash_geometry_t *geometry, uint64_t *eager_bytes, uint64_t *lazy_bytes) {
+    char name[TABLE_NAME_MAX_LEN];
+    uint32_t value = 0;
+    if (flash_sim_mem_create(LARGE_CATALOG_FLASH, FLASH_SECTOR_SIZE) != 0 ||
+        fast_flash_init_ex(&flash_sim_mem_ops, LARGE_CATALOG_FLASH, true, geometry) != 0) {
+        printf("Failed to initialize lazy mount flash\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < LAZY_MOUNT_TABLES; i++) {
+        snprintf(name, sizeof(name), "L%04u", (unsigned)i);
+        if (large_catalog_create(name) != 0 || large_catalog_append(name, i) != 0 ||
+            (i % 128 == 127 && fast_flash_gc() != 0)) {
+            printf("Failed to create table %s\n", name);
+            return -1;
+        }
+    }
+    if (fast_flash_gc() != 0 || lazy_mount_remount(geometry, eager_bytes) != 0) {
+        printf("Failed to remount eagerly\n");
+        return -1;
+    }
+
+    // 延迟挂载只读管理表和目录页地址，与表数量无关
+    fast_flash_set_lazy_mount(true);
+    if (lazy_mount_remount(geometry, lazy_bytes) != 0 || *lazy_bytes * 8 > *eager_bytes) {
+        printf("Lazy mount read %llu bytes (eager %llu)\n",
+               (unsigned long long)*lazy_bytes, (unsigned long long)*eager_bytes);
+        return -1;
+    }
+
+    // 第一次读取只读入散列到的目录页
+    flash_stats_t stats;
+    fast_flash_reset_stats();
+    if (fast_flash_read_table_data("L0123", 0, &value, sizeof(value)) != 0 || value != 123 ||
+        fast_flash_get_stats(&stats) != 0 || stats.total.read_bytes * 8 > *eager_bytes) {
+        printf("First read after lazy mount failed or read too much\n");
+        return -1;
+    }
+    if (fast_flash_table_exists("NONE")) {
+        printf("Nonexistent table found after lazy mount\n");
+        return -1;
+    }
+
+    // 空闲时分批读入剩余目录页
+    int pending = fast_flash_warm_up(0);
+    if (pending <= 0) {
+        printf("No catalog pages deferred by lazy mount\n");
+        return -1;
+    }
+    for (int rounds = 0; pending > 0 && rounds < FF_CATALOG_PAGES(LARGE_CATALOG_TABLES); rounds++) {
+        pending = fast_flash_warm_up(4);
+    }
+    if (pending != 0) {
+        printf("Warm-up did not finish (%d pages pending)\n", pending);
+        return -1;
+    }
+    for (uint32_t i = 0; i < LAZY_MOUNT_TABLES; i++) {
+        snprintf(name, sizeof(name), "L%04u", (unsigned)i);
+        if (fast_flash_read_table_data(name, 0, &value, sizeof(value)) != 0 || value != i) {
+            printf("Table %s value mismatch after warm-up\n", name);
+            return -1;
+        }
+    }
+
+    // 没有读入全部目录页时创建、删除和列出表
+    static flash_table_t listed[LARGE_CATALOG_TABLES];
+    if (lazy_mount_remount(geometry, lazy_bytes) != 0 || large_catalog_create("NEW") != 0 ||
+        fast_flash_delete_table("L0007") != 0 || fast_flash_create_table("L0008", sizeof(uint32_t), 4) != -1 ||
+        lazy_mount_remount(geometry, lazy_bytes) != 0 ||
+        !fast_flash_table_exists("NEW") || fast_flash_table_exists("L0007") || !fast_flash_table_exists("L0599") ||
+        fast_flash_list_tables(listed, LARGE_CATALOG_TABLES) != LAZY_MOUNT_TABLES) {
+        printf("Create/delete after lazy mount failed\n");
+        return -1;
+    }
+
+    // 延迟挂载不能回退到上一个节点：读完目录页时表项总数与管理表不一致，分区停用
+    if (fast_flash_gc() != 0 || lazy_mount_corrupt_count() != 0 || lazy_mount_remount(geometry, lazy_bytes) != 0 ||
+        fast_flash_warm_up(FF_CATALOG_PAGES(LARGE_CATALOG_TABLES)) != -1 ||
+        fast_flash_table_exists("L0599") || fast_flash_warm_up(0) != -1) {
+        printf("Catalog count mismatch not detected after lazy mount\n");
+        return -1;
+    }
+    return 0;
+}
+
+int test_lazy_mount(void) {
+    printf("\n=== Testing Lazy Mount ===\n");
+
+    static uint8_t arena[FF_ARENA_SIZE(1, LARGE_CATALOG_TABLES, LARGE_CATALOG_FLASH, FLASH_SECTOR_SIZE)];
+    flash_geometry_t geometry;
+    memset(&geometry, 0, sizeof(geometry));
+    geometry.sector_size = FLASH_SECTOR_SIZE;
+    geometry.max_tables = LARGE_CATALOG_TABLES;
+    if (fast_flash_set_arena(arena, sizeof(arena)) != 0) {
+        printf("Failed to set arena\n");
+        return -1;
+    }
+
+    uint64_t eager_bytes = 0, lazy_bytes = 0;
+    int result = lazy_mount_run(&geometry, &eager_bytes, &lazy_bytes);
+    fast_flash_set_lazy_mount(false);
+    flash_sim_mem_destroy();
+    restore_default_arena();
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore default configuration\n");
+        return -1;
+    }
+    if (result != 0) {
+        return -1;
+    }
+
+    printf("Lazy mount test passed! (%u tables, mount read %llu -> %llu bytes)\n",
+           LAZY_MOUNT_TABLES, (unsigned long long)eager_bytes, (unsigned long long)lazy_bytes);
+    return 0;
+}
+
+int test_partitions(void) {
+    printf("\n=== Testing Partitions ===\n");
+
+    // 配置分区16KB，日志分区48KB
+    flash_partition_t partitions[2] = {
+        { "CFG", 0, 16 * 1024 },
+        { "LOG", 16 * 1024, 48 * 1024 },
+    };
+
+    flash_partition_t overlapping[2] = {
+        { "A", 0, 32 * 1024 },
+        { "B", 16 * 1024, 32 * 1024 },
+    };
+    if (fast_flash_init_partitions(&sim_flash_ops, overlapping, 2, true, &sim_flash_geometry) != -1) {
+        printf("Expected overlapping partitions to be rejected\n");
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_partitions(&sim_flash_ops, partitions, 2, true, &sim_flash_geometry) != 0) {
+        printf("Failed to initialize partitions\n");
+        return -1;
+    }
+
+    // 两个分区可以有同名的表
+    uint32_t setting = 0x12345678;
+    if (fast_flash_select_partition("CFG") != 0 ||
+        fast_flash_create_table("SET", sizeof(setting), 4) != 0 ||
+        fast_flash_append_table_data("SET", &setting, sizeof(setting)) != 0) {
+        printf("Failed to write CFG partition\n");
+        return -1;
+    }
+    if (fast_flash_get_total_size() != 16 * 1024) {
+        printf("CFG partition size mismatch: %u\n", fast_flash_get_total_size());
+        return -1;
+    }
+
+    // 记录配置分区内容，日志分区写满并GC后不能有任何变化
+    static uint8_t cfg_before[16 * 1024];
+    static uint8_t cfg_after[16 * 1024];
+    sim_flash_read(0, cfg_before, sizeof(cfg_before));
+
+    uint8_t record[256];
+    memset(record, 0x3C, sizeof(record));
+    if (fast_flash_select_partition("LOG") != 0 ||
+        fast_flash_create_table("SET", sizeof(record), 8) != 0 ||
+        fast_flash_write_table_data("SET", record, sizeof(record)) != 0) {
+        printf("Failed to write LOG partition\n");
+        return -1;
+    }
+    int result = 0;
+    for (int i = 0; i < 256 && result == 0; i++) {
+        record[0] = (uint8_t)i;
+        result = fast_flash_write_table_data_by_index("SET", 0, record, sizeof(record));
+    }
+    if (result != -2 || fast_flash_gc() != 0 ||
+        fast_flash_write_table_data_by_index("SET", 0, record, sizeof(record)) != 0) {
+        printf("Expected LOG partition to fill up and recover after GC (%d)\n", result);
+        return -1;
+    }
+
+    sim_flash_read(0, cfg_after, sizeof(cfg_after));
+    if (memcmp(cfg_before, cfg_after, sizeof(cfg_before)) != 0) {
+        printf("CFG partition modified by LOG partition activity\n");
+        return -1;
+    }
+
+    // 重新挂载后两个分区的数据都在
+    if (fast_flash_init_partitions(&sim_flash_ops, partitions, 2, true, &sim_flash_geometry) != 0) {
+        printf("Failed to remount partitions\n");
+        return -1;
+    }
+    uint32_t read_setting = 0;
+    uint8_t readback[256];
+    if (fast_flash_select_partition("CFG") != 0 ||
+        fast_flash_read_table_data("SET", 0, &read_setting, sizeof(read_setting)) != 0 ||
+        read_setting != setting ||
+        fast_flash_select_partition("LOG") != 0 ||
+        fast_flash_read_table_data("SET", 0, readback, sizeof(readback)) != 0 ||
+        memcmp(readback, record, sizeof(record)) != 0) {
+        printf("Partition data lost after remount\n");
+        return -1;
+    }
+    if (fast_flash_select_partition("NONE") != -1) {
+        printf("Expected unknown partition to be rejected\n");
+        return -1;
+    }
+
+    // 恢复为单分区
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore single partition\n");
+        return -1;
+    }
+
+    printf("Partitions test passed!\n");
+    return 0;
+}
+
+// 固定工作负载：格式化、建表、改写直到空间不足再GC，返回消耗的虚拟器件时间
+static uint64_t run_timing_workload(void) {
+    uint64_t start_us = flash_timing_now_us();
+    uint8_t record[128];
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0 ||
+        fast_flash_create_table("TIMING", sizeof(record), 4) != 0) {
+        return 0;
+    }
+    memset(record, 0, sizeof(record));
+    if (fast_flash_write_table_data_batch("TIMING", record, sizeof(record), 1) != 0) {
+        return 0;
+    }
+    for (int i = 0; i < 64; i++) {
+        memset(record, i, sizeof(record));
+        if (fast_flash_write_table_data_by_index("TIMING", 0, record, sizeof(record)) == -2) {
+            fast_flash_gc();
+        }
+    }
+    return flash_timing_now_us() - start_us;
+}
+
+int test_virtual_timing(void) {
+    printf("\n=== Testing Virtual Timing Model ===\n");
+
+    // 相同种子得到完全相同的器件时间
+    flash_timing_seed(1234);
+    uint64_t first_us = run_timing_workload();
+    flash_timing_seed(1234);
+    uint64_t second_us = run_timing_workload();
+    flash_timing_seed(5678);
+    uint64_t other_seed_us = run_timing_workload();
+    printf("Device time: seed 1234 = %.1f ms / %.1f ms, seed 5678 = %.1f ms\n",
+           first_us / 1000.0, second_us / 1000.0, other_seed_us / 1000.0);
+    if (first_us == 0 || first_us != second_us) {
+        printf("Expected identical device time for the same seed\n");
+        return -1;
+    }
+    if (first_us == other_seed_us) {
+        printf("Expected different device time for a different seed\n");
+        return -1;
+    }
+
+    // 零延迟器件参数不推进时钟；虚拟时钟毫秒接口与微秒时钟一致
+    flash_timing_set_profile(&flash_timing_ideal);
+    uint64_t ideal_us = run_timing_workload();
+    flash_timing_set_profile(NULL);
+    if (ideal_us != 0) {
+        printf("Expected ideal profile to take no device time (%llu us)\n", (unsigned long long)ideal_us);
+        return -1;
+    }
+    if (sim_get_time_ms() != (uint32_t)(flash_timing_now_us() / 1000)) {
+        printf("Simulator clock does not follow the virtual clock\n");
+        return -1;
+    }
+
+    // 其他器件参数：擦除更慢的器件消耗更多时间
+    flash_timing_seed(1234);
+    flash_timing_set_profile(&flash_timing_gigadevice_gd25q);
+    uint64_t gd_us = run_timing_workload();
+    flash_timing_set_profile(NULL);
+    printf("Device time with %s profile: %.1f ms\n", flash_timing_gigadevice_gd25q.name, gd_us / 1000.0);
+    if (gd_us == 0 || gd_us == first_us) {
+        printf("Expected profile to change device time\n");
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore flash after timing test\n");
+        return -1;
+    }
+
+    printf("Virtual timing test passed!\n");
+    return 0;
+}
+
+int test_sync_barrier(void) {
+    printf("\n=== Testing Sync Barrier ===\n");
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to initialize flash for sync test\n");
+        return -1;
+    }
+
+    // 每次提交（保存管理表）后只回写修改过的区间，而不是整个镜像
+    sim_flash_perf_stats_t before, after;
+    sim_flash_get_perf_stats(&before);
+    uint32_t value = 0xA5A5A5A5;
+    if (fast_flash_create_table("SYNC", sizeof(value), 8) != 0 ||
+        fast_flash_append_table_data("SYNC", &value, sizeof(value)) != 0) {
+        printf("Failed to write SYNC table\n");
+        return -1;
+    }
+    sim_flash_get_perf_stats(&after);
+    uint32_t syncs = after.sync_operations - before.sync_operations;
+    uint32_t synced = after.bytes_synced - before.bytes_synced;
+    printf("Commits synced: %u, bytes written back: %u\n", syncs, synced);
+    if (syncs == 0 || synced / syncs >= SIM_FLASH_TOTAL_SIZE) {
+        printf("Expected partial write-back per commit\n");
+        return -1;
+    }
+
+    // GC提交新管理表后先同步，再擦除旧扇区
+    sim_flash_get_perf_stats(&before);
+    if (fast_flash_gc() != 0) {
+        printf("GC failed\n");
+        return -1;
+    }
+    sim_flash_get_perf_stats(&after);
+    if (after.sync_operations == before.sync_operations) {
+        printf("GC did not sync the new manager table\n");
+        return -1;
+    }
+
+    // 屏障之后镜像文件与模拟器内容一致
+    if (sim_flash_sync() != 0) {
+        printf("Sync failed\n");
+        return -1;
+    }
+    static uint8_t image[SIM_FLASH_TOTAL_SIZE];
+    static uint8_t on_disk[SIM_FLASH_TOTAL_SIZE];
+    FILE *file = fopen(SIM_FLASH_FILE_NAME, "rb");
+    size_t disk_size = file ? fread(on_disk, 1, sizeof(on_disk), file) : 0;
+    if (file) {
+        fclose(file);
+    }
+    if (sim_flash_read(0, image, sizeof(image)) != 0 || disk_size != sizeof(on_disk) ||
+        memcmp(image, on_disk, sizeof(image)) != 0) {
+        printf("Image file differs from flash contents after sync\n");
+        return -1;
+    }
+
+    printf("Sync barrier test passed!\n");
+    return 0;
+}
+
+int test_latency_histogram(void) {
+    printf("\n=== Testing Latency Histograms ===\n");
+
+    // 已知分布：1..100us，对数-线性分桶的误差不超过12.5%
+    flash_latency_reset();
+    for (uint32_t us = 1; us <= 100; us++) {
+        flash_latency_record(FLASH_LAT_WRITE, 32, us);
+    }
+    flash_latency_summary_t summary;
+    flash_latency_get_summary(FLASH_LAT_WRITE, FLASH_LAT_ALL_SIZES, &summary);
+    printf("1..100us: p50=%u p90=%u p99=%u max=%u\n", summary.p50_us, summary.p90_us, summary.p99_us, summary.max_us);
+    if (summary.samples != 100 || summary.min_us != 1 || summary.max_us != 100 ||
+        summary.p50_us < 50 || summary.p50_us > 56 ||
+        summary.p90_us < 90 || summary.p90_us > 100 ||
+        summary.p99_us < 99 || summary.p99_us > 100) {
+        printf("Unexpected percentiles for known distribution\n");
+        return -1;
+    }
+
+    // 真实工作负载：直方图样本数与操作计数一致，各大小分档之和等于总数
+    flash_timing_seed(1234);
+    run_timing_workload();
+    sim_flash_reset_perf_stats();
+    uint8_t record[128];
+    memset(record, 0x5A, sizeof(record));
+    for (int i = 0; i < 64; i++) {
+        record[0] = (uint8_t)i;
+        if (fast_flash_write_table_data_by_index("TIMING", 0, record, sizeof(record)) == -2) {
+            fast_flash_gc();
+        }
+    }
+    sim_flash_perf_stats_t stats;
+    sim_flash_get_perf_stats(&stats);
+
+    uint32_t expected[FLASH_LAT_OP_COUNT] = { stats.read_operations, stats.write_operations, stats.erase_operations };
+    for (int op = 0; op < FLASH_LAT_OP_COUNT; op++) {
+        flash_latency_get_summary((flash_lat_op_t)op, FLASH_LAT_ALL_SIZES, &summary);
+        uint32_t class_total = 0;
+        for (int sc = 0; sc < FLASH_LAT_SIZE_CLASSES; sc++) {
+            flash_latency_summary_t by_size;
+            flash_latency_get_summary((flash_lat_op_t)op, sc, &by_size);
+            class_total += by_size.samples;
+        }
+        printf("%s: samples=%u p50=%u p99=%u max=%u us\n", flash_latency_op_name((flash_lat_op_t)op),
+               summary.samples, summary.p50_us, summary.p99_us, summary.max_us);
+        if (summary.samples != expected[op] || class_total != summary.samples ||
+            summary.min_us > summary.p50_us || summary.p50_us > summary.p90_us ||
+            summary.p90_us > summary.p99_us || summary.p99_us > summary.max_us) {
+            printf("Inconsistent %s histogram\n", flash_latency_op_name((flash_lat_op_t)op));
+            return -1;
+        }
+    }
+    if (stats.erase_operations == 0) {
+        printf("Expected erases in histogram workload\n");
+        return -1;
+    }
+
+    // JSON输出
+    FILE *json = tmpfile();
+    char text[4096] = {0};
+    if (!json) {
+        printf("Failed to create temporary file\n");
+        return -1;
+    }
+    sim_flash_write_perf_stats_json(json);
+    rewind(json);
+    size_t length = fread(text, 1, sizeof(text) - 1, json);
+    fclose(json);
+    if (length == 0 || text[0] != '{' || !strstr(text, "\"p99_us\"") || !strstr(text, "\"erase\":[")) {
+        printf("Unexpected JSON output: %s\n", text);
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore flash after histogram test\n");
+        return -1;
+    }
+
+    printf("Latency histogram test passed!\n");
+    return 0;
+}
+
+int test_io_stats(void) {
+    printf("\n=== Testing I/O Statistics ===\n");
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to initialize flash for stats test\n");
+        return -1;
+    }
+    fast_flash_reset_stats();
+    sim_flash_reset_perf_stats();
+
+    uint8_t record[16];
+    memset(record, 0x11, sizeof(record));
+    if (fast_flash_create_table("WA", sizeof(record), 8) != 0 ||
+        fast_flash_append_table_data("WA", record, sizeof(record)) != 0 ||
+        fast_flash_write_table_data("WA", record, sizeof(record)) != 0) {
+        printf("Failed to write WA table\n");
+        return -1;
+    }
+    for (int i = 0; i < 40; i++) {
+        record[0] = (uint8_t)i;
+        if (fast_flash_write_table_data_by_index("WA", 1, record, sizeof(record)) != 0) {
+            printf("Failed to update WA table\n");
+            return -1;
+        }
+    }
+    if (fast_flash_gc() != 0) {
+        printf("GC failed in stats test\n");
+        return -1;
+    }
+
+    flash_stats_t stats;
+    flash_io_stats_t table;
+    if (fast_flash_get_stats(&stats) != 0 || fast_flash_get_table_stats("WA", &table) != 0) {
+        printf("Failed to query stats\n");
+        return -1;
+    }
+    fast_flash_print_stats();
+
+    // 各API的用户字节数
+    if (stats.per_api[FF_API_APPEND].user_bytes != sizeof(record) ||
+        stats.per_api[FF_API_WRITE].user_bytes != sizeof(record) ||
+        stats.per_api[FF_API_WRITE_BY_INDEX].user_bytes != 40 * sizeof(record) ||
+        stats.total.user_bytes != 42 * sizeof(record) ||
+        table.user_bytes != stats.total.user_bytes) {
+        printf("Unexpected user byte accounting\n");
+        return -1;
+    }
+
+    // 每次追加都重写整表和管理表；GC搬运记到GC和表名下
+    if (stats.per_api[FF_API_APPEND].data_bytes < sizeof(table_header_t) + sizeof(record) ||
+        stats.per_api[FF_API_APPEND].metadata_bytes == 0 ||
+        stats.per_api[FF_API_GC].relocation_bytes == 0 || table.relocation_bytes == 0 ||
+        stats.per_api[FF_API_GC].erase_count == 0 || stats.total.crc_bytes == 0 ||
+        stats.per_api[FF_API_WRITE_BY_INDEX].calls != 40 || table.calls != 43) {
+        printf("Unexpected programmed byte accounting\n");
+        return -1;
+    }
+
+    // 核心统计与适配层看到的I/O完全一致
+    sim_flash_perf_stats_t device;
+    sim_flash_get_perf_stats(&device);
+    uint64_t programmed = stats.total.data_bytes + stats.total.metadata_bytes + stats.total.relocation_bytes;
+    if (programmed != device.bytes_written || stats.total.erase_bytes != device.bytes_erased ||
+        stats.total.read_bytes != device.bytes_read || stats.total.erase_count != device.erase_operations) {
+        printf("Core stats disagree with device: programmed %llu/%u erased %llu/%u read %llu/%u\n",
+               (unsigned long long)programmed, device.bytes_written,
+               (unsigned long long)stats.total.erase_bytes, device.bytes_erased,
+               (unsigned long long)stats.total.read_bytes, device.bytes_read);
+        return -1;
+    }
+    printf("Write amplification: %.1f\n", (double)programmed / stats.total.user_bytes);
+
+    fast_flash_reset_stats();
+    fast_flash_get_stats(&stats);
+    if (stats.total.calls != 0 || fast_flash_get_table_stats("WA", &table) != 0 || table.user_bytes != 0) {
+        printf("Stats not cleared by reset\n");
+        return -1;
+    }
+
+    printf("I/O statistics test passed!\n");
+    return 0;
+}
+
+int test_energy_model(void) {
+    printf("\n=== Testing Energy Model ===\n");
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to initialize flash for energy test\n");
+        return -1;
+    }
+    fast_flash_reset_stats();
+    sim_flash_reset_perf_stats();
+    flash_timing_reset_energy();
+
+    uint8_t record[32];
+    memset(record, 0x22, sizeof(record));
+    if (fast_flash_create_table("NRG", sizeof(record), 4) != 0 ||
+        fast_flash_write_table_data_batch("NRG", record, sizeof(record), 1) != 0) {
+        printf("Failed to create NRG table\n");
+        return -1;
+    }
+    for (int i = 0; i < 64; i++) {
+        record[0] = (uint8_t)i;
+        if (fast_flash_write_table_data_by_index("NRG", 0, record, sizeof(record)) == -2) {
+            fast_flash_gc();
+        }
+        if (fast_flash_read_table_data("NRG", 0, record, sizeof(record)) != 0) {
+            printf("Failed to read NRG table\n");
+            return -1;
+        }
+    }
+    if (fast_flash_gc() != 0) {
+        printf("GC failed in energy test\n");
+        return -1;
+    }
+
+    flash_stats_t stats;
+    flash_io_stats_t table;
+    sim_flash_perf_stats_t device;
+    fast_flash_get_stats(&stats);
+    fast_flash_get_table_stats("NRG", &table);
+    sim_flash_get_perf_stats(&device);
+    fast_flash_print_stats();
+
+    // 核心按API累计的能耗与器件能耗一致
+    uint64_t per_api = 0;
+    for (int i = 0; i < FF_API_COUNT; i++) {
+        per_api += stats.per_api[i].energy_nj;
+    }
+    if (stats.total.energy_nj == 0 || per_api != stats.total.energy_nj ||
+        stats.total.energy_nj != device.total_energy_nj || device.total_energy_nj != flash_timing_energy_nj() ||
+        table.energy_nj == 0 || table.energy_nj > stats.total.energy_nj) {
+        printf("Energy accounting mismatch: core %llu, per-API %llu, device %llu, model %llu\n",
+               (unsigned long long)stats.total.energy_nj, (unsigned long long)per_api,
+               (unsigned long long)device.total_energy_nj, (unsigned long long)flash_timing_energy_nj());
+        return -1;
+    }
+
+    // 擦除是主要能耗：GC的能耗不少于其擦除次数对应的扇区擦除能耗；读取比改写便宜得多
+    const flash_timing_profile_t *profile = flash_timing_get_profile();
+    const flash_io_stats_t *gc = &stats.per_api[FF_API_GC];
+    const flash_io_stats_t *read = &stats.per_api[FF_API_READ];
+    const flash_io_stats_t *update = &stats.per_api[FF_API_WRITE_BY_INDEX];
+    if (gc->erase_count == 0 || gc->energy_nj < (uint64_t)gc->erase_count * profile->erase_4k_nj ||
+        read->calls == 0 || read->energy_nj / read->calls >= update->energy_nj / update->calls) {
+        printf("Unexpected energy distribution across APIs\n");
+        return -1;
+    }
+    printf("Energy: %.1f uJ per update, %.2f uJ per read, %.1f nJ per user byte\n",
+           update->energy_nj / 1000.0 / update->calls, read->energy_nj / 1000.0 / read->calls,
+           (double)stats.total.energy_nj / stats.total.user_bytes);
+
+    // 零能耗器件参数：不产生能耗
+    flash_timing_set_profile(&flash_timing_ideal);
+    fast_flash_reset_stats();
+    fast_flash_read_table_data("NRG", 0, record, sizeof(record));
+    fast_flash_write_table_data_by_index("NRG", 0, record, sizeof(record));
+    fast_flash_get_stats(&stats);
+    flash_timing_set_profile(NULL);
+    if (stats.total.energy_nj != 0) {
+        printf("Expected ideal profile to use no energy\n");
+        return -1;
+    }
+
+    printf("Energy model test passed!\n");
+    return 0;
+}
+
+int test_power_loss_injection(void) {
+    printf("\n=== Testing Power-Loss Injection ===\n");
+
+    flash_fault_attach(&sim_flash_ops);
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&flash_sim_fault_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to initialize flash through the fault adapter\n");
+        return -1;
+    }
+
+    // 只计数不掉电
+    uint32_t value = 0x11111111;
+    flash_fault_plan_t plan = { 0, FLASH_FAULT_CUT, 0 };
+    flash_fault_arm(&plan);
+    if (fast_flash_create_table("PWR", sizeof(value), 8) != 0 ||
+        fast_flash_append_table_data("PWR", &value, sizeof(value)) != 0 ||
+        flash_fault_op_count() == 0 || flash_fault_tripped()) {
+        printf("Expected operations to be counted without power loss\n");
+        return -1;
+    }
+
+    // 第一次编程时掉电：追加失败，之后读取也失败；重新上电后表保持追加前的状态并且可以继续写入
+    uint32_t next = 0x22222222;
+    plan.cut_at = 1;
+    flash_fault_arm(&plan);
+    uint32_t readback = 0;
+    if (fast_flash_append_table_data("PWR", &next, sizeof(next)) == 0 || !flash_fault_tripped() ||
+        flash_sim_fault_ops.read(0, (uint8_t*)&readback, sizeof(readback)) != -1) {
+        printf("Expected append to fail after power loss\n");
+        return -1;
+    }
+    flash_fault_disarm();
+    if (fast_flash_init_ex(&flash_sim_fault_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0 ||
+        fast_flash_get_table_count("PWR") != 1 || fast_flash_validate_table_data("PWR") != 0 ||
+        fast_flash_read_table_data("PWR", 0, &readback, sizeof(readback)) != 0 || readback != value ||
+        fast_flash_append_table_data("PWR", &next, sizeof(next)) != 0) {
+        printf("Table not recovered after power loss\n");
+        return -1;
+    }
+
+    // 撕裂的编程：前面一部分字节已写入，断点之后保持擦除状态
+    uint32_t addr = SIM_FLASH_TOTAL_SIZE - FLASH_SECTOR_SIZE;
+    uint8_t zeros[64], image[64];
+    memset(zeros, 0, sizeof(zeros));
+    for (int mode = FLASH_FAULT_TEAR_PAGE; mode <= FLASH_FAULT_TEAR_BITS; mode++) {
+        flash_fault_plan_t tear = { 1, (flash_fault_mode_t)mode, 1234 };
+        sim_flash_ops.erase(addr, FLASH_SECTOR_SIZE);
+        flash_fault_arm(&tear);
+        if (flash_sim_fault_ops.write(addr, zeros, sizeof(zeros)) != -1) {
+            printf("Expected torn write to report failure\n");
+            return -1;
+        }
+        flash_fault_disarm();
+        sim_flash_ops.read(addr, image, sizeof(image));
+        uint32_t done = 0;
+        while (done < sizeof(image) && image[done] == 0x00) {
+            done++;
+        }
+        uint32_t blank_from = (mode == FLASH_FAULT_TEAR_BITS && done < sizeof(image)) ? done + 1 : done;
+        for (uint32_t i = blank_from; i < sizeof(image); i++) {
+            if (image[i] != 0xFF) {
+                printf("Torn write (%s) programmed past the break at byte %u\n",
+                       flash_fault_mode_name((flash_fault_mode_t)mode), i);
+                return -1;
+            }
+        }
+        printf("Torn write (%s): %u of %u bytes programmed\n", flash_fault_mode_name((flash_fault_mode_t)mode),
+               done, (uint32_t)sizeof(image));
+        if (done == sizeof(image)) {
+            printf("Expected a partial write\n");
+            return -1;
+        }
+    }
+
+    // 掉电发生在擦除命令之前：内容保持不变
+    flash_fault_arm(&plan);
+    if (flash_sim_fault_ops.erase(addr, FLASH_SECTOR_SIZE) != -1) {
+        printf("Expected erase to fail after power loss\n");
+        return -1;
+    }
+    flash_fault_disarm();
+    sim_flash_ops.read(addr, image, sizeof(image));
+    if (image[0] != 0x00) {
+        printf("Cut erase changed flash contents\n");
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to restore flash after power-loss test\n");
+        return -1;
+    }
+
+    printf("Power-loss injection test passed!\n");
+    return 0;
+}
+
+// 读回延迟日志的格式化输出
+static int read_deferred_log(char *text, size_t size) {
+    FILE *out = fopen("deferred_log.txt", "w+");
+    if (!out) {
+        return -1;
+    }
+    int count = flash_log_flush(out);
+    rewind(out);
+    size_t len = fread(text, 1, size - 1, out);
+    text[len] = '\0';
+    fclose(out);
+    remove("deferred_log.txt");
+    return count;
+}
+
+int test_deferred_log(void) {
+    printf("\n=== Testing Deferred Binary Log ===\n");
+
+    log_level_t saved_level = flash_log_get_level();
+    flash_log_set_level(LOG_LEVEL_DEBUG);
+    flash_log_flush(NULL);
+
+    // 参数在记录时保存：不以0结尾的表名按精度截取，之后修改字符串不影响输出
+    char name[TABLE_NAME_MAX_LEN] = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H' };
+    char temp[16] = "temp";
+    flash_log_record(LOG_LEVEL_INFO, "[INFO]  table '%.*s' addr=0x%08X size=%u %s\n",
+                     TABLE_NAME_MAX_LEN, name, 0x1234u, 30u, temp);
+    strcpy(temp, "gone");
+    flash_log_record(LOG_LEVEL_DEBUG, "[DEBUG] mask=%016llX idx=%d %5u%%\n", 0x8000000000000001ULL, -3, 42u);
+    flash_log_record(LOG_LEVEL_DEBUG, "[DEBUG] ratio=%.2f\n", 1.5);
+    flash_log_set_level(LOG_LEVEL_INFO);
+    flash_log_record(LOG_LEVEL_DEBUG, "[DEBUG] filtered\n");
+
+    static char text[8192];
+    const char *expected = "[INFO]  table 'ABCDEFGH' addr=0x00001234 size=30 temp\n"
+                           "[DEBUG] mask=8000000000000001 idx=-3    42%\n"
+                           "[DEBUG] ratio=1.50\n";
+    int count = read_deferred_log(text, sizeof(text));
+    if (count != 3 || strcmp(text, expected) != 0) {
+        printf("Unexpected deferred log output (%d records):\n%s", count, text);
+        flash_log_set_level(saved_level);
+        return -1;
+    }
+
+    // 缓冲区写满时覆盖最旧的记录，保留最新的
+    for (uint32_t i = 0; i < 1000; i++) {
+        flash_log_record(LOG_LEVEL_INFO, "[INFO]  record %u\n", i);
+    }
+    uint32_t dropped = flash_log_dropped();
+    count = read_deferred_log(text, sizeof(text));
+    const char *last = strstr(text, "record 999\n");
+    if (dropped == 0 || count <= 0 || dropped + (uint32_t)count != 1000 || !last) {
+        printf("Unexpected ring overwrite: dropped %u kept %d\n", dropped, count);
+        flash_log_set_level(saved_level);
+        return -1;
+    }
+
+#ifdef FAST_FLASH_LOG_DEFERRED
+    // TRACE_*写入环形缓冲区而不是立即输出
+    TRACE_INFO("deferred trace %u\n", 7u);
+    count = read_deferred_log(text, sizeof(text));
+    if (count != 1 || strcmp(text, "[INFO]  deferred trace 7\n") != 0) {
+        printf("TRACE_INFO not captured by deferred log\n");
+        flash_log_set_level(saved_level);
+        return -1;
+    }
+#endif
+
+    flash_log_set_level(saved_level);
+    printf("Deferred log test passed!\n");
+    return 0;
+}
+
+#ifdef FAST_FLASH_PROFILE
+static uint32_t profile_clock_us(void) {
+    return (uint32_t)flash_timing_now_us();
+}
+
+int test_profiling(void) {
+    printf("\n=== Testing Profiling Probes ===\n");
+
+    fast_flash_prof_set_clock(profile_clock_us);
+    fast_flash_prof_reset();
+    sim_flash_reset_perf_stats();
+    run_timing_workload();
+    fast_flash_prof_print();
+
+    const flash_prof_stat_t *by_index = fast_flash_prof_get_api(FF_API_WRITE_BY_INDEX);
+    const flash_prof_stat_t *program = fast_flash_prof_get_phase(FF_PHASE_PROGRAM);
+    const flash_prof_stat_t *erase = fast_flash_prof_get_phase(FF_PHASE_ERASE);
+    if (by_index->count != 64 || by_index->total_us == 0 ||
+        fast_flash_prof_get_api(FF_API_INIT)->count != 1 ||
+        fast_flash_prof_get_phase(FF_PHASE_HEADER_READ)->count == 0 ||
+        fast_flash_prof_get_phase(FF_PHASE_CRC)->count == 0 ||
+        fast_flash_prof_get_phase(FF_PHASE_MANAGER_SAVE)->count == 0 ||
+        fast_flash_prof_get_phase(FF_PHASE_MOUNT)->count != 1) {
+        printf("Unexpected probe counts\n");
+        return -1;
+    }
+
+    // 编程/擦除阶段的耗时就是模拟器记录的器件时间
+    sim_flash_perf_stats_t device;
+    sim_flash_get_perf_stats(&device);
+    if (program->count != device.write_operations || program->total_us != device.total_write_time_us ||
+        erase->count != device.erase_operations || erase->total_us != device.total_erase_time_us) {
+        printf("Phase time disagrees with device: program %llu/%llu erase %llu/%llu\n",
+               (unsigned long long)program->total_us, (unsigned long long)device.total_write_time_us,
+               (unsigned long long)erase->total_us, (unsigned long long)device.total_erase_time_us);
+        return -1;
+    }
+
+    // 百分位落在[min, max]之内且单调
+    uint32_t p50 = fast_flash_prof_percentile(by_index, 50);
+    uint32_t p99 = fast_flash_prof_percentile(by_index, 99);
+    if (p50 < by_index->min_us || p50 > p99 || p99 > by_index->max_us) {
+        printf("Unexpected percentiles: min %u p50 %u p99 %u max %u\n", by_index->min_us, p50, p99, by_index->max_us);
+        return -1;
+    }
+
+    // 去掉时钟后探针不再采样
+    fast_flash_prof_set_clock(NULL);
+    uint32_t before = by_index->count;
+    uint8_t record[128] = {0};
+    fast_flash_write_table_data_by_index("TIMING", 0, record, sizeof(record));
+    if (by_index->count != before) {
+        printf("Probes sampled without a clock\n");
+        return -1;
+    }
+
+    printf("Profiling test passed!\n");
+    return 0;
+}
+#endif
+
+#ifdef FAST_FLASH_TRACE
+static uint32_t trace_clock_us(void) {
+    return (uint32_t)flash_timing_now_us();
+}
+
+// 查找包含指定时间区间的事件
+static const flash_trace_event_t *find_enclosing_event(flash_trace_category_t category, const char *name,
+                                                       const flash_trace_event_t *inner) {
+    for (uint32_t i = 0; i < fast_flash_trace_count(); i++) {
+        const flash_trace_event_t *event = fast_flash_trace_get(i);
+        if (event->category == category && strcmp(event->name, name) == 0 &&
+            event->ts_us <= inner->ts_us && inner->ts_us + inner->dur_us <= event->ts_us + event->dur_us) {
+            return event;
+        }
+    }
+    return NULL;
+}
+
+int test_trace_export(void) {
+    printf("\n=== Testing Timeline Trace Export ===\n");
+
+    fast_flash_prof_set_clock(trace_clock_us);
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        printf("Failed to initialize flash for trace test\n");
+        return -1;
+    }
+    fast_flash_trace_reset();
+
+    uint8_t record[16];
+    memset(record, 0x5A, sizeof(record));
+    if (fast_flash_create_table("TRACE", sizeof(record), 4) != 0 ||
+        fast_flash_append_table_data("TRACE", record, sizeof(record)) != 0 ||
+        fast_flash_gc() != 0) {
+        printf("Failed to run trace workload\n");
+        return -1;
+    }
+
+    // GC中的每次设备擦除都落在核心的擦除阶段和GC调用之内
+    int device_erases = 0;
+    for (uint32_t i = 0; i < fast_flash_trace_count(); i++) {
+        const flash_trace_event_t *event = fast_flash_trace_get(i);
+        if (event->category != FF_TRACE_DEVICE || strcmp(event->name, "erase") != 0) {
+            continue;
+        }
+        device_erases++;
+        if (!find_enclosing_event(FF_TRACE_PHASE, "erase", event) ||
+            !find_enclosing_event(FF_TRACE_API, "gc", event)) {
+            printf("Device erase at 0x%08X is not nested in gc/erase\n", event->addr);
+            return -1;
+        }
+    }
+    if (device_erases == 0 || fast_flash_trace_dropped() != 0) {
+        printf("Unexpected trace contents: %d erases, %u dropped\n", device_erases, fast_flash_trace_dropped());
+        return -1;
+    }
+
+    FILE *out = fopen("fast_flash_trace.json", "w+");
+    if (!out || fast_flash_trace_write_json(out) != 0) {
+        printf("Failed to write trace JSON\n");
+        if (out) fclose(out);
+        return -1;
+    }
+    rewind(out);
+    char head[64] = {0};
+    size_t len = fread(head, 1, sizeof(head) - 1, out);
+    fclose(out);
+    if (len == 0 || strncmp(head, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 39) != 0) {
+        printf("Unexpected trace JSON header\n");
+        return -1;
+    }
+    printf("Trace: %u events written to fast_flash_trace.json\n", fast_flash_trace_count());
+
+    fast_flash_prof_set_clock(NULL);
+    printf("Trace export test passed!\n");
+    return 0;
+}
+#endif
+
+#ifdef FAST_FLASH_RECORD
+static uint8_t record_buf[4096];
+static uint32_t record_len = 0;
+
+static void record_sink(const uint8_t *data, uint32_t size, void *ctx) {
+    (void)ctx;
+    if (record_len + size <= sizeof(record_buf)) {
+        memcpy(record_buf + record_len, data, size);
+        record_len += size;
+    }
+}
+
+int test_workload_record(void) {
+    printf("\n=== Testing Workload Recording ===\n");
+
+    record_len = 0;
+    fast_flash_record_start(record_sink, NULL);
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0) {
+        fast_flash_record_stop();
+        printf("Failed to initialize flash for record test\n");
+        return -1;
+    }
+
+    uint8_t record[16];
+    uint8_t batch[48 * 16];
+    memset(record, 0x21, sizeof(record));
+    memset(batch, 0x43, sizeof(batch));
+    int rc = 0;
+    rc |= fast_flash_create_table_ex("REC", sizeof(record), 300, FF_TABLE_COLD);
+    rc |= fast_flash_write_table_data_batch("REC", batch, sizeof(record), 48);
+    rc |= fast_flash_write_table_data_by_index("REC", 1, record, sizeof(record));
+    rc |= fast_flash_write_table_data_by_index("REC", 2, record, sizeof(record));
+    rc |= fast_flash_read_table_data("REC", 1, record, sizeof(record));
+    rc |= fast_flash_clear_table_data("REC", 1ull << 40);
+    fast_flash_table_exists("REC");   // 只读查询不录制
+    rc |= fast_flash_gc();
+    fast_flash_record_stop();
+    fast_flash_append_table_data("REC", record, sizeof(record));   // 停止后不再录制
+    if (rc != 0) {
+        printf("Failed to run record workload\n");
+        return -1;
+    }
+
+    static const flash_record_op_t expected[] = {
+        FF_REC_INIT, FF_REC_CREATE_TABLE, FF_REC_WRITE_BATCH, FF_REC_WRITE_BY_INDEX,
+        FF_REC_WRITE_BY_INDEX, FF_REC_READ, FF_REC_CLEAR, FF_REC_GC
+    };
+    const int expected_count = (int)(sizeof(expected) / sizeof(expected[0]));
+    flash_record_t records[8];
+    int pos = fast_flash_record_check_header(record_buf, record_len);
+    int count = 0;
+    while (pos > 0 && (uint32_t)pos < record_len && count < expected_count) {
+        int used = fast_flash_record_decode(record_buf + pos, record_len - (uint32_t)pos, &records[count]);
+        if (used <= 0 || records[count].op != expected[count]) {
+            printf("Record %d: decode %d, op %u\n", count, used, used > 0 ? records[count].op : 0);
+            return -1;
+        }
+        pos += used;
+        count++;
+    }
+    if (count != expected_count || (uint32_t)pos != record_len || fast_flash_record_count() != (uint32_t)expected_count) {
+        printf("Unexpected record stream: %d records, %d/%u bytes\n", count, pos, record_len);
+        return -1;
+    }
+
+    // 字段：几何参数、建表参数、数据摘要（相同数据摘要相同）、64位掩码
+    if (records[0].args[0] != 1 || records[0].partition_count != 1 ||
+        records[0].partitions[0].size != SIM_FLASH_TOTAL_SIZE ||
+        records[0].geometry.sector_size != sim_flash_geometry.sector_size ||
+        strcmp(records[1].name, "REC") != 0 || records[1].args[0] != sizeof(record) ||
+        records[1].args[1] != 300 || records[1].args[2] != FF_TABLE_COLD ||
+        records[2].args[0] != sizeof(record) || records[2].args[1] != 48 ||
+        records[2].digest != fast_flash_record_digest(batch, sizeof(batch)) ||
+        records[3].args[0] != 1 || records[4].args[0] != 2 || records[3].digest != records[4].digest ||
+        records[5].args[0] != 1 || records[5].args[1] != sizeof(record) ||
+        records[6].args[0] != (1ull << 40)) {
+        printf("Decoded record fields do not match the calls\n");
+        return -1;
+    }
+
+    // 不完整的记录返回0
+    if (fast_flash_record_decode(record_buf + FF_RECORD_HEADER_SIZE, 3, &records[0]) != 0) {
+        printf("Truncated record not detected\n");
+        return -1;
+    }
+
+    // 保存供fast_flash_replay回放
+    FILE *out = fopen("workload.ffrec", "wb");
+    if (!out || fwrite(record_buf, 1, record_len, out) != record_len) {
+        printf("Failed to save workload.ffrec\n");
+        if (out) fclose(out);
+        return -1;
+    }
+    fclose(out);
+    printf("Recorded %d calls in %u bytes\n", count, record_len);
+
+    printf("Workload record test passed!\n");
+    return 0;
+}
+#endif
+
+// 把表头改写为header：读出表所在扇区，擦除后写回（只替换表头）
+static int overwrite_table_header(const char *name, const table_header_t *header) {
+    static uint8_t sector[FLASH_SECTOR_SIZE];
+    flash_table_t info;
+    if (fast_flash_get_table_info(name, &info) != 0) {
+        return -1;
+    }
+    uint32_t sector_addr = info.addr - info.addr % FLASH_SECTOR_SIZE;
+    if (sim_flash_read(sector_addr, sector, FLASH_SECTOR_SIZE) != 0) {
+        return -1;
+    }
+    memcpy(sector + (info.addr - sector_addr), header, sizeof(*header));
+    if (sim_flash_ops.erase(sector_addr, FLASH_SECTOR_SIZE) != 0 ||
+        sim_flash_ops.write(sector_addr, sector, FLASH_SECTOR_SIZE) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+// 表头被破坏（擦除状态、结构体数量撕裂、数据长度与管理表不符）时，所有按表头长度访问数据的接口
+// 都应立即返回错误，不能按其中的长度搬运数据、计算CRC或循环
+int test_corrupt_table_header(void) {
+    printf("\n=== Testing Corrupt Table Header ===\n");
+
+    uint32_t values[4] = { 0xC0, 0xC1, 0xC2, 0xC3 };
+    flash_table_t info;
+    table_header_t good;
+    if (sim_flash_reset() != 0 ||
+        fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true, &sim_flash_geometry) != 0 ||
+        fast_flash_create_table("BADHDR", sizeof(uint32_t), 16) != 0 ||
+        fast_flash_write_table_data_batch("BADHDR", values, sizeof(uint32_t), 4) != 0 ||
+        fast_flash_get_table_info("BADHDR", &info) != 0 ||
+        sim_flash_read(info.addr, (uint8_t*)&good, sizeof(good)) != 0) {
+        printf("Failed to prepare table for header corruption\n");
+        return -1;
+    }
+
+    table_header_t corrupt[3];
+    memset(&corrupt[0], 0xFF, sizeof(corrupt[0]));  // 擦除状态
+    corrupt[1] = good;
+    corrupt[1].struct_nums = 0xFFFFFFFF;              // 撕裂的结构体数量
+    corrupt[2] = good;
+    corrupt[2].data_len += 0x7FFFFFFF;                // 数据长度与管理表不符
+    corrupt[2].struct_nums = corrupt[2].data_len / corrupt[2].struct_size;
+    for (int c = 0; c < 3; c++) {
+        if (overwrite_table_header("BADHDR", &corrupt[c]) != 0) {
+            printf("Failed to corrupt table header (case %d)\n", c);
+            return -1;
+        }
+        uint32_t value = 0xC4;
+        sim_flash_perf_stats_t before, after;
+        sim_flash_get_perf_stats(&before);
+        if (fast_flash_read_table_data("BADHDR", 0, &value, sizeof(value)) == 0 ||
+            fast_flash_get_table_count("BADHDR") != 0 ||
+            fast_flash_write_table_data("BADHDR", &value, sizeof(value)) == 0 ||
+            fast_flash_append_table_data("BADHDR", &value, sizeof(value)) == 0 ||
+            fast_flash_write_table_data_batch("BADHDR", values, sizeof(uint32_t), 2) == 0 ||
+            fast_flash_write_table_data_by_index("BADHDR", 1, &value, sizeof(value)) == 0 ||
+            fast_flash_clear_table_data("BADHDR", 0x1) == 0 ||
+            fast_flash_validate_table_data("BADHDR") == 0 ||
+            fast_flash_repair_table("BADHDR") == 0) {
+            printf("Corrupt table header accepted (case %d)\n", c);
+            return -1;
+        }
+        sim_flash_get_perf_stats(&after);
+        if (after.bytes_read - before.bytes_read > 16 * sizeof(table_header_t) ||
+            after.write_operations != before.write_operations) {
+            printf("Corrupt table header streamed data (case %d): %u bytes read, %u writes\n", c,
+                   after.bytes_read - before.bytes_read, after.write_operations - before.write_operations);
+            return -1;
+        }
+    }
+
+    // 恢复表头后数据照常可用
+    uint32_t value = 0;
+    if (overwrite_table_header("BADHDR", &good) != 0 || fast_flash_get_table_count("BADHDR") != 4 ||
+        fast_flash_read_table_data("BADHDR", 3, &value, sizeof(value)) != 0 || value != 0xC3 ||
+        fast_flash_validate_table_data("BADHDR") != 0) {
+        printf("Table not usable after restoring header\n");
+        return -1;
+    }
+
+    printf("Corrupt table header test passed!\n");
+    return 0;
+}
+
+// 最初版本（v1）的管理表：packed，CRC紧跟魔数，固定24个表项，每个表项末尾有未使用的next_manager_addr
+typedef struct __attribute__((packed)) {
+    char     name[TABLE_NAME_MAX_LEN];
+    uint32_t addr;
+    uint32_t size;
+    uint32_t used_size;
+    uint16_t magic;
+    uint8_t  status;
+    uint8_t  reserved;
+    uint32_t next_manager_addr;
+} v1_table_info_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint32_t crc;
+    uint8_t  version;
+    uint8_t  table_count;
+    uint32_t total_size;
+    uint32_t used_size;
+    uint32_t next_manager_addr;
+    v1_table_info_t tables[MAX_TABLES_ALL_SECTOR];
+} v1_manager_t;
+
+// 按v1的方式写入一个管理表节点
+static int write_v1_manager(uint32_t addr, const v1_table_info_t *entries, uint32_t count,
+                            uint32_t used_size, uint32_t next_addr) {
+    static v1_manager_t node;
+    memset(&node, 0, sizeof(node));
+    node.magic = MAGIC_NUMBER_MANAGER;
+    node.version = 1;
+    node.total_size = SIM_FLASH_TOTAL_SIZE;
+    node.used_size = used_size;
+    node.next_manager_addr = next_addr;
+    for (uint32_t i = 0; i < count; i++) {
+        node.tables[i] = entries[i];
+        if (entries[i].status == TABLE_STATUS_VALID) {
+            node.table_count++;
+        }
+    }
+    node.crc = test_crc32((const uint8_t*)&node + 6, sizeof(node) - 6);
+    return sim_flash_ops.write(addr, (const uint8_t*)&node, sizeof(node));
+}
+
+// 按v1的方式写入表（表头 + count条uint32_t记录），填写对应的表项
+static int write_v1_table(uint32_t addr, const char *name, uint32_t first, uint32_t count, v1_table_info_t *entry) {
+    uint8_t image[sizeof(table_header_t) + 4 * sizeof(uint32_t)];
+    table_header_t header;
+    uint32_t values[4];
+    memset(&header, 0, sizeof(header));
+    header.magic = MAGIC_NUMBER_TABLE;
+    strncpy(header.name, name, TABLE_NAME_MAX_LEN - 1);
+    header.table_size = sizeof(table_header_t) + 16 * sizeof(uint32_t);
+    header.data_len = count * sizeof(uint32_t);
+    header.struct_size = sizeof(uint32_t);
+    header.struct_nums = count;
+    for (uint32_t i = 0; i < count; i++) {
+        values[i] = first + i;
+    }
+    header.data_crc = count ? test_crc32((const uint8_t*)values, header.data_len) : 0;
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + sizeof(header), values, header.data_len);
+
+    memset(entry, 0, sizeof(*entry));
+    strncpy(entry->name, name, TABLE_NAME_MAX_LEN - 1);
+    entry->addr = addr;
+    entry->size = count ? header.table_size : sizeof(table_header_t);
+    entry->used_size = sizeof(header) + header.data_len;
+    entry->magic = MAGIC_NUMBER_TABLE;
+    entry->status = TABLE_STATUS_VALID;
+    return sim_flash_ops.write(addr, image, entry->used_size);
+}
+
+// 检查迁移后的表：记录完整，追加一条后重新挂载仍然完整
+static int check_v1_table(const char *name, uint32_t first, uint32_t count) {
+    uint32_t value = 0;
+    if (fast_flash_get_table_count(name) != count || fast_flash_validate_table_data(name) != 0) {
+        printf("Migrated v1 table %s not usable\n", name);
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (fast_flash_read_table_data(name, i, &value, sizeof(value)) != 0 || value != first + i) {
+            printf("Migrated v1 table %s record %u mismatch\n", name, i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// 最初版本写出的设备：管理表节点与表数据在扇区0中交替排布，每次修改整表复制到新位置（旧副本留在原处），
+// 下一个管理表预留在最新数据之后。不允许擦除时挂载也能迁移，数据和之后的写入照常可用
+int test_v1_migration(void) {
+    printf("\n=== Testing v1 Manager Table Migration ===\n");
+
+    const uint32_t node_size = sizeof(v1_manager_t);
+    v1_table_info_t entries[MAX_TABLES_ALL_SECTOR];
+    uint8_t before[64];
+    uint8_t after[sizeof(before)];
+
+    // 节点0：空设备；节点1：建表后（表头在第一个预留位置之后）；节点2：写入3条记录后（表复制到节点2之后）
+    uint32_t created_addr = 2 * node_size;
+    uint32_t node2_addr = created_addr + sizeof(table_header_t);
+    uint32_t table_addr = node2_addr + node_size;
+    memset(entries, 0, sizeof(entries));
+    strcpy(entries[0].name, "GONE");
+    entries[0].status = TABLE_STATUS_DELETED;
+    if (sim_flash_reset() != 0 ||
+        write_v1_manager(0, NULL, 0, 0, node_size) != 0 ||
+        write_v1_table(created_addr, "BASE", 0, 0, &entries[1]) != 0 ||
+        write_v1_manager(node_size, entries, 2, sizeof(table_header_t), node2_addr) != 0 ||
+        write_v1_table(table_addr, "BASE", 0x1A0, 3, &entries[1]) != 0 ||
+        write_v1_manager(node2_addr, entries, 2, entries[1].used_size, table_addr + entries[1].used_size) != 0 ||
+        sim_flash_read(0, before, sizeof(before)) != 0) {
+        printf("Failed to write v1 image\n");
+        return -1;
+    }
+
+    uint32_t value = 0x1A3;
+    if (fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, false) != 0 ||
+        sim_flash_read(0, after, sizeof(after)) != 0 || memcmp(before, after, sizeof(before)) != 0 ||
+        fast_flash_table_exists("GONE") || check_v1_table("BASE", 0x1A0, 3) != 0 ||
+        fast_flash_append_table_data("BASE", &value, sizeof(value)) != 0 ||
+        fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, false) != 0 ||
+        check_v1_table("BASE", 0x1A0, 4) != 0) {
+        printf("v1 manager table not migrated\n");
+        return -1;
+    }
+
+    // 24个槽位全部使用：当前格式的管理表放得下v1预留的位置，迁移后直接写在那里
+    char name[TABLE_NAME_MAX_LEN];
+    uint32_t addr = node_size + node_size;
+    memset(entries, 0, sizeof(entries));
+    if (sim_flash_reset() != 0) {
+        return -1;
+    }
+    for (int i = 0; i < MAX_TABLES_ALL_SECTOR; i++) {
+        snprintf(name, sizeof(name), "V%02d", i);
+        if (write_v1_table(addr, name, 0x100 * i, 2, &entries[i]) != 0) {
+            printf("Failed to write v1 image\n");
+            return -1;
+        }
+        addr += entries[i].used_size;
+    }
+    if (write_v1_manager(0, NULL, 0, 0, node_size) != 0 ||
+        write_v1_manager(node_size, entries, MAX_TABLES_ALL_SECTOR, addr - 2 * node_size, addr) != 0) {
+        printf("Failed to write v1 image\n");
+        return -1;
+    }
+    value = 0x1702;
+    flash_manager_table_t migrated;
+    if (fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, false) != 0 ||
+        sim_flash_read(addr, (uint8_t*)&migrated, sizeof(migrated)) != 0 ||
+        migrated.version != MANAGER_TABLE_VERSION || migrated.table_count != MAX_TABLES_ALL_SECTOR ||
+        fast_flash_append_table_data("V23", &value, sizeof(value)) != 0 ||
+        fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, false) != 0 ||
+        check_v1_table("V23", 0x1700, 3) != 0) {
+        printf("v1 manager table with all slots in use not migrated\n");
+        return -1;
+    }
+    for (int i = 0; i < MAX_TABLES_ALL_SECTOR - 1; i++) {
+        snprintf(name, sizeof(name), "V%02d", i);
+        if (check_v1_table(name, 0x100 * i, 2) != 0) {
+            return -1;
+        }
+    }
+
+    // 不支持的版本：挂载失败，不当作空白设备擦除
+    uint8_t unknown[sizeof(v1_manager_t)];
+    uint8_t readback[sizeof(unknown)];
+    memset(unknown, 0x5A, sizeof(unknown));
+    unknown[0] = (uint8_t)MAGIC_NUMBER_MANAGER;
+    unknown[1] = (uint8_t)(MAGIC_NUMBER_MANAGER >> 8);
+    unknown[offsetof(flash_manager_table_t, version)] = MANAGER_TABLE_VERSION + 1;
+    if (sim_flash_reset() != 0 || sim_flash_ops.write(0, unknown, sizeof(unknown)) != 0 ||
+        fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, false) != -1 ||
+        fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true) != -1 ||
+        sim_flash_read(0, readback, sizeof(readback)) != 0 || memcmp(unknown, readback, sizeof(unknown)) != 0) {
+        printf("Unsupported manager table version not rejected\n");
+        return -1;
+    }
+
+    if (sim_flash_reset() != 0 || fast_flash_init(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, true) != 0) {
+        printf("Failed to restore clean flash\n");
+        return -1;
+    }
+
+    printf("v1 migration test passed!\n");
+    return 0;
+}
+
 int main(void) {
     // 设置日志级别为INFO，显示所有重要信息
     flash_log_set_level(LOG_LEVEL_DEBUG);
@@ -989,19 +3219,20 @@ int main(void) {
     printf("==============================\n");
     
     // 先初始化Flash适配器（确保文件存在）
-    if (win_flash_init() != 0) {
+    if (sim_flash_init() != 0) {
         printf("Failed to initialize flash adapter\n");
         return -1;
     }
     
     // 重置Flash（干净的测试环境）
-    if (win_flash_reset() != 0) {
+    restore_default_arena();
+    if (sim_flash_reset() != 0) {
         printf("Failed to reset flash\n");
         return -1;
     }
     
     // 初始化系统
-    if (fast_flash_init(&win_flash_ops, WIN_FLASH_TOTAL_SIZE, false) != 0) {
+    if (fast_flash_init_ex(&sim_flash_ops, SIM_FLASH_TOTAL_SIZE, false, &sim_flash_geometry) != 0) {
         printf("Failed to initialize fast flash\n");
         return -1;
     }
@@ -1018,6 +3249,34 @@ int main(void) {
     result |= test_batch_write_function();
     result |= test_garbage_collection();
     result |= test_space_management();
+    result |= test_table_placement_classes();
+    result |= test_block_erase_coalescing();
+    result |= test_runtime_geometry();
+    result |= test_streaming_relocation();
+    result |= test_corrupt_table_header();
+    result |= test_static_arena();
+    result |= test_device_copy();
+    result |= test_manager_format();
+    result |= test_large_catalog();
+    result |= test_lazy_mount();
+    result |= test_partitions();
+    result |= test_virtual_timing();
+    result |= test_sync_barrier();
+    result |= test_latency_histogram();
+    result |= test_io_stats();
+    result |= test_energy_model();
+    result |= test_power_loss_injection();
+    result |= test_deferred_log();
+    result |= test_v1_migration();
+#ifdef FAST_FLASH_PROFILE
+    result |= test_profiling();
+#endif
+#ifdef FAST_FLASH_TRACE
+    result |= test_trace_export();
+#endif
+#ifdef FAST_FLASH_RECORD
+    result |= test_workload_record();
+#endif
 
     
     // 最终状态
@@ -1026,7 +3285,7 @@ int main(void) {
     printf("Final free space: %u bytes\n", fast_flash_get_free_size());
     
     // 打印性能统计
-    win_flash_print_perf_stats();
+    sim_flash_print_perf_stats();
     
     if (result == 0) {
         printf("\n All tests passed!\n");